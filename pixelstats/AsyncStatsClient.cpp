@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "pixelstats-vendor"
+
+#include <pixelstats/AsyncStatsClient.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <utils/Log.h>
+
+#include <cstring>
+
+namespace android {
+namespace hardware {
+namespace google {
+namespace pixel {
+
+namespace {
+
+// Drops are logged on the first one, then once per this many
+constexpr size_t kDropLogInterval = 64;
+
+size_t roundUpToPowerOf2(size_t n) {
+    size_t result = 1;
+    while (result < n) {
+        result <<= 1;
+    }
+    return result;
+}
+
+}  // namespace
+
+AsyncStatsClient::AsyncStatsClient(StatsClientGetter stats_client_getter, size_t capacity)
+    : stats_client_getter_(std::move(stats_client_getter)),
+      mask_(roundUpToPowerOf2(capacity) - 1),
+      slots_(new Slot[mask_ + 1]),
+      event_fd_(eventfd(0, EFD_CLOEXEC)),
+      death_recipient_(AIBinder_DeathRecipient_new(onStatsBinderDied)) {
+    for (size_t i = 0; i <= mask_; i++) {
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    if (event_fd_ < 0) {
+        ALOGE("Unable to create stats eventfd - %s", strerror(errno));
+        return;
+    }
+    thread_ = std::thread([this] { loop(); });
+}
+
+AsyncStatsClient::~AsyncStatsClient() {
+    stopped_ = true;
+    if (thread_.joinable()) {
+        const uint64_t one = 1;
+        TEMP_FAILURE_RETRY(write(event_fd_, &one, sizeof(one)));
+        thread_.join();
+    }
+}
+
+ndk::ScopedAStatus AsyncStatsClient::reportVendorAtom(const VendorAtom &atom) {
+    if (!thread_.joinable()) {
+        countDropped(1, "no stats sender thread");
+        return ndk::ScopedAStatus::fromExceptionCode(EX_ILLEGAL_STATE);
+    }
+    if (!push(atom)) {
+        countDropped(1, "stats queue is full");
+        return ndk::ScopedAStatus::fromExceptionCode(EX_ILLEGAL_STATE);
+    }
+    const uint64_t one = 1;
+    TEMP_FAILURE_RETRY(write(event_fd_, &one, sizeof(one)));
+    return ndk::ScopedAStatus::ok();
+}
+
+size_t AsyncStatsClient::droppedAtoms() const {
+    return dropped_.load(std::memory_order_relaxed);
+}
+
+void AsyncStatsClient::countDropped(size_t count, const char *reason) {
+    const size_t before = dropped_.fetch_add(count, std::memory_order_relaxed);
+    if (before == 0 || before / kDropLogInterval != (before + count) / kDropLogInterval) {
+        ALOGE("Dropped %zu atoms, %s, %zu atoms dropped so far", count, reason, before + count);
+    }
+}
+
+// Bounded MPMC ring of D. Vyukov, used with a single consumer. Each slot's sequence tells whether
+// it is free for the producer at that position or holds an atom for the consumer.
+bool AsyncStatsClient::push(const VendorAtom &atom) {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Slot *slot;
+    while (true) {
+        slot = &slots_[pos & mask_];
+        const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = enqueue_pos_.load(std::memory_order_relaxed);
+        }
+    }
+    slot->atom = atom;
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool AsyncStatsClient::pop(VendorAtom *atom) {
+    Slot &slot = slots_[dequeue_pos_ & mask_];
+    const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if (sequence != dequeue_pos_ + 1) {
+        return false;
+    }
+    *atom = std::move(slot.atom);
+    slot.atom = VendorAtom();
+    slot.sequence.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+    dequeue_pos_++;
+    return true;
+}
+
+void AsyncStatsClient::loop() {
+    std::vector<VendorAtom> batch;
+    bool stopping = false;
+    while (!stopping) {
+        uint64_t count;
+        if (TEMP_FAILURE_RETRY(read(event_fd_, &count, sizeof(count))) < 0) {
+            ALOGE("Stats eventfd error - %s", strerror(errno));
+            return;
+        }
+        // Atoms queued before the stop are still sent
+        stopping = stopped_;
+        VendorAtom atom;
+        while (pop(&atom)) {
+            batch.push_back(std::move(atom));
+        }
+        sendBatch(batch);
+        batch.clear();
+    }
+}
+
+void AsyncStatsClient::sendBatch(const std::vector<VendorAtom> &batch) {
+    for (size_t i = 0; i < batch.size(); i++) {
+        std::shared_ptr<IStats> client = getClient();
+        if (!client) {
+            countDropped(batch.size() - i, "unable to get AIDL Stats service");
+            return;
+        }
+        const ndk::ScopedAStatus status = client->reportVendorAtom(batch[i]);
+        if (status.isOk()) {
+            continue;
+        }
+        // The service may have died before the death notification came, retry on a new binder
+        if (status.getStatus() == STATUS_DEAD_OBJECT ||
+            (client->isRemote() && !AIBinder_isAlive(client->asBinder().get()))) {
+            {
+                std::lock_guard<std::mutex> lock(client_mutex_);
+                if (client_ == client) {
+                    client_.reset();
+                }
+            }
+            client = getClient();
+            if (client && client->reportVendorAtom(batch[i]).isOk()) {
+                continue;
+            }
+        }
+        ALOGE("Unable to report atom %d to Stats service", batch[i].atomId);
+        countDropped(1, "stats service call failed");
+    }
+}
+
+std::shared_ptr<IStats> AsyncStatsClient::getClient() {
+    std::lock_guard<std::mutex> lock(client_mutex_);
+    if (client_) {
+        return client_;
+    }
+    client_ = stats_client_getter_();
+    if (client_ && client_->isRemote() &&
+        AIBinder_linkToDeath(client_->asBinder().get(), death_recipient_.get(), this) !=
+                STATUS_OK) {
+        ALOGE("Failed to register stats service death recipient");
+    }
+    return client_;
+}
+
+void AsyncStatsClient::onStatsBinderDied(void *cookie) {
+    AsyncStatsClient *stats_client = static_cast<AsyncStatsClient *>(cookie);
+    ALOGW("Stats service died, reconnecting on the next atom");
+    std::lock_guard<std::mutex> lock(stats_client->client_mutex_);
+    stats_client->client_.reset();
+}
+
+}  // namespace pixel
+}  // namespace google
+}  // namespace hardware
+}  // namespace android
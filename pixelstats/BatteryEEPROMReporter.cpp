@@ -21,9 +21,11 @@
 #include <utils/Timers.h>
 #include <cinttypes>
 #include <cmath>
+#include <iterator>
 
 #include <android-base/file.h>
 #include <pixelstats/BatteryEEPROMReporter.h>
+#include <pixelstats/BatteryHistoryDecoder.h>
 #include <pixelstats/StatsHelper.h>
 #include <hardware/google/pixel/pixelstats/pixelatoms.pb.h>
 
@@ -54,7 +56,6 @@ void BatteryEEPROMReporter::setAtomFieldValue(std::vector<VendorAtomValue> *valu
 void BatteryEEPROMReporter::checkAndReport(const std::shared_ptr<IStats> &stats_client,
                                            const std::string &path) {
     std::string file_contents;
-    std::string history_each;
 
     const int kSecondsPerMonth = 60 * 60 * 24 * 30;
     int64_t now = getTimeSecs();
@@ -72,6 +73,7 @@ void BatteryEEPROMReporter::checkAndReport(const std::shared_ptr<IStats> &stats_
     int16_t i, num;
     struct BatteryHistory hist;
     const int kHistTotalLen = file_contents.size();
+    const std::string_view contents = file_contents;
 
     ALOGD("kHistTotalLen=%d\n", kHistTotalLen);
 
@@ -81,39 +83,11 @@ void BatteryEEPROMReporter::checkAndReport(const std::shared_ptr<IStats> &stats_
             size_t history_offset = i * LINESIZE_V2;
             if (history_offset > file_contents.size())
                 break;
-            history_each = file_contents.substr(history_offset, LINESIZE_V2);
-            unsigned int data[4];
 
             /* Format transfer: go/gsx01-eeprom */
-            num = sscanf(history_each.c_str(), "%4" SCNx16 "%4" SCNx16 "%x %x %x %x",
-                        &histv2.tempco, &histv2.rcomp0, &data[0], &data[1], &data[2], &data[3]);
-
-            if (histv2.tempco == 0xFFFF && histv2.rcomp0 == 0xFFFF)
-                continue;
-
-            /* Extract each data */
-            uint64_t tmp = (int64_t)data[3] << 48 |
-                           (int64_t)data[2] << 32 |
-                           (int64_t)data[1] << 16 |
-                           data[0];
-
-            /* ignore this data if unreasonable */
-            if (tmp <= 0)
+            if (!decodeBatteryHistoryExtend(contents.substr(history_offset, LINESIZE_V2), &histv2))
                 continue;
 
-            /* data format/unit in go/gsx01-eeprom#heading=h.finy98ign34p */
-            histv2.timer_h = tmp & 0xFF;
-            histv2.fullcapnom = (tmp >>= 8) & 0x3FF;
-            histv2.fullcaprep = (tmp >>= 10) & 0x3FF;
-            histv2.mixsoc = (tmp >>= 10) & 0x3F;
-            histv2.vfsoc = (tmp >>= 6) & 0x3F;
-            histv2.maxvolt = (tmp >>= 6) & 0xF;
-            histv2.minvolt = (tmp >>= 4) & 0xF;
-            histv2.maxtemp = (tmp >>= 4) & 0xF;
-            histv2.mintemp = (tmp >>= 4) & 0xF;
-            histv2.maxchgcurr = (tmp >>= 4) & 0xF;
-            histv2.maxdischgcurr = (tmp >>= 4) & 0xF;
-
             /* Mapping to original format to collect data */
             /* go/pixel-battery-eeprom-atom#heading=h.dcawdjiz2ls6 */
             hist.tempco = histv2.tempco;
@@ -140,26 +114,38 @@ void BatteryEEPROMReporter::checkAndReport(const std::shared_ptr<IStats> &stats_
     for (i = 0; i < (LINESIZE * BATT_HIST_NUM_MAX); i = i + LINESIZE) {
         if (i + LINESIZE > kHistTotalLen)
             break;
-        history_each = file_contents.substr(i, LINESIZE);
-        num = sscanf(history_each.c_str(),
-                   "%4" SCNx16 "%4" SCNx16 "%4" SCNx16 "%4" SCNx16
-                   "%2" SCNx8 "%2" SCNx8 " %2" SCNx8 "%2" SCNx8
-                   "%2" SCNx8 "%2" SCNx8 " %2" SCNx8 "%2" SCNx8
-                   "%2" SCNx8 "%2" SCNx8 " %4" SCNx16 "%4" SCNx16
-                   "%4" SCNx16 "%4" SCNx16 "%4" SCNx16,
-                   &hist.cycle_cnt, &hist.full_cap, &hist.esr,
-                   &hist.rslow, &hist.batt_temp, &hist.soh,
-                   &hist.cc_soc, &hist.cutoff_soc, &hist.msoc,
-                   &hist.sys_soc, &hist.reserve, &hist.batt_soc,
-                   &hist.min_temp, &hist.max_temp,  &hist.max_vbatt,
-                   &hist.min_vbatt, &hist.max_ibatt, &hist.min_ibatt,
-                   &hist.checksum);
+        const std::string_view history_each = contents.substr(i, LINESIZE);
+        static constexpr uint8_t kMaxDigits[] = {4, 4, 4, 4, 2, 2, 2, 2, 2, 2,
+                                                 2, 2, 2, 2, 4, 4, 4, 4, 4};
+        uint32_t data[std::size(kMaxDigits)];
+        num = scanHexFields(history_each, kMaxDigits, std::size(kMaxDigits), data);
 
         if (num != kNumBatteryHistoryFields) {
-            ALOGE("Couldn't process %s", history_each.c_str());
+            ALOGE("Couldn't process %.*s", static_cast<int>(history_each.size()),
+                  history_each.data());
             continue;
         }
 
+        hist.cycle_cnt = data[0];
+        hist.full_cap = data[1];
+        hist.esr = data[2];
+        hist.rslow = data[3];
+        hist.batt_temp = data[4];
+        hist.soh = data[5];
+        hist.cc_soc = data[6];
+        hist.cutoff_soc = data[7];
+        hist.msoc = data[8];
+        hist.sys_soc = data[9];
+        hist.reserve = data[10];
+        hist.batt_soc = data[11];
+        hist.min_temp = data[12];
+        hist.max_temp = data[13];
+        hist.max_vbatt = data[14];
+        hist.min_vbatt = data[15];
+        hist.max_ibatt = data[16];
+        hist.min_ibatt = data[17];
+        hist.checksum = data[18];
+
         if (checkLogEvent(hist)) {
             reportEvent(stats_client, hist);
             report_time_ = getTimeSecs();
@@ -380,35 +366,35 @@ void BatteryEEPROMReporter::checkAndReportMaxfgHistory(const std::shared_ptr<ISt
         return;
     }
 
-    std::string hist_each;
+    const std::string_view contents = file_contents;
     const int kHistTotalLen = file_contents.size();
 
     ALOGD("checkAndReportMaxfgHistory:size=%d\n%s", kHistTotalLen, file_contents.c_str());
 
     for (i = 0; i < kHistTotalLen; i++) {
         struct BatteryHistory maxfg_hist;
-        uint16_t nQRTable00, nQRTable10, nQRTable20, nQRTable30, nCycles, nFullCapNom;
-        uint16_t nRComp0, nTempCo, nIAvgEmpty, nFullCapRep, nVoltTemp, nMaxMinCurr, nMaxMinVolt;
-        uint16_t nMaxMinTemp, nSOC, nTimerH;
+        static constexpr uint8_t kMaxDigits[] = {4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4};
+        uint32_t data[std::size(kMaxDigits)];
         int16_t num;
         size_t hist_offset = i * LINESIZE_MAX17201_HIST;
 
         if (hist_offset >= file_contents.size())
             break;
 
-        hist_each = file_contents.substr(hist_offset, LINESIZE_MAX17201_HIST);
-        num = sscanf(hist_each.c_str(), "%4" SCNx16 "%4" SCNx16 "%4" SCNx16 "%4" SCNx16
-                     "%4" SCNx16 "%4" SCNx16 "%4" SCNx16 "%4" SCNx16 "%4" SCNx16 "%4" SCNx16
-                     "%4" SCNx16 "%4" SCNx16 "%4" SCNx16 "%4" SCNx16 "%4" SCNx16 "%4" SCNx16,
-                     &nQRTable00, &nQRTable10, &nQRTable20, &nQRTable30, &nCycles, &nFullCapNom,
-                     &nRComp0, &nTempCo, &nIAvgEmpty, &nFullCapRep, &nVoltTemp, &nMaxMinCurr,
-                     &nMaxMinVolt, &nMaxMinTemp, &nSOC, &nTimerH);
+        const std::string_view hist_each = contents.substr(hist_offset, LINESIZE_MAX17201_HIST);
+        num = scanHexFields(hist_each, kMaxDigits, std::size(kMaxDigits), data);
 
         if (num != kNum17201HISTFields) {
-            ALOGE("Couldn't process %s (num=%d)", hist_each.c_str(), num);
+            ALOGE("Couldn't process %.*s (num=%d)", static_cast<int>(hist_each.size()),
+                  hist_each.data(), num);
             continue;
         }
 
+        const uint16_t nCycles = data[4], nFullCapNom = data[5], nRComp0 = data[6];
+        const uint16_t nTempCo = data[7], nIAvgEmpty = data[8], nFullCapRep = data[9];
+        const uint16_t nVoltTemp = data[10], nMaxMinCurr = data[11], nMaxMinVolt = data[12];
+        const uint16_t nMaxMinTemp = data[13], nSOC = data[14], nTimerH = data[15];
+
         /* not assign: nQRTable00, nQRTable10, nQRTable20, nQRTable30 */
         maxfg_hist.reserve = 0xFF;
         maxfg_hist.tempco = nTempCo;
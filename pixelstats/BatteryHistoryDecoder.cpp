@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ctype.h>
+#include <pixelstats/BatteryHistoryDecoder.h>
+
+#include <array>
+
+namespace android {
+namespace hardware {
+namespace google {
+namespace pixel {
+
+namespace {
+
+constexpr uint8_t kNotHex = 0xFF;
+
+// Value of each character as a hex digit
+constexpr std::array<uint8_t, 256> kHexValues = [] {
+    std::array<uint8_t, 256> values{};
+    values.fill(kNotHex);
+    for (int i = 0; i < 10; i++) {
+        values['0' + i] = i;
+    }
+    for (int i = 0; i < 6; i++) {
+        values['a' + i] = 10 + i;
+        values['A' + i] = 10 + i;
+    }
+    return values;
+}();
+
+// Bit fields of the packed P21+ history word, from bit 0 up
+enum HistoryExtendField {
+    TIMER_H = 0,
+    FULLCAPNOM,
+    FULLCAPREP,
+    MIXSOC,
+    VFSOC,
+    MAXVOLT,
+    MINVOLT,
+    MAXTEMP,
+    MINTEMP,
+    MAXCHGCURR,
+    MAXDISCHGCURR,
+    NUM_HISTORY_EXTEND_FIELDS,
+};
+
+/* data format/unit in go/gsx01-eeprom#heading=h.finy98ign34p */
+constexpr int kHistoryExtendWidths[NUM_HISTORY_EXTEND_FIELDS] = {
+        8, 10, 10, 6, 6, 4, 4, 4, 4, 4, 4,
+};
+
+constexpr int historyExtendShift(int field) {
+    int shift = 0;
+    for (int i = 0; i < field; i++) {
+        shift += kHistoryExtendWidths[i];
+    }
+    return shift;
+}
+
+static_assert(historyExtendShift(NUM_HISTORY_EXTEND_FIELDS) == 64,
+              "The history fields fill the 64 bit history word");
+
+template <HistoryExtendField field>
+constexpr unsigned historyExtendField(uint64_t word) {
+    return (word >> historyExtendShift(field)) & ((1u << kHistoryExtendWidths[field]) - 1);
+}
+
+}  // namespace
+
+int scanHexFields(std::string_view text, const uint8_t *max_digits, int count, uint32_t *values) {
+    size_t pos = 0;
+    for (int i = 0; i < count; i++) {
+        while (pos < text.size() && isspace(static_cast<unsigned char>(text[pos]))) {
+            pos++;
+        }
+        const size_t end = max_digits[i] && text.size() - pos > max_digits[i]
+                                   ? pos + max_digits[i]
+                                   : text.size();
+        // As strtoumax() under sscanf(), saturate at 64 bits and then truncate
+        uint64_t value = 0;
+        const size_t begin = pos;
+        for (; pos < end; pos++) {
+            const uint8_t digit = kHexValues[static_cast<unsigned char>(text[pos])];
+            if (digit == kNotHex) {
+                break;
+            }
+            value = value >> 60 ? UINT64_MAX : value << 4 | digit;
+        }
+        if (pos == begin) {
+            return i;
+        }
+        values[i] = static_cast<uint32_t>(value);
+    }
+    return count;
+}
+
+bool decodeBatteryHistoryExtend(std::string_view line, BatteryHistoryExtend *hist) {
+    static constexpr uint8_t kMaxDigits[] = {4, 4, 0, 0, 0, 0};
+    uint32_t data[6];
+
+    if (scanHexFields(line, kMaxDigits, 6, data) != 6) {
+        return false;
+    }
+
+    hist->tempco = data[0];
+    hist->rcomp0 = data[1];
+    if (hist->tempco == 0xFFFF && hist->rcomp0 == 0xFFFF) {
+        return false;
+    }
+
+    const uint64_t word = static_cast<uint64_t>(data[5]) << 48 |
+                          static_cast<uint64_t>(data[4]) << 32 |
+                          static_cast<uint64_t>(data[3]) << 16 | data[2];
+    if (word == 0) {
+        return false;
+    }
+
+    hist->timer_h = historyExtendField<TIMER_H>(word);
+    hist->fullcapnom = historyExtendField<FULLCAPNOM>(word);
+    hist->fullcaprep = historyExtendField<FULLCAPREP>(word);
+    hist->mixsoc = historyExtendField<MIXSOC>(word);
+    hist->vfsoc = historyExtendField<VFSOC>(word);
+    hist->maxvolt = historyExtendField<MAXVOLT>(word);
+    hist->minvolt = historyExtendField<MINVOLT>(word);
+    hist->maxtemp = historyExtendField<MAXTEMP>(word);
+    hist->mintemp = historyExtendField<MINTEMP>(word);
+    hist->maxchgcurr = historyExtendField<MAXCHGCURR>(word);
+    hist->maxdischgcurr = historyExtendField<MAXDISCHGCURR>(word);
+    return true;
+}
+
+}  // namespace pixel
+}  // namespace google
+}  // namespace hardware
+}  // namespace android
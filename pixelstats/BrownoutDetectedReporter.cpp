@@ -23,13 +23,15 @@
 #include <android-base/stringprintf.h>
 #include <android-base/strings.h>
 #include <android/binder_manager.h>
+#include <ctype.h>
 #include <hardware/google/pixel/pixelstats/pixelatoms.pb.h>
 #include <pixelstats/BrownoutDetectedReporter.h>
+#include <pixelstats/TextScanner.h>
 #include <time.h>
 #include <utils/Log.h>
 
+#include <charconv>
 #include <map>
-#include <regex>
 
 namespace android {
 namespace hardware {
@@ -42,22 +44,125 @@ using aidl::android::frameworks::stats::VendorAtomValue;
 using android::base::ReadFileToString;
 using android::hardware::google::pixel::PixelAtoms::BrownoutDetected;
 
-#define READING_IDX 2
-#define KEY_IDX 0
 #define DEFAULT_BATTERY_TEMP 9999999
 #define DEFAULT_BATTERY_SOC 100
 #define DEFAULT_BATTERY_VOLT 5000000
 #define ONE_SECOND_IN_US 1000000
 
-const std::regex kTimestampPattern("^\\S+\\s[0-9]+:[0-9]+:[0-9]+\\S+$");
-const std::regex kIrqPattern("^(\\S+)\\striggered\\sat\\s\\S+$");
-const std::regex kOdpmPattern("^CH\\d+\\[(\\S+)\\],\\s(\\d+)$");
-const std::regex kDvfsPattern("^([A-Z1-9]+):(\\d+)$");
-const std::regex kFgPattern("^(voltage_now):(\\d+)$");
-const std::regex kBatteryTempPattern("^(battery):(\\d+)$");
-const std::regex kBatteryCyclePattern("^(battery_cycle):(\\d+)$");
-const std::regex kBatterySocPattern("^(soc):(\\d+)$");
-const std::regex kAlreadyUpdatedPattern("^(LASTMEAL_UPDATED)$");
+namespace {
+
+constexpr std::string_view kAlreadyUpdated = "LASTMEAL_UPDATED";
+
+// The lines of the brownout log follow a few fixed grammars, matched by hand rather than with
+// std::regex: the log is parsed at boot right after a brownout.
+
+size_t findSpace(std::string_view text, size_t pos = 0) {
+    while (pos < text.size() && !isspace(static_cast<unsigned char>(text[pos]))) {
+        pos++;
+    }
+    return pos < text.size() ? pos : std::string_view::npos;
+}
+
+size_t skipDigits(std::string_view text, size_t pos) {
+    while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') {
+        pos++;
+    }
+    return pos;
+}
+
+// All of text as a decimal reading that fits in an int
+bool parseReading(std::string_view text, int *reading) {
+    if (text.empty() || skipDigits(text, 0) != text.size()) {
+        return false;
+    }
+    const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), *reading);
+    return ec == std::errc();
+}
+
+// "<date> <hh>:<mm>:<ss>.<fraction>"
+bool matchTimestamp(std::string_view line) {
+    const size_t space = findSpace(line);
+    if (space == 0 || space == std::string_view::npos) {
+        return false;
+    }
+    const std::string_view time = line.substr(space + 1);
+    if (findSpace(time) != std::string_view::npos) {
+        return false;
+    }
+    size_t pos = 0;
+    for (int i = 0; i < 2; i++) {
+        const size_t end = skipDigits(time, pos);
+        if (end == pos || end == time.size() || time[end] != ':') {
+            return false;
+        }
+        pos = end + 1;
+    }
+    // The seconds, then anything
+    return skipDigits(time, pos) > pos && time.size() - pos >= 2;
+}
+
+// "<irq> triggered at <time>"
+bool matchIrq(std::string_view line) {
+    static constexpr std::string_view kWords[] = {"triggered", "at"};
+    size_t space = findSpace(line);
+    if (space == 0 || space == std::string_view::npos) {
+        return false;
+    }
+    for (const std::string_view word : kWords) {
+        if (line.substr(space + 1, word.size()) != word) {
+            return false;
+        }
+        space += 1 + word.size();
+        if (space >= line.size() || !isspace(static_cast<unsigned char>(line[space]))) {
+            return false;
+        }
+    }
+    return space + 1 < line.size() && findSpace(line, space + 1) == std::string_view::npos;
+}
+
+// "<name>:<reading>", as the fuel gauge and DVFS readings are logged
+bool matchReading(std::string_view line, std::string_view *name, int *reading) {
+    const size_t colon = line.find(':');
+    if (colon == std::string_view::npos) {
+        return false;
+    }
+    *name = line.substr(0, colon);
+    return parseReading(line.substr(colon + 1), reading);
+}
+
+// DVFS domains are named in [A-Z1-9]
+bool isDvfsName(std::string_view name) {
+    if (name.empty()) {
+        return false;
+    }
+    for (const char c : name) {
+        if (!((c >= 'A' && c <= 'Z') || (c >= '1' && c <= '9'))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// "CH<n>[<rail>], <reading>"
+bool matchOdpm(std::string_view line, int *reading) {
+    const size_t space = findSpace(line);
+    if (space == std::string_view::npos || !parseReading(line.substr(space + 1), reading)) {
+        return false;
+    }
+    std::string_view channel = line.substr(0, space);
+    if (channel.substr(0, 2) != "CH") {
+        return false;
+    }
+    const size_t rail = skipDigits(channel, 2);
+    if (rail == 2) {
+        return false;
+    }
+    channel.remove_prefix(rail);
+    return channel.size() > 3 && channel.front() == '[' &&
+           channel.substr(channel.size() - 2) == "],";
+}
+
+}  // namespace
 
 const std::map<std::string, int> kBrownoutReason = {{"uvlo,pmic,if", BrownoutDetected::UVLO_IF},
                                                     {"ocp,pmic,if", BrownoutDetected::OCP_IF},
@@ -89,27 +194,16 @@ const std::map<std::string, int> kBrownoutReason = {{"uvlo,pmic,if", BrownoutDet
                                                     {"ocp,buckcs", BrownoutDetected::OCP_BCS},
                                                     {"ocp,buckds", BrownoutDetected::OCP_BDS}};
 
-bool BrownoutDetectedReporter::updateIfFound(std::string line, std::regex pattern,
-                                             int *current_value, Update flag) {
-    bool found = false;
-    std::smatch pattern_match;
-    if (std::regex_match(line, pattern_match, pattern)) {
-        if (pattern_match.size() < (READING_IDX + 1)) {
-            return found;
+void BrownoutDetectedReporter::updateValue(int reading, int *current_value, Update flag) {
+    if (flag == kUpdateMax) {
+        if (*current_value < reading) {
+            *current_value = reading;
         }
-        found = true;
-        int reading = std::stoi(pattern_match[READING_IDX].str());
-        if (flag == kUpdateMax) {
-            if (*current_value < reading) {
-                *current_value = reading;
-            }
-        } else {
-            if (*current_value > reading) {
-                *current_value = reading;
-            }
+    } else {
+        if (*current_value > reading) {
+            *current_value = reading;
         }
     }
-    return found;
 }
 
 void BrownoutDetectedReporter::setAtomFieldValue(std::vector<VendorAtomValue> *values, int offset,
@@ -276,7 +370,6 @@ void BrownoutDetectedReporter::logBrownoutCsv(const std::shared_ptr<IStats> &sta
     max_value.voltage_now_ = DEFAULT_BATTERY_VOLT;
     max_value.battery_soc_ = DEFAULT_BATTERY_SOC;
     max_value.battery_temp_ = DEFAULT_BATTERY_TEMP;
-    std::smatch pattern_match;
     max_value.brownout_reason_ = brownoutReasonCheck(brownoutReasonProp);
     if (max_value.brownout_reason_ < 0) {
         return;
@@ -285,7 +378,7 @@ void BrownoutDetectedReporter::logBrownoutCsv(const std::shared_ptr<IStats> &sta
     std::vector<std::vector<std::string>> rows;
     int row_num = 0;
     while (std::getline(content, line)) {
-        if (std::regex_match(line, pattern_match, kAlreadyUpdatedPattern)) {
+        if (line == kAlreadyUpdated) {
             isAlreadyUpdated = true;
             break;
         }
@@ -331,88 +424,80 @@ void BrownoutDetectedReporter::logBrownoutCsv(const std::shared_ptr<IStats> &sta
     }
 }
 
-void BrownoutDetectedReporter::logBrownout(const std::shared_ptr<IStats> &stats_client,
-                                           const std::string &logFilePath,
-                                           const std::string &brownoutReasonProp) {
-    std::string logFile;
-    if (!android::base::ReadFileToString(logFilePath, &logFile)) {
-        return;
-    }
-    std::istringstream content(logFile);
-    std::string line;
-    struct BrownoutDetectedInfo max_value = {};
-    max_value.voltage_now_ = DEFAULT_BATTERY_VOLT;
-    max_value.battery_soc_ = DEFAULT_BATTERY_SOC;
-    max_value.battery_temp_ = DEFAULT_BATTERY_TEMP;
-    std::smatch pattern_match;
+bool BrownoutDetectedReporter::parseBrownoutLog(std::string_view logFile,
+                                                struct BrownoutDetectedInfo *max_value) {
+    TextScanner lines(logFile);
+    std::string_view line;
+    std::string_view name;
+    int reading;
     int odpm_index = 0, dvfs_index = 0;
-    max_value.brownout_reason_ = brownoutReasonCheck(brownoutReasonProp);
-    if (max_value.brownout_reason_ < 0) {
-        return;
-    }
-    bool isAlreadyUpdated = false;
-    while (std::getline(content, line)) {
-        if (std::regex_match(line, pattern_match, kAlreadyUpdatedPattern)) {
-            isAlreadyUpdated = true;
-            break;
+    while (lines.nextLine(&line)) {
+        if (line == kAlreadyUpdated) {
+            return false;
         }
-        if (std::regex_match(line, pattern_match, kIrqPattern)) {
-            if (pattern_match.size() < (KEY_IDX + 1)) {
-                return;
-            }
-            std::ssub_match irq = pattern_match[KEY_IDX];
-            if (irq.str().find("batoilo") != std::string::npos) {
-                max_value.triggered_irq_ = BrownoutDetected::BATOILO;
-                continue;
-            }
-            if (irq.str().find("vdroop1") != std::string::npos) {
-                max_value.triggered_irq_ = BrownoutDetected::UVLO1;
-                continue;
-            }
-            if (irq.str().find("vdroop2") != std::string::npos) {
-                max_value.triggered_irq_ = BrownoutDetected::UVLO2;
-                continue;
-            }
-            if (irq.str().find("smpl_gm") != std::string::npos) {
-                max_value.triggered_irq_ = BrownoutDetected::SMPL_WARN;
-                continue;
+        if (matchIrq(line)) {
+            if (line.find("batoilo") != std::string_view::npos) {
+                max_value->triggered_irq_ = BrownoutDetected::BATOILO;
+            } else if (line.find("vdroop1") != std::string_view::npos) {
+                max_value->triggered_irq_ = BrownoutDetected::UVLO1;
+            } else if (line.find("vdroop2") != std::string_view::npos) {
+                max_value->triggered_irq_ = BrownoutDetected::UVLO2;
+            } else if (line.find("smpl_gm") != std::string_view::npos) {
+                max_value->triggered_irq_ = BrownoutDetected::SMPL_WARN;
             }
             continue;
         }
-        if (std::regex_match(line, pattern_match, kTimestampPattern)) {
-            max_value.triggered_timestamp_ = parseTimestamp(line.c_str());
+        if (matchTimestamp(line)) {
+            max_value->triggered_timestamp_ = parseTimestamp(std::string(line));
             continue;
         }
-        if (updateIfFound(line, kBatterySocPattern, &max_value.battery_soc_, kUpdateMin)) {
-            continue;
-        }
-        if (updateIfFound(line, kBatteryTempPattern, &max_value.battery_temp_, kUpdateMin)) {
-            continue;
-        }
-        if (updateIfFound(line, kBatteryCyclePattern, &max_value.battery_cycle_, kUpdateMax)) {
-            continue;
-        }
-        if (updateIfFound(line, kFgPattern, &max_value.voltage_now_, kUpdateMin)) {
-            continue;
-        }
-        if (updateIfFound(line, kDvfsPattern, &max_value.dvfs_value_[dvfs_index], kUpdateMax)) {
-            dvfs_index++;
-            // Discarding previous value and update with new DVFS value
-            if (dvfs_index == DVFS_MAX_IDX) {
-                dvfs_index = 0;
+        if (matchReading(line, &name, &reading)) {
+            if (name == "soc") {
+                updateValue(reading, &max_value->battery_soc_, kUpdateMin);
+            } else if (name == "battery") {
+                updateValue(reading, &max_value->battery_temp_, kUpdateMin);
+            } else if (name == "battery_cycle") {
+                updateValue(reading, &max_value->battery_cycle_, kUpdateMax);
+            } else if (name == "voltage_now") {
+                updateValue(reading, &max_value->voltage_now_, kUpdateMin);
+            } else if (isDvfsName(name)) {
+                updateValue(reading, &max_value->dvfs_value_[dvfs_index], kUpdateMax);
+                dvfs_index++;
+                // Discarding previous value and update with new DVFS value
+                if (dvfs_index == DVFS_MAX_IDX) {
+                    dvfs_index = 0;
+                }
             }
             continue;
         }
-        if (updateIfFound(line, kOdpmPattern, &max_value.odpm_value_[odpm_index], kUpdateMax)) {
+        if (matchOdpm(line, &reading)) {
+            updateValue(reading, &max_value->odpm_value_[odpm_index], kUpdateMax);
             odpm_index++;
             // Discarding previous value and update with new ODPM value
             if (odpm_index == ODPM_MAX_IDX) {
                 odpm_index = 0;
             }
-            continue;
         }
     }
-    if (!isAlreadyUpdated && max_value.battery_temp_ != DEFAULT_BATTERY_TEMP) {
+    return true;
+}
+
+void BrownoutDetectedReporter::logBrownout(const std::shared_ptr<IStats> &stats_client,
+                                           const std::string &logFilePath,
+                                           const std::string &brownoutReasonProp) {
+    std::string logFile;
+    if (!android::base::ReadFileToString(logFilePath, &logFile)) {
+        return;
+    }
+    struct BrownoutDetectedInfo max_value = {};
+    max_value.voltage_now_ = DEFAULT_BATTERY_VOLT;
+    max_value.battery_soc_ = DEFAULT_BATTERY_SOC;
+    max_value.battery_temp_ = DEFAULT_BATTERY_TEMP;
+    max_value.brownout_reason_ = brownoutReasonCheck(brownoutReasonProp);
+    if (max_value.brownout_reason_ < 0) {
+        return;
+    }
+    if (parseBrownoutLog(logFile, &max_value) && max_value.battery_temp_ != DEFAULT_BATTERY_TEMP) {
         std::string file_content = "LASTMEAL_UPDATED\n" + logFile;
         android::base::WriteStringToFile(file_content, logFilePath);
         uploadData(stats_client, max_value);
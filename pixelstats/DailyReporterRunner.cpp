@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "pixelstats-vendor"
+
+#include <pixelstats/DailyReporterRunner.h>
+#include <utils/Log.h>
+
+#include <algorithm>
+#include <condition_variable>
+
+namespace android {
+namespace hardware {
+namespace google {
+namespace pixel {
+
+ndk::ScopedAStatus DailyAtomBatch::reportVendorAtom(const VendorAtom &atom) {
+    std::shared_ptr<IStats> stats_client;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!stats_client_) {
+            atoms_.push_back(atom);
+            return ndk::ScopedAStatus::ok();
+        }
+        stats_client = stats_client_;
+    }
+    return stats_client->reportVendorAtom(atom);
+}
+
+void DailyAtomBatch::flush(const std::shared_ptr<IStats> &stats_client) {
+    std::vector<VendorAtom> atoms;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        atoms.swap(atoms_);
+        stats_client_ = stats_client;
+    }
+    for (const auto &atom : atoms) {
+        if (!stats_client->reportVendorAtom(atom).isOk()) {
+            ALOGE("Unable to report atom %d to Stats service", atom.atomId);
+        }
+    }
+}
+
+DailyReporterRunner::DailyReporterRunner(size_t num_workers,
+                                         std::chrono::milliseconds reporter_timeout,
+                                         std::chrono::milliseconds pass_timeout)
+    : reporter_timeout_(reporter_timeout), pass_timeout_(pass_timeout), pool_(num_workers) {}
+
+void DailyReporterRunner::addGroup(const char *name, std::vector<Reporter> reporters) {
+    auto group = std::make_unique<Group>();
+    group->name = name;
+    group->reporters = std::move(reporters);
+    groups_.push_back(std::move(group));
+}
+
+/**
+ * Run the groups on the pool and wait for them. A group whose current reporter blocks for longer
+ * than reporter_timeout_ is given up, as are groups which have not finished by pass_timeout_.
+ * A group given up keeps running in the background and is skipped by the following passes until
+ * it returns.
+ */
+void DailyReporterRunner::run(const std::shared_ptr<IStats> &stats_client) {
+    struct GroupProgress {
+        const char *reporter = nullptr;
+        std::chrono::steady_clock::time_point start;
+        bool done = false;
+        bool given_up = false;
+    };
+    struct DailyPass {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::vector<GroupProgress> progress;
+        // Groups still waited for
+        size_t remaining = 0;
+        bool expired = false;
+    };
+
+    const auto pass = std::make_shared<DailyPass>();
+    const auto batch = ndk::SharedRefBase::make<DailyAtomBatch>();
+    pass->progress.resize(groups_.size());
+
+    for (size_t i = 0; i < groups_.size(); i++) {
+        Group *group = groups_[i].get();
+        if (group->running.exchange(true)) {
+            ALOGW("Daily %s reporters are still blocked since the last pass", group->name);
+            pass->progress[i].done = true;
+            continue;
+        }
+        pass->remaining++;
+        pool_.post([pass, batch, group, i] {
+            const std::shared_ptr<IStats> client = batch;
+            for (const auto &reporter : group->reporters) {
+                {
+                    std::lock_guard<std::mutex> lock(pass->mutex);
+                    if (pass->expired) {
+                        break;
+                    }
+                    pass->progress[i].reporter = reporter.name;
+                    pass->progress[i].start = std::chrono::steady_clock::now();
+                }
+                reporter.log(client);
+            }
+            group->running = false;
+            std::lock_guard<std::mutex> lock(pass->mutex);
+            pass->progress[i].done = true;
+            if (!pass->progress[i].given_up) {
+                pass->remaining--;
+            }
+            pass->cv.notify_all();
+        });
+    }
+
+    // Blocked reporters are looked for at least once a second
+    const auto poll_period =
+            std::min<std::chrono::milliseconds>(reporter_timeout_, std::chrono::seconds(1));
+    std::unique_lock<std::mutex> lock(pass->mutex);
+    const auto deadline = std::chrono::steady_clock::now() + pass_timeout_;
+    while (pass->remaining > 0) {
+        pass->cv.wait_until(lock,
+                            std::min(std::chrono::steady_clock::now() + poll_period, deadline));
+        const auto now = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < pass->progress.size(); i++) {
+            GroupProgress &progress = pass->progress[i];
+            if (progress.done || progress.given_up || progress.reporter == nullptr ||
+                now - progress.start < reporter_timeout_) {
+                continue;
+            }
+            ALOGE("Daily %s reporters gave up, %s is blocked", groups_[i]->name,
+                  progress.reporter);
+            progress.given_up = true;
+            pass->remaining--;
+        }
+        if (now >= deadline) {
+            ALOGE("Daily collection pass timed out with %zu groups left", pass->remaining);
+            break;
+        }
+    }
+    pass->expired = true;
+    lock.unlock();
+
+    batch->flush(stats_client);
+}
+
+}  // namespace pixel
+}  // namespace google
+}  // namespace hardware
+}  // namespace android
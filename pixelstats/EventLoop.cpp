@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "pixelstats-vendor"
+
+#include <pixelstats/EventLoop.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <utils/Log.h>
+
+#include <cinttypes>
+#include <cstring>
+
+namespace android {
+namespace hardware {
+namespace google {
+namespace pixel {
+
+namespace {
+
+constexpr int kMaxEvents = 8;
+// Shorter periods are missed on most resumes, only missed periods of longer timers are worth a
+// warning
+constexpr std::chrono::hours kMinMissedPeriodWarning(1);
+
+}  // namespace
+
+EventLoop::EventLoop()
+    : epoll_fd_(epoll_create1(EPOLL_CLOEXEC)),
+      timer_fd_(timerfd_create(CLOCK_BOOTTIME, TFD_NONBLOCK | TFD_CLOEXEC)) {
+    if (epoll_fd_ < 0 || timer_fd_ < 0) {
+        ALOGE("Unable to create event loop - %s", strerror(errno));
+        return;
+    }
+    struct epoll_event event = {.events = EPOLLIN, .data = {.fd = timer_fd_.get()}};
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, timer_fd_, &event)) {
+        ALOGE("Unable to watch timerfd - %s", strerror(errno));
+        timer_fd_.reset();
+    }
+}
+
+bool EventLoop::addFd(int fd, Callback callback, uint32_t events) {
+    struct epoll_event event = {.events = events, .data = {.fd = fd}};
+    if (epoll_fd_ < 0 || epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event)) {
+        ALOGE("Unable to watch fd %d - %s", fd, strerror(errno));
+        return false;
+    }
+    fd_callbacks_[fd] = std::move(callback);
+    return true;
+}
+
+void EventLoop::removeFd(int fd) {
+    if (fd_callbacks_.erase(fd) && epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr)) {
+        ALOGE("Unable to stop watching fd %d - %s", fd, strerror(errno));
+    }
+}
+
+void EventLoop::addTimer(const char *name, std::chrono::milliseconds delay,
+                         std::chrono::milliseconds period, std::chrono::milliseconds slack,
+                         Callback callback) {
+    timers_.push_back({name, now() + delay, period, slack, std::move(callback)});
+}
+
+void EventLoop::stop() {
+    stopped_ = true;
+}
+
+bool EventLoop::armTimer() {
+    struct itimerspec spec = {};
+    if (!timers_.empty()) {
+        TimePoint fire = TimePoint::max();
+        for (const Timer &timer : timers_) {
+            fire = std::min(fire, timer.deadline + timer.slack);
+        }
+        const int64_t ns = fire.time_since_epoch().count();
+        // A zero it_value disarms the timer
+        spec.it_value.tv_sec = ns / 1000000000;
+        spec.it_value.tv_nsec = std::max<int64_t>(ns % 1000000000, 1);
+    }
+    if (timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec, nullptr)) {
+        ALOGE("Unable to arm timerfd - %s", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void EventLoop::runDueTimers() {
+    const TimePoint wakeup_time = now();
+    for (size_t i = 0; i < timers_.size();) {
+        Timer &timer = timers_[i];
+        if (timer.deadline > wakeup_time) {
+            i++;
+            continue;
+        }
+        // Callbacks may add timers, so run a copy rather than the element
+        Callback callback;
+        if (timer.period.count() == 0) {
+            callback = std::move(timer.callback);
+            timers_.erase(timers_.begin() + i);
+        } else {
+            const int64_t missed = (wakeup_time - timer.deadline) / timer.period;
+            if (missed > 0 && timer.period >= kMinMissedPeriodWarning) {
+                ALOGW("%s timer: sleep too much: %" PRId64 " periods missed", timer.name, missed);
+            }
+            timer.deadline += (missed + 1) * timer.period;
+            callback = timer.callback;
+            i++;
+        }
+        callback();
+    }
+}
+
+void EventLoop::run() {
+    if (epoll_fd_ < 0 || timer_fd_ < 0) {
+        return;
+    }
+    struct epoll_event events[kMaxEvents];
+    stopped_ = false;
+    while (!stopped_) {
+        if (!armTimer()) {
+            return;
+        }
+        const int n = TEMP_FAILURE_RETRY(epoll_wait(epoll_fd_, events, kMaxEvents, -1));
+        if (n < 0) {
+            ALOGE("Event loop error - %s", strerror(errno));
+            return;
+        }
+        for (int i = 0; i < n; i++) {
+            const int fd = events[i].data.fd;
+            if (fd == timer_fd_) {
+                uint64_t expirations;
+                TEMP_FAILURE_RETRY(read(timer_fd_, &expirations, sizeof(expirations)));
+                continue;
+            }
+            const auto it = fd_callbacks_.find(fd);
+            if (it == fd_callbacks_.end()) {
+                continue;
+            }
+            // The callback may remove its own fd
+            const Callback callback = it->second;
+            callback();
+        }
+        // Any wakeup, timer or fd, runs the timers already past their deadline
+        runDueTimers();
+    }
+}
+
+}  // namespace pixel
+}  // namespace google
+}  // namespace hardware
+}  // namespace android
@@ -26,12 +26,14 @@
 #include <android/binder_manager.h>
 #include <hardware/google/pixel/pixelstats/pixelatoms.pb.h>
 #include <pixelstats/MmMetricsReporter.h>
+#include <pixelstats/TextScanner.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <time.h>
 #include <unistd.h>
 #include <utils/Log.h>
 
+#include <algorithm>
 #include <array>
 #include <cinttypes>
 #include <cstdint>
@@ -130,6 +132,11 @@ const std::vector<MmMetricsReporter::MmMetricsInfo> MmMetricsReporter::kCmaStatu
         {"latency_high", CmaStatusExt::kCmaAllocLatencyHighFieldNumber, false},
 };
 
+const MmMetricsReporter::MmMetricsIndex MmMetricsReporter::kMmMetricsPerHourIndex(
+        kMmMetricsPerHourInfo);
+const MmMetricsReporter::MmMetricsIndex MmMetricsReporter::kMmMetricsPerDayIndex(
+        kMmMetricsPerDayInfo);
+
 // Oom group range names
 const std::array oom_group_range_names{
         "[951,1000]", "[901,950]", "[851,900]", "[801,850]", "[751,800]",  "[701,750]",
@@ -138,6 +145,18 @@ const std::array oom_group_range_names{
         "[101,150]",  "[51,100]",  "[1,50]",    "[0,0]",     "[-1000,-1]",
 };
 
+MmMetricsReporter::MmMetricsIndex::MmMetricsIndex(const std::vector<MmMetricsInfo> &metrics_info)
+    : size_(metrics_info.size()) {
+    for (size_t i = 0; i < metrics_info.size(); i++) {
+        positions_.emplace(metrics_info[i].name, i);
+    }
+}
+
+int MmMetricsReporter::MmMetricsIndex::find(std::string_view name) const {
+    auto it = positions_.find(name);
+    return it == positions_.end() ? -1 : it->second;
+}
+
 static bool file_exists(const char *const path) {
     struct stat sbuf;
 
@@ -341,97 +360,134 @@ bool MmMetricsReporter::reportVendorAtom(const std::shared_ptr<IStats> &stats_cl
     return true;
 }
 
+/**
+ * Read path into read_buf_, which keeps its capacity across reads.
+ */
+bool MmMetricsReporter::readFileToBuffer(const std::string &path) {
+    return ReadFileToString(path, &read_buf_);
+}
+
 /**
  * Parse sysfs node in Name/Value pair form, including /proc/vmstat and /proc/meminfo
- * Name could optionally with a colon (:) suffix (will be removed to produce the output map),
+ * Name could optionally with a colon (:) suffix (will be removed before the lookup),
  * extra columns (e.g. 3rd column 'kb' for /proc/meminfo) will be discarded.
- * Return value: a map containing the pairs of {field_string, data}.
+ * Only the fields of the table of index are kept, in metrics at their position in the table.
+ * Return value: false, with no field found, if the node can't be read or is corrupted.
  */
-std::map<std::string, uint64_t> MmMetricsReporter::readSysfsNameValue(const std::string &path) {
-    std::string file_contents;
-    std::map<std::string, uint64_t> metrics;
+bool MmMetricsReporter::readSysfsNameValue(const std::string &path, const MmMetricsIndex &index,
+                                           MmMetricsValues *metrics) {
+    metrics->assign(index.size(), std::nullopt);
 
-    if (!ReadFileToString(path, &file_contents)) {
+    if (!readFileToBuffer(path)) {
         ALOGE("Unable to read vmstat from %s, err: %s", path.c_str(), strerror(errno));
-        return metrics;
+        return false;
     }
 
-    std::istringstream data(file_contents);
-    std::string line;
+    TextScanner lines(read_buf_);
+    std::string_view line;
     int line_num = 0;
 
-    while (std::getline(data, line)) {
+    while (lines.nextLine(&line)) {
         line_num++;
-        std::vector<std::string> words = android::base::Tokenize(line, " ");
+        TextScanner words(line);
+        std::string_view name;
+        std::string_view value;
 
         uint64_t i;
-        if (words.size() < 2 || !android::base::ParseUint(words[1], &i)) {
+        if (!words.nextField(&name) || !words.nextField(&value) || !parseUint(value, &i)) {
             ALOGE("File %s corrupted at line %d", path.c_str(), line_num);
-            metrics.clear();
-            break;
+            metrics->assign(index.size(), std::nullopt);
+            return false;
         }
 
-        if (words[0][words[0].length() - 1] == ':')
-            words[0].pop_back();
+        if (name.back() == ':')
+            name.remove_suffix(1);
 
-        metrics[words[0]] = i;
+        int pos = index.find(name);
+        if (pos >= 0)
+            (*metrics)[pos] = i;
     }
 
-    return metrics;
+    return true;
 }
 
 /**
  * Parse the output of /proc/stat or any sysfs node having the same output format.
- * The map containing pairs of {field_name, array (vector) of values} will be returned.
+ * Each line is a field name followed by an array of values. Only the fields named in
+ * metrics_info are kept, in pstat at the position of their entry: either the value at the
+ * entry's offset or, for offset -1, the sum of the array.
+ * Return value: false if the node can't be read, is empty or is corrupted.
  */
-std::map<std::string, std::vector<uint64_t>> MmMetricsReporter::readProcStat(
-        const std::string &path) {
-    std::map<std::string, std::vector<uint64_t>> fields;
-    std::string content;
-    bool got_err = false;
-
-    // Use ReadFileToString for convenient file reading
-    if (!android::base::ReadFileToString(path, &content)) {
+bool MmMetricsReporter::readProcStat(const std::string &path,
+                                     const std::vector<ProcStatMetricsInfo> &metrics_info,
+                                     MmMetricsValues *pstat) {
+    pstat->assign(metrics_info.size(), std::nullopt);
+
+    if (!readFileToBuffer(path)) {
         ALOGE("Error: Unable to open %s", path.c_str());
-        return fields;  // Return empty map on error
+        return false;
     }
 
-    // Split the file content into lines
-    std::vector<std::string> lines = android::base::Split(content, "\n");
+    const std::string_view content(read_buf_);
+    TextScanner lines(content);
+    std::string_view line;
+    bool got_line = false;
 
-    for (const auto &line : lines) {
-        std::vector<std::string> tokens = android::base::Tokenize(line, " ");
-        if (tokens.empty()) {
+    while (lines.nextLine(&line)) {
+        TextScanner tokens(line);
+        std::string_view field_name;
+        if (!tokens.nextField(&field_name)) {
             continue;  // Skip empty lines
         }
+        got_line = true;
+
+        // Check for duplicates in the lines before, there are only a few dozens
+        TextScanner prev_lines(content.substr(0, line.data() - content.data()));
+        std::string_view prev_line;
+        while (prev_lines.nextLine(&prev_line)) {
+            std::string_view prev_name;
+            if (TextScanner(prev_line).nextField(&prev_name) && prev_name == field_name) {
+                ALOGE("Duplicate field found: %.*s", static_cast<int>(field_name.size()),
+                      field_name.data());
+                goto err_out;
+            }
+        }
 
-        const std::string &field_name = tokens[0];
-
-        // Check for duplicates
-        if (fields.find(field_name) != fields.end()) {
-            ALOGE("Duplicate field found: %s", field_name.c_str());
-            got_err = true;
-            goto exit_loop;
+        bool wanted = false;
+        for (size_t i = 0; i < metrics_info.size(); i++) {
+            if (metrics_info[i].name == field_name)
+                wanted = true;
         }
 
-        std::vector<uint64_t> values;
-        for (size_t i = 1; i < tokens.size(); ++i) {
+        // All lines are validated, but only the wanted ones are summed up and saved
+        uint64_t sum = 0;
+        int offset = 0;
+        std::string_view token;
+        for (; tokens.nextField(&token); offset++) {
             uint64_t value;
-            if (!android::base::ParseUint(tokens[i], &value)) {
-                ALOGE("Invalid field value format in line: %s", line.c_str());
-                got_err = true;
-                goto exit_loop;
+            if (!parseUint(token, &value)) {
+                ALOGE("Invalid field value format in line: %.*s", static_cast<int>(line.size()),
+                      line.data());
+                goto err_out;
+            }
+            if (!wanted)
+                continue;
+            sum += value;
+            for (size_t i = 0; i < metrics_info.size(); i++) {
+                if (metrics_info[i].offset == offset && metrics_info[i].name == field_name)
+                    (*pstat)[i] = value;
             }
-            values.push_back(value);
         }
-        fields[field_name] = values;
+        for (size_t i = 0; wanted && offset > 0 && i < metrics_info.size(); i++) {
+            if (metrics_info[i].offset == -1 && metrics_info[i].name == field_name)
+                (*pstat)[i] = sum;
+        }
     }
+    return got_line;
 
-exit_loop:
-    if (got_err) {
-        fields.clear();
-    }
-    return fields;
+err_out:
+    pstat->assign(metrics_info.size(), std::nullopt);
+    return false;
 }
 
 uint64_t MmMetricsReporter::getIonTotalPools() {
@@ -461,14 +517,14 @@ uint64_t MmMetricsReporter::getGpuMemory() {
 /**
  * fillAtomValues() is used to copy Mm metrics to values
  * metrics_info: This is a vector of MmMetricsInfo {field_string, atom_key, update_diff}
- *               field_string is used to get the data from mm_metrics.
+ *               The position of an entry is used to get the data from mm_metrics.
  *               atom_key is the position where the data should be put into values.
  *               update_diff will be true if this is an accumulated data.
  *               metrics_info may have multiple entries with the same atom_key,
  *               e.g. workingset_refault and workingset_refault_file.
- * mm_metrics: This map contains pairs of {field_string, cur_value} collected
+ * mm_metrics: This contains the cur_value of each entry of metrics_info collected
  *             from /proc/vmstat or the sysfs for the pixel specific metrics.
- *             e.g. {"nr_free_pages", 200000}
+ *             e.g. 200000 at the position of "nr_free_pages"
  *             Some data in mm_metrics are accumulated, e.g. pswpin.
  *             We upload the difference instead of the accumulated value
  *             when update_diff of the field is true.
@@ -479,8 +535,8 @@ uint64_t MmMetricsReporter::getGpuMemory() {
  * return value: true on success, false on error.
  */
 bool MmMetricsReporter::fillAtomValues(const std::vector<MmMetricsInfo> &metrics_info,
-                                       const std::map<std::string, uint64_t> &mm_metrics,
-                                       std::map<std::string, uint64_t> *prev_mm_metrics,
+                                       const MmMetricsValues &mm_metrics,
+                                       MmMetricsValues *prev_mm_metrics,
                                        std::vector<VendorAtomValue> *atom_values) {
     bool err = false;
     VendorAtomValue tmp;
@@ -495,14 +551,14 @@ bool MmMetricsReporter::fillAtomValues(const std::vector<MmMetricsInfo> &metrics
     if (atom_values->size() < size)
         atom_values->resize(size, tmp);
 
-    for (auto &entry : metrics_info) {
+    for (size_t i = 0; i < metrics_info.size(); i++) {
+        const MmMetricsInfo &entry = metrics_info[i];
         int atom_idx = entry.atom_key - kVendorAtomOffset;
 
-        auto data = mm_metrics.find(entry.name);
-        if (data == mm_metrics.end())
+        if (i >= mm_metrics.size() || !mm_metrics[i].has_value())
             continue;
 
-        uint64_t cur_value = data->second;
+        uint64_t cur_value = *mm_metrics[i];
         uint64_t prev_value = 0;
         if (prev_mm_metrics == nullptr && entry.update_diff) {
             // Bug: We need previous saved metrics to calculate the difference.
@@ -512,9 +568,8 @@ bool MmMetricsReporter::fillAtomValues(const std::vector<MmMetricsInfo> &metrics
             continue;
         } else if (entry.update_diff) {
             // reaching here implies: prev_mm_metrics != nullptr
-            auto prev_data = prev_mm_metrics->find(entry.name);
-            if (prev_data != prev_mm_metrics->end()) {
-                prev_value = prev_data->second;
+            if (i < prev_mm_metrics->size() && (*prev_mm_metrics)[i].has_value()) {
+                prev_value = *(*prev_mm_metrics)[i];
             }
             // else: implies it's the 1st data: nothing to do, since prev_value already = 0
         }
@@ -528,49 +583,6 @@ bool MmMetricsReporter::fillAtomValues(const std::vector<MmMetricsInfo> &metrics
     return !err;
 }
 
-/*
- * offset -1 means to get the sum of the whole mapped array
- * otherwise get the array value at the offset.
- * return value: true for success (got the value), else false
- */
-bool MmMetricsReporter::getValueFromParsedProcStat(
-        const std::map<std::string, std::vector<uint64_t>> pstat, const std::string &name,
-        int offset, uint64_t *output) {
-    static bool log_once = false;
-
-    if (offset < -1) {
-        if (!log_once) {
-            log_once = true;
-            ALOGE("Bug: bad offset %d for entry %s", offset, name.c_str());
-        }
-        return false;
-    }
-
-    // the mapped array not found
-    auto itr = pstat.find(name);
-    if (itr == pstat.end()) {
-        return false;
-    }
-
-    const std::vector<uint64_t> &values = itr->second;
-
-    if (values.size() == 0) {
-        return false;
-    }
-
-    if (offset >= 0 && offset >= values.size()) {
-        return false;
-    }
-
-    if (offset != -1) {
-        *output = values.at(offset);
-        return true;
-    }
-
-    *output = std::accumulate(values.begin(), values.end(), 0);
-    return true;
-}
-
 /**
  *  metrics_info: see struct  ProcStatMetricsInfo for detail
  *
@@ -580,15 +592,15 @@ bool MmMetricsReporter::getValueFromParsedProcStat(
  *
  *  A typical /proc/stat line looks like
  *      cpu  258 132 521 30 15 28 16
- *  The parsed results are a map mapping the name (i.e. the 1st token in a /proc/stat line)
- *  to an array of numbers.
+ *  The parsed results hold, at the position of each entry of metrics_info, the value
+ *  the entry asks for from the line of its name.
  *
  *  Each element (entry) in metrics_info tells us where/how to find the corresponding
  *  value for that entry.  e.g.
  *   // name, offset,   atom_key,                                update_diff
  *    {"cpu", -1,  PixelMmMetricsPerDay::kCpuTotalTimeFieldNumber, true      }
  *  This is the entry "cpu total time".
- *  We need to look at the "cpu" line from /proc/stat (or from the parsed result, i.e. map)
+ *  We need to look at the "cpu" line from /proc/stat
  *  -1 is the offset for the value in the line.  Normally it is a zero-based
  *  number, from that we know which value to get from the array.
  *  -1 is special: it does not mean one specific offset but to sum-up everything in the array.
@@ -600,11 +612,11 @@ bool MmMetricsReporter::getValueFromParsedProcStat(
  *  in the atom field value array (i.e. <atom_values>) where we need to fill in the value.
  */
 bool MmMetricsReporter::fillProcStat(const std::vector<ProcStatMetricsInfo> &metrics_info,
-                                     const std::map<std::string, std::vector<uint64_t>> &cur_pstat,
-                                     std::map<std::string, std::vector<uint64_t>> *prev_pstat,
+                                     const MmMetricsValues &cur_pstat, MmMetricsValues *prev_pstat,
                                      std::vector<VendorAtomValue> *atom_values) {
     bool is_success = true;
-    for (const auto &entry : metrics_info) {
+    for (size_t i = 0; i < metrics_info.size(); i++) {
+        const ProcStatMetricsInfo &entry = metrics_info[i];
         int atom_idx = entry.atom_key - kVendorAtomOffset;
         uint64_t cur_value;
         uint64_t prev_value = 0;
@@ -628,18 +640,19 @@ bool MmMetricsReporter::fillProcStat(const std::vector<ProcStatMetricsInfo> &met
         }
 
         // Find the field value from the current read
-        if (!getValueFromParsedProcStat(cur_pstat, entry.name, entry.offset, &cur_value)) {
+        if (i >= cur_pstat.size() || !cur_pstat[i].has_value()) {
             // Metric not found
-            ALOGE("Metric '%s' not found in ProcStat", entry.name.c_str());
-            printf("Error: Metric '%s' not found in ProcStat", entry.name.c_str());
+            ALOGE("Metric '%s' offset %d not found in ProcStat", entry.name.c_str(),
+                  entry.offset);
             is_success = false;
             break;
         }
+        cur_value = *cur_pstat[i];
 
         // Find the field value from the previous read, if we need diff value
-        if (entry.update_diff) {
-            // prev_value won't change (0) if not found. So, no need to check return status.
-            getValueFromParsedProcStat(*prev_pstat, entry.name, entry.offset, &prev_value);
+        // prev_value won't change (0) if not found.
+        if (entry.update_diff && i < prev_pstat->size() && (*prev_pstat)[i].has_value()) {
+            prev_value = *(*prev_pstat)[i];
         }
 
         // Fill the atom_values array
@@ -649,7 +662,8 @@ bool MmMetricsReporter::fillProcStat(const std::vector<ProcStatMetricsInfo> &met
     }
 
     if (!is_success) {
-        prev_pstat->clear();
+        if (prev_pstat != nullptr)
+            prev_pstat->clear();
         return false;
     }
 
@@ -702,12 +716,12 @@ std::vector<VendorAtomValue> MmMetricsReporter::genPixelMmMetricsPerHour() {
     if (!MmMetricsSupported())
         return std::vector<VendorAtomValue>();
 
-    std::map<std::string, uint64_t> vmstat = readSysfsNameValue(getSysfsPath(kVmstatPath));
-    if (vmstat.size() == 0)
+    MmMetricsValues vmstat;
+    if (!readSysfsNameValue(getSysfsPath(kVmstatPath), kMmMetricsPerHourIndex, &vmstat))
         return std::vector<VendorAtomValue>();
 
-    std::map<std::string, uint64_t> meminfo = readSysfsNameValue(getSysfsPath(kMeminfoPath));
-    if (meminfo.size() == 0)
+    MmMetricsValues meminfo;
+    if (!readSysfsNameValue(getSysfsPath(kMeminfoPath), kMmMetricsPerHourIndex, &meminfo))
         return std::vector<VendorAtomValue>();
 
     uint64_t ion_total_pools = getIonTotalPools();
@@ -752,13 +766,12 @@ std::vector<VendorAtomValue> MmMetricsReporter::genPixelMmMetricsPerDay() {
     if (!MmMetricsSupported())
         return std::vector<VendorAtomValue>();
 
-    std::map<std::string, uint64_t> vmstat = readSysfsNameValue(getSysfsPath(kVmstatPath));
-    if (vmstat.size() == 0)
+    MmMetricsValues vmstat;
+    if (!readSysfsNameValue(getSysfsPath(kVmstatPath), kMmMetricsPerDayIndex, &vmstat))
         return std::vector<VendorAtomValue>();
 
-    std::map<std::string, std::vector<uint64_t>> procstat =
-            readProcStat(getSysfsPath(kProcStatPath));
-    if (procstat.size() == 0)
+    MmMetricsValues procstat;
+    if (!readProcStat(getSysfsPath(kProcStatPath), kProcStatInfo, &procstat))
         return std::vector<VendorAtomValue>();
 
     std::vector<long> direct_reclaim;
@@ -782,8 +795,11 @@ std::vector<VendorAtomValue> MmMetricsReporter::genPixelMmMetricsPerDay() {
         return std::vector<VendorAtomValue>();
     }
 
-    std::map<std::string, uint64_t> pixel_vmstat = readSysfsNameValue(
-            getSysfsPath(android::base::StringPrintf("%s/vmstat", kPixelStatMm).c_str()));
+    // A missing pixel vmstat leaves its fields out of the atom
+    MmMetricsValues pixel_vmstat;
+    readSysfsNameValue(
+            getSysfsPath(android::base::StringPrintf("%s/vmstat", kPixelStatMm).c_str()),
+            kMmMetricsPerDayIndex, &pixel_vmstat);
     if (!fillAtomValues(kMmMetricsPerDayInfo, pixel_vmstat, &prev_day_pixel_vmstat_, &values)) {
         // resets previous read since we reject the current one: so that we will
         // need two more reads to get a new diff.
@@ -810,11 +826,23 @@ std::vector<VendorAtomValue> MmMetricsReporter::genPixelMmMetricsPerDay() {
     return values;
 }
 
+/**
+ * Return true if /proc/<pid>/comm is equal to name.
+ */
+bool MmMetricsReporter::isProcessName(int pid, const std::string &name) {
+    std::string file_contents;
+    std::string path = android::base::StringPrintf("%s/%d/comm", getProcRoot().c_str(), pid);
+    if (!ReadFileToString(path, &file_contents))
+        return false;
+
+    return trimText(file_contents) == name;
+}
+
 /**
  * Return pid if /proc/<pid>/comm is equal to name, or -1 if not found.
  */
 int MmMetricsReporter::findPidByProcessName(const std::string &name) {
-    std::unique_ptr<DIR, int (*)(DIR *)> dir(opendir("/proc"), closedir);
+    std::unique_ptr<DIR, int (*)(DIR *)> dir(opendir(getProcRoot().c_str()), closedir);
     if (!dir)
         return -1;
 
@@ -830,16 +858,8 @@ int MmMetricsReporter::findPidByProcessName(const std::string &name) {
         if (pid == 1)
             continue;
 
-        std::string file_contents;
-        std::string path = android::base::StringPrintf("/proc/%s/comm", dp->d_name);
-        if (!ReadFileToString(path, &file_contents))
-            continue;
-
-        file_contents = android::base::Trim(file_contents);
-        if (file_contents.compare(name))
-            continue;
-
-        return pid;
+        if (isProcessName(pid, name))
+            return pid;
     }
     return -1;
 }
@@ -882,14 +902,19 @@ int64_t MmMetricsReporter::getStimeByPathAndVerifyName(const std::string &path,
     }
 }
 
-// returns /proc/<pid> on success, empty string on failure.
-// For test: use derived class to return custom path for test data injection.
+// returns /proc/<pid>/stat on success, empty string on failure.
+// For test: use derived class to return a custom /proc root, see getProcRoot().
 std::string MmMetricsReporter::getProcessStatPath(const std::string &name, int *prev_pid) {
     if (prev_pid == nullptr) {
         ALOGE("Should not reach here: prev_pid == nullptr");
         return "";
     }
 
+    // The kernel threads looked up here live as long as the system, so the pid found last time
+    // is almost always still right and checking its comm saves walking all of /proc.
+    if (*prev_pid > 0 && isProcessName(*prev_pid, name))
+        return android::base::StringPrintf("%s/%d/stat", getProcRoot().c_str(), *prev_pid);
+
     int pid = findPidByProcessName(name);
     if (pid <= 0) {
         ALOGE("Unable to find pid for %s, err: %s", name.c_str(), strerror(errno));
@@ -900,7 +925,7 @@ std::string MmMetricsReporter::getProcessStatPath(const std::string &name, int *
         ALOGW("%s pid changed from %d to %d.", name.c_str(), *prev_pid, pid);
     *prev_pid = pid;
 
-    return android::base::StringPrintf("/proc/%d/stat", pid);
+    return android::base::StringPrintf("%s/%d/stat", getProcRoot().c_str(), pid);
 }
 
 /**
@@ -950,17 +975,17 @@ void MmMetricsReporter::fillProcessStime(int atom_key, const std::string &name,
  * metrics_info: This is a vector of MmMetricsInfo {metric, atom_key, update_diff}.
  *               Currently, we only collect CMA metrics defined in metrics_info
  */
-std::map<std::string, uint64_t> MmMetricsReporter::readCmaStat(
+MmMetricsReporter::MmMetricsValues MmMetricsReporter::readCmaStat(
         const std::string &cma_type,
         const std::vector<MmMetricsReporter::MmMetricsInfo> &metrics_info) {
     uint64_t file_contents;
-    std::map<std::string, uint64_t> cma_stat;
-    for (auto &entry : metrics_info) {
-        std::string path = android::base::StringPrintf("%s/cma/%s/%s", kPixelStatMm,
-                                                       cma_type.c_str(), entry.name.c_str());
+    MmMetricsValues cma_stat(metrics_info.size());
+    for (size_t i = 0; i < metrics_info.size(); i++) {
+        std::string path = android::base::StringPrintf(
+                "%s/cma/%s/%s", kPixelStatMm, cma_type.c_str(), metrics_info[i].name.c_str());
         if (!ReadFileToUint(getSysfsPath(path.c_str()), &file_contents))
             continue;
-        cma_stat[entry.name] = file_contents;
+        cma_stat[i] = file_contents;
     }
     return cma_stat;
 }
@@ -1154,18 +1179,17 @@ void MmMetricsReporter::readPressureStall(const std::string &basePath, std::vect
     // loop thru all pressure stall files: cpu, io, memory
     for (int type_idx = 0; type_idx < kPsiNumFiles;
          ++type_idx, file_save_idx += kPsiMetricsPerFile) {
-        std::string file_contents;
         std::string path = getSysfsPath(basePath + '/' + kPsiTypes[type_idx]);
 
-        if (!ReadFileToString(path, &file_contents)) {
+        if (!readFileToBuffer(path)) {
             // Don't print this log if the file doesn't exist, since logs will be printed
             // repeatedly.
             if (errno != ENOENT)
                 ALOGI("Unable to read %s - %s", path.c_str(), strerror(errno));
             goto err_out;
         }
-        if (!MmMetricsReporter::parsePressureStallFileContent(type_idx == kTypeIdxCpu,
-                                                              file_contents, store, file_save_idx))
+        if (!MmMetricsReporter::parsePressureStallFileContent(type_idx == kTypeIdxCpu, read_buf_,
+                                                              store, file_save_idx))
             goto err_out;
     }
     return;
@@ -1190,33 +1214,38 @@ err_out:
  *
  * Return value: true on success, false otherwise.
  */
-bool MmMetricsReporter::parsePressureStallFileContent(bool is_cpu, const std::string &lines,
+bool MmMetricsReporter::parsePressureStallFileContent(bool is_cpu, std::string_view lines,
                                                       std::vector<long> *store, int file_save_idx) {
     constexpr int kNumOfWords = 5;  // expected number of words separated by spaces.
     constexpr int kCategoryFull = 0;
 
-    std::istringstream data(lines);
-    std::string line;
+    TextScanner data(lines);
+    std::string_view line;
 
-    while (std::getline(data, line)) {
+    while (data.nextLine(&line)) {
         int category_idx = 0;
 
-        line = android::base::Trim(line);
-        std::vector<std::string> words = android::base::Tokenize(line, " ");
-        if (words.size() != kNumOfWords) {
-            ALOGE("PSI parse fail: num of words = %d != expected %d",
-                  static_cast<int>(words.size()), kNumOfWords);
+        TextScanner tokens(trimText(line));
+        std::string_view words[kNumOfWords];
+        int num_words = 0;
+        for (std::string_view word; tokens.nextField(&word); ++num_words) {
+            if (num_words < kNumOfWords)
+                words[num_words] = word;
+        }
+        if (num_words != kNumOfWords) {
+            ALOGE("PSI parse fail: num of words = %d != expected %d", num_words, kNumOfWords);
             return false;
         }
 
         // words[0] should be either "full" or "some", the category name.
         for (auto &cat : kPsiCategories) {
-            if (words[0].compare(cat) == 0)
+            if (words[0] == cat)
                 break;
             ++category_idx;
         }
         if (category_idx == kPsiNumCategories) {
-            ALOGE("PSI parse fail: unknown category %s", words[0].c_str());
+            ALOGE("PSI parse fail: unknown category %.*s", static_cast<int>(words[0].size()),
+                  words[0].data());
             return false;
         }
 
@@ -1226,11 +1255,11 @@ bool MmMetricsReporter::parsePressureStallFileContent(bool is_cpu, const std::st
             continue;
         }
 
-        // Now we have separated words in a vector, e.g.
+        // Now we have separated words, e.g.
         // ["some", "avg10=2.93", "avg60=3.17", "avg300=3.15",  total=94628150260"]
         // call parsePressureStallWords to parse them.
         int line_save_idx = file_save_idx + category_idx * kPsiNumNames;
-        if (!parsePressureStallWords(words, store, line_save_idx))
+        if (!parsePressureStallWords(words, num_words, store, line_save_idx))
             return false;
     }
     return true;
@@ -1241,23 +1270,28 @@ bool MmMetricsReporter::parsePressureStallFileContent(bool is_cpu, const std::st
 // from a line (category) in a pressure stall file.
 //
 // words: the split words in the form of "name=value"
+// num_words: the number of words
 // store: the output vector
 // line_save_idx: the base start index to save in vector for this line (category)
 //
 // Return value: true on success, false otherwise.
-bool MmMetricsReporter::parsePressureStallWords(const std::vector<std::string> &words,
+bool MmMetricsReporter::parsePressureStallWords(const std::string_view *words, int num_words,
                                                 std::vector<long> *store, int line_save_idx) {
     // Skip the first word, which is already parsed by the caller.
     // All others are value pairs in "name=value" form.
     // e.g. ["some", "avg10=0.00", "avg60=0.00", "avg300=0.00", "total=29705314"]
     // "some" is skipped.
-    for (int i = 1; i < words.size(); ++i) {
-        std::vector<std::string> metric = android::base::Tokenize(words[i], "=");
-        if (metric.size() != 2) {
+    for (int i = 1; i < num_words; ++i) {
+        TextScanner metric(words[i]);
+        std::string_view name;
+        std::string_view value;
+        std::string_view extra;
+        if (!metric.nextField(&name, "=") || !metric.nextField(&value, "=") ||
+            metric.nextField(&extra, "=")) {
             ALOGE("%s: parse error (name=value) @ idx %d", __FUNCTION__, i);
             return false;
         }
-        if (!MmMetricsReporter::savePressureMetrics(metric[0], metric[1], store, line_save_idx))
+        if (!MmMetricsReporter::savePressureMetrics(name, value, store, line_save_idx))
             return false;
     }
     return true;
@@ -1277,13 +1311,13 @@ bool MmMetricsReporter::parsePressureStallWords(const std::vector<std::string> &
 //
 // Return value: true on success, false otherwise.
 //
-bool MmMetricsReporter::savePressureMetrics(const std::string &name, const std::string &value,
+bool MmMetricsReporter::savePressureMetrics(std::string_view name, std::string_view value,
                                             std::vector<long> *store, int base_save_idx) {
     int name_idx = 0;
     constexpr int kNameIdxTotal = 3;
 
     for (auto &mn : kPsiMetricNames) {
-        if (name.compare(mn) == 0)
+        if (name == mn)
             break;
         ++name_idx;
     }
@@ -1295,18 +1329,18 @@ bool MmMetricsReporter::savePressureMetrics(const std::string &name, const std::
     long out;
     if (name_idx == kNameIdxTotal) {
         // 'total' metrics
-        unsigned long tmp;
-        if (!android::base::ParseUint(value, &tmp))
+        uint64_t tmp;
+        if (!parseUint(value, &tmp))
             out = -1;
         else
             out = tmp;
     } else {
-        // 'avg' metrics
-        double d = -1.0;
-        if (android::base::ParseDouble(value, &d))
-            out = static_cast<long>(d * 100 + 0.5);
-        else
+        // 'avg' metrics, e.g. "2.93" is saved as 293
+        int64_t tmp;
+        if (!parseHundredths(value, &tmp))
             out = -1;
+        else
+            out = tmp;
     }
 
     if (base_save_idx + name_idx >= store->size()) {
@@ -1523,17 +1557,18 @@ cleanup:
  * metrics_info: This is a vector of MmMetricsInfo {metric, atom_key, update_diff}.
  *               We only collect metrics defined in metrics_info from CMA heap path.
  * all_prev_cma_stat: This is the CMA status collected last time.
- *                    It is a map containing pairs of {type_idx, cma_stat}, and cma_stat is
- *                    a map contains pairs of {metric, cur_value}.
- *                    e.g. {CmaType::FARAWIMG, {"alloc_pages_attempts", 100000}, {...}, ....}
- *                    is collected from kPixelStatMm/cma/farawimg/alloc_pages_attempts
+ *                    It is a map containing pairs of {type_idx, cma_stat}, and cma_stat
+ *                    holds the cur_value of each metric of metrics_info.
+ *                    e.g. {CmaType::FARAWIMG, {100000, ....}}, where 100000 is
+ *                    collected from kPixelStatMm/cma/farawimg/alloc_pages_attempts
  */
 void MmMetricsReporter::reportCmaStatusAtom(
         const std::shared_ptr<IStats> &stats_client, int atom_id, const std::string &cma_type,
         int cma_name_offset, const std::vector<MmMetricsInfo> &metrics_info,
-        std::map<std::string, std::map<std::string, uint64_t>> *all_prev_cma_stat) {
-    std::map<std::string, uint64_t> cma_stat = readCmaStat(cma_type, metrics_info);
-    if (!cma_stat.empty()) {
+        std::map<std::string, MmMetricsValues> *all_prev_cma_stat) {
+    MmMetricsValues cma_stat = readCmaStat(cma_type, metrics_info);
+    if (std::any_of(cma_stat.begin(), cma_stat.end(),
+                    [](const std::optional<uint64_t> &value) { return value.has_value(); })) {
         std::vector<VendorAtomValue> values;
         VendorAtomValue tmp;
         // type is an enum value corresponding to the CMA heap name. Since CMA heap name
@@ -1542,7 +1577,7 @@ void MmMetricsReporter::reportCmaStatusAtom(
         tmp.set<VendorAtomValue::intValue>(0);
         values.push_back(tmp);
 
-        std::map<std::string, uint64_t> prev_cma_stat;
+        MmMetricsValues prev_cma_stat;
         auto entry = all_prev_cma_stat->find(cma_type);
         if (entry != all_prev_cma_stat->end())
             prev_cma_stat = entry->second;
@@ -1594,14 +1629,19 @@ void MmMetricsReporter::logCmaStatus(const std::shared_ptr<IStats> &stats_client
  * parse one line of proc fs "vendor_mm/memory_usage_by_oom_score"
  */
 std::optional<MmMetricsReporter::OomGroupMemUsage>
-MmMetricsReporter::parseMmProcessUsageByOomGroupLine(const std::string &line) {
+MmMetricsReporter::parseMmProcessUsageByOomGroupLine(std::string_view line) {
     static_assert(OOM_NUM_OF_GROUPS == oom_group_range_names.size(),
                   "Error: Number of groups must match.");
-
-    std::vector<std::string> tokens = android::base::Tokenize(line, " \t");
-    if (tokens.size() < 7) {
-        ALOGE("Error: Insufficient tokens on line: %s", line.c_str());
-        return std::nullopt;
+    constexpr int kNumTokens = 7;
+
+    TextScanner scanner(line);
+    std::string_view tokens[kNumTokens];
+    for (auto &token : tokens) {
+        if (!scanner.nextField(&token, " \t")) {
+            ALOGE("Error: Insufficient tokens on line: %.*s", static_cast<int>(line.size()),
+                  line.data());
+            return std::nullopt;
+        }
     }
 
     MmMetricsReporter::OomGroupMemUsage data;
@@ -1609,23 +1649,25 @@ MmMetricsReporter::parseMmProcessUsageByOomGroupLine(const std::string &line) {
     // Find the matching group range name and convert it to enumerate:int32_t
     auto it = std::find(oom_group_range_names.begin(), oom_group_range_names.end(), tokens[0]);
     if (it == oom_group_range_names.end()) {
-        ALOGE("Error: Unknown group range: %s", tokens[0].c_str());
+        ALOGE("Error: Unknown group range: %.*s", static_cast<int>(tokens[0].size()),
+              tokens[0].data());
         return std::nullopt;
     }
     data.oom_group =
             static_cast<OomScoreAdjGroup>(std::distance(oom_group_range_names.begin(), it));
 
-    bool success = android::base::ParseInt(tokens[1], &data.nr_task) &&
-                   android::base::ParseInt(tokens[2], &data.file_rss_kb) &&
-                   android::base::ParseInt(tokens[3], &data.anon_rss_kb) &&
-                   android::base::ParseInt(tokens[4], &data.pgtable_kb) &&
-                   android::base::ParseInt(tokens[5], &data.swap_ents_kb) &&
-                   android::base::ParseInt(tokens[6], &data.shmem_rss_kb) && data.nr_task >= 0 &&
+    bool success = parseInt(tokens[1], &data.nr_task) &&
+                   parseInt(tokens[2], &data.file_rss_kb) &&
+                   parseInt(tokens[3], &data.anon_rss_kb) &&
+                   parseInt(tokens[4], &data.pgtable_kb) &&
+                   parseInt(tokens[5], &data.swap_ents_kb) &&
+                   parseInt(tokens[6], &data.shmem_rss_kb) && data.nr_task >= 0 &&
                    data.file_rss_kb >= 0 && data.anon_rss_kb >= 0 && data.pgtable_kb >= 0 &&
                    data.swap_ents_kb >= 0 && data.shmem_rss_kb >= 0;
 
     if (!success) {
-        ALOGE("Error parsing UInt values on line: %s", line.c_str());
+        ALOGE("Error parsing UInt values on line: %.*s", static_cast<int>(line.size()),
+              line.data());
         return std::nullopt;
     }
 
@@ -1638,16 +1680,18 @@ MmMetricsReporter::parseMmProcessUsageByOomGroupLine(const std::string &line) {
 bool MmMetricsReporter::readMmProcessUsageByOomGroup(
         std::vector<MmMetricsReporter::OomGroupMemUsage> *ogusage) {
     ogusage->clear();
+    ogusage->reserve(OOM_NUM_OF_GROUPS);
     oom_usage_uid_++;  // Unique ID per read
     std::string path = getSysfsPath(kProcVendorMmUsageByOom);
 
-    std::string file_contents;
-    if (!android::base::ReadFileToString(path, &file_contents)) {
+    if (!readFileToBuffer(path)) {
         ALOGE("Error reading file: %s", path.c_str());
-        goto error_out;
+        return false;
     }
 
-    for (const auto &line : android::base::Split(file_contents, "\n")) {
+    TextScanner lines(read_buf_);
+    std::string_view line;
+    while (lines.nextLine(&line)) {
         if (line.empty() || line[0] == '#')
             continue;  // Skip the header line or an empty line
         std::optional<MmMetricsReporter::OomGroupMemUsage> parsedData =
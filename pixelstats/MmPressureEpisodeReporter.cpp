@@ -0,0 +1,286 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "pixelstats: MmPressureEpisode"
+
+#include <android-base/file.h>
+#include <android-base/properties.h>
+#include <fcntl.h>
+#include <hardware/google/pixel/pixelstats/pixelatoms.pb.h>
+#include <pixelstats/MmPressureEpisodeReporter.h>
+#include <pixelstats/StatsHelper.h>
+#include <pixelstats/TextScanner.h>
+#include <unistd.h>
+#include <utils/Log.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace android {
+namespace hardware {
+namespace google {
+namespace pixel {
+
+using aidl::android::frameworks::stats::VendorAtom;
+using aidl::android::frameworks::stats::VendorAtomValue;
+using android::hardware::google::pixel::PixelAtoms::MmMemoryPressureEpisode;
+
+namespace {
+
+constexpr char kEnableProperty[] = "persist.vendor.pixelstats.mm_pressure_episodes";
+constexpr char kPsiMemoryPath[] = "/proc/pressure/memory";
+constexpr char kVmstatPath[] = "/proc/vmstat";
+// 150ms of memory stall within 2s starts an episode. Unprivileged triggers need a window that
+// is a multiple of 2s.
+constexpr char kPsiTrigger[] = "some 150000 2000000";
+
+constexpr std::chrono::milliseconds kSamplePeriod(100);
+// An episode ends after 1s without memory stall, or is cut after 5 minutes of it
+constexpr int kQuietSamples = 10;
+constexpr std::chrono::minutes kMaxEpisode(5);
+// Quiet time after an episode before another one can start
+constexpr std::chrono::minutes kEpisodeCooldown(5);
+
+uint64_t delta(uint64_t cur, uint64_t prev) {
+    return cur > prev ? cur - prev : 0;
+}
+
+uint32_t saturatedDelta(uint64_t cur, uint64_t prev) {
+    return static_cast<uint32_t>(std::min<uint64_t>(delta(cur, prev), UINT32_MAX));
+}
+
+}  // namespace
+
+bool MmPressureEpisodeReporter::isEnabled() {
+    return android::base::GetBoolProperty(kEnableProperty, false);
+}
+
+uint32_t MmPressureEpisodeReporter::percentile(uint32_t *values, size_t count, int pct) {
+    const size_t rank = std::max<size_t>((count * pct + 99) / 100, 1) - 1;
+    std::nth_element(values, values + rank, values + count);
+    return values[rank];
+}
+
+std::shared_ptr<IStats> MmPressureEpisodeReporter::getStatsClient() {
+    return getStatsService();
+}
+
+bool MmPressureEpisodeReporter::start(EventLoop *loop) {
+    trigger_fd_.reset(open(kPsiMemoryPath, O_RDWR | O_NONBLOCK | O_CLOEXEC));
+    if (trigger_fd_ < 0) {
+        ALOGE("Unable to open %s - %s", kPsiMemoryPath, strerror(errno));
+        return false;
+    }
+    // The trigger is written with its terminating NUL
+    if (TEMP_FAILURE_RETRY(write(trigger_fd_, kPsiTrigger, sizeof(kPsiTrigger))) < 0) {
+        ALOGE("Unable to set PSI trigger \"%s\" - %s", kPsiTrigger, strerror(errno));
+        trigger_fd_.reset();
+        return false;
+    }
+    loop_ = loop;
+    return loop_->addFd(trigger_fd_, [this] { onTrigger(); }, EPOLLPRI);
+}
+
+bool MmPressureEpisodeReporter::readTotals(Totals *totals) {
+    *totals = {};
+    if (!android::base::ReadFileToString(getProcPath(kPsiMemoryPath), &read_buf_)) {
+        ALOGE("Unable to read %s - %s", kPsiMemoryPath, strerror(errno));
+        return false;
+    }
+    // some avg10=0.00 avg60=0.00 avg300=0.00 total=0
+    // full avg10=0.00 avg60=0.00 avg300=0.00 total=0
+    TextScanner lines(read_buf_);
+    std::string_view line;
+    while (lines.nextLine(&line)) {
+        TextScanner fields(line);
+        std::string_view kind;
+        std::string_view field;
+        if (!fields.nextField(&kind)) {
+            continue;
+        }
+        uint64_t *total = kind == "some"   ? &totals->some_stall_us
+                          : kind == "full" ? &totals->full_stall_us
+                                           : nullptr;
+        while (total && fields.nextField(&field)) {
+            if (field.substr(0, 6) == "total=" && !parseUint(field.substr(6), total)) {
+                ALOGE("Unable to parse %s line: %.*s", kPsiMemoryPath,
+                      static_cast<int>(line.size()), line.data());
+                return false;
+            }
+        }
+    }
+
+    if (!android::base::ReadFileToString(getProcPath(kVmstatPath), &read_buf_)) {
+        ALOGE("Unable to read %s - %s", kVmstatPath, strerror(errno));
+        return false;
+    }
+    // In Counter order
+    static constexpr std::string_view kCounterNames[NUM_COUNTERS] = {
+            "pgscan_kswapd",
+            "pgscan_direct",
+            "workingset_refault_file",
+            "pswpin",
+    };
+    lines = TextScanner(read_buf_);
+    while (lines.nextLine(&line)) {
+        TextScanner fields(line);
+        std::string_view name;
+        std::string_view value;
+        if (!fields.nextField(&name) || !fields.nextField(&value)) {
+            continue;
+        }
+        for (int i = 0; i < NUM_COUNTERS; i++) {
+            if (name == kCounterNames[i]) {
+                // A counter missing from this kernel stays zero
+                parseUint(value, &totals->counters[i]);
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+void MmPressureEpisodeReporter::onTrigger() {
+    if (startEpisode()) {
+        scheduleSample();
+    }
+}
+
+bool MmPressureEpisodeReporter::startEpisode() {
+    if (in_episode_ || now() < next_episode_start_) {
+        return false;
+    }
+    if (!readTotals(&prev_totals_)) {
+        return false;
+    }
+    in_episode_ = true;
+    episode_start_ = now();
+    episode_start_totals_ = prev_totals_;
+    sample_count_ = 0;
+    max_some_stall_us_ = 0;
+    max_full_stall_us_ = 0;
+    quiet_samples_ = 0;
+    return true;
+}
+
+void MmPressureEpisodeReporter::scheduleSample() {
+    loop_->addTimer("Pressure sample", kSamplePeriod, std::chrono::milliseconds(0),
+                    std::chrono::milliseconds(0), [this] { sample(); });
+}
+
+void MmPressureEpisodeReporter::sample() {
+    if (sampleEpisode()) {
+        scheduleSample();
+    }
+}
+
+bool MmPressureEpisodeReporter::sampleEpisode() {
+    Totals totals;
+    if (!readTotals(&totals)) {
+        in_episode_ = false;
+        return false;
+    }
+    Sample &s = ring_[sample_count_++ % kRingSize];
+    s.some_stall_us = saturatedDelta(totals.some_stall_us, prev_totals_.some_stall_us);
+    s.full_stall_us = saturatedDelta(totals.full_stall_us, prev_totals_.full_stall_us);
+    prev_totals_ = totals;
+    max_some_stall_us_ = std::max(max_some_stall_us_, s.some_stall_us);
+    max_full_stall_us_ = std::max(max_full_stall_us_, s.full_stall_us);
+    quiet_samples_ = s.some_stall_us ? 0 : quiet_samples_ + 1;
+
+    if (quiet_samples_ < kQuietSamples && now() - episode_start_ < kMaxEpisode) {
+        return true;
+    }
+    in_episode_ = false;
+    next_episode_start_ = now() + kEpisodeCooldown;
+    const std::shared_ptr<IStats> stats_client = getStatsClient();
+    if (!stats_client) {
+        ALOGE("Unable to get AIDL Stats service");
+        return false;
+    }
+    reportEpisode(stats_client);
+    return false;
+}
+
+void MmPressureEpisodeReporter::reportEpisode(const std::shared_ptr<IStats> &stats_client) {
+    // The episode ends with its last stalled sample, the quiet samples which ended it would
+    // pull the percentiles toward zero
+    const size_t quiet = std::min<size_t>(quiet_samples_, sample_count_);
+    const size_t end = sample_count_ - quiet;
+    const size_t begin = sample_count_ > kRingSize ? sample_count_ - kRingSize : 0;
+    size_t count = 0;
+    std::array<uint32_t, kRingSize> some;
+    std::array<uint32_t, kRingSize> full;
+    for (size_t i = begin; i < end; i++, count++) {
+        some[count] = ring_[i % kRingSize].some_stall_us;
+        full[count] = ring_[i % kRingSize].full_stall_us;
+    }
+    auto stallPercentile = [count](std::array<uint32_t, kRingSize> &values, int pct) {
+        return count ? percentile(values.data(), count, pct) : 0;
+    };
+    const int64_t duration_ms =
+            std::chrono::duration_cast<std::chrono::milliseconds>(now() - episode_start_ -
+                                                                  quiet * kSamplePeriod)
+                    .count();
+
+    std::vector<VendorAtomValue> values(MmMemoryPressureEpisode::kPswpinFieldNumber -
+                                        kVendorAtomOffset + 1);
+    auto setInt = [&values](int field, int32_t value) {
+        values[field - kVendorAtomOffset].set<VendorAtomValue::intValue>(value);
+    };
+    auto setLong = [&values](int field, int64_t value) {
+        values[field - kVendorAtomOffset].set<VendorAtomValue::longValue>(value);
+    };
+    setLong(MmMemoryPressureEpisode::kDurationMsFieldNumber, duration_ms);
+    setInt(MmMemoryPressureEpisode::kSamplePeriodMsFieldNumber, kSamplePeriod.count());
+    setInt(MmMemoryPressureEpisode::kSampleCountFieldNumber, end);
+    setLong(MmMemoryPressureEpisode::kSomeStallTotalUsFieldNumber,
+            delta(prev_totals_.some_stall_us, episode_start_totals_.some_stall_us));
+    setLong(MmMemoryPressureEpisode::kFullStallTotalUsFieldNumber,
+            delta(prev_totals_.full_stall_us, episode_start_totals_.full_stall_us));
+    setInt(MmMemoryPressureEpisode::kSomeStallP50UsFieldNumber, stallPercentile(some, 50));
+    setInt(MmMemoryPressureEpisode::kSomeStallP90UsFieldNumber, stallPercentile(some, 90));
+    setInt(MmMemoryPressureEpisode::kSomeStallP99UsFieldNumber, stallPercentile(some, 99));
+    setInt(MmMemoryPressureEpisode::kSomeStallMaxUsFieldNumber, max_some_stall_us_);
+    setInt(MmMemoryPressureEpisode::kFullStallP50UsFieldNumber, stallPercentile(full, 50));
+    setInt(MmMemoryPressureEpisode::kFullStallP90UsFieldNumber, stallPercentile(full, 90));
+    setInt(MmMemoryPressureEpisode::kFullStallP99UsFieldNumber, stallPercentile(full, 99));
+    setInt(MmMemoryPressureEpisode::kFullStallMaxUsFieldNumber, max_full_stall_us_);
+    // In Counter order
+    static constexpr int kCounterFields[NUM_COUNTERS] = {
+            MmMemoryPressureEpisode::kPgscanKswapdFieldNumber,
+            MmMemoryPressureEpisode::kPgscanDirectFieldNumber,
+            MmMemoryPressureEpisode::kWorkingsetRefaultFileFieldNumber,
+            MmMemoryPressureEpisode::kPswpinFieldNumber,
+    };
+    for (int i = 0; i < NUM_COUNTERS; i++) {
+        setLong(kCounterFields[i],
+                delta(prev_totals_.counters[i], episode_start_totals_.counters[i]));
+    }
+
+    VendorAtom event = {.reverseDomainName = "",
+                        .atomId = PixelAtoms::Atom::kMmMemoryPressureEpisode,
+                        .values = std::move(values)};
+    const ndk::ScopedAStatus ret = stats_client->reportVendorAtom(event);
+    if (!ret.isOk()) {
+        ALOGE("Unable to report MmMemoryPressureEpisode to Stats service");
+    }
+}
+
+}  // namespace pixel
+}  // namespace google
+}  // namespace hardware
+}  // namespace android
@@ -17,12 +17,15 @@
 #include <cinttypes>
 #include <android/binder_manager.h>
 #include <android-base/file.h>
+#include <pixelstats/AsyncStatsClient.h>
 #include <pixelstats/StatsHelper.h>
 
 #define LOG_TAG "pixelstats-vendor"
 
 #include <utils/Log.h>
 
+#include <mutex>
+
 namespace android {
 namespace hardware {
 namespace google {
@@ -37,6 +40,9 @@ using android::base::ReadFileToString;
 // -2.
 const int kVendorAtomOffset = 2;
 
+// Atoms waiting for the stats service, the daily collection is the largest burst
+constexpr size_t kStatsQueueCapacity = 1024;
+
 bool fileExists(const std::string &path) {
     struct stat sb;
 
@@ -44,17 +50,25 @@ bool fileExists(const std::string &path) {
 }
 
 std::shared_ptr<IStats> getStatsService() {
-    const std::string instance = std::string() + IStats::descriptor + "/default";
-    static bool isStatsDeclared = false;
-    if (!isStatsDeclared) {
-        // It is good to cache the result - it would not be changed
-        isStatsDeclared = AServiceManager_isDeclared(instance.c_str());
-        if (!isStatsDeclared) {
+    static std::mutex stats_client_mutex;
+    static std::shared_ptr<IStats> stats_client;
+
+    std::lock_guard<std::mutex> lock(stats_client_mutex);
+    if (!stats_client) {
+        const std::string instance = std::string() + IStats::descriptor + "/default";
+        if (!AServiceManager_isDeclared(instance.c_str())) {
             ALOGE("Stats service is not registered.");
             return nullptr;
         }
+        // Callers only queue their atoms, the binder is looked up on the sender thread
+        stats_client = ndk::SharedRefBase::make<AsyncStatsClient>(
+                [instance] {
+                    return IStats::fromBinder(
+                            ndk::SpAIBinder(AServiceManager_waitForService(instance.c_str())));
+                },
+                kStatsQueueCapacity);
     }
-    return IStats::fromBinder(ndk::SpAIBinder(AServiceManager_waitForService(instance.c_str())));
+    return stats_client;
 }
 
 void reportSpeakerImpedance(const std::shared_ptr<IStats> &stats_client,
@@ -16,6 +16,7 @@
 
 #include <pixelstats/StatsHelper.h>
 #include <pixelstats/SysfsCollector.h>
+#include <pixelstats/SysfsMetrics.h>
 
 #define LOG_TAG "pixelstats-vendor"
 
@@ -28,8 +29,8 @@
 #include <utils/Timers.h>
 
 #include <mntent.h>
-#include <sys/timerfd.h>
 #include <sys/vfs.h>
+#include <chrono>
 #include <cinttypes>
 #include <string>
 
@@ -84,6 +85,11 @@ using android::hardware::google::pixel::PixelAtoms::VendorTempResidencyStats;
 using android::hardware::google::pixel::PixelAtoms::ZramBdStat;
 using android::hardware::google::pixel::PixelAtoms::ZramMmStat;
 
+// Threads for the daily reporter groups, a group blocked in a read holds on to one of them
+constexpr size_t kDailyWorkers = 4;
+constexpr std::chrono::seconds kDailyReporterTimeout(30);
+constexpr std::chrono::minutes kDailyPassTimeout(3);
+
 SysfsCollector::SysfsCollector(const struct SysfsPaths &sysfs_paths)
     : kSlowioReadCntPath(sysfs_paths.SlowioReadCntPath),
       kSlowioWriteCntPath(sysfs_paths.SlowioWriteCntPath),
@@ -224,13 +230,7 @@ void SysfsCollector::logBatteryEEPROM(const std::shared_ptr<IStats> &stats_clien
 /**
  * Log battery history validation
  */
-void SysfsCollector::logBatteryHistoryValidation() {
-    const std::shared_ptr<IStats> stats_client = getStatsService();
-    if (!stats_client) {
-        ALOGE("Unable to get AIDL Stats service");
-        return;
-    }
-
+void SysfsCollector::logBatteryHistoryValidation(const std::shared_ptr<IStats> &stats_client) {
     battery_EEPROM_reporter_.checkAndReportValidation(stats_client, kFGLogBufferPath);
 }
 
@@ -516,7 +516,6 @@ void SysfsCollector::logSpeechDspStat(const std::shared_ptr<IStats> &stats_clien
 }
 
 void SysfsCollector::logBatteryCapacity(const std::shared_ptr<IStats> &stats_client) {
-    std::string file_contents;
     if (kBatteryCapacityCC == nullptr || strlen(kBatteryCapacityCC) == 0) {
         ALOGV("Battery Capacity CC path not specified");
         return;
@@ -525,30 +524,16 @@ void SysfsCollector::logBatteryCapacity(const std::shared_ptr<IStats> &stats_cli
         ALOGV("Battery Capacity VFSOC path not specified");
         return;
     }
-    int delta_cc_sum, delta_vfsoc_sum;
-    if (!ReadFileToInt(kBatteryCapacityCC, &delta_cc_sum) ||
-            !ReadFileToInt(kBatteryCapacityVFSOC, &delta_vfsoc_sum))
-        return;
-
-    // Load values array
-    std::vector<VendorAtomValue> values(2);
-    VendorAtomValue tmp;
-    tmp.set<VendorAtomValue::intValue>(delta_cc_sum);
-    values[BatteryCapacity::kDeltaCcSumFieldNumber - kVendorAtomOffset] = tmp;
-    tmp.set<VendorAtomValue::intValue>(delta_vfsoc_sum);
-    values[BatteryCapacity::kDeltaVfsocSumFieldNumber - kVendorAtomOffset] = tmp;
-
-    // Send vendor atom to IStats HAL
-    VendorAtom event = {.reverseDomainName = "",
-                        .atomId = PixelAtoms::Atom::kBatteryCapacity,
-                        .values = std::move(values)};
-    const ndk::ScopedAStatus ret = stats_client->reportVendorAtom(event);
-    if (!ret.isOk())
-        ALOGE("Unable to report ChargeStats to Stats service");
+    const SysfsMetricField fields[] = {
+            {kBatteryCapacityCC, BatteryCapacity::kDeltaCcSumFieldNumber, true, false},
+            {kBatteryCapacityVFSOC, BatteryCapacity::kDeltaVfsocSumFieldNumber, true, false},
+    };
+    SysfsMetricReader("").report(
+            stats_client,
+            makeSysfsMetric("BatteryCapacity", PixelAtoms::Atom::kBatteryCapacity, fields));
 }
 
 void SysfsCollector::logUFSLifetime(const std::shared_ptr<IStats> &stats_client) {
-    std::string file_contents;
     if (kUFSLifetimeA == nullptr || strlen(kUFSLifetimeA) == 0) {
         ALOGV("UFS lifetimeA path not specified");
         return;
@@ -561,33 +546,14 @@ void SysfsCollector::logUFSLifetime(const std::shared_ptr<IStats> &stats_client)
         ALOGV("UFS lifetimeC path not specified");
         return;
     }
-
-    int lifetimeA = 0, lifetimeB = 0, lifetimeC = 0;
-    if (!ReadFileToInt(kUFSLifetimeA, &lifetimeA) ||
-        !ReadFileToInt(kUFSLifetimeB, &lifetimeB) ||
-        !ReadFileToInt(kUFSLifetimeC, &lifetimeC)) {
-        ALOGE("Unable to read UFS lifetime : %s", strerror(errno));
-        return;
-    }
-
-    // Load values array
-    std::vector<VendorAtomValue> values(3);
-    VendorAtomValue tmp;
-    tmp.set<VendorAtomValue::intValue>(lifetimeA);
-    values[StorageUfsHealth::kLifetimeAFieldNumber - kVendorAtomOffset] = tmp;
-    tmp.set<VendorAtomValue::intValue>(lifetimeB);
-    values[StorageUfsHealth::kLifetimeBFieldNumber - kVendorAtomOffset] = tmp;
-    tmp.set<VendorAtomValue::intValue>(lifetimeC);
-    values[StorageUfsHealth::kLifetimeCFieldNumber - kVendorAtomOffset] = tmp;
-
-    // Send vendor atom to IStats HAL
-    VendorAtom event = {.reverseDomainName = "",
-                        .atomId = PixelAtoms::Atom::kStorageUfsHealth,
-                        .values = std::move(values)};
-    const ndk::ScopedAStatus ret = stats_client->reportVendorAtom(event);
-    if (!ret.isOk()) {
-        ALOGE("Unable to report UfsHealthStat to Stats service");
-    }
+    const SysfsMetricField fields[] = {
+            {kUFSLifetimeA, StorageUfsHealth::kLifetimeAFieldNumber, true, false},
+            {kUFSLifetimeB, StorageUfsHealth::kLifetimeBFieldNumber, true, false},
+            {kUFSLifetimeC, StorageUfsHealth::kLifetimeCFieldNumber, true, false},
+    };
+    SysfsMetricReader("").report(
+            stats_client,
+            makeSysfsMetric("UfsHealthStat", PixelAtoms::Atom::kStorageUfsHealth, fields));
 }
 
 void SysfsCollector::logUFSErrorStats(const std::shared_ptr<IStats> &stats_client) {
@@ -638,204 +604,64 @@ static std::string getUserDataBlock() {
     return "";
 }
 
-void SysfsCollector::logF2fsStats(const std::shared_ptr<IStats> &stats_client) {
-    int dirty, free, cp_calls_fg, gc_calls_fg, moved_block_fg, vblocks;
-    int cp_calls_bg, gc_calls_bg, moved_block_bg;
+// Nodes below /sys/fs/f2fs/<userdata block>, in the order they are read
+constexpr SysfsMetricField kF2fsStatsFields[] = {
+        {"dirty_segments", F2fsStatsInfo::kDirtySegmentsFieldNumber, false, false},
+        {"free_segments", F2fsStatsInfo::kFreeSegmentsFieldNumber, false, false},
+        {"cp_foreground_calls", F2fsStatsInfo::kCpCallsFgFieldNumber, false, false},
+        {"cp_background_calls", F2fsStatsInfo::kCpCallsBgFieldNumber, false, false},
+        {"gc_foreground_calls", F2fsStatsInfo::kGcCallsFgFieldNumber, false, false},
+        {"gc_background_calls", F2fsStatsInfo::kGcCallsBgFieldNumber, false, false},
+        {"moved_blocks_foreground", F2fsStatsInfo::kMovedBlocksFgFieldNumber, false, false},
+        {"moved_blocks_background", F2fsStatsInfo::kMovedBlocksBgFieldNumber, false, false},
+        {"avg_vblocks", F2fsStatsInfo::kValidBlocksFieldNumber, false, false},
+};
+
+constexpr SysfsMetricField kF2fsAtomicWriteFields[] = {
+        {"peak_atomic_write", F2fsAtomicWriteInfo::kPeakAtomicWriteFieldNumber, true, true},
+        {"committed_atomic_block", F2fsAtomicWriteInfo::kCommittedAtomicBlockFieldNumber, true,
+         true},
+        {"revoked_atomic_block", F2fsAtomicWriteInfo::kRevokedAtomicBlockFieldNumber, true, true},
+};
+
+constexpr SysfsMetricField kF2fsCompressionFields[] = {
+        {"compr_written_block", F2fsCompressionInfo::kComprWrittenBlocksFieldNumber, true, false},
+        {"compr_saved_block", F2fsCompressionInfo::kComprSavedBlocksFieldNumber, true, true},
+        {"compr_new_inode", F2fsCompressionInfo::kComprNewInodesFieldNumber, true, true},
+};
+
+constexpr SysfsMetric kF2fsStatsMetric =
+        makeSysfsMetric("F2fs stats", PixelAtoms::Atom::kF2FsStats, kF2fsStatsFields);
+constexpr SysfsMetric kF2fsAtomicWriteMetric = makeSysfsMetric(
+        "F2fs Atomic Write info", PixelAtoms::Atom::kF2FsAtomicWriteInfo, kF2fsAtomicWriteFields);
+constexpr SysfsMetric kF2fsCompressionMetric =
+        makeSysfsMetric("F2fs compression info", PixelAtoms::Atom::kF2FsCompressionInfo,
+                        kF2fsCompressionFields);
 
+void SysfsCollector::logF2fsStats(const std::shared_ptr<IStats> &stats_client) {
     if (kF2fsStatsPath == nullptr) {
         ALOGE("F2fs stats path not specified");
         return;
     }
-
-    const std::string userdataBlock = getUserDataBlock();
-    const std::string kF2fsStatsDir = kF2fsStatsPath + userdataBlock;
-
-    if (!ReadFileToInt(kF2fsStatsDir + "/dirty_segments", &dirty)) {
-        ALOGV("Unable to read dirty segments");
-    }
-
-    if (!ReadFileToInt(kF2fsStatsDir + "/free_segments", &free)) {
-        ALOGV("Unable to read free segments");
-    }
-
-    if (!ReadFileToInt(kF2fsStatsDir + "/cp_foreground_calls", &cp_calls_fg)) {
-        ALOGV("Unable to read cp_foreground_calls");
-    }
-
-    if (!ReadFileToInt(kF2fsStatsDir + "/cp_background_calls", &cp_calls_bg)) {
-        ALOGV("Unable to read cp_background_calls");
-    }
-
-    if (!ReadFileToInt(kF2fsStatsDir + "/gc_foreground_calls", &gc_calls_fg)) {
-        ALOGV("Unable to read gc_foreground_calls");
-    }
-
-    if (!ReadFileToInt(kF2fsStatsDir + "/gc_background_calls", &gc_calls_bg)) {
-        ALOGV("Unable to read gc_background_calls");
-    }
-
-    if (!ReadFileToInt(kF2fsStatsDir + "/moved_blocks_foreground", &moved_block_fg)) {
-        ALOGV("Unable to read moved_blocks_foreground");
-    }
-
-    if (!ReadFileToInt(kF2fsStatsDir + "/moved_blocks_background", &moved_block_bg)) {
-        ALOGV("Unable to read moved_blocks_background");
-    }
-
-    if (!ReadFileToInt(kF2fsStatsDir + "/avg_vblocks", &vblocks)) {
-        ALOGV("Unable to read avg_vblocks");
-    }
-
-    // Load values array
-    std::vector<VendorAtomValue> values(9);
-    VendorAtomValue tmp;
-    tmp.set<VendorAtomValue::intValue>(dirty);
-    values[F2fsStatsInfo::kDirtySegmentsFieldNumber - kVendorAtomOffset] = tmp;
-    tmp.set<VendorAtomValue::intValue>(free);
-    values[F2fsStatsInfo::kFreeSegmentsFieldNumber - kVendorAtomOffset] = tmp;
-    tmp.set<VendorAtomValue::intValue>(cp_calls_fg);
-    values[F2fsStatsInfo::kCpCallsFgFieldNumber - kVendorAtomOffset] = tmp;
-    tmp.set<VendorAtomValue::intValue>(cp_calls_bg);
-    values[F2fsStatsInfo::kCpCallsBgFieldNumber - kVendorAtomOffset] = tmp;
-    tmp.set<VendorAtomValue::intValue>(gc_calls_fg);
-    values[F2fsStatsInfo::kGcCallsFgFieldNumber - kVendorAtomOffset] = tmp;
-    tmp.set<VendorAtomValue::intValue>(gc_calls_bg);
-    values[F2fsStatsInfo::kGcCallsBgFieldNumber - kVendorAtomOffset] = tmp;
-    tmp.set<VendorAtomValue::intValue>(moved_block_fg);
-    values[F2fsStatsInfo::kMovedBlocksFgFieldNumber - kVendorAtomOffset] = tmp;
-    tmp.set<VendorAtomValue::intValue>(moved_block_bg);
-    values[F2fsStatsInfo::kMovedBlocksBgFieldNumber - kVendorAtomOffset] = tmp;
-    tmp.set<VendorAtomValue::intValue>(vblocks);
-    values[F2fsStatsInfo::kValidBlocksFieldNumber - kVendorAtomOffset] = tmp;
-
-    // Send vendor atom to IStats HAL
-    VendorAtom event = {.reverseDomainName = "",
-                        .atomId = PixelAtoms::Atom::kF2FsStats,
-                        .values = std::move(values)};
-    const ndk::ScopedAStatus ret = stats_client->reportVendorAtom(event);
-    if (!ret.isOk()) {
-        ALOGE("Unable to report F2fs stats to Stats service");
-    }
+    SysfsMetricReader(kF2fsStatsPath + getUserDataBlock()).report(stats_client, kF2fsStatsMetric);
 }
 
 void SysfsCollector::logF2fsAtomicWriteInfo(const std::shared_ptr<IStats> &stats_client) {
-    int peak_atomic_write, committed_atomic_block, revoked_atomic_block;
-
     if (kF2fsStatsPath == nullptr) {
         ALOGV("F2fs stats path not specified");
         return;
     }
-
-    std::string userdataBlock = getUserDataBlock();
-
-    std::string path = kF2fsStatsPath + (userdataBlock + "/peak_atomic_write");
-    if (!ReadFileToInt(path, &peak_atomic_write)) {
-        ALOGE("Unable to read peak_atomic_write");
-        return;
-    } else {
-        if (!WriteStringToFile(std::to_string(0), path)) {
-            ALOGE("Failed to write to file %s", path.c_str());
-            return;
-        }
-    }
-
-    path = kF2fsStatsPath + (userdataBlock + "/committed_atomic_block");
-    if (!ReadFileToInt(path, &committed_atomic_block)) {
-        ALOGE("Unable to read committed_atomic_block");
-        return;
-    } else {
-        if (!WriteStringToFile(std::to_string(0), path)) {
-            ALOGE("Failed to write to file %s", path.c_str());
-            return;
-        }
-    }
-
-    path = kF2fsStatsPath + (userdataBlock + "/revoked_atomic_block");
-    if (!ReadFileToInt(path, &revoked_atomic_block)) {
-        ALOGE("Unable to read revoked_atomic_block");
-        return;
-    } else {
-        if (!WriteStringToFile(std::to_string(0), path)) {
-            ALOGE("Failed to write to file %s", path.c_str());
-            return;
-        }
-    }
-
-    // Load values array
-    std::vector<VendorAtomValue> values(3);
-    values[F2fsAtomicWriteInfo::kPeakAtomicWriteFieldNumber - kVendorAtomOffset] =
-                    VendorAtomValue::make<VendorAtomValue::intValue>(peak_atomic_write);
-    values[F2fsAtomicWriteInfo::kCommittedAtomicBlockFieldNumber - kVendorAtomOffset] =
-                    VendorAtomValue::make<VendorAtomValue::intValue>(committed_atomic_block);
-    values[F2fsAtomicWriteInfo::kRevokedAtomicBlockFieldNumber - kVendorAtomOffset] =
-                    VendorAtomValue::make<VendorAtomValue::intValue>(revoked_atomic_block);
-
-    // Send vendor atom to IStats HAL
-    VendorAtom event = {.reverseDomainName = "",
-                        .atomId = PixelAtoms::Atom::kF2FsAtomicWriteInfo,
-                        .values = values};
-    const ndk::ScopedAStatus ret = stats_client->reportVendorAtom(event);
-    if (!ret.isOk()) {
-        ALOGE("Unable to report F2fs Atomic Write info to Stats service");
-    }
+    SysfsMetricReader(kF2fsStatsPath + getUserDataBlock())
+            .report(stats_client, kF2fsAtomicWriteMetric);
 }
 
 void SysfsCollector::logF2fsCompressionInfo(const std::shared_ptr<IStats> &stats_client) {
-    int compr_written_blocks, compr_saved_blocks, compr_new_inodes;
-
     if (kF2fsStatsPath == nullptr) {
         ALOGV("F2fs stats path not specified");
         return;
     }
-
-    std::string userdataBlock = getUserDataBlock();
-
-    std::string path = kF2fsStatsPath + (userdataBlock + "/compr_written_block");
-    if (!ReadFileToInt(path, &compr_written_blocks)) {
-        ALOGE("Unable to read compression written blocks");
-        return;
-    }
-
-    path = kF2fsStatsPath + (userdataBlock + "/compr_saved_block");
-    if (!ReadFileToInt(path, &compr_saved_blocks)) {
-        ALOGE("Unable to read compression saved blocks");
-        return;
-    } else {
-        if (!WriteStringToFile(std::to_string(0), path)) {
-            ALOGE("Failed to write to file %s", path.c_str());
-            return;
-        }
-    }
-
-    path = kF2fsStatsPath + (userdataBlock + "/compr_new_inode");
-    if (!ReadFileToInt(path, &compr_new_inodes)) {
-        ALOGE("Unable to read compression new inodes");
-        return;
-    } else {
-        if (!WriteStringToFile(std::to_string(0), path)) {
-            ALOGE("Failed to write to file %s", path.c_str());
-            return;
-        }
-    }
-
-    // Load values array
-    std::vector<VendorAtomValue> values(3);
-    VendorAtomValue tmp;
-    tmp.set<VendorAtomValue::intValue>(compr_written_blocks);
-    values[F2fsCompressionInfo::kComprWrittenBlocksFieldNumber - kVendorAtomOffset] = tmp;
-    tmp.set<VendorAtomValue::intValue>(compr_saved_blocks);
-    values[F2fsCompressionInfo::kComprSavedBlocksFieldNumber - kVendorAtomOffset] = tmp;
-    tmp.set<VendorAtomValue::intValue>(compr_new_inodes);
-    values[F2fsCompressionInfo::kComprNewInodesFieldNumber - kVendorAtomOffset] = tmp;
-
-    // Send vendor atom to IStats HAL
-    VendorAtom event = {.reverseDomainName = "",
-                        .atomId = PixelAtoms::Atom::kF2FsCompressionInfo,
-                        .values = values};
-    const ndk::ScopedAStatus ret = stats_client->reportVendorAtom(event);
-    if (!ret.isOk()) {
-        ALOGE("Unable to report F2fs compression info to Stats service");
-    }
+    SysfsMetricReader(kF2fsStatsPath + getUserDataBlock())
+            .report(stats_client, kF2fsCompressionMetric);
 }
 
 int SysfsCollector::getReclaimedSegments(const std::string &mode) {
@@ -2112,6 +1938,71 @@ void SysfsCollector::logMitigationDurationCounts(const std::shared_ptr<IStats> &
     mitigation_duration_reporter_.logMitigationDuration(stats_client, kPowerMitigationDurationPath);
 }
 
+void SysfsCollector::initDailyReporters() {
+    using std::placeholders::_1;
+    daily_reporters_ = std::make_unique<DailyReporterRunner>(kDailyWorkers, kDailyReporterTimeout,
+                                                             kDailyPassTimeout);
+    const auto add_group = [this](const char *name,
+                                  std::vector<DailyReporterRunner::Reporter> reporters) {
+        daily_reporters_->addGroup(name, std::move(reporters));
+    };
+#define DAILY_REPORTER(fn) \
+    { #fn, std::bind(&SysfsCollector::fn, this, _1) }
+
+    add_group("battery", {
+            DAILY_REPORTER(logBatteryCapacity),
+            DAILY_REPORTER(logBatteryChargeCycles),
+            DAILY_REPORTER(logBatteryEEPROM),
+            DAILY_REPORTER(logBatteryHealth),
+            DAILY_REPORTER(logBatteryTTF),
+            DAILY_REPORTER(logBatteryHistoryValidation),
+    });
+    add_group("storage", {
+            DAILY_REPORTER(logBlockStatsReported),
+            DAILY_REPORTER(logF2fsStats),
+            DAILY_REPORTER(logF2fsAtomicWriteInfo),
+            DAILY_REPORTER(logF2fsCompressionInfo),
+            DAILY_REPORTER(logF2fsGcSegmentInfo),
+            DAILY_REPORTER(logF2fsSmartIdleMaintEnabled),
+            DAILY_REPORTER(logSlowIO),
+            DAILY_REPORTER(logUFSLifetime),
+            DAILY_REPORTER(logUFSErrorStats),
+            DAILY_REPORTER(logPartitionUsedSpace),
+    });
+    add_group("audio", {
+            DAILY_REPORTER(logCodec1Failed),
+            DAILY_REPORTER(logCodecFailed),
+            DAILY_REPORTER(logSpeakerImpedance),
+            DAILY_REPORTER(logSpeechDspStat),
+            DAILY_REPORTER(logSpeakerHealthStats),
+            DAILY_REPORTER(logVendorAudioHardwareStats),
+            DAILY_REPORTER(logVendorAudioPdmStatsReported),
+            DAILY_REPORTER(logWavesStats),
+            DAILY_REPORTER(logAdaptedInfoStats),
+            DAILY_REPORTER(logPcmUsageStats),
+            DAILY_REPORTER(logOffloadEffectsStats),
+            DAILY_REPORTER(logBluetoothAudioUsage),
+    });
+    add_group("display", {
+            DAILY_REPORTER(logDisplayStats),
+            DAILY_REPORTER(logDisplayPortStats),
+            DAILY_REPORTER(logDisplayPortDSCStats),
+            DAILY_REPORTER(logDisplayPortMaxResolutionStats),
+            DAILY_REPORTER(logHDCPStats),
+    });
+    add_group("thermal", {
+            DAILY_REPORTER(logThermalStats),
+            DAILY_REPORTER(logTempResidencyStats),
+            DAILY_REPORTER(logMitigationDurationCounts),
+    });
+    add_group("soc", {
+            DAILY_REPORTER(logVendorLongIRQStatsReported),
+            DAILY_REPORTER(logVendorResumeLatencyStats),
+            DAILY_REPORTER(logPcieLinkStats),
+    });
+#undef DAILY_REPORTER
+}
+
 void SysfsCollector::logPerDay() {
     const std::shared_ptr<IStats> stats_client = getStatsService();
     if (!stats_client) {
@@ -2122,48 +2013,15 @@ void SysfsCollector::logPerDay() {
     if (!log_once_reported) {
         logBootStats(stats_client);
     }
-    logBatteryCapacity(stats_client);
-    logBatteryChargeCycles(stats_client);
-    logBatteryEEPROM(stats_client);
-    logBatteryHealth(stats_client);
-    logBatteryTTF(stats_client);
-    logBatteryHistoryValidation();
-    logBlockStatsReported(stats_client);
-    logCodec1Failed(stats_client);
-    logCodecFailed(stats_client);
-    logDisplayStats(stats_client);
-    logDisplayPortStats(stats_client);
-    logDisplayPortDSCStats(stats_client);
-    logDisplayPortMaxResolutionStats(stats_client);
-    logHDCPStats(stats_client);
-    logF2fsStats(stats_client);
-    logF2fsAtomicWriteInfo(stats_client);
-    logF2fsCompressionInfo(stats_client);
-    logF2fsGcSegmentInfo(stats_client);
-    logF2fsSmartIdleMaintEnabled(stats_client);
-    logSlowIO(stats_client);
-    logSpeakerImpedance(stats_client);
-    logSpeechDspStat(stats_client);
-    logUFSLifetime(stats_client);
-    logUFSErrorStats(stats_client);
-    logSpeakerHealthStats(stats_client);
+    // The mm reporter is shared with the 5 min and hourly collection on this worker
     mm_metrics_reporter_.logCmaStatus(stats_client);
     mm_metrics_reporter_.logPixelMmMetricsPerDay(stats_client);
     mm_metrics_reporter_.logGcmaPerDay(stats_client);
-    logVendorAudioHardwareStats(stats_client);
-    logThermalStats(stats_client);
-    logTempResidencyStats(stats_client);
-    logVendorLongIRQStatsReported(stats_client);
-    logVendorResumeLatencyStats(stats_client);
-    logPartitionUsedSpace(stats_client);
-    logPcieLinkStats(stats_client);
-    logMitigationDurationCounts(stats_client);
-    logVendorAudioPdmStatsReported(stats_client);
-    logWavesStats(stats_client);
-    logAdaptedInfoStats(stats_client);
-    logPcmUsageStats(stats_client);
-    logOffloadEffectsStats(stats_client);
-    logBluetoothAudioUsage(stats_client);
+
+    if (!daily_reporters_) {
+        initDailyReporters();
+    }
+    daily_reporters_->run(stats_client);
 }
 
 void SysfsCollector::aggregatePer5Min() {
@@ -2208,85 +2066,68 @@ void SysfsCollector::logPerHour() {
  * IStats.
  */
 void SysfsCollector::collect(void) {
-    int timerfd = timerfd_create(CLOCK_BOOTTIME, 0);
-    if (timerfd < 0) {
-        ALOGE("Unable to create timerfd - %s", strerror(errno));
-        return;
-    }
-
-    // Sleep for 30 seconds on launch to allow codec driver to load.
-    sleep(30);
-
-    // sample & aggregate for the first time.
-    aggregatePer5Min();
-
-    // Collect first set of stats on boot.
-    logOnce();
-    logPerHour();
-    logPerDay();
-
-    struct itimerspec period;
-
-    // gcd (greatest common divisor) of all the following timings
-    constexpr int kSecondsPerWake = 5 * 60;
-
-    constexpr int kWakesPer5Min = 5 * 60 / kSecondsPerWake;
-    constexpr int kWakesPerHour = 60 * 60 / kSecondsPerWake;
-    constexpr int kWakesPerDay = 24 * 60 * 60 / kSecondsPerWake;
-
-    int wake_5min = 0;
-    int wake_hours = 0;
-    int wake_days = 0;
+    EventLoop loop;
+    // The loop is only shared with the memory pressure sampling, without it the passes run on
+    // the loop itself
+    addCollectionTimers(&loop, MmPressureEpisodeReporter::isEnabled());
+    loop.run();
+}
 
-    period.it_interval.tv_sec = kSecondsPerWake;
-    period.it_interval.tv_nsec = 0;
-    period.it_value.tv_sec = kSecondsPerWake;
-    period.it_value.tv_nsec = 0;
+/**
+ * Add the collection timers to loop, which must not outlive the collector. The collection itself
+ * runs on a worker, in order, so a slow pass never holds up the loop.
+ */
+void SysfsCollector::schedule(EventLoop *loop) {
+    addCollectionTimers(loop, true);
+}
 
-    if (timerfd_settime(timerfd, 0, &period, NULL)) {
-        ALOGE("Unable to set one hour timer - %s", strerror(errno));
-        return;
+void SysfsCollector::runPass(std::function<void()> pass) {
+    if (collect_pool_) {
+        collect_pool_->post(std::move(pass));
+    } else {
+        pass();
     }
+}
 
-    ALOGI("Time-series metrics were initiated.");
-    while (1) {
-        int readval;
-        union {
-            char buf[8];
-            uint64_t count;
-        } expire;
-
-        do {
-            errno = 0;
-            readval = read(timerfd, expire.buf, sizeof(expire.buf));
-        } while (readval < 0 && errno == EINTR);
-        if (readval < 0) {
-            ALOGE("Timerfd error - %s\n", strerror(errno));
-            return;
-        }
-
-        wake_5min += expire.count;
-        wake_hours += expire.count;
-        wake_days += expire.count;
-
-        if (wake_5min >= kWakesPer5Min) {
-            wake_5min %= kWakesPer5Min;
+/**
+ * Add the collection timers to loop. The passes run on a worker when the loop is shared, so that
+ * a slow pass never holds up the other users of the loop.
+ */
+void SysfsCollector::addCollectionTimers(EventLoop *loop, bool shared_loop) {
+    using std::chrono::hours;
+    using std::chrono::minutes;
+    using std::chrono::seconds;
+
+    // Wait 30 seconds on launch to allow codec driver to load.
+    constexpr seconds kLaunchDelay(30);
+    constexpr minutes k5Min(5);
+    constexpr hours kHour(1);
+    constexpr hours kDay(24);
+
+    if (shared_loop && !collect_pool_) {
+        collect_pool_ = std::make_unique<WorkerPool>(1);
+    }
+    loop->addTimer("Launch", kLaunchDelay, seconds(0), seconds(0), [this] {
+        runPass([this] {
+            // sample & aggregate for the first time.
             aggregatePer5Min();
-        }
-
-        if (wake_hours >= kWakesPerHour) {
-            if (wake_hours >= 2 * kWakesPerHour)
-                ALOGW("Hourly wake: sleep too much: expire.count=%" PRId64, expire.count);
-            wake_hours %= kWakesPerHour;
+            // Collect first set of stats on boot.
+            logOnce();
             logPerHour();
-        }
-
-        if (wake_days >= kWakesPerDay) {
-            if (wake_hours >= 2 * kWakesPerDay)
-                ALOGW("Daily wake: sleep too much: expire.count=%" PRId64, expire.count);
-            wake_days %= kWakesPerDay;
             logPerDay();
-        }
+            ALOGI("Time-series metrics were initiated.");
+        });
+    });
+    loop->addTimer("5 min", kLaunchDelay + k5Min, k5Min, seconds(0),
+                   [this] { runPass([this] { aggregatePer5Min(); }); });
+    // The slack lets the hourly and daily collection ride on another wakeup
+    loop->addTimer("Hourly", kLaunchDelay + kHour, kHour, minutes(10),
+                   [this] { runPass([this] { logPerHour(); }); });
+    loop->addTimer("Daily", kLaunchDelay + kDay, kDay, hours(1),
+                   [this] { runPass([this] { logPerDay(); }); });
+    // Sampled on the loop itself, only while memory is under pressure
+    if (MmPressureEpisodeReporter::isEnabled()) {
+        mm_pressure_episode_reporter_.start(loop);
     }
 }
 
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "pixelstats-vendor"
+
+#include <fcntl.h>
+#include <pixelstats/SysfsMetrics.h>
+#include <unistd.h>
+#include <utils/Log.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace android {
+namespace hardware {
+namespace google {
+namespace pixel {
+
+using aidl::android::frameworks::stats::VendorAtomValue;
+
+namespace {
+
+// Proto messages are 1-indexed and VendorAtom field numbers start at 2
+constexpr int kVendorAtomOffset = 2;
+
+}  // namespace
+
+SysfsMetricReader::SysfsMetricReader(const std::string &dir) : dir_(dir) {
+    if (dir_.empty()) {
+        return;
+    }
+    dir_fd_.reset(TEMP_FAILURE_RETRY(open(dir_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC)));
+    if (dir_fd_ < 0) {
+        ALOGE("Unable to open %s - %s", dir_.c_str(), strerror(errno));
+    }
+}
+
+bool SysfsMetricReader::readInt(const char *node, int *val) {
+    const int dir_fd = dir_.empty() ? AT_FDCWD : dir_fd_.get();
+    android::base::unique_fd fd(
+            TEMP_FAILURE_RETRY(openat(dir_fd, node, O_RDONLY | O_CLOEXEC)));
+    if (fd < 0) {
+        ALOGV("Unable to open %s/%s - %s", dir_.c_str(), node, strerror(errno));
+        return false;
+    }
+    const ssize_t len = TEMP_FAILURE_RETRY(pread(fd, buf_, sizeof(buf_) - 1, 0));
+    if (len < 0) {
+        ALOGE("Unable to read %s/%s - %s", dir_.c_str(), node, strerror(errno));
+        return false;
+    }
+    buf_[len] = '\0';
+
+    if (strncmp(buf_, "0x", 2) == 0) {
+        if (sscanf(buf_, "0x%x", val) != 1) {
+            ALOGE("Unable to convert %s/%s to hex", dir_.c_str(), node);
+            return false;
+        }
+    } else if (sscanf(buf_, "%d", val) != 1) {
+        ALOGE("Unable to convert %s/%s to int", dir_.c_str(), node);
+        return false;
+    }
+    return true;
+}
+
+bool SysfsMetricReader::resetNode(const char *node) {
+    const int dir_fd = dir_.empty() ? AT_FDCWD : dir_fd_.get();
+    android::base::unique_fd fd(
+            TEMP_FAILURE_RETRY(openat(dir_fd, node, O_WRONLY | O_TRUNC | O_CLOEXEC)));
+    if (fd < 0 || TEMP_FAILURE_RETRY(write(fd, "0", 1)) != 1) {
+        ALOGE("Failed to write to file %s/%s - %s", dir_.c_str(), node, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool SysfsMetricReader::read(const SysfsMetric &metric, VendorAtom *atom) {
+    if (!dir_.empty() && dir_fd_ < 0) {
+        return false;
+    }
+
+    int max_field_number = kVendorAtomOffset;
+    for (size_t i = 0; i < metric.num_fields; i++) {
+        max_field_number = std::max(max_field_number, metric.fields[i].field_number);
+    }
+    std::vector<VendorAtomValue> values(max_field_number - kVendorAtomOffset + 1);
+
+    for (size_t i = 0; i < metric.num_fields; i++) {
+        const SysfsMetricField &field = metric.fields[i];
+        int val = 0;
+        if (!readInt(field.node, &val)) {
+            if (field.required) {
+                ALOGE("Unable to read %s for %s", field.node, metric.name);
+                return false;
+            }
+        } else if (field.reset_after_read && !resetNode(field.node)) {
+            return false;
+        }
+        values[field.field_number - kVendorAtomOffset] =
+                VendorAtomValue::make<VendorAtomValue::intValue>(val);
+    }
+
+    atom->reverseDomainName = "";
+    atom->atomId = metric.atom_id;
+    atom->values = std::move(values);
+    return true;
+}
+
+void SysfsMetricReader::report(const std::shared_ptr<IStats> &stats_client,
+                               const SysfsMetric &metric) {
+    VendorAtom event;
+    if (!read(metric, &event)) {
+        return;
+    }
+    const ndk::ScopedAStatus ret = stats_client->reportVendorAtom(event);
+    if (!ret.isOk()) {
+        ALOGE("Unable to report %s to Stats service", metric.name);
+    }
+}
+
+}  // namespace pixel
+}  // namespace google
+}  // namespace hardware
+}  // namespace android
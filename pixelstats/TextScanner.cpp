@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ctype.h>
+#include <pixelstats/TextScanner.h>
+
+#include <charconv>
+
+namespace android {
+namespace hardware {
+namespace google {
+namespace pixel {
+
+namespace {
+
+template <typename T>
+bool parseNumber(std::string_view text, T *val) {
+    int base = 10;
+    if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+        text.remove_prefix(2);
+        base = 16;
+    }
+    const char *end = text.data() + text.size();
+    const auto [ptr, ec] = std::from_chars(text.data(), end, *val, base);
+    return !text.empty() && ec == std::errc() && ptr == end;
+}
+
+}  // namespace
+
+bool TextScanner::nextLine(std::string_view *line) {
+    if (text_.empty()) {
+        return false;
+    }
+    const size_t end = text_.find('\n');
+    *line = text_.substr(0, end);
+    text_.remove_prefix(end == std::string_view::npos ? text_.size() : end + 1);
+    return true;
+}
+
+bool TextScanner::nextField(std::string_view *field, std::string_view delims) {
+    const size_t begin = text_.find_first_not_of(delims);
+    if (begin == std::string_view::npos) {
+        text_ = {};
+        return false;
+    }
+    text_.remove_prefix(begin);
+    const size_t end = text_.find_first_of(delims);
+    *field = text_.substr(0, end);
+    text_.remove_prefix(end == std::string_view::npos ? text_.size() : end);
+    return true;
+}
+
+std::string_view trimText(std::string_view text) {
+    while (!text.empty() && isspace(static_cast<unsigned char>(text.front()))) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && isspace(static_cast<unsigned char>(text.back()))) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+bool parseUint(std::string_view text, uint64_t *val) {
+    return parseNumber(text, val);
+}
+
+bool parseInt(std::string_view text, int64_t *val) {
+    return parseNumber(text, val);
+}
+
+bool parseHundredths(std::string_view text, int64_t *val) {
+    const size_t dot = text.find('.');
+    uint64_t whole;
+    if (!parseUint(text.substr(0, dot), &whole)) {
+        return false;
+    }
+    int64_t hundredths = whole * 100;
+    if (dot != std::string_view::npos) {
+        const std::string_view fraction = text.substr(dot + 1);
+        int scale = 10;
+        for (size_t i = 0; i < fraction.size(); i++) {
+            if (!isdigit(static_cast<unsigned char>(fraction[i]))) {
+                return false;
+            }
+            if (i < 2) {
+                hundredths += (fraction[i] - '0') * scale;
+                scale /= 10;
+            } else if (i == 2 && fraction[i] >= '5') {
+                hundredths++;
+            }
+        }
+    }
+    *val = hundredths;
+    return true;
+}
+
+}  // namespace pixel
+}  // namespace google
+}  // namespace hardware
+}  // namespace android
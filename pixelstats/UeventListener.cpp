@@ -45,10 +45,12 @@
 #include <cutils/uevent.h>
 #include <fcntl.h>
 #include <hardware/google/pixel/pixelstats/pixelatoms.pb.h>
+#include <linux/netlink.h>
 #include <linux/thermal.h>
 #include <log/log.h>
 #include <pixelstats/StatsHelper.h>
 #include <pixelstats/UeventListener.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -74,6 +76,10 @@ using android::hardware::google::pixel::PixelAtoms::VendorHardwareFailed;
 using android::hardware::google::pixel::PixelAtoms::VendorUsbPortOverheat;
 
 constexpr int32_t UEVENT_MSG_LEN = 2048;  // it's 2048 in all other users.
+// Uevents taken from the socket per recvmmsg()
+constexpr int kUeventBatchSize = 16;
+// Stop listening after this many failed ProcessUevent() calls in a row, to prevent spinning
+constexpr int kMaxConsecutiveErrors = 10;
 constexpr int32_t PRODUCT_TYPE_OFFSET = 23;
 constexpr int32_t PRODUCT_TYPE_MASK = 7;
 constexpr int32_t PRODUCT_TYPE_CHARGER = 3;
@@ -82,8 +88,6 @@ constexpr int32_t VID_GOOGLE = 0x18d1;
 constexpr int32_t PID_OFFSET = 2;
 constexpr int32_t PID_LENGTH = 4;
 constexpr uint32_t PID_P30 = 0x4f05;
-constexpr const char *THERMAL_ABNORMAL_INFO_EQ = "THERMAL_ABNORMAL_INFO=";
-constexpr const char *THERMAL_ABNORMAL_TYPE_EQ = "THERMAL_ABNORMAL_TYPE=";
 
 bool UeventListener::ReadFileToInt(const std::string &path, int *val) {
     return ReadFileToInt(path.c_str(), val);
@@ -113,49 +117,42 @@ void UeventListener::ReportMicBrokenOrDegraded(const std::shared_ptr<IStats> &st
 }
 
 void UeventListener::ReportMicStatusUevents(const std::shared_ptr<IStats> &stats_client,
-                                            const char *devpath, const char *mic_status) {
-    if (!devpath || !mic_status)
+                                            const char *mic_status) {
+    if (!mic_status)
         return;
-    if (!strcmp(devpath, ("DEVPATH=" + kAudioUevent).c_str())) {
-        std::vector<std::string> value = android::base::Split(mic_status, "=");
-        bool isbroken;
-
-        if (value.size() == 2) {
-            if (!value[0].compare("MIC_BREAK_STATUS"))
-                isbroken = true;
-            else if (!value[0].compare("MIC_DEGRADE_STATUS"))
-                isbroken = false;
-            else
+    std::vector<std::string> value = android::base::Split(mic_status, "=");
+    bool isbroken;
+
+    if (value.size() == 2) {
+        if (!value[0].compare("MIC_BREAK_STATUS"))
+            isbroken = true;
+        else if (!value[0].compare("MIC_DEGRADE_STATUS"))
+            isbroken = false;
+        else
+            return;
+
+        if (!value[1].compare("true")) {
+            ReportMicBrokenOrDegraded(stats_client, 0, isbroken);
+        } else {
+            int mic_status = atoi(value[1].c_str());
+
+            if (mic_status > 0 && mic_status <= 7) {
+                for (int mic_bit = 0; mic_bit < 3; mic_bit++)
+                    if (mic_status & (0x1 << mic_bit))
+                        ReportMicBrokenOrDegraded(stats_client, mic_bit, isbroken);
+            } else if (mic_status == 0) {
+                // mic is ok
                 return;
-
-            if (!value[1].compare("true")) {
-                ReportMicBrokenOrDegraded(stats_client, 0, isbroken);
             } else {
-                int mic_status = atoi(value[1].c_str());
-
-                if (mic_status > 0 && mic_status <= 7) {
-                    for (int mic_bit = 0; mic_bit < 3; mic_bit++)
-                        if (mic_status & (0x1 << mic_bit))
-                            ReportMicBrokenOrDegraded(stats_client, mic_bit, isbroken);
-                } else if (mic_status == 0) {
-                    // mic is ok
-                    return;
-                } else {
-                    // should not enter here
-                    ALOGE("invalid mic status");
-                    return;
-                }
+                // should not enter here
+                ALOGE("invalid mic status");
+                return;
             }
         }
     }
 }
 
-void UeventListener::ReportUsbPortOverheatEvent(const std::shared_ptr<IStats> &stats_client,
-                                                const char *driver) {
-    if (!driver || strcmp(driver, "DRIVER=google,overheat_mitigation")) {
-        return;
-    }
-
+void UeventListener::ReportUsbPortOverheatEvent(const std::shared_ptr<IStats> &stats_client) {
     int32_t plug_temperature_deci_c = 0;
     int32_t max_temperature_deci_c = 0;
     int32_t time_to_overheat_secs = 0;
@@ -179,21 +176,11 @@ void UeventListener::ReportUsbPortOverheatEvent(const std::shared_ptr<IStats> &s
     reportUsbPortOverheat(stats_client, overheat_info);
 }
 
-void UeventListener::ReportChargeMetricsEvent(const std::shared_ptr<IStats> &stats_client,
-                                              const char *driver) {
-    if (!driver || strcmp(driver, "DRIVER=google,battery")) {
-        return;
-    }
-
+void UeventListener::ReportChargeMetricsEvent(const std::shared_ptr<IStats> &stats_client) {
     charge_stats_reporter_.checkAndReport(stats_client, kChargeMetricsPath);
 }
 
-void UeventListener::ReportFGMetricsEvent(const std::shared_ptr<IStats> &stats_client,
-                                              const char *driver) {
-    if (!driver || (strcmp(driver, "DRIVER=max77779-fg") && strcmp(driver, "DRIVER=maxfg") &&
-        strcmp(driver, "DRIVER=max1720x")))
-        return;
-
+void UeventListener::ReportFGMetricsEvent(const std::shared_ptr<IStats> &stats_client) {
     battery_fg_reporter_.checkAndReportFwUpdate(stats_client, kFwUpdatePath);
     battery_fg_reporter_.checkAndReportFGAbnormality(stats_client, kFGAbnlPath);
 }
@@ -215,17 +202,7 @@ void UeventListener::ReportFGMetricsEvent(const std::shared_ptr<IStats> &stats_c
  *      5. When there is a difference of >= 4 percent between the raw hardware
  *          battery capacity and the system reported battery capacity.
  */
-void UeventListener::ReportBatteryCapacityFGEvent(const std::shared_ptr<IStats> &stats_client,
-                                                  const char *subsystem) {
-    if (!subsystem || strcmp(subsystem, "SUBSYSTEM=power_supply")) {
-        return;
-    }
-
-    // Indicates an implicit disable of the battery capacity reporting
-    if (kBatterySSOCPath.empty()) {
-        return;
-    }
-
+void UeventListener::ReportBatteryCapacityFGEvent(const std::shared_ptr<IStats> &stats_client) {
     battery_capacity_reporter_.checkAndReport(stats_client, kBatterySSOCPath);
 }
 
@@ -286,10 +263,9 @@ void UeventListener::ReportTypeCPartnerId(const std::shared_ptr<IStats> &stats_c
     }
 }
 
-void UeventListener::ReportGpuEvent(const std::shared_ptr<IStats> &stats_client, const char *driver,
+void UeventListener::ReportGpuEvent(const std::shared_ptr<IStats> &stats_client,
                                     const char *gpu_event_type, const char *gpu_event_info) {
-    if (!stats_client || !driver || strncmp(driver, "DRIVER=mali", strlen("DRIVER=mali")) ||
-        !gpu_event_type || !gpu_event_info)
+    if (!gpu_event_type || !gpu_event_info)
         return;
 
     std::vector<std::string> type = android::base::Split(gpu_event_type, "=");
@@ -325,13 +301,9 @@ void UeventListener::ReportGpuEvent(const std::shared_ptr<IStats> &stats_client,
  *      3. thermistor or tj showing very low temperature reading
  */
 void UeventListener::ReportThermalAbnormalEvent(const std::shared_ptr<IStats> &stats_client,
-                                                const char *devpath,
                                                 const char *thermal_abnormal_event_type,
                                                 const char *thermal_abnormal_event_info) {
-    if (!stats_client || !devpath ||
-        strncmp(devpath, "DEVPATH=/module/pixel_metrics",
-                strlen("DEVPATH=/module/pixel_metrics")) ||
-        !thermal_abnormal_event_type || !thermal_abnormal_event_info)
+    if (!thermal_abnormal_event_type || !thermal_abnormal_event_info)
         return;
     ALOGD("Thermal Abnormal Type: %s, Thermal Abnormal Info: %s", thermal_abnormal_event_type,
           thermal_abnormal_event_info);
@@ -395,17 +367,142 @@ void UeventListener::ReportThermalAbnormalEvent(const std::shared_ptr<IStats> &s
         ALOGE("Unable to report Thermal Abnormal event.");
 }
 
-bool UeventListener::ProcessUevent() {
-    char msg[UEVENT_MSG_LEN + 2];
-    char *cp;
-    const char *driver, *product, *subsystem;
-    const char *mic_break_status, *mic_degrade_status;
-    const char *devpath;
-    bool collect_partner_id = false;
-    const char *gpu_event_type = nullptr, *gpu_event_info = nullptr;
-    const char *thermal_abnormal_event_type = nullptr, *thermal_abnormal_event_info = nullptr;
-    int n;
+/**
+ * Build the key matcher and the subscription table. A handler only gets a subscription when it is
+ * configured, so uevents for a disabled report are dropped like any other.
+ */
+void UeventListener::InitUeventDispatch() {
+    const std::pair<std::string, UeventKey> keys[] = {
+            {"DRIVER", kUeventDriver},
+            {"DEVPATH", kUeventDevpath},
+            {"SUBSYSTEM", kUeventSubsystem},
+            {"MIC_BREAK_STATUS", kUeventMicBreakStatus},
+            {"MIC_DEGRADE_STATUS", kUeventMicDegradeStatus},
+            {"GPU_UEVENT_TYPE", kUeventGpuEventType},
+            {"GPU_UEVENT_INFO", kUeventGpuEventInfo},
+            {"THERMAL_ABNORMAL_TYPE", kUeventThermalAbnormalType},
+            {"THERMAL_ABNORMAL_INFO", kUeventThermalAbnormalInfo},
+            {kTypeCPartnerUevent.substr(0, kTypeCPartnerUevent.find('=')), kUeventTypeCPartner},
+    };
+    for (const auto &key : keys) {
+        if (key.first.size() >= uevent_keys_by_length_.size()) {
+            uevent_keys_by_length_.resize(key.first.size() + 1);
+        }
+        uevent_keys_by_length_[key.first.size()].push_back(key);
+    }
+
+    // In the order the reports were always sent
+    if (!kAudioUevent.empty()) {
+        subscriptions_.push_back({"ReportMicStatusUevents", kUeventDevpath,
+                                  "DEVPATH=" + kAudioUevent, false,
+                                  [this](const auto &stats_client, const auto &fields) {
+                                      ReportMicStatusUevents(stats_client,
+                                                             fields[kUeventMicBreakStatus]);
+                                      ReportMicStatusUevents(stats_client,
+                                                             fields[kUeventMicDegradeStatus]);
+                                  }});
+    }
+    subscriptions_.push_back({"ReportUsbPortOverheatEvent", kUeventDriver,
+                              "DRIVER=google,overheat_mitigation", false,
+                              [this](const auto &stats_client, const auto &) {
+                                  ReportUsbPortOverheatEvent(stats_client);
+                              }});
+    subscriptions_.push_back({"ReportChargeMetricsEvent", kUeventDriver,
+                              "DRIVER=google,battery", false,
+                              [this](const auto &stats_client, const auto &) {
+                                  ReportChargeMetricsEvent(stats_client);
+                              }});
+    // An empty ssoc path indicates an implicit disable of the battery capacity reporting
+    if (!kBatterySSOCPath.empty()) {
+        subscriptions_.push_back({"ReportBatteryCapacityFGEvent", kUeventSubsystem,
+                                  "SUBSYSTEM=power_supply", false,
+                                  [this](const auto &stats_client, const auto &) {
+                                      ReportBatteryCapacityFGEvent(stats_client);
+                                  }});
+    }
+    subscriptions_.push_back({"ReportTypeCPartnerId", kUeventTypeCPartner,
+                              kTypeCPartnerUevent, true,
+                              [this](const auto &stats_client, const auto &) {
+                                  ReportTypeCPartnerId(stats_client);
+                              }});
+    subscriptions_.push_back({"ReportGpuEvent", kUeventDriver, "DRIVER=mali", true,
+                              [this](const auto &stats_client, const auto &fields) {
+                                  ReportGpuEvent(stats_client, fields[kUeventGpuEventType],
+                                                 fields[kUeventGpuEventInfo]);
+                              }});
+    subscriptions_.push_back({"ReportThermalAbnormalEvent", kUeventDevpath,
+                              "DEVPATH=/module/pixel_metrics", true,
+                              [this](const auto &stats_client, const auto &fields) {
+                                  ReportThermalAbnormalEvent(stats_client,
+                                                             fields[kUeventThermalAbnormalType],
+                                                             fields[kUeventThermalAbnormalInfo]);
+                              }});
+    for (const char *fg_driver : {"DRIVER=max77779-fg", "DRIVER=maxfg", "DRIVER=max1720x"}) {
+        subscriptions_.push_back({"ReportFGMetricsEvent", kUeventDriver, fg_driver, false,
+                                  [this](const auto &stats_client, const auto &) {
+                                      ReportFGMetricsEvent(stats_client);
+                                  }});
+    }
+}
+
+/**
+ * msg is a sequence of null-terminated "KEY=value" strings, a double null indicates the end of
+ * the message. Record the fields whose key is looked at by a handler.
+ */
+void UeventListener::ParseUevent(const char *msg, UeventFields *fields) {
+    fields->fill(nullptr);
+    const char *cp = msg;
+    while (*cp) {
+        const size_t len = strlen(cp);
+        if (log_fd_ > 0) {
+            write(log_fd_, cp, len);
+            write(log_fd_, "\n", 1);
+        }
+
+        const char *eq = static_cast<const char *>(memchr(cp, '=', len));
+        const size_t key_len = eq ? eq - cp : 0;
+        if (key_len > 0 && key_len < uevent_keys_by_length_.size()) {
+            for (const auto &[key, index] : uevent_keys_by_length_[key_len]) {
+                if (!memcmp(cp, key.data(), key_len)) {
+                    (*fields)[index] = cp;
+                }
+            }
+        }
+        cp += len + 1;
+    }
+}
+
+void UeventListener::DispatchUevent(const UeventFields &fields) {
+    std::vector<const UeventSubscription *> matched;
+    for (const auto &subscription : subscriptions_) {
+        const char *field = fields[subscription.key];
+        if (!field) {
+            continue;
+        }
+        if (subscription.prefix
+                    ? !strncmp(field, subscription.match.c_str(), subscription.match.size())
+                    : !strcmp(field, subscription.match.c_str())) {
+            matched.push_back(&subscription);
+        }
+    }
+    if (!matched.empty()) {
+        RunUeventHandlers(matched, fields);
+    }
+}
+
+void UeventListener::RunUeventHandlers(const std::vector<const UeventSubscription *> &matched,
+                                       const UeventFields &fields) {
+    std::shared_ptr<IStats> stats_client = getStatsService();
+    if (!stats_client) {
+        ALOGE("Unable to get Stats service instance.");
+        return;
+    }
+    for (const UeventSubscription *subscription : matched) {
+        subscription->handler(stats_client, fields);
+    }
+}
 
+bool UeventListener::OpenUeventSocket() {
     if (uevent_fd_ < 0) {
         uevent_fd_ = uevent_open_socket(64 * 1024, true);
         if (uevent_fd_ < 0) {
@@ -413,6 +510,20 @@ bool UeventListener::ProcessUevent() {
             return false;
         }
     }
+    return true;
+}
+
+bool UeventListener::ProcessUevent() {
+    // Ensure double-null termination of each message
+    char msgs[kUeventBatchSize][UEVENT_MSG_LEN + 2];
+    char controls[kUeventBatchSize][CMSG_SPACE(sizeof(struct ucred))];
+    struct sockaddr_nl addrs[kUeventBatchSize];
+    struct iovec iovs[kUeventBatchSize];
+    struct mmsghdr hdrs[kUeventBatchSize];
+
+    if (!OpenUeventSocket()) {
+        return false;
+    }
 
 #ifdef LOG_UEVENTS_TO_FILE_ONLY_FOR_DEVEL
     if (log_fd_ < 0) {
@@ -423,78 +534,49 @@ bool UeventListener::ProcessUevent() {
     }
 #endif
 
-    n = uevent_kernel_multicast_recv(uevent_fd_, msg, UEVENT_MSG_LEN);
-    if (n <= 0 || n >= UEVENT_MSG_LEN)
-        return false;
-
-    // Ensure double-null termination of msg.
-    msg[n] = '\0';
-    msg[n + 1] = '\0';
+    for (int i = 0; i < kUeventBatchSize; i++) {
+        iovs[i] = {msgs[i], UEVENT_MSG_LEN};
+        hdrs[i].msg_hdr = {
+                .msg_name = &addrs[i],
+                .msg_namelen = sizeof(addrs[i]),
+                .msg_iov = &iovs[i],
+                .msg_iovlen = 1,
+                .msg_control = controls[i],
+                .msg_controllen = sizeof(controls[i]),
+                .msg_flags = 0,
+        };
+    }
 
-    driver = product = subsystem = NULL;
-    mic_break_status = mic_degrade_status = devpath = NULL;
+    // Block for the first uevent, then take whatever else is already queued
+    const int n = TEMP_FAILURE_RETRY(
+            recvmmsg(uevent_fd_, hdrs, kUeventBatchSize, MSG_WAITFORONE, nullptr));
+    if (n <= 0)
+        return false;
 
-    /**
-     * msg is a sequence of null-terminated strings.
-     * Iterate through and record positions of string/value pairs of interest.
-     * Double null indicates end of the message. (enforced above).
-     */
-    cp = msg;
-    while (*cp) {
-        if (log_fd_ > 0) {
-            write(log_fd_, cp, strlen(cp));
-            write(log_fd_, "\n", 1);
+    UeventFields fields;
+    for (int i = 0; i < n; i++) {
+        const unsigned int len = hdrs[i].msg_len;
+        if (len == 0 || len >= UEVENT_MSG_LEN) {
+            continue;
         }
-
-        if (!strncmp(cp, "DRIVER=", strlen("DRIVER="))) {
-            driver = cp;
-        } else if (!strncmp(cp, "PRODUCT=", strlen("PRODUCT="))) {
-            product = cp;
-        } else if (!strncmp(cp, "MIC_BREAK_STATUS=", strlen("MIC_BREAK_STATUS="))) {
-            mic_break_status = cp;
-        } else if (!strncmp(cp, "MIC_DEGRADE_STATUS=", strlen("MIC_DEGRADE_STATUS="))) {
-            mic_degrade_status = cp;
-        } else if (!strncmp(cp, "DEVPATH=", strlen("DEVPATH="))) {
-            devpath = cp;
-        } else if (!strncmp(cp, "SUBSYSTEM=", strlen("SUBSYSTEM="))) {
-            subsystem = cp;
-        } else if (!strncmp(cp, kTypeCPartnerUevent.c_str(), kTypeCPartnerUevent.size())) {
-            collect_partner_id = true;
-        } else if (!strncmp(cp, "GPU_UEVENT_TYPE=", strlen("GPU_UEVENT_TYPE="))) {
-            gpu_event_type = cp;
-        } else if (!strncmp(cp, "GPU_UEVENT_INFO=", strlen("GPU_UEVENT_INFO="))) {
-            gpu_event_info = cp;
-        } else if (!strncmp(cp, THERMAL_ABNORMAL_TYPE_EQ, strlen(THERMAL_ABNORMAL_TYPE_EQ))) {
-            thermal_abnormal_event_type = cp;
-        } else if (!strncmp(cp, THERMAL_ABNORMAL_INFO_EQ, strlen(THERMAL_ABNORMAL_INFO_EQ))) {
-            thermal_abnormal_event_info = cp;
+        // Same checks as uevent_kernel_multicast_recv(): only accept multicasts from the kernel
+        const struct cmsghdr *cmsg = CMSG_FIRSTHDR(&hdrs[i].msg_hdr);
+        if (cmsg == nullptr || cmsg->cmsg_type != SCM_CREDENTIALS) {
+            continue;
         }
-        /* advance to after the next \0 */
-        while (*cp++) {
+        const struct ucred *cred = reinterpret_cast<const struct ucred *>(CMSG_DATA(cmsg));
+        if (cred->uid != 0 || addrs[i].nl_groups == 0 || addrs[i].nl_pid != 0) {
+            continue;
         }
-    }
+        msgs[i][len] = '\0';
+        msgs[i][len + 1] = '\0';
 
-    std::shared_ptr<IStats> stats_client = getStatsService();
-    if (!stats_client) {
-        ALOGE("Unable to get Stats service instance.");
-    } else {
-        /* Process the strings recorded. */
-        ReportMicStatusUevents(stats_client, devpath, mic_break_status);
-        ReportMicStatusUevents(stats_client, devpath, mic_degrade_status);
-        ReportUsbPortOverheatEvent(stats_client, driver);
-        ReportChargeMetricsEvent(stats_client, driver);
-        ReportBatteryCapacityFGEvent(stats_client, subsystem);
-        if (collect_partner_id) {
-            ReportTypeCPartnerId(stats_client);
-        }
-        ReportGpuEvent(stats_client, driver, gpu_event_type, gpu_event_info);
-        ReportThermalAbnormalEvent(stats_client, devpath, thermal_abnormal_event_type,
-                                   thermal_abnormal_event_info);
-        ReportFGMetricsEvent(stats_client, driver);
-    }
+        ParseUevent(msgs[i], &fields);
+        DispatchUevent(fields);
 
-    if (log_fd_ > 0) {
-        write(log_fd_, "\n", 1);
+        if (log_fd_ > 0) {
+            write(log_fd_, "\n", 1);
+        }
     }
     return true;
 }
@@ -516,7 +598,9 @@ UeventListener::UeventListener(const std::string audio_uevent, const std::string
       kFwUpdatePath(fw_update_path),
       kFGAbnlPath(fg_abnl_path),
       uevent_fd_(-1),
-      log_fd_(-1) {}
+      log_fd_(-1) {
+    InitUeventDispatch();
+}
 
 UeventListener::UeventListener(const struct UeventPaths &uevents_paths)
     : kAudioUevent((uevents_paths.AudioUevent == nullptr) ? "" : uevents_paths.AudioUevent),
@@ -540,12 +624,13 @@ UeventListener::UeventListener(const struct UeventPaths &uevents_paths)
                                    ? "" : uevents_paths.FwUpdatePath),
       kFGAbnlPath(uevents_paths.FGAbnlPath),
       uevent_fd_(-1),
-      log_fd_(-1) {}
+      log_fd_(-1) {
+    InitUeventDispatch();
+}
 
 /* Thread function to continuously monitor uevents.
  * Exit after kMaxConsecutiveErrors to prevent spinning. */
 void UeventListener::ListenForever() {
-    constexpr int kMaxConsecutiveErrors = 10;
     int consecutive_errors = 0;
 
     while (1) {
@@ -560,6 +645,23 @@ void UeventListener::ListenForever() {
     }
 }
 
+/* Process uevents whenever the socket is readable from loop, which must not outlive the
+ * listener. Stop listening after kMaxConsecutiveErrors to prevent spinning. */
+bool UeventListener::ListenOn(EventLoop *loop) {
+    if (!OpenUeventSocket()) {
+        return false;
+    }
+    consecutive_errors_ = 0;
+    return loop->addFd(uevent_fd_, [this, loop] {
+        if (ProcessUevent()) {
+            consecutive_errors_ = 0;
+        } else if (++consecutive_errors_ >= kMaxConsecutiveErrors) {
+            ALOGE("Too many ProcessUevent errors; exiting UeventListener.");
+            loop->removeFd(uevent_fd_);
+        }
+    });
+}
+
 }  // namespace pixel
 }  // namespace google
 }  // namespace hardware
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HARDWARE_GOOGLE_PIXEL_PIXELSTATS_ASYNCSTATSCLIENT_H
+#define HARDWARE_GOOGLE_PIXEL_PIXELSTATS_ASYNCSTATSCLIENT_H
+
+#include <aidl/android/frameworks/stats/BnStats.h>
+#include <android-base/unique_fd.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace android {
+namespace hardware {
+namespace google {
+namespace pixel {
+
+using aidl::android::frameworks::stats::BnStats;
+using aidl::android::frameworks::stats::IStats;
+using aidl::android::frameworks::stats::VendorAtom;
+
+/**
+ * IStats which only queues the atom and returns, the atoms are sent to the stats service from
+ * a sender thread. Producers push into a fixed size lock-free ring, so neither a slow stats
+ * service nor another producer can block them; when the ring is full the atom is dropped and an
+ * error returned. The sender caches the service binder, drops it when the service dies and
+ * reconnects on the next batch.
+ *
+ * An OK status only means that the atom was queued. Atoms which the sender fails to deliver,
+ * because the service can't be reached or the call fails even on a new binder, are dropped too.
+ * Every drop is counted in droppedAtoms() and logged, rate limited.
+ */
+class AsyncStatsClient : public BnStats {
+  public:
+    using StatsClientGetter = std::function<std::shared_ptr<IStats>()>;
+
+    // capacity is rounded up to a power of 2
+    AsyncStatsClient(StatsClientGetter stats_client_getter, size_t capacity);
+    ~AsyncStatsClient();
+
+    ndk::ScopedAStatus reportVendorAtom(const VendorAtom &atom) override;
+
+    // Atoms dropped since the creation, on a full ring or after a failed delivery
+    size_t droppedAtoms() const;
+
+  private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        VendorAtom atom;
+    };
+
+    bool push(const VendorAtom &atom);
+    bool pop(VendorAtom *atom);
+    void loop();
+    void sendBatch(const std::vector<VendorAtom> &batch);
+    void countDropped(size_t count, const char *reason);
+    std::shared_ptr<IStats> getClient();
+    static void onStatsBinderDied(void *cookie);
+
+    const StatsClientGetter stats_client_getter_;
+    const size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<size_t> enqueue_pos_ = 0;
+    // Sender thread only
+    size_t dequeue_pos_ = 0;
+    std::atomic<size_t> dropped_ = 0;
+    android::base::unique_fd event_fd_;
+    std::atomic<bool> stopped_ = false;
+
+    std::mutex client_mutex_;
+    std::shared_ptr<IStats> client_;
+    ndk::ScopedAIBinder_DeathRecipient death_recipient_;
+    std::thread thread_;
+};
+
+}  // namespace pixel
+}  // namespace google
+}  // namespace hardware
+}  // namespace android
+
+#endif  // HARDWARE_GOOGLE_PIXEL_PIXELSTATS_ASYNCSTATSCLIENT_H
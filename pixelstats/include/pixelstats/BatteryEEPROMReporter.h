@@ -130,23 +130,6 @@ class BatteryEEPROMReporter {
     const int kNumValidationFields = 4;
     unsigned int last_hv_check_ = 0;
 
-    /* P21+ history format */
-    struct BatteryHistoryExtend {
-        uint16_t tempco;
-        uint16_t rcomp0;
-        uint8_t timer_h;
-        unsigned fullcapnom:10;
-        unsigned fullcaprep:10;
-        unsigned mixsoc:6;
-        unsigned vfsoc:6;
-        unsigned maxvolt:4;
-        unsigned minvolt:4;
-        unsigned maxtemp:4;
-        unsigned mintemp:4;
-        unsigned maxchgcurr:4;
-        unsigned maxdischgcurr:4;
-    };
-
     struct BatteryHistoryInt32 {
         int32_t cycle_cnt;
         int32_t full_cap;
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HARDWARE_GOOGLE_PIXEL_PIXELSTATS_BATTERYHISTORYDECODER_H
+#define HARDWARE_GOOGLE_PIXEL_PIXELSTATS_BATTERYHISTORYDECODER_H
+
+#include <cstdint>
+#include <string_view>
+
+namespace android {
+namespace hardware {
+namespace google {
+namespace pixel {
+
+/* P21+ history format */
+struct BatteryHistoryExtend {
+    uint16_t tempco;
+    uint16_t rcomp0;
+    uint8_t timer_h;
+    unsigned fullcapnom:10;
+    unsigned fullcaprep:10;
+    unsigned mixsoc:6;
+    unsigned vfsoc:6;
+    unsigned maxvolt:4;
+    unsigned minvolt:4;
+    unsigned maxtemp:4;
+    unsigned mintemp:4;
+    unsigned maxchgcurr:4;
+    unsigned maxdischgcurr:4;
+};
+
+/**
+ * Scan count fields of hex digits from text into values, as sscanf() with "%<N>x" conversions
+ * would: each field skips leading whitespace and takes at most max_digits[i] digits, or all the
+ * digits when it is 0, saturating past 64 bits. Unlike sscanf(), no sign or "0x" prefix is taken.
+ *
+ * Returns the number of fields scanned before text ran out or held no hex digit.
+ */
+int scanHexFields(std::string_view text, const uint8_t *max_digits, int count, uint32_t *values);
+
+/**
+ * Decode a P21+ history entry, "%4x%4x%x %x %x %x" as printed by the fuel gauge driver. The
+ * last four fields are the 16 bit words of the packed history word, lowest first.
+ *
+ * Returns false for a malformed, erased or empty entry.
+ */
+bool decodeBatteryHistoryExtend(std::string_view line, BatteryHistoryExtend *hist);
+
+}  // namespace pixel
+}  // namespace google
+}  // namespace hardware
+}  // namespace android
+
+#endif  // HARDWARE_GOOGLE_PIXEL_PIXELSTATS_BATTERYHISTORYDECODER_H
@@ -21,8 +21,8 @@
 #include <hardware/google/pixel/pixelstats/pixelatoms.pb.h>
 
 #include <map>
-#include <regex>
 #include <string>
+#include <string_view>
 
 namespace android {
 namespace hardware {
@@ -97,7 +97,8 @@ class BrownoutDetectedReporter {
                         const std::string &brownoutReasonProp);
     int brownoutReasonCheck(const std::string &brownoutReasonProp);
 
-  private:
+  protected:
+    // Reached by the parser tests and benchmark through MockBrownoutDetectedReporter
     struct BrownoutDetectedInfo {
         int triggered_irq_;
         long triggered_timestamp_;
@@ -120,9 +121,14 @@ class BrownoutDetectedReporter {
         int vimon_ibatt_;
     };
 
-    void setAtomFieldValue(std::vector<VendorAtomValue> *values, int offset, int content);
+    // Fold the readings of a brownout log into max_value. Returns false if the log holds
+    // LASTMEAL_UPDATED, i.e. it was already reported.
+    bool parseBrownoutLog(std::string_view logFile, struct BrownoutDetectedInfo *max_value);
     long parseTimestamp(std::string timestamp);
-    bool updateIfFound(std::string line, std::regex pattern, int *current_value, Update flag);
+
+  private:
+    void setAtomFieldValue(std::vector<VendorAtomValue> *values, int offset, int content);
+    void updateValue(int reading, int *current_value, Update flag);
     void uploadData(const std::shared_ptr<IStats> &stats_client,
                     const struct BrownoutDetectedInfo max_value);
     // Proto messages are 1-indexed and VendorAtom field numbers start at 2, so
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HARDWARE_GOOGLE_PIXEL_PIXELSTATS_DAILYREPORTERRUNNER_H
+#define HARDWARE_GOOGLE_PIXEL_PIXELSTATS_DAILYREPORTERRUNNER_H
+
+#include <aidl/android/frameworks/stats/BnStats.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "WorkerPool.h"
+
+namespace android {
+namespace hardware {
+namespace google {
+namespace pixel {
+
+using aidl::android::frameworks::stats::BnStats;
+using aidl::android::frameworks::stats::IStats;
+using aidl::android::frameworks::stats::VendorAtom;
+
+/**
+ * Collects the atoms of the daily reporters while they run on the pool, they are sent together
+ * from the collector thread once the pass is over. Atoms of a reporter that outlived the pass are
+ * sent right away.
+ */
+class DailyAtomBatch : public BnStats {
+  public:
+    ndk::ScopedAStatus reportVendorAtom(const VendorAtom &atom) override;
+    // Sends the collected atoms, the later ones go straight to stats_client
+    void flush(const std::shared_ptr<IStats> &stats_client);
+
+  private:
+    std::mutex mutex_;
+    std::vector<VendorAtom> atoms_;
+    std::shared_ptr<IStats> stats_client_;
+};
+
+/**
+ * Runs groups of daily reporters on a WorkerPool, one worker per group at a time. The reporters
+ * of a group share an I/O domain and run in order.
+ */
+class DailyReporterRunner {
+  public:
+    struct Reporter {
+        const char *name;
+        std::function<void(const std::shared_ptr<IStats> &)> log;
+    };
+
+    DailyReporterRunner(size_t num_workers, std::chrono::milliseconds reporter_timeout,
+                        std::chrono::milliseconds pass_timeout);
+    // Disallow copy and assign
+    DailyReporterRunner(const DailyReporterRunner &) = delete;
+    void operator=(const DailyReporterRunner &) = delete;
+
+    void addGroup(const char *name, std::vector<Reporter> reporters);
+    void run(const std::shared_ptr<IStats> &stats_client);
+
+  private:
+    struct Group {
+        const char *name;
+        std::vector<Reporter> reporters;
+        // Still set when a reporter of the group blocked past the last pass
+        std::atomic<bool> running = false;
+    };
+
+    const std::chrono::milliseconds reporter_timeout_;
+    const std::chrono::milliseconds pass_timeout_;
+    std::vector<std::unique_ptr<Group>> groups_;
+    // Declared last, so that its workers are joined before the groups go away
+    WorkerPool pool_;
+};
+
+}  // namespace pixel
+}  // namespace google
+}  // namespace hardware
+}  // namespace android
+
+#endif  // HARDWARE_GOOGLE_PIXEL_PIXELSTATS_DAILYREPORTERRUNNER_H
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HARDWARE_GOOGLE_PIXEL_PIXELSTATS_EVENTLOOP_H
+#define HARDWARE_GOOGLE_PIXEL_PIXELSTATS_EVENTLOOP_H
+
+#include <android-base/chrono_utils.h>
+#include <android-base/unique_fd.h>
+#include <sys/epoll.h>
+
+#include <chrono>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace android {
+namespace hardware {
+namespace google {
+namespace pixel {
+
+/**
+ * Single threaded epoll reactor running the callbacks of readable fds and of timers. All timers
+ * share one CLOCK_BOOTTIME timerfd, which is armed for the earliest deadline plus slack, and
+ * every wakeup runs all the timers already past their deadline, so timers with slack share the
+ * wakeups of other timers and fds. Like the CLOCK_BOOTTIME timers before it, it does not wake
+ * the device from suspend.
+ *
+ * Callbacks run on the thread in run() and must be short; heavy work belongs on a WorkerPool.
+ * Not thread safe: fds and timers are added before run() or from its callbacks.
+ */
+class EventLoop {
+  public:
+    using Callback = std::function<void()>;
+
+    EventLoop();
+    virtual ~EventLoop() {}
+    // Disallow copy and assign
+    EventLoop(const EventLoop &) = delete;
+    void operator=(const EventLoop &) = delete;
+
+    // Runs callback whenever fd has any of events, readable by default, until removeFd(fd). Each
+    // call runs a copy of callback, so that it can remove its own fd; state kept in a mutable
+    // lambda is lost between calls.
+    bool addFd(int fd, Callback callback, uint32_t events = EPOLLIN);
+    void removeFd(int fd);
+    // Runs callback after delay, then every period unless period is zero. It may run up to slack
+    // late to share a wakeup; the schedule does not drift and periods missed while suspended
+    // are skipped.
+    void addTimer(const char *name, std::chrono::milliseconds delay,
+                  std::chrono::milliseconds period, std::chrono::milliseconds slack,
+                  Callback callback);
+
+    // Dispatch events until stop() is called from a callback or epoll fails
+    void run();
+    void stop();
+
+  protected:
+    using TimePoint = android::base::boot_clock::time_point;
+
+    // Runs the timers past their deadline, called after every wakeup of run()
+    void runDueTimers();
+
+  private:
+    struct Timer {
+        const char *name;
+        TimePoint deadline;
+        std::chrono::milliseconds period;
+        std::chrono::milliseconds slack;
+        Callback callback;
+    };
+
+    // Test hook, see EventLoopTest
+    virtual TimePoint now() { return android::base::boot_clock::now(); }
+    bool armTimer();
+
+    android::base::unique_fd epoll_fd_;
+    android::base::unique_fd timer_fd_;
+    std::unordered_map<int, Callback> fd_callbacks_;
+    std::vector<Timer> timers_;
+    bool stopped_ = false;
+};
+
+}  // namespace pixel
+}  // namespace google
+}  // namespace hardware
+}  // namespace android
+
+#endif  // HARDWARE_GOOGLE_PIXEL_PIXELSTATS_EVENTLOOP_H
@@ -18,7 +18,11 @@
 #define HARDWARE_GOOGLE_PIXEL_PIXELSTATS_MMMETRICSREPORTER_H
 
 #include <map>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 #include <aidl/android/frameworks/stats/IStats.h>
 #include <hardware/google/pixel/pixelstats/pixelatoms.pb.h>
@@ -91,6 +95,10 @@ class MmMetricsReporter {
     std::vector<VendorAtomValue> readAndGenGcmaPerDay();
     virtual ~MmMetricsReporter() {}
 
+  protected:
+    // Called by the test code, with a fake /proc root from getProcRoot()
+    std::string getProcessStatPath(const std::string &name, int *prev_pid);
+
   private:
     struct MmMetricsInfo {
         std::string name;
@@ -111,6 +119,23 @@ class MmMetricsReporter {
         bool update_diff;
     };
 
+    // The values of the fields of a MmMetricsInfo or ProcStatMetricsInfo table, by position in
+    // the table; nullopt when the field was not found. Empty when there is no previous read.
+    using MmMetricsValues = std::vector<std::optional<uint64_t>>;
+
+    // The position of each field name in a MmMetricsInfo table, precomputed once per table
+    class MmMetricsIndex {
+      public:
+        explicit MmMetricsIndex(const std::vector<MmMetricsInfo> &metrics_info);
+        size_t size() const { return size_; }
+        // -1 if the table has no such field
+        int find(std::string_view name) const;
+
+      private:
+        size_t size_;
+        std::unordered_map<std::string_view, int> positions_;
+    };
+
     enum CmaType {
         FARAWIMG = 0,
         FAIMG = 1,
@@ -123,6 +148,8 @@ class MmMetricsReporter {
     static const std::vector<MmMetricsInfo> kMmMetricsPerHourInfo;
     static const std::vector<MmMetricsInfo> kMeminfoInfo;
     static const std::vector<MmMetricsInfo> kMmMetricsPerDayInfo;
+    static const MmMetricsIndex kMmMetricsPerHourIndex;
+    static const MmMetricsIndex kMmMetricsPerDayIndex;
     static const std::vector<ProcStatMetricsInfo> kProcStatInfo;
     static const std::vector<MmMetricsInfo> kCmaStatusInfo;
     static const std::vector<MmMetricsInfo> kCmaStatusExtInfo;
@@ -182,42 +209,41 @@ class MmMetricsReporter {
     void fillDirectReclaimStatAtom(const std::vector<long> &store,
                                    std::vector<VendorAtomValue> *values);
     void readPressureStall(const std::string &basePath, std::vector<long> *store);
-    bool parsePressureStallFileContent(bool is_cpu, const std::string &lines,
+    bool parsePressureStallFileContent(bool is_cpu, std::string_view lines,
                                        std::vector<long> *store, int file_save_idx);
-    bool parsePressureStallWords(const std::vector<std::string> &words, std::vector<long> *store,
-                                 int line_save_idx);
-    bool savePressureMetrics(const std::string &name, const std::string &value,
+    bool parsePressureStallWords(const std::string_view *words, int num_words,
+                                 std::vector<long> *store, int line_save_idx);
+    bool savePressureMetrics(std::string_view name, std::string_view value,
                              std::vector<long> *store, int base_save_idx);
     void fillPressureStallAtom(std::vector<VendorAtomValue> *values);
     void aggregatePressureStall();
-    std::map<std::string, uint64_t> readSysfsNameValue(const std::string &path);
-    std::map<std::string, std::vector<uint64_t>> readProcStat(const std::string &path);
+    bool readFileToBuffer(const std::string &path);
+    bool readSysfsNameValue(const std::string &path, const MmMetricsIndex &index,
+                            MmMetricsValues *metrics);
+    bool readProcStat(const std::string &path, const std::vector<ProcStatMetricsInfo> &metrics_info,
+                      MmMetricsValues *pstat);
     uint64_t getIonTotalPools();
     uint64_t getGpuMemory();
     bool fillAtomValues(const std::vector<MmMetricsInfo> &metrics_info,
-                        const std::map<std::string, uint64_t> &mm_metrics,
-                        std::map<std::string, uint64_t> *prev_mm_metrics,
+                        const MmMetricsValues &mm_metrics, MmMetricsValues *prev_mm_metrics,
                         std::vector<VendorAtomValue> *atom_values);
-    bool getValueFromParsedProcStat(const std::map<std::string, std::vector<uint64_t>> pstat,
-                                    const std::string &name, int offset, uint64_t *output);
     bool fillProcStat(const std::vector<ProcStatMetricsInfo> &metrics_info,
-                      const std::map<std::string, std::vector<uint64_t>> &cur_pstat,
-                      std::map<std::string, std::vector<uint64_t>> *prev_pstat,
+                      const MmMetricsValues &cur_pstat, MmMetricsValues *prev_pstat,
                       std::vector<VendorAtomValue> *atom_values);
-    virtual std::string getProcessStatPath(const std::string &name, int *prev_pid);
     bool isValidProcessInfoPath(const std::string &path, const char *name);
+    bool isProcessName(int pid, const std::string &name);
     int findPidByProcessName(const std::string &name);
     int64_t getStimeByPathAndVerifyName(const std::string &path, const std::string &name);
     void fillProcessStime(int atom_key, const std::string &name, int *pid, uint64_t *prev_stime,
                           std::vector<VendorAtomValue> *atom_values);
-    std::map<std::string, uint64_t> readCmaStat(const std::string &cma_type,
-                                                const std::vector<MmMetricsInfo> &metrics_info);
-    void reportCmaStatusAtom(
-            const std::shared_ptr<IStats> &stats_client, int atom_id, const std::string &cma_type,
-            int cma_name_offset, const std::vector<MmMetricsInfo> &metrics_info,
-            std::map<std::string, std::map<std::string, uint64_t>> *all_prev_cma_stat);
-
-    std::optional<OomGroupMemUsage> parseMmProcessUsageByOomGroupLine(const std::string &line);
+    MmMetricsValues readCmaStat(const std::string &cma_type,
+                                const std::vector<MmMetricsInfo> &metrics_info);
+    void reportCmaStatusAtom(const std::shared_ptr<IStats> &stats_client, int atom_id,
+                             const std::string &cma_type, int cma_name_offset,
+                             const std::vector<MmMetricsInfo> &metrics_info,
+                             std::map<std::string, MmMetricsValues> *all_prev_cma_stat);
+
+    std::optional<OomGroupMemUsage> parseMmProcessUsageByOomGroupLine(std::string_view line);
     bool readMmProcessUsageByOomGroupFile(const std::string &path,
                                           std::vector<OomGroupMemUsage> *ogusage, int32_t *m_uid);
 
@@ -225,6 +251,9 @@ class MmMetricsReporter {
     // though named 'Sysfs', it can be applied to proc fs
     virtual std::string getSysfsPath(const std::string &path) { return path; }
 
+    // test code could override this to look the kernel threads up in a fake /proc/<pid> tree
+    virtual std::string getProcRoot() { return "/proc"; }
+
     const char *const kVmstatPath;
     const char *const kIonTotalPoolsPath;
     const char *const kIonTotalPoolsPathForLegacy;
@@ -269,12 +298,14 @@ class MmMetricsReporter {
     long psi_total_[kPsiNumAllTotals];
     long psi_aggregated_[kPsiNumAllUploadAvgMetrics];  // min, max and avg of original avgXXX
     int psi_data_set_count_ = 0;
-    std::map<std::string, uint64_t> prev_hour_vmstat_;
-    std::map<std::string, uint64_t> prev_day_vmstat_;
-    std::map<std::string, uint64_t> prev_day_pixel_vmstat_;
-    std::map<std::string, std::vector<uint64_t>> prev_procstat_;
-    std::map<std::string, std::map<std::string, uint64_t>> prev_cma_stat_;
-    std::map<std::string, std::map<std::string, uint64_t>> prev_cma_stat_ext_;
+    MmMetricsValues prev_hour_vmstat_;
+    MmMetricsValues prev_day_vmstat_;
+    MmMetricsValues prev_day_pixel_vmstat_;
+    MmMetricsValues prev_procstat_;
+    std::map<std::string, MmMetricsValues> prev_cma_stat_;
+    std::map<std::string, MmMetricsValues> prev_cma_stat_ext_;
+    // The proc and sysfs files are read into this buffer, kept across reads
+    std::string read_buf_;
     int prev_kswapd_pid_ = -1;
     int prev_kcompactd_pid_ = -1;
     uint64_t prev_kswapd_stime_ = 0;
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HARDWARE_GOOGLE_PIXEL_PIXELSTATS_MMPRESSUREEPISODEREPORTER_H
+#define HARDWARE_GOOGLE_PIXEL_PIXELSTATS_MMPRESSUREEPISODEREPORTER_H
+
+#include <aidl/android/frameworks/stats/IStats.h>
+#include <android-base/chrono_utils.h>
+#include <android-base/unique_fd.h>
+
+#include <array>
+#include <string>
+
+#include "EventLoop.h"
+
+namespace android {
+namespace hardware {
+namespace google {
+namespace pixel {
+
+using aidl::android::frameworks::stats::IStats;
+
+/**
+ * Opt-in high resolution sampling of memory pressure episodes. A PSI trigger on
+ * /proc/pressure/memory starts an episode; while the stall goes on, the memory stall and a few
+ * /proc/vmstat counters are sampled every 100ms, the stall increments into a fixed ring. The
+ * vmstat counters are only summed over the episode, they are not kept per sample. When the stall
+ * stops for 1s, one MmMemoryPressureEpisode atom summarizes the episode up to its last stalled
+ * sample in percentiles. Nothing is read between episodes, and a new episode only starts 5
+ * minutes after the end of the last one.
+ *
+ * Runs on the EventLoop thread, each sample reads two small proc files.
+ */
+class MmPressureEpisodeReporter {
+  public:
+    virtual ~MmPressureEpisodeReporter() {}
+
+    // Whether the device opted in with persist.vendor.pixelstats.mm_pressure_episodes
+    static bool isEnabled();
+
+    // Arm the PSI trigger and watch it on loop, which must not outlive the reporter
+    bool start(EventLoop *loop);
+
+  protected:
+    // Nearest rank percentile of values, which is reordered
+    static uint32_t percentile(uint32_t *values, size_t count, int pct);
+
+    // Start an episode unless one is running or the last one ended too recently. Returns
+    // whether it started.
+    bool startEpisode();
+    // Take one sample of the running episode, and report the episode if it ended. Returns
+    // whether the episode goes on.
+    bool sampleEpisode();
+
+  private:
+    enum Counter {
+        PGSCAN_KSWAPD = 0,
+        PGSCAN_DIRECT,
+        WORKINGSET_REFAULT_FILE,
+        PSWPIN,
+        NUM_COUNTERS,
+    };
+    // Cumulative values, as read from the proc files
+    struct Totals {
+        uint64_t some_stall_us;
+        uint64_t full_stall_us;
+        uint64_t counters[NUM_COUNTERS];
+    };
+    // Stall over one sample period, saturated to keep the ring small. The counters are only
+    // summed over the episode.
+    struct Sample {
+        uint32_t some_stall_us;
+        uint32_t full_stall_us;
+    };
+    // 60 seconds of samples
+    static constexpr size_t kRingSize = 600;
+    static constexpr int kVendorAtomOffset = 2;
+
+    // Test hooks, see MockMmPressureEpisodeReporter
+    virtual std::string getProcPath(const char *path) { return path; }
+    virtual android::base::boot_clock::time_point now() {
+        return android::base::boot_clock::now();
+    }
+    virtual std::shared_ptr<IStats> getStatsClient();
+
+    bool readTotals(Totals *totals);
+    void onTrigger();
+    void sample();
+    void scheduleSample();
+    void reportEpisode(const std::shared_ptr<IStats> &stats_client);
+
+    EventLoop *loop_ = nullptr;
+    android::base::unique_fd trigger_fd_;
+    std::string read_buf_;
+
+    bool in_episode_ = false;
+    android::base::boot_clock::time_point episode_start_;
+    // Triggers before this are ignored, to report at most one episode per kEpisodeCooldown
+    android::base::boot_clock::time_point next_episode_start_;
+    Totals prev_totals_;
+    Totals episode_start_totals_;
+    std::array<Sample, kRingSize> ring_;
+    // Samples taken in the episode; the newest of them is at (sample_count_ - 1) % kRingSize
+    size_t sample_count_ = 0;
+    uint32_t max_some_stall_us_ = 0;
+    uint32_t max_full_stall_us_ = 0;
+    int quiet_samples_ = 0;
+};
+
+}  // namespace pixel
+}  // namespace google
+}  // namespace hardware
+}  // namespace android
+
+#endif  // HARDWARE_GOOGLE_PIXEL_PIXELSTATS_MMPRESSUREEPISODEREPORTER_H
@@ -28,6 +28,14 @@ namespace pixel {
 using aidl::android::frameworks::stats::IStats;
 
 bool fileExists(const std::string &path);
+
+/**
+ * Returns the process-wide stats client, or nullptr when no stats service is declared.
+ * reportVendorAtom() on it doesn't wait for the stats service: it queues the atom, returns OK
+ * and the atom is sent later from a sender thread. An error is only returned when the queue is
+ * full. A failure to deliver a queued atom is not seen by the caller, it is logged and counted
+ * by the client, see AsyncStatsClient.
+ */
 std::shared_ptr<IStats> getStatsService();
 
 enum ReportEventType {
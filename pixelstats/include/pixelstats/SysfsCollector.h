@@ -20,16 +20,24 @@
 #include <aidl/android/frameworks/stats/IStats.h>
 #include <hardware/google/pixel/pixelstats/pixelatoms.pb.h>
 
+#include <functional>
+#include <memory>
+#include <vector>
+
 #include "BatteryEEPROMReporter.h"
 #include "BatteryHealthReporter.h"
 #include "BatteryTTFReporter.h"
 #include "BrownoutDetectedReporter.h"
+#include "DailyReporterRunner.h"
 #include "DisplayStatsReporter.h"
+#include "EventLoop.h"
 #include "MitigationDurationReporter.h"
 #include "MitigationStatsReporter.h"
 #include "MmMetricsReporter.h"
+#include "MmPressureEpisodeReporter.h"
 #include "TempResidencyReporter.h"
 #include "ThermalStatsReporter.h"
+#include "WorkerPool.h"
 
 namespace android {
 namespace hardware {
@@ -103,17 +111,27 @@ class SysfsCollector {
     };
 
     SysfsCollector(const struct SysfsPaths &paths);
+    // Run the collection on an EventLoop of its own, forever
     void collect();
+    // Add the collection to an EventLoop shared with e.g. UeventListener::ListenOn(). The
+    // pixelstats service main() of each device owns that loop and runs it; this tree has none.
+    void schedule(EventLoop *loop);
 
   private:
     bool ReadFileToInt(const std::string &path, int *val);
     bool ReadFileToInt(const char *path, int *val);
+    void addCollectionTimers(EventLoop *loop, bool shared_loop);
+    // Runs pass on collect_pool_ if there is one, else right away
+    void runPass(std::function<void()> pass);
     void aggregatePer5Min();
     void logOnce();
     void logBrownout();
     void logPerDay();
     void logPerHour();
 
+    // Groups the daily reporters by I/O domain
+    void initDailyReporters();
+
     void logBatteryChargeCycles(const std::shared_ptr<IStats> &stats_client);
     void logBatteryHealth(const std::shared_ptr<IStats> &stats_client);
     void logBatteryTTF(const std::shared_ptr<IStats> &stats_client);
@@ -161,7 +179,7 @@ class SysfsCollector {
     void logOffloadEffectsStats(const std::shared_ptr<IStats> &stats_client);
     void logBluetoothAudioUsage(const std::shared_ptr<IStats> &stats_client);
     void logBatteryGMSR(const std::shared_ptr<IStats> &stats_client);
-    void logBatteryHistoryValidation();
+    void logBatteryHistoryValidation(const std::shared_ptr<IStats> &stats_client);
 
     const char *const kSlowioReadCntPath;
     const char *const kSlowioWriteCntPath;
@@ -224,6 +242,7 @@ class SysfsCollector {
 
     BatteryEEPROMReporter battery_EEPROM_reporter_;
     MmMetricsReporter mm_metrics_reporter_;
+    MmPressureEpisodeReporter mm_pressure_episode_reporter_;
     MitigationStatsReporter mitigation_stats_reporter_;
     MitigationDurationReporter mitigation_duration_reporter_;
     BrownoutDetectedReporter brownout_detected_reporter_;
@@ -236,6 +255,10 @@ class SysfsCollector {
     // store everything in the values array at the index of the field number    // -2.
     const int kVendorAtomOffset = 2;
 
+    std::unique_ptr<DailyReporterRunner> daily_reporters_;
+    // Runs the timed collection passes in order, only when they share their EventLoop
+    std::unique_ptr<WorkerPool> collect_pool_;
+
     bool log_once_reported = false;
     int64_t prev_huge_pages_since_boot_ = -1;
 
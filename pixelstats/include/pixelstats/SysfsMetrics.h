@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HARDWARE_GOOGLE_PIXEL_PIXELSTATS_SYSFSMETRICS_H
+#define HARDWARE_GOOGLE_PIXEL_PIXELSTATS_SYSFSMETRICS_H
+
+#include <aidl/android/frameworks/stats/IStats.h>
+#include <android-base/unique_fd.h>
+
+#include <string>
+
+namespace android {
+namespace hardware {
+namespace google {
+namespace pixel {
+
+using aidl::android::frameworks::stats::IStats;
+using aidl::android::frameworks::stats::VendorAtom;
+
+/**
+ * One int field of a sysfs metric atom, read from a single node holding a decimal or "0x"
+ * hex value.
+ */
+struct SysfsMetricField {
+    // Node name relative to the metric directory, or an absolute path
+    const char *node;
+    // Proto field number of the value in the atom
+    int field_number;
+    // A missing node fails the whole atom instead of reporting 0
+    bool required;
+    // Write 0 back once read, for counters the kernel accumulates until cleared
+    bool reset_after_read;
+};
+
+/**
+ * An atom made only of int fields read from sysfs nodes. The fields are read in table order, so a
+ * required node that fails leaves the nodes after it untouched.
+ */
+struct SysfsMetric {
+    const char *name;
+    int32_t atom_id;
+    const SysfsMetricField *fields;
+    size_t num_fields;
+};
+
+template <size_t N>
+constexpr SysfsMetric makeSysfsMetric(const char *name, int32_t atom_id,
+                                      const SysfsMetricField (&fields)[N]) {
+    return {name, atom_id, fields, N};
+}
+
+/**
+ * Reads SysfsMetric tables below one directory. The directory is opened once and every node is
+ * read with openat()/pread() into a buffer shared by all the fields.
+ */
+class SysfsMetricReader {
+  public:
+    // An empty dir means every node of the metrics read is an absolute path
+    explicit SysfsMetricReader(const std::string &dir);
+
+    // Fill the atom from the metric's nodes, returns false if a required node could not be read
+    bool read(const SysfsMetric &metric, VendorAtom *atom);
+    // Read the metric and report it to IStats
+    void report(const std::shared_ptr<IStats> &stats_client, const SysfsMetric &metric);
+
+  private:
+    bool readInt(const char *node, int *val);
+    bool resetNode(const char *node);
+
+    const std::string dir_;
+    android::base::unique_fd dir_fd_;
+    char buf_[64];
+};
+
+}  // namespace pixel
+}  // namespace google
+}  // namespace hardware
+}  // namespace android
+
+#endif  // HARDWARE_GOOGLE_PIXEL_PIXELSTATS_SYSFSMETRICS_H
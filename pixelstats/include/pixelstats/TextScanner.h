@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HARDWARE_GOOGLE_PIXEL_PIXELSTATS_TEXTSCANNER_H
+#define HARDWARE_GOOGLE_PIXEL_PIXELSTATS_TEXTSCANNER_H
+
+#include <cstdint>
+#include <string_view>
+
+namespace android {
+namespace hardware {
+namespace google {
+namespace pixel {
+
+/**
+ * Walks the lines of a proc or sysfs file, or the fields of a line, as views into the buffer the
+ * file was read into, so that parsing copies and allocates nothing.
+ */
+class TextScanner {
+  public:
+    explicit TextScanner(std::string_view text) : text_(text) {}
+
+    // Take the next line, without its '\n'. As with std::getline(), a '\n' ending the text does
+    // not start another line.
+    bool nextLine(std::string_view *line);
+    // Take the next field separated by any of delims. Empty fields are skipped, as by
+    // android::base::Tokenize().
+    bool nextField(std::string_view *field, std::string_view delims = " ");
+
+  private:
+    std::string_view text_;
+};
+
+// Strip the leading and trailing whitespace, as android::base::Trim()
+std::string_view trimText(std::string_view text);
+// Parse all of text as a decimal, or "0x" prefixed hex, number, as android::base::ParseInt()
+bool parseUint(std::string_view text, uint64_t *val);
+bool parseInt(std::string_view text, int64_t *val);
+// Parse a decimal fraction such as "2.93" in hundredths, rounded to the nearest
+bool parseHundredths(std::string_view text, int64_t *val);
+
+}  // namespace pixel
+}  // namespace google
+}  // namespace hardware
+}  // namespace android
+
+#endif  // HARDWARE_GOOGLE_PIXEL_PIXELSTATS_TEXTSCANNER_H
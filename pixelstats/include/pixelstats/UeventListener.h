@@ -19,10 +19,19 @@
 
 #include <aidl/android/frameworks/stats/IStats.h>
 #include <android-base/chrono_utils.h>
+#include <hardware/google/pixel/pixelstats/pixelatoms.pb.h>
 #include <pixelstats/BatteryCapacityReporter.h>
 #include <pixelstats/ChargeStatsReporter.h>
+#include <pixelstats/EventLoop.h>
 #include <pixelstats/BatteryFGReporter.h>
 
+#include <array>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 namespace android {
 namespace hardware {
 namespace google {
@@ -32,8 +41,14 @@ using aidl::android::frameworks::stats::IStats;
 /**
  * A class to listen for uevents and report reliability events to
  * the PixelStats HAL.
- * Runs in a background thread if created with ListenForeverInNewThread().
- * Alternatively, process one message at a time with ProcessUevent().
+ * Runs in a background thread if created with ListenForeverInNewThread(), or
+ * on an EventLoop shared with the SysfsCollector with ListenOn().
+ * Alternatively, process the pending messages with ProcessUevent().
+ * The pixelstats service main() of each device, outside this tree, picks one.
+ *
+ * Each uevent field is matched on its key against the keys the handlers use, and only the
+ * uevents matching a subscription reach the handlers. The others are dropped before any stats
+ * or sysfs work.
  */
 class UeventListener {
   public:
@@ -70,34 +85,72 @@ class UeventListener {
                    const std::string fw_update_path = "",
                    const std::vector<std::string> fg_abnl_path = {""});
     UeventListener(const struct UeventPaths &paths);
+    virtual ~UeventListener() {}
 
-    bool ProcessUevent();  // Process a single Uevent.
+    bool ProcessUevent();  // Process the next batch of Uevents.
     void ListenForever();  // Process Uevents forever
+    bool ListenOn(EventLoop *loop);  // Process Uevents from an EventLoop
+
+  protected:
+    // The uevent fields handlers look at
+    enum UeventKey {
+        kUeventDriver,
+        kUeventDevpath,
+        kUeventSubsystem,
+        kUeventMicBreakStatus,
+        kUeventMicDegradeStatus,
+        kUeventGpuEventType,
+        kUeventGpuEventInfo,
+        kUeventThermalAbnormalType,
+        kUeventThermalAbnormalInfo,
+        kUeventTypeCPartner,
+        kNumUeventKeys,
+    };
+    // The "KEY=value" field of each key in one uevent, nullptr if it is not there
+    using UeventFields = std::array<const char *, kNumUeventKeys>;
+    using UeventHandler =
+            std::function<void(const std::shared_ptr<IStats> &, const UeventFields &)>;
+    // Routes the uevents whose key field equals, or starts with, match to the handler
+    struct UeventSubscription {
+        // Of the report the handler runs
+        const char *name;
+        UeventKey key;
+        std::string match;
+        bool prefix;
+        UeventHandler handler;
+    };
+
+    void ParseUevent(const char *msg, UeventFields *fields);
+    void DispatchUevent(const UeventFields &fields);
 
   private:
     bool ReadFileToInt(const std::string &path, int *val);
     bool ReadFileToInt(const char *path, int *val);
-    void ReportMicStatusUevents(const std::shared_ptr<IStats> &stats_client, const char *devpath,
+    bool OpenUeventSocket();
+    void InitUeventDispatch();
+    // Test hook, see MockUeventListener. Runs the handlers of the matched subscriptions in order.
+    virtual void RunUeventHandlers(const std::vector<const UeventSubscription *> &matched,
+                                   const UeventFields &fields);
+
+    void ReportMicStatusUevents(const std::shared_ptr<IStats> &stats_client,
                                 const char *mic_status);
     void ReportMicBrokenOrDegraded(const std::shared_ptr<IStats> &stats_client, const int mic,
                                    const bool isBroken);
-    void ReportUsbPortOverheatEvent(const std::shared_ptr<IStats> &stats_client,
-                                    const char *driver);
+    void ReportUsbPortOverheatEvent(const std::shared_ptr<IStats> &stats_client);
     void ReportChargeStats(const std::shared_ptr<IStats> &stats_client, const std::string line,
                            const std::string wline_at, const std::string wline_ac,
                            const std::string pca_line);
     void ReportVoltageTierStats(const std::shared_ptr<IStats> &stats_client, const char *line,
                                 const bool has_wireless, const std::string wfile_contents);
-    void ReportChargeMetricsEvent(const std::shared_ptr<IStats> &stats_client, const char *driver);
-    void ReportBatteryCapacityFGEvent(const std::shared_ptr<IStats> &stats_client,
-                                      const char *subsystem);
+    void ReportChargeMetricsEvent(const std::shared_ptr<IStats> &stats_client);
+    void ReportBatteryCapacityFGEvent(const std::shared_ptr<IStats> &stats_client);
     void ReportTypeCPartnerId(const std::shared_ptr<IStats> &stats_client);
-    void ReportGpuEvent(const std::shared_ptr<IStats> &stats_client, const char *driver,
-                        const char *gpu_event_type, const char *gpu_event_info);
+    void ReportGpuEvent(const std::shared_ptr<IStats> &stats_client, const char *gpu_event_type,
+                        const char *gpu_event_info);
     void ReportThermalAbnormalEvent(const std::shared_ptr<IStats> &stats_client,
-                                    const char *devpath, const char *thermal_abnormal_event_type,
+                                    const char *thermal_abnormal_event_type,
                                     const char *thermal_abnormal_event_info);
-    void ReportFGMetricsEvent(const std::shared_ptr<IStats> &stats_client, const char *driver);
+    void ReportFGMetricsEvent(const std::shared_ptr<IStats> &stats_client);
 
     const std::string kAudioUevent;
     const std::string kBatterySSOCPath;
@@ -201,8 +254,14 @@ class UeventListener {
     // -2.
     const int kVendorAtomOffset = 2;
 
+    // Keys to match, bucketed by their length
+    std::vector<std::vector<std::pair<std::string, UeventKey>>> uevent_keys_by_length_;
+    std::vector<UeventSubscription> subscriptions_;
+
     int uevent_fd_;
     int log_fd_;
+    // ProcessUevent() failures in a row on the EventLoop, see ListenOn()
+    int consecutive_errors_ = 0;
 };
 
 }  // namespace pixel
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HARDWARE_GOOGLE_PIXEL_PIXELSTATS_WORKERPOOL_H
+#define HARDWARE_GOOGLE_PIXEL_PIXELSTATS_WORKERPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace android {
+namespace hardware {
+namespace google {
+namespace pixel {
+
+/**
+ * A fixed number of threads running posted tasks in FIFO order. A task stuck in a sysfs read
+ * keeps its thread, so callers must not post more work than they can afford to lose a thread to.
+ */
+class WorkerPool {
+  public:
+    explicit WorkerPool(size_t num_threads);
+    // Runs the tasks left in the queue and joins the threads
+    ~WorkerPool();
+    // Disallow copy and assign
+    WorkerPool(const WorkerPool &) = delete;
+    void operator=(const WorkerPool &) = delete;
+
+    void post(std::function<void()> task);
+
+  private:
+    void loop();
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> tasks_;
+    bool stopped_ = false;
+    std::vector<std::thread> threads_;
+};
+
+}  // namespace pixel
+}  // namespace google
+}  // namespace hardware
+}  // namespace android
+
+#endif  // HARDWARE_GOOGLE_PIXEL_PIXELSTATS_WORKERPOOL_H
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/stringprintf.h>
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include "MockBrownoutDetectedReporter.h"
+
+namespace android {
+namespace hardware {
+namespace google {
+namespace pixel {
+namespace {
+
+using android::base::StringAppendF;
+
+// A brownout log of records as battery_mitigation writes them: the IRQ, the timestamp, the fuel
+// gauge readings, then the DVFS and ODPM readings
+std::string makeBrownoutLog(int records) {
+    static constexpr const char *kDvfsDomains[DVFS_MAX_IDX] = {"BIG", "MID", "LIT",
+                                                               "GPU", "TPU", "AUR"};
+    std::string log;
+    for (int i = 0; i < records; i++) {
+        log += "batoilo triggered at 2024-03-12_10:21:07.123456\n";
+        StringAppendF(&log, "2024-03-12 10:21:%02d.%06d\n", i % 60, i);
+        StringAppendF(&log, "battery:%d\nbattery_cycle:%d\nvoltage_now:%d\nsoc:%d\n", 250 + i % 10,
+                      120, 3800000 - i, 45);
+        for (int d = 0; d < DVFS_MAX_IDX; d++) {
+            StringAppendF(&log, "%s:%d\n", kDvfsDomains[d], 1800000 - d * 100000);
+        }
+        for (int ch = 0; ch < ODPM_MAX_IDX; ch++) {
+            StringAppendF(&log, "CH%d[S%dM_VDD_RAIL], %d\n", ch, ch, 1000 + i + ch);
+        }
+    }
+    return log;
+}
+
+void BM_ParseBrownoutLog(benchmark::State &state) {
+    const std::string log = makeBrownoutLog(state.range(0));
+    MockBrownoutDetectedReporter reporter;
+    for (auto _ : state) {
+        MockBrownoutDetectedReporter::BrownoutDetectedInfo max_value = {};
+        benchmark::DoNotOptimize(reporter.parseBrownoutLog(log, &max_value));
+        benchmark::DoNotOptimize(max_value);
+    }
+    state.SetBytesProcessed(state.iterations() * log.size());
+}
+BENCHMARK(BM_ParseBrownoutLog)->Arg(1)->Arg(64)->Arg(1024);
+
+}  // namespace
+}  // namespace pixel
+}  // namespace google
+}  // namespace hardware
+}  // namespace android
+
+BENCHMARK_MAIN();
@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/file.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "MockBrownoutDetectedReporter.h"
+
+namespace android {
+namespace hardware {
+namespace google {
+namespace pixel {
+
+using android::hardware::google::pixel::PixelAtoms::BrownoutDetected;
+using BrownoutDetectedInfo = MockBrownoutDetectedReporter::BrownoutDetectedInfo;
+
+namespace {
+
+// The defaults logBrownout() starts from
+constexpr int kDefaultBatteryTemp = 9999999;
+constexpr int kDefaultBatterySoc = 100;
+constexpr int kDefaultBatteryVolt = 5000000;
+
+// The golden logs are installed next to the test binary
+std::string readGoldenLog(const char *name) {
+    std::string log;
+    EXPECT_TRUE(android::base::ReadFileToString(
+            android::base::GetExecutableDirectory() + "/data/" + name, &log));
+    return log;
+}
+
+BrownoutDetectedInfo defaultInfo() {
+    BrownoutDetectedInfo info = {};
+    info.battery_temp_ = kDefaultBatteryTemp;
+    info.battery_soc_ = kDefaultBatterySoc;
+    info.voltage_now_ = kDefaultBatteryVolt;
+    return info;
+}
+
+}  // namespace
+
+TEST(BrownoutDetectedReporterTest, FoldsTheRecordsOfGoldenLog) {
+    MockBrownoutDetectedReporter reporter;
+    BrownoutDetectedInfo info = defaultInfo();
+    ASSERT_TRUE(reporter.parseBrownoutLog(readGoldenLog("brownout_log"), &info));
+
+    // The IRQ and timestamp of the last record
+    EXPECT_EQ(info.triggered_irq_, BrownoutDetected::UVLO1);
+    EXPECT_NE(info.triggered_timestamp_, 0);
+    EXPECT_EQ(info.triggered_timestamp_, reporter.parseTimestamp("2024-03-12 10:21:09.000002"));
+    // The worst fuel gauge readings of all records
+    EXPECT_EQ(info.battery_soc_, 44);
+    EXPECT_EQ(info.battery_temp_, 240);
+    EXPECT_EQ(info.battery_cycle_, 121);
+    EXPECT_EQ(info.voltage_now_, 3650000);
+    // The max of each DVFS domain and ODPM channel over the records
+    const int dvfs[DVFS_MAX_IDX] = {1800000, 1600000, 1200000, 850000, 900000, 700000};
+    for (int i = 0; i < DVFS_MAX_IDX; i++) {
+        EXPECT_EQ(info.dvfs_value_[i], dvfs[i]) << "DVFS " << i;
+    }
+    const int odpm[ODPM_MAX_IDX] = {1000, 1129, 1158, 1111, 1216, 1245, 1222, 1303,
+                                    1332, 1333, 1390, 1419, 1444, 1481, 1518, 1555,
+                                    1592, 1629, 1666, 1703, 1740, 1777, 1814, 1851};
+    for (int i = 0; i < ODPM_MAX_IDX; i++) {
+        EXPECT_EQ(info.odpm_value_[i], odpm[i]) << "ODPM channel " << i;
+    }
+}
+
+TEST(BrownoutDetectedReporterTest, ReportedLogIsSkipped) {
+    MockBrownoutDetectedReporter reporter;
+    BrownoutDetectedInfo info = defaultInfo();
+    EXPECT_FALSE(reporter.parseBrownoutLog(readGoldenLog("brownout_log_updated"), &info));
+    EXPECT_EQ(info.battery_temp_, kDefaultBatteryTemp);
+}
+
+TEST(BrownoutDetectedReporterTest, MapsIrqNames) {
+    MockBrownoutDetectedReporter reporter;
+    const std::pair<const char *, int> irqs[] = {
+            {"batoilo", BrownoutDetected::BATOILO},
+            {"vdroop1", BrownoutDetected::UVLO1},
+            {"vdroop2", BrownoutDetected::UVLO2},
+            {"smpl_gm", BrownoutDetected::SMPL_WARN},
+    };
+    for (const auto &[name, irq] : irqs) {
+        BrownoutDetectedInfo info = defaultInfo();
+        const std::string log = std::string(name) + " triggered at 2024-03-12_10:21:07.123456\n";
+        ASSERT_TRUE(reporter.parseBrownoutLog(log, &info));
+        EXPECT_EQ(info.triggered_irq_, irq) << name;
+    }
+
+    // An unknown IRQ keeps the one of the previous record
+    BrownoutDetectedInfo info = defaultInfo();
+    ASSERT_TRUE(reporter.parseBrownoutLog("vdroop2 triggered at 2024-03-12_10:21:07.123456\n"
+                                          "ocp_cpu1 triggered at 2024-03-12_10:21:08.123456\n",
+                                          &info));
+    EXPECT_EQ(info.triggered_irq_, BrownoutDetected::UVLO2);
+}
+
+TEST(BrownoutDetectedReporterTest, OverIntReadingsAreIgnored) {
+    MockBrownoutDetectedReporter reporter;
+    BrownoutDetectedInfo info = defaultInfo();
+    ASSERT_TRUE(reporter.parseBrownoutLog("soc:2147483648\n"
+                                          "battery:99999999999\n"
+                                          "battery_cycle:4294967296\n"
+                                          "voltage_now:99999999999\n"
+                                          "BIG:2147483648\n"
+                                          "CH0[S2M_VDD_CPUCL2], 4294967296\n"
+                                          "battery_cycle:2147483647\n"
+                                          "MID:1500000\n"
+                                          "CH1[S3M_VDD_CPUCL1], 1037\n",
+                                          &info));
+    EXPECT_EQ(info.battery_soc_, kDefaultBatterySoc);
+    EXPECT_EQ(info.battery_temp_, kDefaultBatteryTemp);
+    EXPECT_EQ(info.voltage_now_, kDefaultBatteryVolt);
+    EXPECT_EQ(info.battery_cycle_, 2147483647);
+    // A skipped line doesn't take a DVFS domain or an ODPM channel
+    EXPECT_EQ(info.dvfs_value_[0], 1500000);
+    EXPECT_EQ(info.dvfs_value_[1], 0);
+    EXPECT_EQ(info.odpm_value_[0], 1037);
+    EXPECT_EQ(info.odpm_value_[1], 0);
+}
+
+TEST(BrownoutDetectedReporterTest, MalformedLinesAreIgnored) {
+    MockBrownoutDetectedReporter reporter;
+    BrownoutDetectedInfo info = defaultInfo();
+    ASSERT_TRUE(reporter.parseBrownoutLog("soc:-5\n"
+                                          "soc:\n"
+                                          "battery: 250\n"
+                                          "voltage_now:3800000mV\n"
+                                          "big:1800000\n"
+                                          "CH[S2M_VDD_CPUCL2], 1000\n"
+                                          "CH0[S2M_VDD_CPUCL2] 1000\n"
+                                          "batoilo triggered\n"
+                                          "2024-03-12\n",
+                                          &info));
+    EXPECT_EQ(info.battery_soc_, kDefaultBatterySoc);
+    EXPECT_EQ(info.battery_temp_, kDefaultBatteryTemp);
+    EXPECT_EQ(info.voltage_now_, kDefaultBatteryVolt);
+    EXPECT_EQ(info.dvfs_value_[0], 0);
+    EXPECT_EQ(info.odpm_value_[0], 0);
+    EXPECT_EQ(info.triggered_irq_, 0);
+    EXPECT_EQ(info.triggered_timestamp_, 0);
+}
+
+}  // namespace pixel
+}  // namespace google
+}  // namespace hardware
+}  // namespace android
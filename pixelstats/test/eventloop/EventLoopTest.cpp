@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/unique_fd.h>
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <pixelstats/EventLoop.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace android {
+namespace hardware {
+namespace google {
+namespace pixel {
+
+using android::base::boot_clock;
+using std::chrono::hours;
+using std::chrono::milliseconds;
+using std::chrono::minutes;
+
+namespace {
+
+// Runs the due timers on a clock set by the test, as if the device slept in between
+class FakeClockEventLoop : public EventLoop {
+  public:
+    using EventLoop::runDueTimers;
+
+    void advance(milliseconds duration) { now_ += duration; }
+
+  private:
+    TimePoint now() override { return now_; }
+
+    TimePoint now_ = TimePoint(hours(1));
+};
+
+// A pipe with a byte written to it, its read end stays readable
+struct ReadablePipe {
+    ReadablePipe() {
+        int fds[2];
+        EXPECT_EQ(pipe2(fds, O_CLOEXEC), 0);
+        read_fd.reset(fds[0]);
+        write_fd.reset(fds[1]);
+        EXPECT_EQ(write(write_fd, "x", 1), 1);
+    }
+
+    android::base::unique_fd read_fd;
+    android::base::unique_fd write_fd;
+};
+
+}  // namespace
+
+TEST(EventLoopTest, TimerWithSlackSharesTheWakeupOfAnother) {
+    EventLoop loop;
+    const auto start = boot_clock::now();
+    std::vector<std::string> runs;
+    boot_clock::time_point slack_run_time;
+    loop.addTimer("Tight", milliseconds(100), milliseconds(0), milliseconds(0), [&] {
+        runs.push_back("tight");
+        loop.stop();
+    });
+    // Due first, but its slack lets it wait for the tight timer
+    loop.addTimer("Slack", milliseconds(20), milliseconds(0), milliseconds(500), [&] {
+        runs.push_back("slack");
+        slack_run_time = boot_clock::now();
+        loop.stop();
+    });
+    loop.run();
+
+    // Both ran on the one wakeup, which stopped the loop
+    EXPECT_EQ(runs, std::vector<std::string>({"tight", "slack"}));
+    EXPECT_GE(slack_run_time - start, milliseconds(100));
+}
+
+TEST(EventLoopTest, PeriodsMissedWhileAsleepAreSkippedWithoutDrift) {
+    FakeClockEventLoop loop;
+    int runs = 0;
+    loop.addTimer("Hourly", hours(1), hours(1), milliseconds(0), [&] { runs++; });
+
+    loop.advance(hours(1) - milliseconds(1));
+    loop.runDueTimers();
+    EXPECT_EQ(runs, 0);
+    // A late wakeup doesn't move the next deadline
+    loop.advance(milliseconds(1) + minutes(10));
+    loop.runDueTimers();
+    EXPECT_EQ(runs, 1);
+    loop.advance(minutes(50) - milliseconds(1));
+    loop.runDueTimers();
+    EXPECT_EQ(runs, 1);
+    loop.advance(milliseconds(1));
+    loop.runDueTimers();
+    EXPECT_EQ(runs, 2);
+
+    // Asleep for 3.5 periods: one run for all of them, then back on the hour
+    loop.advance(hours(3) + minutes(30));
+    loop.runDueTimers();
+    EXPECT_EQ(runs, 3);
+    loop.advance(minutes(30) - milliseconds(1));
+    loop.runDueTimers();
+    EXPECT_EQ(runs, 3);
+    loop.advance(milliseconds(1));
+    loop.runDueTimers();
+    EXPECT_EQ(runs, 4);
+}
+
+TEST(EventLoopTest, FdRemovedDuringDispatchIsNotRun) {
+    EventLoop loop;
+    ReadablePipe first;
+    ReadablePipe second;
+    int runs = 0;
+    // Both fds are ready on the same wakeup; whichever runs first removes both
+    auto remove_both = [&] {
+        runs++;
+        loop.removeFd(first.read_fd);
+        loop.removeFd(second.read_fd);
+    };
+    ASSERT_TRUE(loop.addFd(first.read_fd, remove_both));
+    ASSERT_TRUE(loop.addFd(second.read_fd, remove_both));
+    loop.addTimer("Stop", milliseconds(50), milliseconds(0), milliseconds(0),
+                  [&] { loop.stop(); });
+    loop.run();
+
+    EXPECT_EQ(runs, 1);
+}
+
+}  // namespace pixel
+}  // namespace google
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/stringprintf.h>
+#include <fuzzer/FuzzedDataProvider.h>
+#include <pixelstats/BatteryHistoryDecoder.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using android::base::StringPrintf;
+using android::hardware::google::pixel::BatteryHistoryExtend;
+using android::hardware::google::pixel::decodeBatteryHistoryExtend;
+using android::hardware::google::pixel::scanHexFields;
+
+namespace {
+
+// Malformed input: any bytes, scanned with any field widths
+void fuzzScan(FuzzedDataProvider *fdp) {
+    const int count = fdp->ConsumeIntegralInRange<int>(0, 32);
+    std::vector<uint8_t> max_digits(count);
+    for (uint8_t &digits : max_digits) {
+        digits = fdp->ConsumeIntegralInRange<uint8_t>(0, 20);
+    }
+    std::vector<uint32_t> values(count);
+    const std::string text = fdp->ConsumeRandomLengthString(256);
+    const int scanned = scanHexFields(text, max_digits.data(), count, values.data());
+    if (scanned < 0 || scanned > count) {
+        abort();
+    }
+
+    BatteryHistoryExtend hist;
+    decodeBatteryHistoryExtend(text, &hist);
+}
+
+// Well formed input: an entry printed as the driver does must decode to its fields
+void fuzzRoundTrip(FuzzedDataProvider *fdp) {
+    const uint16_t tempco = fdp->ConsumeIntegral<uint16_t>();
+    const uint16_t rcomp0 = fdp->ConsumeIntegral<uint16_t>();
+    const uint64_t word = fdp->ConsumeIntegral<uint64_t>();
+    const std::string line =
+            StringPrintf("%04x%04x%04x %04x %04x %04x\n", tempco, rcomp0,
+                         static_cast<unsigned>(word & 0xFFFF),
+                         static_cast<unsigned>((word >> 16) & 0xFFFF),
+                         static_cast<unsigned>((word >> 32) & 0xFFFF),
+                         static_cast<unsigned>(word >> 48));
+
+    BatteryHistoryExtend hist;
+    const bool decoded = decodeBatteryHistoryExtend(line, &hist);
+    if (decoded != !((tempco == 0xFFFF && rcomp0 == 0xFFFF) || word == 0)) {
+        abort();
+    }
+    if (!decoded) {
+        return;
+    }
+    const uint64_t packed = static_cast<uint64_t>(hist.maxdischgcurr) << 60 |
+                            static_cast<uint64_t>(hist.maxchgcurr) << 56 |
+                            static_cast<uint64_t>(hist.mintemp) << 52 |
+                            static_cast<uint64_t>(hist.maxtemp) << 48 |
+                            static_cast<uint64_t>(hist.minvolt) << 44 |
+                            static_cast<uint64_t>(hist.maxvolt) << 40 |
+                            static_cast<uint64_t>(hist.vfsoc) << 34 |
+                            static_cast<uint64_t>(hist.mixsoc) << 28 |
+                            static_cast<uint64_t>(hist.fullcaprep) << 18 |
+                            static_cast<uint64_t>(hist.fullcapnom) << 8 | hist.timer_h;
+    if (hist.tempco != tempco || hist.rcomp0 != rcomp0 || packed != word) {
+        abort();
+    }
+}
+
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    FuzzedDataProvider fdp(data, size);
+
+    if (fdp.ConsumeBool()) {
+        fuzzScan(&fdp);
+    } else {
+        fuzzRoundTrip(&fdp);
+    }
+    return 0;
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/file.h>
+#include <benchmark/benchmark.h>
+#include <pixelstats/MmMetricsReporter.h>
+
+#include <string>
+#include <vector>
+
+#include "MockMmMetricsReporter.h"
+
+namespace android {
+namespace hardware {
+namespace google {
+namespace pixel {
+namespace {
+
+// The test data is installed next to the benchmark binary
+std::string dataPath(const char *set) {
+    return android::base::GetExecutableDirectory() + "/data/" + set;
+}
+
+// One 5 minute PSI sample, reading the three /proc/pressure files
+void BM_AggregatePer5Min(benchmark::State &state) {
+    MockMmMetricsReporter mreport;
+    mreport.setBasePath(dataPath("test_data_0"));
+    for (auto _ : state) {
+        mreport.aggregatePixelMmMetricsPer5Min();
+    }
+}
+BENCHMARK(BM_AggregatePer5Min);
+
+// The hourly atom: meminfo, vmstat, the pixel vmstat and the heap sizes
+void BM_GenPerHour(benchmark::State &state) {
+    MockMmMetricsReporter mreport;
+    mreport.setBasePath(dataPath("test_data_0"));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(mreport.genPixelMmMetricsPerHour());
+    }
+}
+BENCHMARK(BM_GenPerHour);
+
+// The daily atom, adding /proc/stat, the kthread stats and the PSI and CMA diffs
+void BM_GenPerDay(benchmark::State &state) {
+    MockMmMetricsReporter mreport;
+    mreport.setBasePath(dataPath("test_data_0"));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(mreport.genPixelMmMetricsPerDay());
+    }
+}
+BENCHMARK(BM_GenPerDay);
+
+void BM_ReadOomGroupUsage(benchmark::State &state) {
+    MockMmMetricsReporter mreport;
+    mreport.setBasePath(dataPath("test_data_0"));
+    std::vector<MmMetricsReporter::OomGroupMemUsage> ogusage;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(mreport.readMmProcessUsageByOomGroup(&ogusage));
+    }
+}
+BENCHMARK(BM_ReadOomGroupUsage);
+
+}  // namespace
+}  // namespace pixel
+}  // namespace google
+}  // namespace hardware
+}  // namespace android
+
+BENCHMARK_MAIN();
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <android-base/file.h>
 #include <gtest/gtest.h>
 #include <pixelstats/MmMetricsReporter.h>
 #include <sys/stat.h>
@@ -372,6 +373,65 @@ TEST(MmMetricsReporterTest, MmMetricsGcmaPerDaySuccess) {
     }
 }
 
+// Create <proc_root>/<pid>/comm, as the kernel would for a thread named comm
+static void writeFakeProcComm(const std::string &proc_root, int pid, const std::string &comm) {
+    const std::string pid_dir = proc_root + "/" + std::to_string(pid);
+    ASSERT_TRUE(mkdir(pid_dir.c_str(), 0755) == 0 || errno == EEXIST);
+    ASSERT_TRUE(android::base::WriteStringToFile(comm + "\n", pid_dir + "/comm"));
+}
+
+TEST(MmMetricsReporterTest, ProcessStatPathReusesTheCachedPid) {
+    TemporaryDir base_dir;
+    const std::string proc_root = std::string(base_dir.path) + "/proc";
+    ASSERT_EQ(mkdir(proc_root.c_str(), 0755), 0);
+    MockMmMetricsReporter mreport;
+    mreport.setBasePath(base_dir.path);
+
+    writeFakeProcComm(proc_root, 42, "kswapd0");
+    int pid = -1;
+    EXPECT_EQ(mreport.getProcessStatPath("kswapd0", &pid), proc_root + "/42/stat");
+    EXPECT_EQ(pid, 42);
+
+    // Both pids match, whatever order /proc is walked in; only the cached one is returned
+    writeFakeProcComm(proc_root, 43, "kswapd0");
+    EXPECT_EQ(mreport.getProcessStatPath("kswapd0", &pid), proc_root + "/42/stat");
+    EXPECT_EQ(pid, 42);
+    pid = 43;
+    EXPECT_EQ(mreport.getProcessStatPath("kswapd0", &pid), proc_root + "/43/stat");
+    EXPECT_EQ(pid, 43);
+}
+
+TEST(MmMetricsReporterTest, ProcessStatPathFallsBackToTheWalkOnAStalePid) {
+    TemporaryDir base_dir;
+    const std::string proc_root = std::string(base_dir.path) + "/proc";
+    ASSERT_EQ(mkdir(proc_root.c_str(), 0755), 0);
+    MockMmMetricsReporter mreport;
+    mreport.setBasePath(base_dir.path);
+
+    // pid 1 is never looked at, nor are the entries which are not pids
+    writeFakeProcComm(proc_root, 1, "kcompactd0");
+    ASSERT_EQ(mkdir((proc_root + "/self").c_str(), 0755), 0);
+    ASSERT_TRUE(android::base::WriteStringToFile("kcompactd0\n", proc_root + "/self/comm"));
+    int pid = -1;
+    EXPECT_EQ(mreport.getProcessStatPath("kcompactd0", &pid), "");
+    EXPECT_EQ(pid, -1);
+
+    writeFakeProcComm(proc_root, 84, "kcompactd0");
+    EXPECT_EQ(mreport.getProcessStatPath("kcompactd0", &pid), proc_root + "/84/stat");
+    EXPECT_EQ(pid, 84);
+
+    // The thread respawned and its pid was reused by another one
+    writeFakeProcComm(proc_root, 84, "kworker/0:1");
+    writeFakeProcComm(proc_root, 97, "kcompactd0");
+    EXPECT_EQ(mreport.getProcessStatPath("kcompactd0", &pid), proc_root + "/97/stat");
+    EXPECT_EQ(pid, 97);
+
+    // The cached pid exited
+    pid = 120;
+    EXPECT_EQ(mreport.getProcessStatPath("kcompactd0", &pid), proc_root + "/97/stat");
+    EXPECT_EQ(pid, 97);
+}
+
 }  // namespace pixel
 }  // namespace google
 }  // namespace hardware
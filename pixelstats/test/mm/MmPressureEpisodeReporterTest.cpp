@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <hardware/google/pixel/pixelstats/pixelatoms.pb.h>
+
+#include "MockMmPressureEpisodeReporter.h"
+#include "VendorAtomIntValueUtil.h"
+
+namespace android {
+namespace hardware {
+namespace google {
+namespace pixel {
+
+using android::hardware::google::pixel::PixelAtoms::MmMemoryPressureEpisode;
+
+namespace {
+
+const std::string kDataPath = "/data/local/tmp/test/pixelstats_mm_test/data/pressure_episode";
+constexpr std::chrono::milliseconds kSamplePeriod(100);
+constexpr int kVendorAtomOffset = 2;
+
+int64_t getField(const VendorAtom &atom, int field) {
+    return getVendorAtomIntValue(atom.values[field - kVendorAtomOffset]);
+}
+
+// Samples the data set of dir, count times, as the sample timer would
+bool sampleFrom(MockMmPressureEpisodeReporter *reporter, const char *dir, int count) {
+    reporter->setBasePath(kDataPath + "/" + dir);
+    bool ongoing = true;
+    for (int i = 0; i < count; i++) {
+        reporter->advance(kSamplePeriod);
+        ongoing = reporter->sampleEpisode();
+    }
+    return ongoing;
+}
+
+}  // namespace
+
+TEST(MmPressureEpisodeReporterTest, PercentileIsNearestRank) {
+    uint32_t values[] = {50, 10, 40, 20, 30};
+    EXPECT_EQ(MockMmPressureEpisodeReporter::percentile(values, 5, 50), 30);
+    EXPECT_EQ(MockMmPressureEpisodeReporter::percentile(values, 5, 90), 50);
+    EXPECT_EQ(MockMmPressureEpisodeReporter::percentile(values, 5, 0), 10);
+    EXPECT_EQ(MockMmPressureEpisodeReporter::percentile(values, 5, 100), 50);
+
+    uint32_t single[] = {7};
+    EXPECT_EQ(MockMmPressureEpisodeReporter::percentile(single, 1, 50), 7);
+    EXPECT_EQ(MockMmPressureEpisodeReporter::percentile(single, 1, 99), 7);
+
+    // Rank 90 of 100 is the 90th smallest value, not the 91st
+    uint32_t hundred[100];
+    for (uint32_t i = 0; i < 100; i++) {
+        hundred[i] = 100 - i;
+    }
+    EXPECT_EQ(MockMmPressureEpisodeReporter::percentile(hundred, 100, 90), 90);
+    EXPECT_EQ(MockMmPressureEpisodeReporter::percentile(hundred, 100, 99), 99);
+}
+
+TEST(MmPressureEpisodeReporterTest, EpisodeEndsAfterOneQuietSecond) {
+    MockMmPressureEpisodeReporter reporter;
+    reporter.setBasePath(kDataPath + "/start");
+    ASSERT_TRUE(reporter.startEpisode());
+    // A trigger during the episode doesn't restart it
+    EXPECT_FALSE(reporter.startEpisode());
+
+    EXPECT_TRUE(sampleFrom(&reporter, "stall_1", 1));
+    EXPECT_TRUE(sampleFrom(&reporter, "stall_2", 1));
+    // 9 quiet samples are not enough to end the episode, the 10th is
+    EXPECT_TRUE(sampleFrom(&reporter, "quiet", 9));
+    EXPECT_TRUE(reporter.atoms().empty());
+    EXPECT_FALSE(sampleFrom(&reporter, "quiet", 1));
+
+    ASSERT_EQ(reporter.atoms().size(), 1);
+    const VendorAtom &atom = reporter.atoms()[0];
+    EXPECT_EQ(atom.atomId, PixelAtoms::Atom::kMmMemoryPressureEpisode);
+    ASSERT_EQ(atom.values.size(),
+              MmMemoryPressureEpisode::kPswpinFieldNumber - kVendorAtomOffset + 1);
+    // The episode ends with its last stalled sample, the 10 quiet samples are left out
+    EXPECT_EQ(getField(atom, MmMemoryPressureEpisode::kDurationMsFieldNumber), 200);
+    EXPECT_EQ(getField(atom, MmMemoryPressureEpisode::kSamplePeriodMsFieldNumber), 100);
+    EXPECT_EQ(getField(atom, MmMemoryPressureEpisode::kSampleCountFieldNumber), 2);
+    EXPECT_EQ(getField(atom, MmMemoryPressureEpisode::kSomeStallTotalUsFieldNumber), 30000);
+    EXPECT_EQ(getField(atom, MmMemoryPressureEpisode::kFullStallTotalUsFieldNumber), 6000);
+    // Per sample stall: 10000 and 20000 us some, 2000 and 4000 us full
+    EXPECT_EQ(getField(atom, MmMemoryPressureEpisode::kSomeStallP50UsFieldNumber), 10000);
+    EXPECT_EQ(getField(atom, MmMemoryPressureEpisode::kSomeStallP90UsFieldNumber), 20000);
+    EXPECT_EQ(getField(atom, MmMemoryPressureEpisode::kSomeStallP99UsFieldNumber), 20000);
+    EXPECT_EQ(getField(atom, MmMemoryPressureEpisode::kSomeStallMaxUsFieldNumber), 20000);
+    EXPECT_EQ(getField(atom, MmMemoryPressureEpisode::kFullStallP50UsFieldNumber), 2000);
+    EXPECT_EQ(getField(atom, MmMemoryPressureEpisode::kFullStallP90UsFieldNumber), 4000);
+    EXPECT_EQ(getField(atom, MmMemoryPressureEpisode::kFullStallP99UsFieldNumber), 4000);
+    EXPECT_EQ(getField(atom, MmMemoryPressureEpisode::kFullStallMaxUsFieldNumber), 4000);
+    EXPECT_EQ(getField(atom, MmMemoryPressureEpisode::kPgscanKswapdFieldNumber), 1300);
+    EXPECT_EQ(getField(atom, MmMemoryPressureEpisode::kPgscanDirectFieldNumber), 120);
+    EXPECT_EQ(getField(atom, MmMemoryPressureEpisode::kWorkingsetRefaultFileFieldNumber), 1000);
+    EXPECT_EQ(getField(atom, MmMemoryPressureEpisode::kPswpinFieldNumber), 30);
+}
+
+TEST(MmPressureEpisodeReporterTest, StallResetsTheQuietCount) {
+    MockMmPressureEpisodeReporter reporter;
+    reporter.setBasePath(kDataPath + "/start");
+    ASSERT_TRUE(reporter.startEpisode());
+
+    EXPECT_TRUE(sampleFrom(&reporter, "stall_1", 1));
+    EXPECT_TRUE(sampleFrom(&reporter, "quiet", 9));
+    EXPECT_TRUE(sampleFrom(&reporter, "stall_again", 1));
+    EXPECT_TRUE(sampleFrom(&reporter, "quiet_again", 9));
+    EXPECT_TRUE(reporter.atoms().empty());
+    EXPECT_FALSE(sampleFrom(&reporter, "quiet_again", 1));
+    ASSERT_EQ(reporter.atoms().size(), 1);
+    EXPECT_EQ(getField(reporter.atoms()[0], MmMemoryPressureEpisode::kSampleCountFieldNumber),
+              11);
+}
+
+TEST(MmPressureEpisodeReporterTest, EpisodeIsCutAfterFiveMinutes) {
+    MockMmPressureEpisodeReporter reporter;
+    reporter.setBasePath(kDataPath + "/start");
+    ASSERT_TRUE(reporter.startEpisode());
+
+    EXPECT_TRUE(sampleFrom(&reporter, "stall_1", 1));
+    reporter.advance(std::chrono::minutes(5) - 3 * kSamplePeriod);
+    EXPECT_TRUE(sampleFrom(&reporter, "stall_2", 1));
+    // One quiet sample is far from the end, yet the episode is over
+    EXPECT_FALSE(sampleFrom(&reporter, "stall_2", 1));
+
+    ASSERT_EQ(reporter.atoms().size(), 1);
+    const VendorAtom &atom = reporter.atoms()[0];
+    EXPECT_EQ(getField(atom, MmMemoryPressureEpisode::kDurationMsFieldNumber), 299900);
+    EXPECT_EQ(getField(atom, MmMemoryPressureEpisode::kSampleCountFieldNumber), 2);
+}
+
+TEST(MmPressureEpisodeReporterTest, NoEpisodeStartsWithinFiveMinutesOfTheLast) {
+    MockMmPressureEpisodeReporter reporter;
+    reporter.setBasePath(kDataPath + "/quiet");
+    ASSERT_TRUE(reporter.startEpisode());
+    EXPECT_FALSE(sampleFrom(&reporter, "quiet", 10));
+    ASSERT_EQ(reporter.atoms().size(), 1);
+    // Without any stalled sample, there is nothing to take percentiles of
+    const VendorAtom &atom = reporter.atoms()[0];
+    EXPECT_EQ(getField(atom, MmMemoryPressureEpisode::kDurationMsFieldNumber), 0);
+    EXPECT_EQ(getField(atom, MmMemoryPressureEpisode::kSampleCountFieldNumber), 0);
+    EXPECT_EQ(getField(atom, MmMemoryPressureEpisode::kSomeStallP50UsFieldNumber), 0);
+    EXPECT_EQ(getField(atom, MmMemoryPressureEpisode::kFullStallP99UsFieldNumber), 0);
+
+    EXPECT_FALSE(reporter.startEpisode());
+    reporter.advance(std::chrono::minutes(5) - std::chrono::milliseconds(1));
+    EXPECT_FALSE(reporter.startEpisode());
+    reporter.advance(std::chrono::milliseconds(1));
+    EXPECT_TRUE(reporter.startEpisode());
+    EXPECT_FALSE(sampleFrom(&reporter, "quiet", 10));
+    EXPECT_EQ(reporter.atoms().size(), 2);
+}
+
+TEST(MmPressureEpisodeReporterTest, UnreadableFilesEndTheEpisodeUnreported) {
+    MockMmPressureEpisodeReporter reporter;
+    reporter.setBasePath(kDataPath + "/not_found");
+    EXPECT_FALSE(reporter.startEpisode());
+
+    reporter.setBasePath(kDataPath + "/start");
+    ASSERT_TRUE(reporter.startEpisode());
+    EXPECT_TRUE(sampleFrom(&reporter, "stall_1", 1));
+    EXPECT_FALSE(sampleFrom(&reporter, "not_found", 1));
+    EXPECT_TRUE(reporter.atoms().empty());
+    // Nothing was reported, so no cooldown either
+    reporter.setBasePath(kDataPath + "/start");
+    EXPECT_TRUE(reporter.startEpisode());
+}
+
+}  // namespace pixel
+}  // namespace google
+}  // namespace hardware
+}  // namespace android
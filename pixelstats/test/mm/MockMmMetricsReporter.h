@@ -43,6 +43,7 @@ class MockMmMetricsReporter : public MmMetricsReporter {
     MockMmMetricsReporter() : MmMetricsReporter() {}
     virtual ~MockMmMetricsReporter() {}
     void setBasePath(const std::string &path) { base_path_ = path; }
+    using MmMetricsReporter::getProcessStatPath;
 
   private:
     /**
@@ -80,8 +81,6 @@ class MockMmMetricsReporter : public MmMetricsReporter {
             {"/proc/pressure/cpu", "psi_cpu"},
             {"/proc/pressure/io", "psi_io"},
             {"/proc/pressure/memory", "psi_memory"},
-            {"kswapd0", "kswapd0_stat"},
-            {"kcompactd0", "kcompactd0_stat"},
             {"/proc/vendor_mm/memory_usage_by_oom_score", "oom_mm_usage"},
             {"/sys/kernel/vendor_mm/gcma/cached", "gcma_cached"},
             {"/sys/kernel/vendor_mm/gcma/discarded", "gcma_discarded"},
@@ -108,10 +107,9 @@ class MockMmMetricsReporter : public MmMetricsReporter {
         }
     }
 
-    virtual std::string getProcessStatPath(const std::string &name, int *prev_pid) {
-        (void)(prev_pid);  // unused parameter
-        return getSysfsPath(name);
-    }
+    // The kernel threads are looked up in the proc directory of the data set, with the
+    // /proc/<pid>/comm and /proc/<pid>/stat files of each
+    virtual std::string getProcRoot() { return base_path_ + "/proc"; }
 };
 
 }  // namespace pixel
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HARDWARE_GOOGLE_PIXEL_PIXELSTATS_TEST_MOCKMMPRESSUREEPISODE_H
+#define HARDWARE_GOOGLE_PIXEL_PIXELSTATS_TEST_MOCKMMPRESSUREEPISODE_H
+
+#include <aidl/android/frameworks/stats/BnStats.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "pixelstats/MmPressureEpisodeReporter.h"
+
+namespace android {
+namespace hardware {
+namespace google {
+namespace pixel {
+
+using aidl::android::frameworks::stats::BnStats;
+using aidl::android::frameworks::stats::VendorAtom;
+
+/**
+ * IStats keeping the reported atoms
+ */
+class RecordingStats : public BnStats {
+  public:
+    ndk::ScopedAStatus reportVendorAtom(const VendorAtom &atom) override {
+        atoms.push_back(atom);
+        return ndk::ScopedAStatus::ok();
+    }
+
+    std::vector<VendorAtom> atoms;
+};
+
+/**
+ * mock version of MmPressureEpisodeReporter class, reading the proc files from a test data
+ * directory, on a clock set by the test, and reporting to a RecordingStats
+ */
+class MockMmPressureEpisodeReporter : public MmPressureEpisodeReporter {
+  public:
+    using MmPressureEpisodeReporter::percentile;
+    using MmPressureEpisodeReporter::sampleEpisode;
+    using MmPressureEpisodeReporter::startEpisode;
+
+    MockMmPressureEpisodeReporter()
+        : stats_(ndk::SharedRefBase::make<RecordingStats>()),
+          now_(android::base::boot_clock::time_point(std::chrono::hours(1))) {}
+
+    // Directory of the proc files read by the next start or sample
+    void setBasePath(const std::string &path) { base_path_ = path; }
+    void advance(std::chrono::milliseconds duration) { now_ += duration; }
+    const std::vector<VendorAtom> &atoms() const { return stats_->atoms; }
+
+  private:
+    const std::map<const std::string, const char *> mock_path_map = {
+            {"/proc/pressure/memory", "psi_memory"},
+            {"/proc/vmstat", "proc_vmstat"},
+    };
+
+    std::string getProcPath(const char *path) override {
+        const auto it = mock_path_map.find(path);
+        return base_path_ + '/' + (it == mock_path_map.end() ? "not_found" : it->second);
+    }
+    android::base::boot_clock::time_point now() override { return now_; }
+    std::shared_ptr<IStats> getStatsClient() override { return stats_; }
+
+    const std::shared_ptr<RecordingStats> stats_;
+    std::string base_path_;
+    android::base::boot_clock::time_point now_;
+};
+
+}  // namespace pixel
+}  // namespace google
+}  // namespace hardware
+}  // namespace android
+
+#endif  // HARDWARE_GOOGLE_PIXEL_PIXELSTATS_TEST_MOCKMMPRESSUREEPISODE_H
@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <pixelstats/AsyncStatsClient.h>
+
+#include <chrono>
+#include <condition_variable>
+
+namespace android {
+namespace hardware {
+namespace google {
+namespace pixel {
+
+namespace {
+
+constexpr std::chrono::seconds kTimeout(5);
+
+// Records the atoms it gets; it can hold the sender in reportVendorAtom() or fail every call
+class FakeStats : public BnStats {
+  public:
+    explicit FakeStats(binder_status_t status = STATUS_OK) : status_(status) {}
+
+    ndk::ScopedAStatus reportVendorAtom(const VendorAtom &atom) override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        calls_++;
+        sender_thread_ = std::this_thread::get_id();
+        cv_.notify_all();
+        cv_.wait(lock, [this] { return !held_; });
+        if (status_ != STATUS_OK) {
+            return ndk::ScopedAStatus::fromStatus(status_);
+        }
+        atom_ids_.push_back(atom.atomId);
+        cv_.notify_all();
+        return ndk::ScopedAStatus::ok();
+    }
+
+    void hold() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        held_ = true;
+    }
+
+    void release() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        held_ = false;
+        cv_.notify_all();
+    }
+
+    bool waitForCalls(size_t count) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_for(lock, kTimeout, [&] { return calls_ >= count; });
+    }
+
+    bool waitForAtoms(size_t count) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_for(lock, kTimeout, [&] { return atom_ids_.size() >= count; });
+    }
+
+    std::vector<int32_t> atomIds() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return atom_ids_;
+    }
+
+    std::thread::id senderThread() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return sender_thread_;
+    }
+
+  private:
+    const binder_status_t status_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool held_ = false;
+    size_t calls_ = 0;
+    std::vector<int32_t> atom_ids_;
+    std::thread::id sender_thread_;
+};
+
+VendorAtom makeAtom(int32_t atom_id) {
+    VendorAtom atom;
+    atom.atomId = atom_id;
+    return atom;
+}
+
+bool waitForDropped(const AsyncStatsClient &client, size_t count) {
+    const auto deadline = std::chrono::steady_clock::now() + kTimeout;
+    while (client.droppedAtoms() < count) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+}  // namespace
+
+TEST(AsyncStatsClientTest, SendsQueuedAtomsInOrderFromSenderThread) {
+    auto stats = ndk::SharedRefBase::make<FakeStats>();
+    auto client = ndk::SharedRefBase::make<AsyncStatsClient>([stats] { return stats; }, 128);
+
+    std::vector<int32_t> expected;
+    for (int32_t i = 0; i < 100; i++) {
+        ASSERT_TRUE(client->reportVendorAtom(makeAtom(i)).isOk());
+        expected.push_back(i);
+    }
+
+    ASSERT_TRUE(stats->waitForAtoms(expected.size()));
+    EXPECT_EQ(stats->atomIds(), expected);
+    EXPECT_NE(stats->senderThread(), std::this_thread::get_id());
+    EXPECT_EQ(client->droppedAtoms(), 0);
+}
+
+TEST(AsyncStatsClientTest, DropsAtomsWhenRingIsFull) {
+    auto stats = ndk::SharedRefBase::make<FakeStats>();
+    auto client = ndk::SharedRefBase::make<AsyncStatsClient>([stats] { return stats; }, 4);
+
+    // Hold the sender in the stats call, the ring is empty again once it took atom 0
+    stats->hold();
+    ASSERT_TRUE(client->reportVendorAtom(makeAtom(0)).isOk());
+    ASSERT_TRUE(stats->waitForCalls(1));
+
+    for (int32_t i = 1; i <= 4; i++) {
+        EXPECT_TRUE(client->reportVendorAtom(makeAtom(i)).isOk());
+    }
+    EXPECT_FALSE(client->reportVendorAtom(makeAtom(5)).isOk());
+    EXPECT_EQ(client->droppedAtoms(), 1);
+
+    stats->release();
+    ASSERT_TRUE(stats->waitForAtoms(5));
+    EXPECT_EQ(stats->atomIds(), std::vector<int32_t>({0, 1, 2, 3, 4}));
+    EXPECT_EQ(client->droppedAtoms(), 1);
+}
+
+TEST(AsyncStatsClientTest, RetriesOnNewBinderWhenServiceDied) {
+    auto dead_stats = ndk::SharedRefBase::make<FakeStats>(STATUS_DEAD_OBJECT);
+    auto stats = ndk::SharedRefBase::make<FakeStats>();
+    std::atomic<int> lookups = 0;
+    auto client = ndk::SharedRefBase::make<AsyncStatsClient>(
+            [&]() -> std::shared_ptr<IStats> {
+                return lookups++ == 0 ? dead_stats : stats;
+            },
+            4);
+
+    ASSERT_TRUE(client->reportVendorAtom(makeAtom(1)).isOk());
+    ASSERT_TRUE(stats->waitForAtoms(1));
+    EXPECT_EQ(stats->atomIds(), std::vector<int32_t>({1}));
+    EXPECT_TRUE(dead_stats->atomIds().empty());
+    EXPECT_EQ(lookups, 2);
+
+    // The new binder is kept for the next atoms
+    ASSERT_TRUE(client->reportVendorAtom(makeAtom(2)).isOk());
+    ASSERT_TRUE(stats->waitForAtoms(2));
+    EXPECT_EQ(lookups, 2);
+    EXPECT_EQ(client->droppedAtoms(), 0);
+}
+
+TEST(AsyncStatsClientTest, CountsAtomsWhichCantBeDelivered) {
+    auto failing_stats = ndk::SharedRefBase::make<FakeStats>(STATUS_UNKNOWN_ERROR);
+    std::atomic<bool> has_service = false;
+    auto client = ndk::SharedRefBase::make<AsyncStatsClient>(
+            [&]() -> std::shared_ptr<IStats> {
+                return has_service ? failing_stats : nullptr;
+            },
+            4);
+
+    // Queued even without a stats service, the drop is only seen on the sender thread
+    ASSERT_TRUE(client->reportVendorAtom(makeAtom(1)).isOk());
+    ASSERT_TRUE(client->reportVendorAtom(makeAtom(2)).isOk());
+    ASSERT_TRUE(waitForDropped(*client, 2));
+
+    has_service = true;
+    ASSERT_TRUE(client->reportVendorAtom(makeAtom(3)).isOk());
+    ASSERT_TRUE(waitForDropped(*client, 3));
+    EXPECT_TRUE(failing_stats->atomIds().empty());
+}
+
+TEST(AsyncStatsClientTest, SendsQueuedAtomsBeforeStopping) {
+    auto stats = ndk::SharedRefBase::make<FakeStats>();
+    auto client = ndk::SharedRefBase::make<AsyncStatsClient>([stats] { return stats; }, 16);
+
+    stats->hold();
+    for (int32_t i = 0; i < 8; i++) {
+        ASSERT_TRUE(client->reportVendorAtom(makeAtom(i)).isOk());
+    }
+    stats->release();
+    client.reset();
+
+    EXPECT_EQ(stats->atomIds().size(), 8);
+}
+
+}  // namespace pixel
+}  // namespace google
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HARDWARE_GOOGLE_PIXEL_PIXELSTATS_TEST_MOCKUEVENTLISTENER_H
+#define HARDWARE_GOOGLE_PIXEL_PIXELSTATS_TEST_MOCKUEVENTLISTENER_H
+
+#include <pixelstats/UeventListener.h>
+
+#include <string>
+#include <vector>
+
+namespace android {
+namespace hardware {
+namespace google {
+namespace pixel {
+
+/**
+ * mock version of UeventListener class, recording the handlers a uevent is routed to instead of
+ * running them
+ */
+class MockUeventListener : public UeventListener {
+  public:
+    using UeventListener::UeventListener;
+    using UeventListener::kUeventDevpath;
+    using UeventListener::kUeventDriver;
+    using UeventListener::kUeventGpuEventInfo;
+    using UeventListener::kUeventGpuEventType;
+    using UeventListener::kUeventMicBreakStatus;
+    using UeventListener::kUeventMicDegradeStatus;
+    using UeventListener::kUeventSubsystem;
+    using UeventListener::kUeventThermalAbnormalInfo;
+    using UeventListener::kUeventThermalAbnormalType;
+    using UeventListener::kUeventTypeCPartner;
+    using UeventListener::UeventKey;
+
+    // Names of the reports msg is routed to, in the order they would run. msg is a sequence of
+    // null-terminated "KEY=value" strings ending with a double null, as read from the socket.
+    std::vector<std::string> dispatch(const char *msg) {
+        handlers_.clear();
+        ParseUevent(msg, &fields_);
+        DispatchUevent(fields_);
+        return handlers_;
+    }
+
+    // The field of key in the last uevent dispatched, "" if it had none
+    std::string field(UeventKey key) const { return fields_[key] ? fields_[key] : ""; }
+
+    int handlerRuns() const { return handler_runs_; }
+
+  private:
+    void RunUeventHandlers(const std::vector<const UeventSubscription *> &matched,
+                           const UeventFields &) override {
+        handler_runs_++;
+        for (const UeventSubscription *subscription : matched) {
+            handlers_.push_back(subscription->name);
+        }
+    }
+
+    UeventFields fields_ = {};
+    std::vector<std::string> handlers_;
+    int handler_runs_ = 0;
+};
+
+}  // namespace pixel
+}  // namespace google
+}  // namespace hardware
+}  // namespace android
+
+#endif  // HARDWARE_GOOGLE_PIXEL_PIXELSTATS_TEST_MOCKUEVENTLISTENER_H
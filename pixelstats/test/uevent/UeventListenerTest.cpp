@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "MockUeventListener.h"
+
+namespace android {
+namespace hardware {
+namespace google {
+namespace pixel {
+
+using Handlers = std::vector<std::string>;
+
+namespace {
+
+constexpr const char *kAudioUevent = "/devices/virtual/misc/msm_audio";
+constexpr const char *kSsocDetailsPath = "/sys/class/power_supply/battery/ssoc_details";
+
+// Each string literal is one field, the implicit null of the last one ends the message
+constexpr char kMultiKeyUevent[] =
+        "ACTION=change\0"
+        "DEVPATH=/devices/virtual/misc/msm_audio\0"
+        "DEVTYPE=typec_partner\0"
+        "SUBSYSTEM=power_supply\0"
+        "MIC_BREAK_STATUS=true\0"
+        "MIC_DEGRADE_STATUS=false\0"
+        "DRIVER=google,battery\0"
+        "SEQNUM=1234\0";
+
+}  // namespace
+
+TEST(UeventListenerTest, MultiKeyUeventRunsTheReportsInTheirOrder) {
+    MockUeventListener listener(kAudioUevent, kSsocDetailsPath);
+    // The reports run in the order ProcessUevent always called them, not in field order
+    EXPECT_EQ(listener.dispatch(kMultiKeyUevent),
+              Handlers({"ReportMicStatusUevents", "ReportChargeMetricsEvent",
+                        "ReportBatteryCapacityFGEvent", "ReportTypeCPartnerId"}));
+    EXPECT_EQ(listener.field(MockUeventListener::kUeventMicBreakStatus), "MIC_BREAK_STATUS=true");
+    EXPECT_EQ(listener.field(MockUeventListener::kUeventMicDegradeStatus),
+              "MIC_DEGRADE_STATUS=false");
+
+    EXPECT_EQ(listener.dispatch("DRIVER=mali\0"
+                                "THERMAL_ABNORMAL_INFO=name:battery,val:120\0"
+                                "THERMAL_ABNORMAL_TYPE=EXTREME_HIGH_TEMP\0"
+                                "DEVPATH=/module/pixel_metrics\0"
+                                "GPU_UEVENT_INFO=CSG_SUSPEND\0"
+                                "GPU_UEVENT_TYPE=KMD_ERROR\0"),
+              Handlers({"ReportGpuEvent", "ReportThermalAbnormalEvent"}));
+
+    EXPECT_EQ(listener.dispatch("DRIVER=google,overheat_mitigation\0"),
+              Handlers({"ReportUsbPortOverheatEvent"}));
+    for (const char *driver : {"DRIVER=max77779-fg", "DRIVER=maxfg", "DRIVER=max1720x"}) {
+        // c_str() adds the second null
+        const std::string msg = std::string(driver) + '\0';
+        EXPECT_EQ(listener.dispatch(msg.c_str()), Handlers({"ReportFGMetricsEvent"})) << driver;
+    }
+}
+
+TEST(UeventListenerTest, KeysInTheSameLengthBucketAreToldApart) {
+    MockUeventListener listener(kAudioUevent, kSsocDetailsPath);
+    // DEVPATH, DEVTYPE, DEVNAME and PRODUCT share a bucket, as do DRIVER, ACTION and SEQNUM, the
+    // GPU_UEVENT_ and the THERMAL_ABNORMAL_ keys
+    listener.dispatch("DEVTYPE=usb_device\0"
+                      "DEVPATH=/module/pixel_metrics\0"
+                      "DEVNAME=bus/usb/001\0"
+                      "PRODUCT=18d1/4ee7/404\0"
+                      "ACTION=add\0"
+                      "DRIVER=mali\0"
+                      "SEQNUM=77\0"
+                      "GPU_UEVENT_INFO=CSG_SUSPEND\0"
+                      "GPU_UEVENT_TYPE=KMD_ERROR\0"
+                      "THERMAL_ABNORMAL_INFO=name:battery,val:120\0"
+                      "THERMAL_ABNORMAL_TYPE=EXTREME_HIGH_TEMP\0");
+    EXPECT_EQ(listener.field(MockUeventListener::kUeventDevpath), "DEVPATH=/module/pixel_metrics");
+    EXPECT_EQ(listener.field(MockUeventListener::kUeventTypeCPartner), "DEVTYPE=usb_device");
+    EXPECT_EQ(listener.field(MockUeventListener::kUeventDriver), "DRIVER=mali");
+    EXPECT_EQ(listener.field(MockUeventListener::kUeventGpuEventType), "GPU_UEVENT_TYPE=KMD_ERROR");
+    EXPECT_EQ(listener.field(MockUeventListener::kUeventGpuEventInfo),
+              "GPU_UEVENT_INFO=CSG_SUSPEND");
+    EXPECT_EQ(listener.field(MockUeventListener::kUeventThermalAbnormalType),
+              "THERMAL_ABNORMAL_TYPE=EXTREME_HIGH_TEMP");
+    EXPECT_EQ(listener.field(MockUeventListener::kUeventThermalAbnormalInfo),
+              "THERMAL_ABNORMAL_INFO=name:battery,val:120");
+    EXPECT_EQ(listener.field(MockUeventListener::kUeventSubsystem), "");
+}
+
+TEST(UeventListenerTest, KeysSharingAPrefixAreNotMatched) {
+    MockUeventListener listener(kAudioUevent, kSsocDetailsPath);
+    EXPECT_TRUE(listener.dispatch("DRIVERS=mali\0"
+                                  "DRIVER_OVERRIDE=google,battery\0"
+                                  "DEVPATH_OLD=/module/pixel_metrics\0"
+                                  "SUBSYSTEMS=power_supply\0"
+                                  "DEVTYPES=typec_partner\0"
+                                  "MIC_BREAK=true\0"
+                                  "GPU_UEVENT=KMD_ERROR\0")
+                        .empty());
+    for (const auto key : {MockUeventListener::kUeventDriver, MockUeventListener::kUeventDevpath,
+                           MockUeventListener::kUeventSubsystem,
+                           MockUeventListener::kUeventTypeCPartner,
+                           MockUeventListener::kUeventMicBreakStatus,
+                           MockUeventListener::kUeventGpuEventType}) {
+        EXPECT_EQ(listener.field(key), "") << key;
+    }
+    // Nothing matched, so the stats service isn't even looked up
+    EXPECT_EQ(listener.handlerRuns(), 0);
+}
+
+TEST(UeventListenerTest, ValuesAreMatchedLikeTheReportsDid) {
+    MockUeventListener listener(kAudioUevent, kSsocDetailsPath);
+    // Exact values
+    EXPECT_TRUE(listener.dispatch("DRIVER=google,battery2\0").empty());
+    EXPECT_TRUE(listener.dispatch("DRIVER=maxfg2\0").empty());
+    EXPECT_TRUE(listener.dispatch("SUBSYSTEM=power_supply_ext\0").empty());
+    EXPECT_TRUE(listener.dispatch("DEVPATH=/devices/virtual/misc/msm_audio/extra\0").empty());
+    // Prefixes
+    EXPECT_EQ(listener.dispatch("DRIVER=mali-gpu\0"), Handlers({"ReportGpuEvent"}));
+    EXPECT_EQ(listener.dispatch("DEVPATH=/module/pixel_metrics/parameters\0"),
+              Handlers({"ReportThermalAbnormalEvent"}));
+    EXPECT_EQ(listener.dispatch("DEVTYPE=typec_partner_alt\0"), Handlers({"ReportTypeCPartnerId"}));
+    // The last of repeated keys wins
+    EXPECT_EQ(listener.dispatch("DRIVER=google,battery\0DRIVER=mali\0"),
+              Handlers({"ReportGpuEvent"}));
+    EXPECT_EQ(listener.handlerRuns(), 4);
+}
+
+TEST(UeventListenerTest, UnconfiguredReportsAreNotSubscribed) {
+    MockUeventListener listener("");
+    EXPECT_EQ(listener.dispatch(kMultiKeyUevent),
+              Handlers({"ReportChargeMetricsEvent", "ReportTypeCPartnerId"}));
+}
+
+}  // namespace pixel
+}  // namespace google
+}  // namespace hardware
+}  // namespace android
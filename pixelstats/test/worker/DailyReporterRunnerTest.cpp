@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <pixelstats/DailyReporterRunner.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+
+namespace android {
+namespace hardware {
+namespace google {
+namespace pixel {
+
+namespace {
+
+constexpr std::chrono::seconds kTimeout(5);
+constexpr std::chrono::milliseconds kReporterTimeout(100);
+
+// Records the ids of the atoms it gets
+class FakeStats : public BnStats {
+  public:
+    ndk::ScopedAStatus reportVendorAtom(const VendorAtom &atom) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        atom_ids_.push_back(atom.atomId);
+        cv_.notify_all();
+        return ndk::ScopedAStatus::ok();
+    }
+
+    bool waitForAtoms(size_t count) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_for(lock, kTimeout, [&] { return atom_ids_.size() >= count; });
+    }
+
+    // In the order they came in, unless sorted
+    std::vector<int32_t> atomIds(bool sorted = false) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<int32_t> ids = atom_ids_;
+        if (sorted) {
+            std::sort(ids.begin(), ids.end());
+        }
+        return ids;
+    }
+
+  private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<int32_t> atom_ids_;
+};
+
+// Blocks the reporters waiting on it until it is opened
+class Gate {
+  public:
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return open_; });
+    }
+
+    void open() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        open_ = true;
+        cv_.notify_all();
+    }
+
+  private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool open_ = false;
+};
+
+VendorAtom makeAtom(int32_t atom_id) {
+    VendorAtom atom;
+    atom.atomId = atom_id;
+    return atom;
+}
+
+DailyReporterRunner::Reporter atomReporter(const char *name, int32_t atom_id) {
+    return {name, [atom_id](const std::shared_ptr<IStats> &stats_client) {
+                stats_client->reportVendorAtom(makeAtom(atom_id));
+            }};
+}
+
+}  // namespace
+
+TEST(DailyAtomBatchTest, FlushesTheAtomsOnce) {
+    auto stats = ndk::SharedRefBase::make<FakeStats>();
+    auto batch = ndk::SharedRefBase::make<DailyAtomBatch>();
+
+    EXPECT_TRUE(batch->reportVendorAtom(makeAtom(1)).isOk());
+    EXPECT_TRUE(batch->reportVendorAtom(makeAtom(2)).isOk());
+    EXPECT_TRUE(stats->atomIds().empty());
+
+    batch->flush(stats);
+    EXPECT_EQ(stats->atomIds(), std::vector<int32_t>({1, 2}));
+    batch->flush(stats);
+    EXPECT_EQ(stats->atomIds(), std::vector<int32_t>({1, 2}));
+
+    // After the flush, the atoms of a late reporter go through right away
+    EXPECT_TRUE(batch->reportVendorAtom(makeAtom(3)).isOk());
+    EXPECT_EQ(stats->atomIds(), std::vector<int32_t>({1, 2, 3}));
+}
+
+TEST(DailyReporterRunnerTest, ReportsTheAtomsOfEveryGroupOnce) {
+    auto stats = ndk::SharedRefBase::make<FakeStats>();
+    DailyReporterRunner runner(2, kReporterTimeout, kTimeout);
+    runner.addGroup("battery", {atomReporter("capacity", 1), atomReporter("health", 2)});
+    runner.addGroup("storage", {atomReporter("f2fs", 3)});
+    runner.addGroup("audio", {atomReporter("codec", 4)});
+
+    runner.run(stats);
+    EXPECT_EQ(stats->atomIds(true), std::vector<int32_t>({1, 2, 3, 4}));
+    runner.run(stats);
+    EXPECT_EQ(stats->atomIds(true), std::vector<int32_t>({1, 1, 2, 2, 3, 3, 4, 4}));
+}
+
+TEST(DailyReporterRunnerTest, BlockedGroupIsGivenUpWithoutHoldingTheOthers) {
+    auto stats = ndk::SharedRefBase::make<FakeStats>();
+    Gate gate;
+    std::atomic<int> stuck_calls = 0;
+    DailyReporterRunner runner(2, kReporterTimeout, kTimeout);
+    runner.addGroup("stuck", {{"blocked", [&](const std::shared_ptr<IStats> &stats_client) {
+                                   stuck_calls++;
+                                   stats_client->reportVendorAtom(makeAtom(1));
+                                   gate.wait();
+                                   stats_client->reportVendorAtom(makeAtom(2));
+                               }}});
+    runner.addGroup("fast", {atomReporter("a", 10), atomReporter("b", 11)});
+
+    // The pass ends once the stuck reporter is past its timeout, not at the pass timeout
+    auto start = std::chrono::steady_clock::now();
+    runner.run(stats);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, kReporterTimeout);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, kTimeout);
+    EXPECT_EQ(stats->atomIds(true), std::vector<int32_t>({1, 10, 11}));
+
+    // The group still blocked is skipped, the other one runs again
+    start = std::chrono::steady_clock::now();
+    runner.run(stats);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, kReporterTimeout);
+    EXPECT_EQ(stuck_calls, 1);
+    EXPECT_EQ(stats->atomIds(true), std::vector<int32_t>({1, 10, 10, 11, 11}));
+
+    // Once it returns, its late atom goes out and the next pass runs it again
+    gate.open();
+    ASSERT_TRUE(stats->waitForAtoms(6));
+    EXPECT_EQ(stats->atomIds().back(), 2);
+    runner.run(stats);
+    EXPECT_EQ(stuck_calls, 2);
+    EXPECT_EQ(stats->atomIds(true), std::vector<int32_t>({1, 1, 2, 2, 10, 10, 10, 11, 11, 11}));
+}
+
+TEST(DailyReporterRunnerTest, ExpiredPassStopsTheGroupAtItsNextReporter) {
+    auto stats = ndk::SharedRefBase::make<FakeStats>();
+    Gate gate;
+    {
+        DailyReporterRunner runner(1, kTimeout, kReporterTimeout);
+        runner.addGroup("slow",
+                        {{"blocked", [&](const std::shared_ptr<IStats> &) { gate.wait(); }},
+                         atomReporter("next", 1)});
+        runner.run(stats);
+        gate.open();
+    }
+    // The runner joined its worker, which left the group without running the next reporter
+    EXPECT_TRUE(stats->atomIds().empty());
+}
+
+}  // namespace pixel
+}  // namespace google
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <pixelstats/WorkerPool.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <set>
+
+namespace android {
+namespace hardware {
+namespace google {
+namespace pixel {
+
+namespace {
+
+constexpr std::chrono::seconds kTimeout(5);
+
+}  // namespace
+
+TEST(WorkerPoolTest, RunsAllPostedTasksOnItsThreads) {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<int> ran;
+    std::set<std::thread::id> threads;
+    WorkerPool pool(3);
+
+    for (int i = 0; i < 100; i++) {
+        pool.post([&, i] {
+            std::lock_guard<std::mutex> lock(mutex);
+            ran.push_back(i);
+            threads.insert(std::this_thread::get_id());
+            cv.notify_all();
+        });
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    ASSERT_TRUE(cv.wait_for(lock, kTimeout, [&] { return ran.size() == 100; }));
+    std::sort(ran.begin(), ran.end());
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(ran[i], i);
+    }
+    EXPECT_LE(threads.size(), 3);
+    EXPECT_EQ(threads.count(std::this_thread::get_id()), 0);
+}
+
+TEST(WorkerPoolTest, DestructorRunsTheQueuedTasks) {
+    std::atomic<int> ran = 0;
+    {
+        WorkerPool pool(1);
+        // Holds the only thread while the pool is destroyed, the other tasks are still queued
+        pool.post([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            ran++;
+        });
+        for (int i = 0; i < 10; i++) {
+            pool.post([&] { ran++; });
+        }
+    }
+    EXPECT_EQ(ran, 11);
+}
+
+TEST(WorkerPoolTest, IdlePoolIsDestroyed) {
+    const auto start = std::chrono::steady_clock::now();
+    { WorkerPool pool(4); }
+    EXPECT_LT(std::chrono::steady_clock::now() - start, kTimeout);
+}
+
+}  // namespace pixel
+}  // namespace google
+}  // namespace hardware
+}  // namespace android
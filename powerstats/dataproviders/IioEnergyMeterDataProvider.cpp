@@ -14,16 +14,9 @@
  * limitations under the License.
  */
 
-#define ATRACE_TAG (ATRACE_TAG_POWER | ATRACE_TAG_HAL)
-
-#include <android-base/file.h>
 #include <android-base/logging.h>
-#include <android-base/stringprintf.h>
-#include <android-base/strings.h>
 #include <dataproviders/IioEnergyMeterDataProvider.h>
 #include <dataproviders/IioEnergyMeterDataSelector.h>
-#include <inttypes.h>
-#include <utils/Trace.h>
 
 namespace aidl {
 namespace android {
@@ -33,173 +26,49 @@ namespace stats {
 
 using aidl::android::hardware::power::stats::IioEnergyMeterDataSelector;
 
-#define MAX_RAIL_NAME_LEN 50
-#define STR(s) #s
-#define XSTR(s) STR(s)
-
-void IioEnergyMeterDataProvider::findIioEnergyMeterNodes() {
-    struct dirent *ent;
-
-    DIR *iioDir = opendir(kIioRootDir.c_str());
-    if (!iioDir) {
-        PLOG(ERROR) << "Error opening directory" << kIioRootDir;
-        return;
-    }
-
-    // Find any iio:devices that match the given kDeviceNames
-    while (ent = readdir(iioDir), ent) {
-        std::string devTypeDir = ent->d_name;
-        if (devTypeDir.find(kDeviceType) != std::string::npos) {
-            std::string devicePath = kIioRootDir + devTypeDir;
-            std::string deviceNameContents;
-
-            if (!::android::base::ReadFileToString(devicePath + kNameNode, &deviceNameContents)) {
-                LOG(WARNING) << "Failed to read device name from " << devicePath;
-            } else {
-                for (const auto &deviceName : kDeviceNames) {
-                    if (deviceNameContents.find(deviceName) != std::string::npos) {
-                        mDevicePaths.emplace(devicePath, deviceName);
-                    }
-                }
-            }
-        }
-    }
-
-    closedir(iioDir);
-    return;
-}
-
-void IioEnergyMeterDataProvider::parseEnabledRails() {
-    std::string data;
-    int32_t id = 0;
-    for (const auto &path : mDevicePaths) {
-        // Get list of enabled rails
-        if (!::android::base::ReadFileToString(path.first + kEnabledRailsNode, &data)) {
-            LOG(ERROR) << "Error reading enabled rails from " << path.first;
-            continue;
-        }
-
-        // Build RailInfos from list of enabled rails
-        std::istringstream railNames(data);
-        std::string line;
-        while (std::getline(railNames, line)) {
-            /* Format example: CH2[VSYS_PWR_RFFE]:Cellular */
-            std::vector<std::string> words = ::android::base::Split(line, ":][");
-            if (words.size() == 4) {
-                const std::string channelName = words[1];
-                const std::string subsystemName = words[3];
-                if (mChannelIds.count(channelName) == 0) {
-                    mChannelInfos.push_back(
-                            {.id = id, .name = channelName, .subsystem = subsystemName});
-                    mChannelIds.emplace(channelName, id);
-                    id++;
-                } else {
-                    LOG(WARNING) << "There exists rails with the same name (not supported): "
-                                 << channelName << ". Only the last occurrence of rail energy will "
-                                 << "be provided.";
-                }
-            } else {
-                LOG(WARNING) << "Unexpected enabled rail format in " << path.first;
-            }
-        }
-    }
-}
+using ::android::hardware::google::pixel::OdpmSample;
+using ::android::hardware::google::pixel::OdpmSampler;
 
 IioEnergyMeterDataProvider::IioEnergyMeterDataProvider(const std::vector<std::string> &deviceNames,
                                                        const bool useSelector)
-    : kDeviceNames(std::move(deviceNames)) {
-    findIioEnergyMeterNodes();
+    : kDeviceNames(std::move(deviceNames)), mSampler(OdpmSampler::getInstance()) {
+    if (!mSampler.registerDevices(kDeviceNames)) {
+        LOG(ERROR) << "Failed to find iio energy meter devices";
+    }
     if (useSelector) {
         /* Run meter selection in constructor; object can be discarded afterwards */
-        IioEnergyMeterDataSelector selector(mDevicePaths);
+        IioEnergyMeterDataSelector selector(mSampler.getDevicePaths(kDeviceNames));
     }
-    parseEnabledRails();
-    mReading.resize(mChannelInfos.size());
-}
 
-int IioEnergyMeterDataProvider::parseEnergyContents(const std::string &contents) {
-    std::istringstream energyData(contents);
-    std::string line;
-
-    int ret = 0;
-    uint64_t timestamp = 0;
-    bool timestampRead = false;
-
-    while (std::getline(energyData, line)) {
-        bool parseLineSuccess = false;
-
-        if (timestampRead == false) {
-            /* Read timestamp from boot (ms) */
-            if (sscanf(line.c_str(), "t=%" PRIu64, &timestamp) == 1) {
-                if (timestamp == 0 || timestamp == ULLONG_MAX) {
-                    LOG(ERROR) << "Potentially wrong timestamp: " << timestamp;
-                }
-                timestampRead = true;
-                parseLineSuccess = true;
-            }
-
-        } else {
-            /* Read rail energy */
-            uint64_t energy = 0;
-            uint64_t duration = 0;
-            char railNameRaw[MAX_RAIL_NAME_LEN + 1];
-
-            /* Format example: CH3(T=358356)[S2M_VDD_CPUCL2], 761330 */
-            if (sscanf(line.c_str(),
-                       "CH%*d(T=%" PRIu64 ")[%" XSTR(MAX_RAIL_NAME_LEN) "[^]]], %" PRIu64,
-                       &duration, railNameRaw, &energy) == 3) {
-                std::string railName(railNameRaw);
-
-                /* If the count == 0, the rail may not be enabled */
-                /* The count cannot be > 1; mChannelIds is a map */
-                if (mChannelIds.count(railName) == 1) {
-                    size_t index = mChannelIds[railName];
-                    mReading[index].id = index;
-                    mReading[index].timestampMs = timestamp;
-                    mReading[index].durationMs = duration;
-                    mReading[index].energyUWs = energy;
-                    if (mReading[index].energyUWs == ULLONG_MAX) {
-                        LOG(ERROR) << "Potentially wrong energy value on rail: " << railName;
-                    }
-                    ATRACE_INT(railNameRaw, energy);
-                }
-                parseLineSuccess = true;
-            }
-        }
-
-        if (parseLineSuccess == false) {
-            ret = -1;
-            break;
-        }
+    // The sampler numbers the rails of every consumer, the channels of this provider are
+    // numbered from 0
+    for (const auto &rail : mSampler.getRails(kDeviceNames)) {
+        const auto id = static_cast<int32_t>(mChannelInfos.size());
+        mChannelInfos.push_back({.id = id, .name = rail.name, .subsystem = rail.subsystem});
+        mRailIds.push_back(rail.id);
     }
-
-    return ret;
-}
-
-int IioEnergyMeterDataProvider::parseEnergyValue(std::string path) {
-    int ret = 0;
-    std::string data;
-    if (!::android::base::ReadFileToString(path + kEnergyValueNode, &data)) {
-        LOG(ERROR) << "Error reading energy value in " << path;
-        return -1;
-    }
-
-    ret = parseEnergyContents(data);
-    if (ret != 0) {
-        LOG(ERROR) << "Unexpected format in " << path;
-    }
-    return ret;
+    mReading.resize(mChannelInfos.size());
 }
 
 ndk::ScopedAStatus IioEnergyMeterDataProvider::readEnergyMeter(
         const std::vector<int32_t> &in_channelIds, std::vector<EnergyMeasurement> *_aidl_return) {
     std::scoped_lock lock(mLock);
 
-    for (const auto &devicePath : mDevicePaths) {
-        if (parseEnergyValue(devicePath.first) < 0) {
-            LOG(ERROR) << "Error in parsing " << devicePath.first;
-            return ndk::ScopedAStatus::ok();
+    if (!mSampler.sample(&mSamples)) {
+        LOG(ERROR) << "Error in sampling energy meters";
+        return ndk::ScopedAStatus::ok();
+    }
+
+    for (size_t id = 0; id < mRailIds.size(); ++id) {
+        if (mRailIds[id] < 0 || static_cast<size_t>(mRailIds[id]) >= mSamples.size()) {
+            continue;
         }
+        const auto &sample = mSamples[mRailIds[id]];
+        auto &reading = mReading[id];
+        reading.id = static_cast<int32_t>(id);
+        reading.timestampMs = sample.timestamp_ms;
+        reading.durationMs = sample.duration_ms;
+        reading.energyUWs = sample.energy_uws;
     }
 
     if (in_channelIds.empty()) {
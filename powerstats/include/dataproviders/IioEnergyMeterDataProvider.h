@@ -17,6 +17,7 @@
 #pragma once
 
 #include <PowerStatsAidl.h>
+#include <odpm/OdpmSampler.h>
 
 #include <unordered_map>
 
@@ -37,23 +38,15 @@ class IioEnergyMeterDataProvider : public PowerStats::IEnergyMeterDataProvider {
     ndk::ScopedAStatus getEnergyMeterInfo(std::vector<Channel> *_aidl_return) override;
 
   private:
-    void findIioEnergyMeterNodes();
-    void parseEnabledRails();
-    int parseEnergyValue(std::string path);
-    int parseEnergyContents(const std::string &contents);
-
     std::mutex mLock;
-    std::unordered_map<std::string, std::string> mDevicePaths;  // key: path, value: device name
-    std::unordered_map<std::string, int32_t> mChannelIds;  // key: name, value: id
     std::vector<Channel> mChannelInfos;
     std::vector<EnergyMeasurement> mReading;
+    // The sampler rail id of each channel, indexed by channel id
+    std::vector<int32_t> mRailIds;
+    std::vector<::android::hardware::google::pixel::OdpmSample> mSamples;
 
     const std::vector<std::string> kDeviceNames;
-    const std::string kDeviceType = "iio:device";
-    const std::string kIioRootDir = "/sys/bus/iio/devices/";
-    const std::string kNameNode = "/name";
-    const std::string kEnabledRailsNode = "/enabled_rails";
-    const std::string kEnergyValueNode = "/energy_value";
+    ::android::hardware::google::pixel::OdpmSampler &mSampler;
 };
 
 }  // namespace stats
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/unique_fd.h>
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace android {
+namespace hardware {
+namespace google {
+namespace pixel {
+
+struct OdpmRail {
+    int32_t id;
+    std::string name;
+    std::string subsystem;
+};
+
+struct OdpmSample {
+    int32_t rail_id;
+    // Time since boot of the sampling pass, from the "t=" header of energy_value
+    uint64_t timestamp_ms;
+    // Accumulation duration of the rail, from the "T=" field of each channel
+    uint64_t duration_ms;
+    uint64_t energy_uws;
+};
+
+// A channel entry parsed from ODPM energy_value content. The rail name points into the parsed
+// buffer, so it is only valid until the buffer is modified.
+struct OdpmRecord {
+    std::string_view rail;
+    uint64_t duration_ms;
+    uint64_t energy_uws;
+};
+
+// Parse the ODPM energy_value content in a single pass without copying.
+// Format example:
+//   t=358360
+//   CH3(T=358356)[S2M_VDD_CPUCL2], 761330
+// The "t=" header is stored to timestamp_ms if present, and the channel records are appended to
+// records. Return false if any line does not match the format.
+bool ParseOdpmEnergyValues(std::string_view content, uint64_t *timestamp_ms,
+                           std::vector<OdpmRecord> *records);
+
+/**
+ * A process-wide ODPM sampler for the energy consumers of a process, i.e. the thermal HAL power
+ * rails or the power stats HAL energy meter, which run in separate processes. The iio:device
+ * nodes are discovered once, the energy_value fds are kept open and read with one parser.
+ */
+class OdpmSampler {
+  public:
+    static OdpmSampler &getInstance();
+
+    // Disallow copy and assign.
+    OdpmSampler(const OdpmSampler &) = delete;
+    void operator=(const OdpmSampler &) = delete;
+
+    // Add the iio:devices whose name contains any of device_names, or every iio:device providing
+    // energy_value if device_names is empty. Return false if none of these devices is registered.
+    bool registerDevices(const std::vector<std::string> &device_names);
+    // Get the registered devices among device_names, key: device path, value: the entry of
+    // device_names contained in the device name, or the device name if device_names is empty.
+    std::unordered_map<std::string, std::string> getDevicePaths(
+            const std::vector<std::string> &device_names);
+    // Get the rails of the registered devices among device_names. The rail ids index the samples
+    // of every consumer, so the rails of one consumer may not be numbered contiguously.
+    std::vector<OdpmRail> getRails(const std::vector<std::string> &device_names);
+    // Get the rail id by rail name, return -1 if the rail is not found.
+    int32_t getRailId(std::string_view rail_name);
+    // Read the energy of every rail, indexed by rail id. Every call reads the devices.
+    bool sample(std::vector<OdpmSample> *samples);
+
+  private:
+    struct OdpmDevice {
+        std::string path;
+        std::string name;
+        ::android::base::unique_fd energy_fd;
+        // The ids of the rails of this device
+        std::vector<int32_t> rail_ids;
+        // The rail id of each parsed record, learned from the previous read.
+        std::vector<int32_t> record_rail_ids;
+    };
+
+    OdpmSampler() = default;
+    bool hasDevicesLocked(const std::vector<std::string> &device_names);
+    void buildRailsLocked();
+    bool readDeviceLocked(OdpmDevice *device, uint64_t *timestamp_ms);
+    bool samplingPassLocked();
+
+    std::mutex lock_;
+    std::vector<OdpmDevice> devices_;
+    std::vector<OdpmRail> rails_;
+    std::unordered_map<std::string, int32_t> rail_ids_;
+    bool rails_built_ = false;
+    std::vector<OdpmSample> samples_;
+    // The reused buffers for reading and parsing energy_value content
+    std::string buffer_;
+    std::vector<OdpmRecord> records_;
+};
+
+}  // namespace pixel
+}  // namespace google
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,397 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define ATRACE_TAG (ATRACE_TAG_POWER | ATRACE_TAG_HAL)
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <android-base/strings.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <odpm/OdpmSampler.h>
+#include <unistd.h>
+#include <utils/Trace.h>
+
+#include <climits>
+#include <sstream>
+
+namespace android {
+namespace hardware {
+namespace google {
+namespace pixel {
+
+namespace {
+
+constexpr std::string_view kDeviceType("iio:device");
+constexpr std::string_view kIioRootDir("/sys/bus/iio/devices/");
+constexpr std::string_view kNameNode("/name");
+constexpr std::string_view kEnabledRailsNode("/enabled_rails");
+constexpr std::string_view kEnergyValueNode("/energy_value");
+constexpr size_t kEnergyBufferSize = 4096;
+
+// Parse the decimal digits at the start of str, return false if there is no digit.
+bool parseDecimal(std::string_view str, uint64_t *value) {
+    size_t i = 0;
+    *value = 0;
+    while (i < str.size() && str[i] >= '0' && str[i] <= '9') {
+        *value = *value * 10 + static_cast<uint64_t>(str[i] - '0');
+        ++i;
+    }
+    return i > 0;
+}
+
+// Parse one channel line, e.g. "CH3(T=358356)[S2M_VDD_CPUCL2], 761330"
+bool parseOdpmRecord(std::string_view line, OdpmRecord *record) {
+    auto start_pos = line.find("(T=");
+    if (line.substr(0, 2) != "CH" || start_pos == std::string_view::npos ||
+        !parseDecimal(line.substr(start_pos + 3), &record->duration_ms)) {
+        return false;
+    }
+
+    start_pos = line.find(")[", start_pos);
+    if (start_pos == std::string_view::npos) {
+        return false;
+    }
+    auto end_pos = line.find("],", start_pos);
+    if (end_pos == std::string_view::npos) {
+        return false;
+    }
+    record->rail = line.substr(start_pos + 2, end_pos - start_pos - 2);
+
+    start_pos = line.find_first_not_of(' ', end_pos + 2);
+    return start_pos != std::string_view::npos &&
+           parseDecimal(line.substr(start_pos), &record->energy_uws);
+}
+
+// Find the entry of device_names contained in device_name. Every device matches an empty list.
+bool matchDeviceName(const std::string &device_name, const std::vector<std::string> &device_names,
+                     std::string *matched) {
+    if (device_names.empty()) {
+        *matched = device_name;
+        return true;
+    }
+    for (const auto &name : device_names) {
+        if (device_name.find(name) != std::string::npos) {
+            *matched = name;
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+bool ParseOdpmEnergyValues(std::string_view content, uint64_t *timestamp_ms,
+                           std::vector<OdpmRecord> *records) {
+    bool ret = true;
+
+    while (!content.empty()) {
+        auto line_end = content.find('\n');
+        std::string_view line = content.substr(0, line_end);
+        content = (line_end == std::string_view::npos) ? std::string_view()
+                                                       : content.substr(line_end + 1);
+        if (line.empty()) {
+            continue;
+        }
+
+        /* Read timestamp from boot (ms) */
+        if (line.substr(0, 2) == "t=") {
+            if (!parseDecimal(line.substr(2), timestamp_ms)) {
+                ret = false;
+            }
+            continue;
+        }
+
+        OdpmRecord record;
+        if (parseOdpmRecord(line, &record)) {
+            records->emplace_back(record);
+        } else {
+            ret = false;
+        }
+    }
+
+    return ret;
+}
+
+OdpmSampler &OdpmSampler::getInstance() {
+    static OdpmSampler sampler;
+    return sampler;
+}
+
+bool OdpmSampler::registerDevices(const std::vector<std::string> &device_names) {
+    std::scoped_lock lock(lock_);
+    std::string matched;
+
+    std::unique_ptr<DIR, decltype(&closedir)> dir(opendir(kIioRootDir.data()), closedir);
+    if (!dir) {
+        PLOG(ERROR) << "Error opening directory" << kIioRootDir;
+        return hasDevicesLocked(device_names);
+    }
+
+    // Find any iio:devices that match the given device_names
+    while (struct dirent *ent = readdir(dir.get())) {
+        std::string devTypeDir = ent->d_name;
+        if (devTypeDir.find(kDeviceType) == std::string::npos) {
+            continue;
+        }
+
+        const std::string devicePath = std::string(kIioRootDir) + devTypeDir;
+        bool registered = false;
+        for (const auto &device : devices_) {
+            registered |= (device.path == devicePath);
+        }
+        if (registered) {
+            continue;
+        }
+
+        std::string deviceName;
+        if (!::android::base::ReadFileToString(devicePath + std::string(kNameNode), &deviceName)) {
+            LOG(WARNING) << "Failed to read device name from " << devicePath;
+            if (device_names.size()) {
+                continue;
+            }
+        }
+        deviceName = ::android::base::Trim(deviceName);
+        if (!matchDeviceName(deviceName, device_names, &matched)) {
+            continue;
+        }
+
+        const std::string energyPath = devicePath + std::string(kEnergyValueNode);
+        ::android::base::unique_fd fd(
+                TEMP_FAILURE_RETRY(open(energyPath.c_str(), O_RDONLY | O_CLOEXEC)));
+        if (fd == -1) {
+            if (device_names.size()) {
+                PLOG(ERROR) << "Failed to open " << energyPath;
+            }
+            continue;
+        }
+
+        devices_.push_back({.path = devicePath,
+                            .name = deviceName,
+                            .energy_fd = std::move(fd),
+                            .rail_ids = {},
+                            .record_rail_ids = {}});
+        rails_built_ = false;
+    }
+
+    if (buffer_.size() < kEnergyBufferSize) {
+        buffer_.resize(kEnergyBufferSize);
+    }
+    return hasDevicesLocked(device_names);
+}
+
+bool OdpmSampler::hasDevicesLocked(const std::vector<std::string> &device_names) {
+    std::string matched;
+
+    // Devices registered by other consumers only count if they match this caller
+    for (const auto &device : devices_) {
+        if (matchDeviceName(device.name, device_names, &matched)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::unordered_map<std::string, std::string> OdpmSampler::getDevicePaths(
+        const std::vector<std::string> &device_names) {
+    std::scoped_lock lock(lock_);
+    std::unordered_map<std::string, std::string> device_paths;
+    std::string matched;
+
+    for (const auto &device : devices_) {
+        if (matchDeviceName(device.name, device_names, &matched)) {
+            device_paths.emplace(device.path, matched);
+        }
+    }
+    return device_paths;
+}
+
+void OdpmSampler::buildRailsLocked() {
+    if (rails_built_) {
+        return;
+    }
+
+    // Rebuilt from scratch so that a device added since the last build is not duplicated
+    rails_.clear();
+    rail_ids_.clear();
+    std::string data;
+    for (auto &device : devices_) {
+        device.rail_ids.clear();
+        device.record_rail_ids.clear();
+        std::vector<std::pair<std::string, std::string>> device_rails;
+
+        if (::android::base::ReadFileToString(device.path + std::string(kEnabledRailsNode),
+                                              &data)) {
+            // Build rails from list of enabled rails
+            std::istringstream railNames(data);
+            std::string line;
+            while (std::getline(railNames, line)) {
+                /* Format example: CH2[VSYS_PWR_RFFE]:Cellular */
+                std::vector<std::string> words = ::android::base::Split(line, ":][");
+                if (words.size() == 4) {
+                    device_rails.emplace_back(words[1], words[3]);
+                } else {
+                    LOG(WARNING) << "Unexpected enabled rail format in " << device.path;
+                }
+            }
+        } else {
+            // Fall back to the rails reported by energy_value
+            uint64_t timestamp_ms = 0;
+            records_.clear();
+            if (readDeviceLocked(&device, &timestamp_ms)) {
+                for (const auto &record : records_) {
+                    device_rails.emplace_back(std::string(record.rail), "");
+                }
+            }
+        }
+
+        for (auto &device_rail : device_rails) {
+            if (rail_ids_.count(device_rail.first)) {
+                LOG(WARNING) << "There exists rails with the same name (not supported): "
+                             << device_rail.first << ". Only the last occurrence of rail energy "
+                             << "will be provided.";
+                continue;
+            }
+            const auto id = static_cast<int32_t>(rails_.size());
+            rail_ids_.emplace(device_rail.first, id);
+            device.rail_ids.push_back(id);
+            rails_.push_back({.id = id,
+                              .name = std::move(device_rail.first),
+                              .subsystem = std::move(device_rail.second)});
+        }
+    }
+
+    samples_.clear();
+    samples_.resize(rails_.size());
+    for (size_t i = 0; i < samples_.size(); ++i) {
+        samples_[i] = {.rail_id = static_cast<int32_t>(i),
+                       .timestamp_ms = 0,
+                       .duration_ms = 0,
+                       .energy_uws = 0};
+    }
+    rails_built_ = true;
+}
+
+std::vector<OdpmRail> OdpmSampler::getRails(const std::vector<std::string> &device_names) {
+    std::scoped_lock lock(lock_);
+    buildRailsLocked();
+    std::vector<OdpmRail> rails;
+    std::string matched;
+
+    for (const auto &device : devices_) {
+        if (!matchDeviceName(device.name, device_names, &matched)) {
+            continue;
+        }
+        for (const auto id : device.rail_ids) {
+            rails.push_back(rails_[id]);
+        }
+    }
+    return rails;
+}
+
+int32_t OdpmSampler::getRailId(std::string_view rail_name) {
+    std::scoped_lock lock(lock_);
+    buildRailsLocked();
+    const auto it = rail_ids_.find(std::string(rail_name));
+    return (it == rail_ids_.end()) ? -1 : it->second;
+}
+
+bool OdpmSampler::readDeviceLocked(OdpmDevice *device, uint64_t *timestamp_ms) {
+    size_t total = 0;
+
+    // The sysfs content is regenerated on every read from offset 0, so the fd can be reused.
+    while (true) {
+        auto len = TEMP_FAILURE_RETRY(pread(device->energy_fd, buffer_.data() + total,
+                                            buffer_.size() - total, total));
+        if (len < 0) {
+            PLOG(ERROR) << "Error reading energy value in " << device->path;
+            return false;
+        }
+        total += static_cast<size_t>(len);
+        if (len == 0 || total < buffer_.size()) {
+            break;
+        }
+        // The buffer is full, grow it and keep reading the rest of the content.
+        buffer_.resize(buffer_.size() * 2);
+    }
+
+    if (!ParseOdpmEnergyValues(std::string_view(buffer_.data(), total), timestamp_ms,
+                               &records_)) {
+        LOG(ERROR) << "Unexpected format in " << device->path;
+        return false;
+    }
+    return true;
+}
+
+bool OdpmSampler::samplingPassLocked() {
+    ATRACE_CALL();
+    for (auto &device : devices_) {
+        uint64_t timestamp_ms = 0;
+        records_.clear();
+        if (!readDeviceLocked(&device, &timestamp_ms)) {
+            return false;
+        }
+        if (timestamp_ms == 0 || timestamp_ms == ULLONG_MAX) {
+            LOG(ERROR) << "Potentially wrong timestamp: " << timestamp_ms;
+        }
+
+        auto &record_rail_ids = device.record_rail_ids;
+        if (record_rail_ids.size() != records_.size()) {
+            record_rail_ids.assign(records_.size(), -1);
+        }
+
+        for (size_t i = 0; i < records_.size(); ++i) {
+            const auto &record = records_[i];
+            // The channel order is stable across reads, so only resolve the rail name when the
+            // record does not match the rail learned from the previous read.
+            auto &rail_id = record_rail_ids[i];
+            if (rail_id < 0 || rails_[rail_id].name != record.rail) {
+                const auto it = rail_ids_.find(std::string(record.rail));
+                if (it == rail_ids_.end()) {
+                    // The rail may not be enabled
+                    continue;
+                }
+                rail_id = it->second;
+            }
+
+            auto &sample = samples_[rail_id];
+            sample.timestamp_ms = timestamp_ms;
+            sample.duration_ms = record.duration_ms;
+            sample.energy_uws = record.energy_uws;
+            if (sample.energy_uws == ULLONG_MAX) {
+                LOG(ERROR) << "Potentially wrong energy value on rail: " << record.rail;
+            }
+            ATRACE_INT(rails_[rail_id].name.c_str(), record.energy_uws);
+        }
+    }
+
+    return true;
+}
+
+bool OdpmSampler::sample(std::vector<OdpmSample> *samples) {
+    std::scoped_lock lock(lock_);
+    buildRailsLocked();
+    if (!samplingPassLocked()) {
+        return false;
+    }
+    *samples = samples_;
+    return true;
+}
+
+}  // namespace pixel
+}  // namespace google
+}  // namespace hardware
+}  // namespace android
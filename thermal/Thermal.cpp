@@ -20,8 +20,11 @@
 
 #include <android-base/file.h>
 #include <android-base/logging.h>
+#include <json/writer.h>
 #include <utils/Trace.h>
 
+#include <algorithm>
+
 namespace aidl {
 namespace android {
 namespace hardware {
@@ -370,10 +373,16 @@ void Thermal::dumpVtEstimatorInfo(std::ostringstream *dump_buf) {
     }
 }
 
-void Thermal::dumpThrottlingInfo(std::ostringstream *dump_buf) {
+void Thermal::dumpThrottlingInfo(std::ostringstream *dump_buf, const ThermalSnapshot &snapshot) {
     *dump_buf << "getThrottlingInfo:" << std::endl;
     const auto &map = thermal_helper_->GetSensorInfoMap();
-    const auto &thermal_throttling_status_map = thermal_helper_->GetThermalThrottlingStatusMap();
+    std::unordered_map<std::string, const ThermalThrottlingStatus *> thermal_throttling_status_map;
+    for (const auto &sensor_snapshot : snapshot.sensors) {
+        if (sensor_snapshot->throttling_status != nullptr) {
+            thermal_throttling_status_map[sensor_snapshot->name] =
+                    sensor_snapshot->throttling_status.get();
+        }
+    }
     for (const auto &name_info_pair : map) {
         if (name_info_pair.second.throttling_info == nullptr) {
             continue;
@@ -385,7 +394,7 @@ void Thermal::dumpThrottlingInfo(std::ostringstream *dump_buf) {
             }
             *dump_buf << " Name: " << name_info_pair.first << std::endl;
             if (thermal_throttling_status_map.at(name_info_pair.first)
-                        .pid_power_budget_map.size()) {
+                        ->pid_power_budget_map.size()) {
                 *dump_buf << "  PID Info:" << std::endl;
                 *dump_buf << "   K_po: [";
                 for (size_t i = 0; i < kThrottlingSeverityCount; ++i) {
@@ -438,7 +447,7 @@ void Thermal::dumpThrottlingInfo(std::ostringstream *dump_buf) {
                 }
                 *dump_buf << "]" << std::endl;
             }
-            const auto &profile = thermal_throttling_status_map.at(name_info_pair.first).profile;
+            const auto &profile = thermal_throttling_status_map.at(name_info_pair.first)->profile;
             *dump_buf << "  Binded CDEV Info:" << (profile.empty() ? "default" : profile)
                       << std::endl;
 
@@ -448,7 +457,7 @@ void Thermal::dumpThrottlingInfo(std::ostringstream *dump_buf) {
                          : name_info_pair.second.throttling_info->binded_cdev_info_map) {
                 *dump_buf << "   Cooling device name: " << binded_cdev_info_pair.first << std::endl;
                 if (thermal_throttling_status_map.at(name_info_pair.first)
-                            .pid_power_budget_map.size()) {
+                            ->pid_power_budget_map.size()) {
                     *dump_buf << "    WeightForPID: [";
                     for (size_t i = 0; i < kThrottlingSeverityCount; ++i) {
                         *dump_buf << binded_cdev_info_pair.second.cdev_weight_for_pid[i] << " ";
@@ -510,49 +519,52 @@ void Thermal::dumpThrottlingInfo(std::ostringstream *dump_buf) {
     }
 }
 
-void Thermal::dumpThrottlingRequestStatus(std::ostringstream *dump_buf) {
-    const auto &thermal_throttling_status_map = thermal_helper_->GetThermalThrottlingStatusMap();
-    if (!thermal_throttling_status_map.size()) {
+void Thermal::dumpThrottlingRequestStatus(std::ostringstream *dump_buf,
+                                          const ThermalSnapshot &snapshot) {
+    if (std::none_of(snapshot.sensors.begin(), snapshot.sensors.end(),
+                     [](const auto &sensor_snapshot) {
+                         return sensor_snapshot->throttling_status != nullptr;
+                     })) {
         return;
     }
     *dump_buf << "getThrottlingRequestStatus:" << std::endl;
-    for (const auto &thermal_throttling_status_pair : thermal_throttling_status_map) {
-        *dump_buf << " Name: " << thermal_throttling_status_pair.first << std::endl;
-        if (thermal_throttling_status_pair.second.pid_power_budget_map.size()) {
+    for (const auto &sensor_snapshot : snapshot.sensors) {
+        if (sensor_snapshot->throttling_status == nullptr) {
+            continue;
+        }
+        const auto &thermal_throttling_status = *sensor_snapshot->throttling_status;
+        *dump_buf << " Name: " << sensor_snapshot->name << std::endl;
+        if (thermal_throttling_status.pid_power_budget_map.size()) {
             *dump_buf << "  power budget request state" << std::endl;
-            for (const auto &request_pair :
-                 thermal_throttling_status_pair.second.pid_power_budget_map) {
+            for (const auto &request_pair : thermal_throttling_status.pid_power_budget_map) {
                 *dump_buf << "   " << request_pair.first << ": " << request_pair.second
                           << std::endl;
             }
         }
-        if (thermal_throttling_status_pair.second.pid_cdev_request_map.size()) {
+        if (thermal_throttling_status.pid_cdev_request_map.size()) {
             *dump_buf << "  pid cdev request state" << std::endl;
-            for (const auto &request_pair :
-                 thermal_throttling_status_pair.second.pid_cdev_request_map) {
+            for (const auto &request_pair : thermal_throttling_status.pid_cdev_request_map) {
                 *dump_buf << "   " << request_pair.first << ": " << request_pair.second
                           << std::endl;
             }
         }
-        if (thermal_throttling_status_pair.second.hardlimit_cdev_request_map.size()) {
+        if (thermal_throttling_status.hardlimit_cdev_request_map.size()) {
             *dump_buf << "  hard limit cdev request state" << std::endl;
-            for (const auto &request_pair :
-                 thermal_throttling_status_pair.second.hardlimit_cdev_request_map) {
+            for (const auto &request_pair : thermal_throttling_status.hardlimit_cdev_request_map) {
                 *dump_buf << "   " << request_pair.first << ": " << request_pair.second
                           << std::endl;
             }
         }
-        if (thermal_throttling_status_pair.second.throttling_release_map.size()) {
+        if (thermal_throttling_status.throttling_release_map.size()) {
             *dump_buf << "  cdev release state" << std::endl;
-            for (const auto &request_pair :
-                 thermal_throttling_status_pair.second.throttling_release_map) {
+            for (const auto &request_pair : thermal_throttling_status.throttling_release_map) {
                 *dump_buf << "   " << request_pair.first << ": " << request_pair.second
                           << std::endl;
             }
         }
-        if (thermal_throttling_status_pair.second.cdev_status_map.size()) {
+        if (thermal_throttling_status.cdev_status_map.size()) {
             *dump_buf << "  cdev request state" << std::endl;
-            for (const auto &request_pair : thermal_throttling_status_pair.second.cdev_status_map) {
+            for (const auto &request_pair : thermal_throttling_status.cdev_status_map) {
                 *dump_buf << "   " << request_pair.first << ": " << request_pair.second
                           << std::endl;
             }
@@ -560,9 +572,9 @@ void Thermal::dumpThrottlingRequestStatus(std::ostringstream *dump_buf) {
     }
 }
 
-void Thermal::dumpPowerRailInfo(std::ostringstream *dump_buf) {
+void Thermal::dumpPowerRailInfo(std::ostringstream *dump_buf, const ThermalSnapshot &snapshot) {
     const auto &power_rail_info_map = thermal_helper_->GetPowerRailInfoMap();
-    const auto &power_status_map = thermal_helper_->GetPowerStatusMap();
+    const auto &power_status_map = *snapshot.power_status_map;
 
     *dump_buf << "getPowerRailInfo:" << std::endl;
     for (const auto &power_rail_pair : power_rail_info_map) {
@@ -572,7 +584,7 @@ void Thermal::dumpPowerRailInfo(std::ostringstream *dump_buf) {
         *dump_buf << "  Power Sample Delay: " << power_rail_pair.second.power_sample_delay.count()
                   << std::endl;
         if (power_status_map.count(power_rail_pair.first)) {
-            auto power_history = power_status_map.at(power_rail_pair.first).power_history;
+            const auto &power_history = power_status_map.at(power_rail_pair.first).power_history;
             *dump_buf << "  Last Updated AVG Power: "
                       << power_status_map.at(power_rail_pair.first).last_updated_avg_power << " mW"
                       << std::endl;
@@ -610,9 +622,8 @@ void Thermal::dumpPowerRailInfo(std::ostringstream *dump_buf) {
                 } else {
                     *dump_buf << "  Power Samples: ";
                 }
-                while (power_history[i].size() > 0) {
-                    const auto power_sample = power_history[i].front();
-                    power_history[i].pop();
+                for (size_t j = 0; j < power_history[i].size(); ++j) {
+                    const auto &power_sample = power_history[i][j];
                     *dump_buf << "(T=" << power_sample.duration
                               << ", uWs=" << power_sample.energy_counter << ") ";
                 }
@@ -700,104 +711,246 @@ void Thermal::dumpThermalStats(std::ostringstream *dump_buf) {
     }
 }
 
+void Thermal::dumpSensorConfig(std::ostringstream *dump_buf) {
+    const auto &map = thermal_helper_->GetSensorInfoMap();
+    *dump_buf << "getTemperatureThresholds:" << std::endl;
+    for (const auto &name_info_pair : map) {
+        if (!name_info_pair.second.is_watch) {
+            continue;
+        }
+        *dump_buf << " Type: " << toString(name_info_pair.second.type)
+                  << " Name: " << name_info_pair.first;
+        *dump_buf << " hotThrottlingThreshold: [";
+        for (size_t i = 0; i < kThrottlingSeverityCount; ++i) {
+            *dump_buf << name_info_pair.second.hot_thresholds[i] << " ";
+        }
+        *dump_buf << "] coldThrottlingThreshold: [";
+        for (size_t i = 0; i < kThrottlingSeverityCount; ++i) {
+            *dump_buf << name_info_pair.second.cold_thresholds[i] << " ";
+        }
+        *dump_buf << "] vrThrottlingThreshold: " << name_info_pair.second.vr_threshold;
+        *dump_buf << std::endl;
+    }
+    *dump_buf << "getHysteresis:" << std::endl;
+    for (const auto &name_info_pair : map) {
+        if (!name_info_pair.second.is_watch) {
+            continue;
+        }
+        *dump_buf << " Name: " << name_info_pair.first;
+        *dump_buf << " hotHysteresis: [";
+        for (size_t i = 0; i < kThrottlingSeverityCount; ++i) {
+            *dump_buf << name_info_pair.second.hot_hysteresis[i] << " ";
+        }
+        *dump_buf << "] coldHysteresis: [";
+        for (size_t i = 0; i < kThrottlingSeverityCount; ++i) {
+            *dump_buf << name_info_pair.second.cold_hysteresis[i] << " ";
+        }
+        *dump_buf << "]" << std::endl;
+    }
+}
+
+void Thermal::dumpNotificationConfig(std::ostringstream *dump_buf) {
+    const auto &map = thermal_helper_->GetSensorInfoMap();
+    *dump_buf << "sendCallback:" << std::endl;
+    *dump_buf << "  Enabled List: ";
+    for (const auto &name_info_pair : map) {
+        if (name_info_pair.second.send_cb) {
+            *dump_buf << name_info_pair.first << " ";
+        }
+    }
+    *dump_buf << std::endl;
+    *dump_buf << "sendPowerHint:" << std::endl;
+    *dump_buf << "  Enabled List: ";
+    for (const auto &name_info_pair : map) {
+        if (name_info_pair.second.send_powerhint) {
+            *dump_buf << name_info_pair.first << " ";
+        }
+    }
+    *dump_buf << std::endl;
+}
+
+const Thermal::ConfigDump &Thermal::getConfigDump() {
+    // The config does not change once the HAL is up, so its sections are serialized once
+    std::call_once(config_dump_once_, [this] {
+        std::ostringstream sensor_config, notification_config, virtual_sensor_config;
+        dumpSensorConfig(&sensor_config);
+        dumpNotificationConfig(&notification_config);
+        dumpVirtualSensorInfo(&virtual_sensor_config);
+        config_dump_ = {
+                .sensor_config = sensor_config.str(),
+                .notification_config = notification_config.str(),
+                .virtual_sensor_config = virtual_sensor_config.str(),
+        };
+    });
+    return config_dump_;
+}
+
+void Thermal::dumpThermalSnapshotJson(std::ostringstream *dump_buf,
+                                      const ThermalSnapshot &snapshot) {
+    const auto now = boot_clock::now();
+    const auto age_ms = [&now](boot_clock::time_point time) {
+        return static_cast<Json::Int64>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(now - time).count());
+    };
+    const auto request_map_json = [](const std::unordered_map<std::string, int> &request_map) {
+        Json::Value requests(Json::objectValue);
+        for (const auto &[cdev, request] : request_map) {
+            requests[cdev] = request;
+        }
+        return requests;
+    };
+
+    Json::Value root;
+    root["pass"] = static_cast<Json::UInt64>(snapshot.pass_count);
+    root["pass_age_ms"] = age_ms(snapshot.pass_time);
+
+    Json::Value sensors(Json::arrayValue);
+    for (const auto &sensor_snapshot : snapshot.sensors) {
+        Json::Value sensor;
+        sensor["name"] = sensor_snapshot->name;
+        sensor["type"] = toString(sensor_snapshot->temp.type);
+        if (sensor_snapshot->update_time != boot_clock::time_point::min()) {
+            sensor["value"] = sensor_snapshot->temp.value;
+            sensor["throttling_status"] = toString(sensor_snapshot->temp.throttlingStatus);
+            sensor["severity"] = toString(sensor_snapshot->severity);
+            sensor["update_age_ms"] = age_ms(sensor_snapshot->update_time);
+        }
+        if (sensor_snapshot->throttling_status != nullptr) {
+            const auto &throttling_status = *sensor_snapshot->throttling_status;
+            Json::Value throttling;
+            throttling["profile"] = throttling_status.profile;
+            if (!std::isnan(throttling_status.prev_power_budget)) {
+                throttling["power_budget"] = throttling_status.prev_power_budget;
+            }
+            throttling["pid_power_budget"] =
+                    request_map_json(throttling_status.pid_power_budget_map);
+            throttling["pid_cdev_request"] =
+                    request_map_json(throttling_status.pid_cdev_request_map);
+            throttling["hardlimit_cdev_request"] =
+                    request_map_json(throttling_status.hardlimit_cdev_request_map);
+            throttling["cdev_release"] = request_map_json(throttling_status.throttling_release_map);
+            throttling["cdev_request"] = request_map_json(throttling_status.cdev_status_map);
+            sensor["throttling"] = throttling;
+        }
+        const auto emul_it = snapshot.emul_settings->find(sensor_snapshot->name);
+        if (emul_it != snapshot.emul_settings->end()) {
+            sensor["emul_temp"] = emul_it->second.temp;
+            sensor["emul_severity"] = emul_it->second.severity;
+            sensor["max_throttling"] = emul_it->second.max_throttling;
+        }
+        sensors.append(sensor);
+    }
+    root["sensors"] = sensors;
+
+    const auto &cdev_info_map = thermal_helper_->GetCdevInfoMap();
+    Json::Value cdevs(Json::arrayValue);
+    for (const auto &[cdev_name, request] : *snapshot.cdev_requests) {
+        Json::Value cdev;
+        cdev["name"] = cdev_name;
+        const auto cdev_info_it = cdev_info_map.find(cdev_name);
+        if (cdev_info_it != cdev_info_map.end()) {
+            cdev["type"] = toString(cdev_info_it->second.type);
+        }
+        cdev["request"] = request;
+        cdevs.append(cdev);
+    }
+    root["cooling_devices"] = cdevs;
+
+    Json::Value power_rails(Json::arrayValue);
+    for (const auto &[rail_name, power_status] : *snapshot.power_status_map) {
+        Json::Value power_rail;
+        power_rail["name"] = rail_name;
+        if (!std::isnan(power_status.last_updated_avg_power)) {
+            power_rail["avg_power_mw"] = power_status.last_updated_avg_power;
+        }
+        power_rails.append(power_rail);
+    }
+    root["power_rails"] = power_rails;
+
+    Json::Value polling_stats;
+    polling_stats["wakeups"] = static_cast<Json::UInt64>(snapshot.polling_stats.wakeups);
+    polling_stats["sensors_polled"] =
+            static_cast<Json::UInt64>(snapshot.polling_stats.sensors_polled);
+    polling_stats["sensors_deferred"] =
+            static_cast<Json::UInt64>(snapshot.polling_stats.sensors_deferred);
+    polling_stats["adaptive_polls_saved"] =
+            static_cast<Json::UInt64>(snapshot.polling_stats.adaptive_polls_saved);
+    root["polling_stats"] = polling_stats;
+
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = " ";
+    *dump_buf << Json::writeString(builder, root) << std::endl;
+}
+
 void Thermal::dumpThermalData(int fd, const char **args, uint32_t numArgs) {
     std::ostringstream dump_buf;
 
     if (!thermal_helper_->isInitializedOk()) {
         dump_buf << "ThermalHAL not initialized properly." << std::endl;
     } else if (numArgs == 0 || std::string(args[0]) == "-a") {
-        const auto &sensor_status_map = thermal_helper_->GetSensorStatusMap();
+        // Live state is read from the last watcher pass' snapshot, never from the live maps
+        const auto snapshot = thermal_helper_->GetThermalSnapshot();
+        const auto &config_dump = getConfigDump();
+        const boot_clock::time_point now = boot_clock::now();
+        {
+            dump_buf << "getThermalSnapshot:" << std::endl;
+            dump_buf << " Pass: " << snapshot->pass_count << " Age: "
+                     << std::chrono::duration_cast<std::chrono::milliseconds>(now -
+                                                                              snapshot->pass_time)
+                                .count()
+                     << "ms" << std::endl;
+        }
         {
             dump_buf << "getCachedTemperatures:" << std::endl;
-            boot_clock::time_point now = boot_clock::now();
-            for (const auto &sensor_status_pair : sensor_status_map) {
-                if ((sensor_status_pair.second.thermal_cached.timestamp) ==
-                    boot_clock::time_point::min()) {
+            for (const auto &sensor_snapshot : snapshot->sensors) {
+                if (sensor_snapshot->update_time == boot_clock::time_point::min()) {
                     continue;
                 }
-                dump_buf << " Name: " << sensor_status_pair.first
-                         << " CachedValue: " << sensor_status_pair.second.thermal_cached.temp
-                         << " TimeToCache: "
+                dump_buf << " Name: " << sensor_snapshot->name
+                         << " CachedValue: " << sensor_snapshot->temp.value << " TimeToCache: "
                          << std::chrono::duration_cast<std::chrono::milliseconds>(
-                                    now - sensor_status_pair.second.thermal_cached.timestamp)
+                                    now - sensor_snapshot->update_time)
                                     .count()
                          << "ms" << std::endl;
             }
         }
         {
             dump_buf << "getEmulSettings:" << std::endl;
-            for (const auto &sensor_status_pair : sensor_status_map) {
-                if (sensor_status_pair.second.override_status.emul_temp == nullptr) {
-                    continue;
-                }
-                dump_buf << " Name: " << sensor_status_pair.first << " EmulTemp: "
-                         << sensor_status_pair.second.override_status.emul_temp->temp
-                         << " EmulSeverity: "
-                         << sensor_status_pair.second.override_status.emul_temp->severity
-                         << " maxThrottling: " << std::boolalpha
-                         << sensor_status_pair.second.override_status.max_throttling << std::endl;
+            for (const auto &[sensor_name, emul_setting] : *snapshot->emul_settings) {
+                dump_buf << " Name: " << sensor_name << " EmulTemp: " << emul_setting.temp
+                         << " EmulSeverity: " << emul_setting.severity
+                         << " maxThrottling: " << std::boolalpha << emul_setting.max_throttling
+                         << std::endl;
             }
         }
         {
-            const auto &map = thermal_helper_->GetSensorInfoMap();
             dump_buf << "getCurrentTemperatures:" << std::endl;
-            Temperature temp_2_0;
-            for (const auto &name_info_pair : map) {
-                thermal_helper_->readTemperature(name_info_pair.first, &temp_2_0, true);
-                dump_buf << " Type: " << toString(temp_2_0.type)
-                         << " Name: " << name_info_pair.first << " CurrentValue: " << temp_2_0.value
-                         << " ThrottlingStatus: " << toString(temp_2_0.throttlingStatus)
-                         << std::endl;
-            }
-            dump_buf << "getTemperatureThresholds:" << std::endl;
-            for (const auto &name_info_pair : map) {
-                if (!name_info_pair.second.is_watch) {
+            for (const auto &sensor_snapshot : snapshot->sensors) {
+                if (sensor_snapshot->update_time == boot_clock::time_point::min()) {
                     continue;
                 }
-                dump_buf << " Type: " << toString(name_info_pair.second.type)
-                         << " Name: " << name_info_pair.first;
-                dump_buf << " hotThrottlingThreshold: [";
-                for (size_t i = 0; i < kThrottlingSeverityCount; ++i) {
-                    dump_buf << name_info_pair.second.hot_thresholds[i] << " ";
-                }
-                dump_buf << "] coldThrottlingThreshold: [";
-                for (size_t i = 0; i < kThrottlingSeverityCount; ++i) {
-                    dump_buf << name_info_pair.second.cold_thresholds[i] << " ";
-                }
-                dump_buf << "] vrThrottlingThreshold: " << name_info_pair.second.vr_threshold;
-                dump_buf << std::endl;
-            }
-            dump_buf << "getHysteresis:" << std::endl;
-            for (const auto &name_info_pair : map) {
-                if (!name_info_pair.second.is_watch) {
-                    continue;
-                }
-                dump_buf << " Name: " << name_info_pair.first;
-                dump_buf << " hotHysteresis: [";
-                for (size_t i = 0; i < kThrottlingSeverityCount; ++i) {
-                    dump_buf << name_info_pair.second.hot_hysteresis[i] << " ";
-                }
-                dump_buf << "] coldHysteresis: [";
-                for (size_t i = 0; i < kThrottlingSeverityCount; ++i) {
-                    dump_buf << name_info_pair.second.cold_hysteresis[i] << " ";
-                }
-                dump_buf << "]" << std::endl;
+                dump_buf << " Type: " << toString(sensor_snapshot->temp.type)
+                         << " Name: " << sensor_snapshot->name
+                         << " CurrentValue: " << sensor_snapshot->temp.value
+                         << " ThrottlingStatus: "
+                         << toString(sensor_snapshot->temp.throttlingStatus) << std::endl;
             }
+            dump_buf << config_dump.sensor_config;
         }
         {
-            dump_buf << "getCurrentCoolingDevices:" << std::endl;
-            std::vector<CoolingDevice> cooling_devices;
-            if (!thermal_helper_->fillCurrentCoolingDevices(false, CoolingType::CPU,
-                                                            &cooling_devices)) {
-                dump_buf << " Failed to getCurrentCoolingDevices." << std::endl;
-            }
-
-            for (const auto &c : cooling_devices) {
-                dump_buf << " Type: " << toString(c.type) << " Name: " << c.name
-                         << " CurrentValue: " << c.value << std::endl;
+            dump_buf << "getCoolingDeviceRequests:" << std::endl;
+            const auto &cdev_info_map = thermal_helper_->GetCdevInfoMap();
+            for (const auto &[cdev_name, request] : *snapshot->cdev_requests) {
+                const auto cdev_info_it = cdev_info_map.find(cdev_name);
+                if (cdev_info_it == cdev_info_map.end()) {
+                    continue;
+                }
+                dump_buf << " Type: " << toString(cdev_info_it->second.type)
+                         << " Name: " << cdev_name << " RequestedValue: " << request << std::endl;
             }
         }
         {
+            std::lock_guard<std::mutex> _lock(thermal_callback_mutex_);
             dump_buf << "getCallbacks:" << std::endl;
             dump_buf << " Total: " << callbacks_.size() << std::endl;
             for (const auto &c : callbacks_) {
@@ -805,34 +958,22 @@ void Thermal::dumpThermalData(int fd, const char **args, uint32_t numArgs) {
                          << std::endl;
             }
         }
-        {
-            dump_buf << "sendCallback:" << std::endl;
-            dump_buf << "  Enabled List: ";
-            const auto &map = thermal_helper_->GetSensorInfoMap();
-            for (const auto &name_info_pair : map) {
-                if (name_info_pair.second.send_cb) {
-                    dump_buf << name_info_pair.first << " ";
-                }
-            }
-            dump_buf << std::endl;
-        }
-        {
-            dump_buf << "sendPowerHint:" << std::endl;
-            dump_buf << "  Enabled List: ";
-            const auto &map = thermal_helper_->GetSensorInfoMap();
-            for (const auto &name_info_pair : map) {
-                if (name_info_pair.second.send_powerhint) {
-                    dump_buf << name_info_pair.first << " ";
-                }
-            }
-            dump_buf << std::endl;
-        }
-        dumpVirtualSensorInfo(&dump_buf);
+        dump_buf << config_dump.notification_config;
+        dump_buf << config_dump.virtual_sensor_config;
         dumpVtEstimatorInfo(&dump_buf);
-        dumpThrottlingInfo(&dump_buf);
-        dumpThrottlingRequestStatus(&dump_buf);
-        dumpPowerRailInfo(&dump_buf);
+        dumpThrottlingInfo(&dump_buf, *snapshot);
+        dumpThrottlingRequestStatus(&dump_buf, *snapshot);
+        dumpPowerRailInfo(&dump_buf, *snapshot);
         dumpThermalStats(&dump_buf);
+        {
+            const auto &polling_stats = snapshot->polling_stats;
+            dump_buf << "getPollingStats:" << std::endl;
+            dump_buf << " Wakeups: " << polling_stats.wakeups << std::endl;
+            dump_buf << " Sensors Polled: " << polling_stats.sensors_polled << std::endl;
+            dump_buf << " Sensors Deferred: " << polling_stats.sensors_deferred << std::endl;
+            dump_buf << " Adaptive Polls Saved: " << polling_stats.adaptive_polls_saved
+                     << std::endl;
+        }
         {
             dump_buf << "getAIDLPowerHalInfo:" << std::endl;
             dump_buf << " Exist: " << std::boolalpha << thermal_helper_->isAidlPowerHalExist()
@@ -842,6 +983,8 @@ void Thermal::dumpThermalData(int fd, const char **args, uint32_t numArgs) {
             dump_buf << " Ext connected: " << std::boolalpha
                      << thermal_helper_->isPowerHalExtConnected() << std::endl;
         }
+    } else if (std::string(args[0]) == "-json") {
+        dumpThermalSnapshotJson(&dump_buf, *thermal_helper_->GetThermalSnapshot());
     } else if (std::string(args[0]) == "-vt-estimator") {
         dumpVtEstimatorInfo(&dump_buf);
     }
@@ -854,7 +997,8 @@ void Thermal::dumpThermalData(int fd, const char **args, uint32_t numArgs) {
 }
 
 binder_status_t Thermal::dump(int fd, const char **args, uint32_t numArgs) {
-    if (numArgs == 0 || std::string(args[0]) == "-a" || std::string(args[0]) == "-vt-estimator") {
+    if (numArgs == 0 || std::string(args[0]) == "-a" || std::string(args[0]) == "-json" ||
+        std::string(args[0]) == "-vt-estimator") {
         dumpThermalData(fd, args, numArgs);
         return STATUS_OK;
     }
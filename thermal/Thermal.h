@@ -108,6 +108,13 @@ class Thermal : public BnThermal {
         void loop();
     };
 
+    // Sections which only depend on the config
+    struct ConfigDump {
+        std::string sensor_config;
+        std::string notification_config;
+        std::string virtual_sensor_config;
+    };
+
     std::shared_ptr<ThermalHelper> thermal_helper_;
     std::mutex thermal_callback_mutex_;
     std::vector<CallbackSetting> callbacks_;
@@ -115,6 +122,8 @@ class Thermal : public BnThermal {
     std::vector<CoolingDeviceCallbackSetting> cdev_callbacks_;
 
     Looper looper_;
+    std::once_flag config_dump_once_;
+    ConfigDump config_dump_;
 
     ndk::ScopedAStatus getFilteredTemperatures(bool filterType, TemperatureType type,
                                                std::vector<Temperature> *_aidl_return);
@@ -126,14 +135,20 @@ class Thermal : public BnThermal {
             const std::shared_ptr<IThermalChangedCallback> &callback, bool filterType,
             TemperatureType type);
 
+    const ConfigDump &getConfigDump();
+
+    void dumpSensorConfig(std::ostringstream *dump_buf);
+    void dumpNotificationConfig(std::ostringstream *dump_buf);
     void dumpVirtualSensorInfo(std::ostringstream *dump_buf);
     void dumpVtEstimatorInfo(std::ostringstream *dump_buf);
-    void dumpThrottlingInfo(std::ostringstream *dump_buf);
-    void dumpThrottlingRequestStatus(std::ostringstream *dump_buf);
-    void dumpPowerRailInfo(std::ostringstream *dump_buf);
+    void dumpThrottlingInfo(std::ostringstream *dump_buf, const ThermalSnapshot &snapshot);
+    void dumpThrottlingRequestStatus(std::ostringstream *dump_buf,
+                                     const ThermalSnapshot &snapshot);
+    void dumpPowerRailInfo(std::ostringstream *dump_buf, const ThermalSnapshot &snapshot);
     void dumpStatsRecord(std::ostringstream *dump_buf, const StatsRecord &stats_record,
                          std::string_view line_prefix);
     void dumpThermalStats(std::ostringstream *dump_buf);
+    void dumpThermalSnapshotJson(std::ostringstream *dump_buf, const ThermalSnapshot &snapshot);
     void dumpThermalData(int fd, const char **args, uint32_t numArgs);
 };
 
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <sstream>
+#include <string>
+#include <unordered_map>
+
+#include "utils/power_files.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+namespace {
+
+using ::android::hardware::google::pixel::OdpmRecord;
+using ::android::hardware::google::pixel::ParseOdpmEnergyValues;
+
+// ODPM energy_value dumps captured from the main and sub PMIC of a device.
+constexpr std::string_view kOdpmMainDump =
+        "t=2348718\n"
+        "CH0(T=2348718)[S10M_VDD_TPU], 3426362148\n"
+        "CH1(T=2348718)[VSYS_PWR_MODEM], 15497520830\n"
+        "CH2(T=2348718)[VSYS_PWR_RFFE], 246310938\n"
+        "CH3(T=2348718)[S2M_VDD_CPUCL2], 19285327917\n"
+        "CH4(T=2348718)[S3M_VDD_CPUCL1], 10412519624\n"
+        "CH5(T=2348718)[S4M_VDD_CPUCL0], 25765418133\n"
+        "CH6(T=2348718)[S5M_VDD_INT], 20468553446\n"
+        "CH7(T=2348718)[S1M_VDD_MIF], 18931049370\n";
+constexpr std::string_view kOdpmSubDump =
+        "t=2348722\n"
+        "CH0(T=2348722)[VSYS_PWR_DISPLAY], 29314827652\n"
+        "CH1(T=2348722)[L2S_VDD_AOC_RET], 1032551843\n"
+        "CH2(T=2348722)[S9S_VDD_AOC], 7396285034\n"
+        "CH3(T=2348722)[S5S_VDDQ_MEM], 5028140294\n"
+        "CH4(T=2348722)[S10S_VDD2L], 11349621058\n"
+        "CH5(T=2348722)[S4S_VDD2H_MEM], 9612042171\n"
+        "CH6(T=2348722)[S2S_VDD_G3D], 13861950263\n"
+        "CH7(T=2348722)[VSYS_PWR_MMWAVE], 0\n";
+
+// The istringstream based parser used before ParseOdpmEnergyValues, kept as the baseline.
+void ParseEnergyValuesWithStream(const std::string &content,
+                                 std::unordered_map<std::string, PowerSample> *energy_info_map) {
+    std::istringstream energyData(content);
+    std::string line;
+
+    while (std::getline(energyData, line)) {
+        auto start_pos = line.find("T=");
+        auto end_pos = line.find(')');
+        if (start_pos == std::string::npos) {
+            continue;
+        }
+        const uint64_t duration =
+                strtoul(line.substr(start_pos + 2, end_pos - start_pos - 2).c_str(), NULL, 10);
+
+        start_pos = line.find(")[");
+        end_pos = line.find(']');
+        if (start_pos == std::string::npos) {
+            continue;
+        }
+        std::string railName = line.substr(start_pos + 2, end_pos - start_pos - 2);
+
+        start_pos = line.find("],");
+        if (start_pos == std::string::npos) {
+            continue;
+        }
+        const uint64_t energy_counter = strtoul(line.substr(start_pos + 2).c_str(), NULL, 10);
+        (*energy_info_map)[railName] = {.energy_counter = energy_counter, .duration = duration};
+    }
+}
+
+void BM_ParseEnergyValuesWithStream(benchmark::State &state) {
+    const std::string content = std::string(kOdpmMainDump) + std::string(kOdpmSubDump);
+    std::unordered_map<std::string, PowerSample> energy_info_map;
+
+    for (auto _ : state) {
+        ParseEnergyValuesWithStream(content, &energy_info_map);
+        benchmark::DoNotOptimize(energy_info_map);
+    }
+}
+BENCHMARK(BM_ParseEnergyValuesWithStream);
+
+void BM_ParseOdpmEnergyValues(benchmark::State &state) {
+    std::vector<OdpmRecord> records;
+    uint64_t timestamp_ms = 0;
+
+    for (auto _ : state) {
+        records.clear();
+        ParseOdpmEnergyValues(kOdpmMainDump, &timestamp_ms, &records);
+        ParseOdpmEnergyValues(kOdpmSubDump, &timestamp_ms, &records);
+        benchmark::DoNotOptimize(records.data());
+    }
+    state.SetItemsProcessed(state.iterations() * records.size());
+}
+BENCHMARK(BM_ParseOdpmEnergyValues);
+
+void BM_PowerHistoryPush(benchmark::State &state) {
+    PowerHistory power_history(state.range(0), {.energy_counter = 0, .duration = 0});
+    uint64_t t = 0;
+
+    for (auto _ : state) {
+        const auto &last_sample = power_history.front();
+        benchmark::DoNotOptimize(last_sample.energy_counter);
+        power_history.push({.energy_counter = t * 10, .duration = t});
+        t++;
+    }
+}
+BENCHMARK(BM_PowerHistoryPush)->Arg(1)->Arg(10)->Arg(60);
+
+}  // namespace
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
+
+BENCHMARK_MAIN();
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "utils/thermal_info.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+namespace {
+
+const ThrottlingArray kHotThresholds = {NAN, 39, 41, 43, 45, 47, 55};
+const ThrottlingArray kColdThresholds = {NAN, NAN, NAN, NAN, NAN, NAN, NAN};
+const ThrottlingArray kHotHysteresis = {0, 0.9, 0.9, 0.9, 0.9, 0.9, 0.9};
+const ThrottlingArray kColdHysteresis = {0, 0, 0, 0, 0, 0, 0};
+
+// Noisy readings spread across every skin threshold
+std::vector<float> MakeReadings() {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> temperature(35, 58);
+    std::vector<float> readings(4096);
+    for (auto &reading : readings) {
+        reading = temperature(rng);
+    }
+    return readings;
+}
+
+// Previous implementation: walk the severities from SHUTDOWN down on every reading.
+void BM_SeverityWalk(benchmark::State &state) {
+    const std::vector<float> readings = MakeReadings();
+    // Copies, as the thresholds live in SensorInfo rather than in constants
+    ThrottlingArray hot_thresholds = kHotThresholds;
+    ThrottlingArray cold_thresholds = kColdThresholds;
+    ThrottlingArray hot_hysteresis = kHotHysteresis;
+    ThrottlingArray cold_hysteresis = kColdHysteresis;
+    benchmark::DoNotOptimize(hot_thresholds);
+    benchmark::DoNotOptimize(cold_thresholds);
+    benchmark::DoNotOptimize(hot_hysteresis);
+    benchmark::DoNotOptimize(cold_hysteresis);
+    ThrottlingSeverity prev_hot_severity = ThrottlingSeverity::NONE;
+    ThrottlingSeverity prev_cold_severity = ThrottlingSeverity::NONE;
+    size_t count = 0;
+
+    for (auto _ : state) {
+        const float value = readings[count++ % readings.size()];
+        ThrottlingSeverity ret_hot = ThrottlingSeverity::NONE;
+        ThrottlingSeverity ret_hot_hysteresis = ThrottlingSeverity::NONE;
+        ThrottlingSeverity ret_cold = ThrottlingSeverity::NONE;
+        ThrottlingSeverity ret_cold_hysteresis = ThrottlingSeverity::NONE;
+        for (size_t i = static_cast<size_t>(ThrottlingSeverity::SHUTDOWN);
+             i > static_cast<size_t>(ThrottlingSeverity::NONE); --i) {
+            if (!std::isnan(hot_thresholds[i]) && hot_thresholds[i] <= value &&
+                ret_hot == ThrottlingSeverity::NONE) {
+                ret_hot = static_cast<ThrottlingSeverity>(i);
+            }
+            if (!std::isnan(hot_thresholds[i]) && (hot_thresholds[i] - hot_hysteresis[i]) < value &&
+                ret_hot_hysteresis == ThrottlingSeverity::NONE) {
+                ret_hot_hysteresis = static_cast<ThrottlingSeverity>(i);
+            }
+            if (!std::isnan(cold_thresholds[i]) && cold_thresholds[i] >= value &&
+                ret_cold == ThrottlingSeverity::NONE) {
+                ret_cold = static_cast<ThrottlingSeverity>(i);
+            }
+            if (!std::isnan(cold_thresholds[i]) &&
+                (cold_thresholds[i] + cold_hysteresis[i]) > value &&
+                ret_cold_hysteresis == ThrottlingSeverity::NONE) {
+                ret_cold_hysteresis = static_cast<ThrottlingSeverity>(i);
+            }
+        }
+        if (static_cast<size_t>(ret_hot) < static_cast<size_t>(prev_hot_severity)) {
+            ret_hot = ret_hot_hysteresis;
+        }
+        if (static_cast<size_t>(ret_cold) < static_cast<size_t>(prev_cold_severity)) {
+            ret_cold = ret_cold_hysteresis;
+        }
+        prev_hot_severity = ret_hot;
+        prev_cold_severity = ret_cold;
+        benchmark::DoNotOptimize(prev_hot_severity);
+        benchmark::DoNotOptimize(prev_cold_severity);
+    }
+}
+BENCHMARK(BM_SeverityWalk);
+
+void BM_SeverityTable(benchmark::State &state) {
+    const std::vector<float> readings = MakeReadings();
+    SeverityTable table =
+            BuildSeverityTable(kHotThresholds, kColdThresholds, kHotHysteresis, kColdHysteresis);
+    benchmark::DoNotOptimize(table);
+    ThrottlingSeverity prev_hot_severity = ThrottlingSeverity::NONE;
+    ThrottlingSeverity prev_cold_severity = ThrottlingSeverity::NONE;
+    size_t count = 0;
+
+    for (auto _ : state) {
+        const float value = readings[count++ % readings.size()];
+        std::tie(prev_hot_severity, prev_cold_severity) =
+                table.classify(value, prev_hot_severity, prev_cold_severity);
+        benchmark::DoNotOptimize(prev_hot_severity);
+        benchmark::DoNotOptimize(prev_cold_severity);
+    }
+}
+BENCHMARK(BM_SeverityTable);
+
+}  // namespace
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/file.h>
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/thermal_capture_writer.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+namespace {
+
+constexpr size_t kSensorCount = 40;
+constexpr size_t kThrottlingSensorCount = 10;
+constexpr size_t kCdevCount = 10;
+
+// A watcher pass polling every sensor, half of the cdevs updated, then the record commit
+void BM_ThermalCapturePass(benchmark::State &state) {
+    std::unordered_map<std::string, SensorInfo> sensor_info_map;
+    std::unordered_map<std::string, CdevInfo> cooling_device_info_map;
+    std::unordered_map<std::string, ThermalThrottlingStatus> throttling_status_map;
+    std::vector<std::string> sensors, cdevs;
+    for (size_t i = 0; i < kCdevCount; ++i) {
+        cdevs.push_back("cdev" + std::to_string(i));
+        cooling_device_info_map[cdevs.back()] = CdevInfo{};
+    }
+    for (size_t i = 0; i < kSensorCount; ++i) {
+        sensors.push_back("sensor" + std::to_string(i));
+        sensor_info_map[sensors.back()] = SensorInfo{};
+        if (i < kThrottlingSensorCount) {
+            auto &status = throttling_status_map[sensors.back()];
+            for (const auto &cdev : cdevs) {
+                status.pid_power_budget_map[cdev] = 1000;
+                status.pid_cdev_request_map[cdev] = 0;
+            }
+        }
+    }
+
+    TemporaryDir capture_dir;
+    ThermalCapture capture;
+    if (!capture.init(std::string(capture_dir.path) + "/thermal_capture.bin", 4096,
+                      sensor_info_map, cooling_device_info_map, throttling_status_map)) {
+        state.SkipWithError("Failed to init the capture");
+        return;
+    }
+
+    const auto now = boot_clock::now();
+    float temp = 30;
+    for (auto _ : state) {
+        for (size_t i = 0; i < kSensorCount; ++i) {
+            const auto status_it = throttling_status_map.find(sensors[i]);
+            capture.updateSensor(
+                    sensors[i], temp, ThrottlingSeverity::NONE,
+                    status_it == throttling_status_map.end() ? nullptr : &status_it->second);
+        }
+        for (size_t i = 0; i < kCdevCount; i += 2) {
+            capture.updateCdev(cdevs[i], i);
+        }
+        capture.commit(now);
+        temp += 0.01;
+    }
+}
+BENCHMARK(BM_ThermalCapturePass);
+
+}  // namespace
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/file.h>
+#include <android-base/properties.h>
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "utils/thermal_config_cache.h"
+#include "utils/thermal_info.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+namespace {
+
+// About the size of a phone config
+constexpr size_t kSensorCount = 48;
+constexpr size_t kThrottlingSensorCount = 16;
+constexpr size_t kVirtualSensorCount = 12;
+constexpr size_t kCdevCount = 16;
+constexpr size_t kBindedCdevCount = 4;
+
+std::string MakeConfig() {
+    std::string config = R"({"Sensors": [)";
+    for (size_t i = 0; i < kSensorCount; ++i) {
+        config += R"({"Name": "tz)" + std::to_string(i) +
+                  R"(", "Type": "UNKNOWN", "Multiplier": 0.001, "PollingDelay": 300000,
+                  "PassiveDelay": 7000, "HotThreshold": ["NAN", 39, 41, 43, 45, 47, 55],
+                  "HotHysteresis": [0, 0.9, 0.9, 0.9, 0.9, 0.9, 0.9])";
+        if (i < kThrottlingSensorCount) {
+            config += R"(, "PIDInfo": {
+                "K_Po": ["NAN", 50, 50, 50, 50, 50, 50],
+                "K_Pu": ["NAN", 50, 50, 50, 50, 50, 50],
+                "K_I": ["NAN", 5, 5, 5, 5, 5, 5],
+                "K_D": ["NAN", 0, 0, 0, 0, 0, 0],
+                "I_Max": ["NAN", 2000, 2000, 2000, 2000, 2000, 2000],
+                "MaxAllocPower": ["NAN", 8000, 8000, 8000, 8000, 8000, 8000],
+                "MinAllocPower": ["NAN", 500, 500, 500, 500, 500, 500],
+                "S_Power": ["NAN", "NAN", 4000, "NAN", "NAN", "NAN", "NAN"],
+                "I_Cutoff": ["NAN", 2, 2, 2, 2, 2, 2]}, "BindedCdevInfo": [)";
+            for (size_t j = 0; j < kBindedCdevCount; ++j) {
+                config += std::string(j ? "," : "") + R"({"CdevRequest": "cdev)" +
+                          std::to_string((i + j) % kCdevCount) +
+                          R"(", "CdevWeightForPID": ["NAN", 1, 1, 1, 1, 1, 1]})";
+            }
+            config += "]";
+        }
+        config += "},";
+    }
+    for (size_t i = 0; i < kVirtualSensorCount; ++i) {
+        config += R"({"Name": "virtual)" + std::to_string(i) +
+                  R"(", "Type": "SKIN", "VirtualSensor": true, "Formula": "WEIGHTED_AVG",
+                  "Combination": ["tz0", "tz1", "tz2", "tz3"],
+                  "Coefficient": [0.25, 0.25, 0.25, 0.25], "Multiplier": 0.001,
+                  "PollingDelay": 300000, "PassiveDelay": 7000,
+                  "HotThreshold": ["NAN", 39, 41, 43, 45, 47, 55],
+                  "HotHysteresis": [0, 0.9, 0.9, 0.9, 0.9, 0.9, 0.9]})";
+        config += i + 1 < kVirtualSensorCount ? "," : "";
+    }
+    config += R"(], "CoolingDevices": [)";
+    for (size_t i = 0; i < kCdevCount; ++i) {
+        config += R"({"Name": "cdev)" + std::to_string(i) +
+                  R"(", "Type": "CPU",
+                  "State2Power": [5000, 4500, 4000, 3500, 3000, 2500, 2000, 1500, 1000, 500]})";
+        config += i + 1 < kCdevCount ? "," : "";
+    }
+    return config + "]}";
+}
+
+// Reading and parsing the JSON document, without the sensor and cdev maps
+void BM_LoadThermalConfig(benchmark::State &state) {
+    TemporaryFile config_file;
+    if (!::android::base::WriteStringToFile(MakeConfig(), config_file.path)) {
+        state.SkipWithError("Failed to write the config");
+        return;
+    }
+    for (auto _ : state) {
+        Json::Value config;
+        std::unordered_set<std::string> loaded_config_paths;
+        if (!ParseThermalConfig(config_file.path, &config, &loaded_config_paths)) {
+            state.SkipWithError("Failed to load the config");
+            return;
+        }
+    }
+}
+BENCHMARK(BM_LoadThermalConfig)->Unit(benchmark::kMicrosecond);
+
+// Loading the same document from the config cache, which hashes the config file to validate it
+void BM_LoadThermalConfigCache(benchmark::State &state) {
+    TemporaryDir cache_dir;
+    TemporaryFile config_file;
+    const std::string cache_path = std::string(cache_dir.path) + "/thermal_config_cache.bin";
+    Json::Value config;
+    std::unordered_set<std::string> loaded_config_paths;
+    if (!::android::base::WriteStringToFile(MakeConfig(), config_file.path) ||
+        !ParseThermalConfig(config_file.path, &config, &loaded_config_paths) ||
+        !SaveThermalConfigCache(cache_path, config_file.path, config, loaded_config_paths)) {
+        state.SkipWithError("Failed to save the config cache");
+        return;
+    }
+    for (auto _ : state) {
+        Json::Value cached_config;
+        if (!LoadThermalConfigCache(cache_path, config_file.path, &cached_config)) {
+            state.SkipWithError("Failed to load the config cache");
+            return;
+        }
+    }
+}
+BENCHMARK(BM_LoadThermalConfigCache)->Unit(benchmark::kMicrosecond);
+
+void BM_ParseSensorInfo(benchmark::State &state) {
+    TemporaryFile config_file;
+    Json::Value config;
+    if (!::android::base::WriteStringToFile(MakeConfig(), config_file.path) ||
+        !LoadThermalConfig(config_file.path, &config)) {
+        state.SkipWithError("Failed to load the config");
+        return;
+    }
+    for (auto _ : state) {
+        std::unordered_map<std::string, SensorInfo> sensor_info_map;
+        if (!ParseSensorInfo(config, &sensor_info_map)) {
+            state.SkipWithError("Failed to parse the sensors");
+            return;
+        }
+    }
+}
+BENCHMARK(BM_ParseSensorInfo)->Unit(benchmark::kMicrosecond);
+
+void BM_ParseCoolingDevice(benchmark::State &state) {
+    TemporaryFile config_file;
+    Json::Value config;
+    if (!::android::base::WriteStringToFile(MakeConfig(), config_file.path) ||
+        !LoadThermalConfig(config_file.path, &config)) {
+        state.SkipWithError("Failed to load the config");
+        return;
+    }
+    for (auto _ : state) {
+        std::unordered_map<std::string, CdevInfo> cooling_device_info_map;
+        if (!ParseCoolingDevice(config, &cooling_device_info_map)) {
+            state.SkipWithError("Failed to parse the cdevs");
+            return;
+        }
+    }
+}
+BENCHMARK(BM_ParseCoolingDevice)->Unit(benchmark::kMicrosecond);
+
+// The config of the device, with the loads of its vt estimator models
+void BM_ParseDeviceConfig(benchmark::State &state) {
+    const std::string config_path =
+            "/vendor/etc/" +
+            ::android::base::GetProperty("vendor.thermal.config", "thermal_info_config.json");
+    for (auto _ : state) {
+        Json::Value config;
+        std::unordered_set<std::string> loaded_config_paths;
+        std::unordered_map<std::string, SensorInfo> sensor_info_map;
+        std::unordered_map<std::string, CdevInfo> cooling_device_info_map;
+        if (!ParseThermalConfig(config_path, &config, &loaded_config_paths) ||
+            !ParseCoolingDevice(config, &cooling_device_info_map) ||
+            !ParseSensorInfo(config, &sensor_info_map)) {
+            state.SkipWithError("Failed to parse the device config");
+            return;
+        }
+    }
+}
+BENCHMARK(BM_ParseDeviceConfig)->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/logging.h>
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/thermal_throttling.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+namespace {
+
+constexpr size_t kSensorCount = 20;
+constexpr size_t kCdevCount = 10;
+constexpr int kCdevMaxState = 31;
+constexpr float kBudgetTolerance = 50;
+
+// Every cdev halves its power over its states, from 3000mW down to a 100mW floor
+std::vector<float> MakeState2Power() {
+    std::vector<float> state2power;
+    for (int i = 0; i <= kCdevMaxState; ++i) {
+        state2power.push_back(100 + 2900 * std::pow(0.9f, i));
+    }
+    return state2power;
+}
+
+std::string CdevName(size_t i) {
+    return "cdev" + std::to_string(i);
+}
+
+std::string RailName(size_t i) {
+    return "rail" + std::to_string(i);
+}
+
+// kSensorCount skin-like sensors, each splitting its budget over the same kCdevCount cdevs
+class ThrottlingFixture {
+  public:
+    explicit ThrottlingFixture(float budget_tolerance) {
+        ::android::base::SetMinimumLogSeverity(::android::base::WARNING);
+        for (size_t i = 0; i < kCdevCount; ++i) {
+            cooling_device_info_map_[CdevName(i)] = CdevInfo{
+                    .type = CoolingType::CPU,
+                    .read_path = "",
+                    .write_path = "",
+                    .state2power = MakeState2Power(),
+                    .max_state = kCdevMaxState,
+                    .state2power_descending = true,
+            };
+            power_status_map_[RailName(i)].last_updated_avg_power = 1500;
+        }
+
+        sensor_info_map_.reserve(kSensorCount);
+        for (size_t i = 0; i < kSensorCount; ++i) {
+            const std::string name = "sensor" + std::to_string(i);
+            auto &sensor_info = sensor_info_map_[name];
+            sensor_info.type = TemperatureType::SKIN;
+            sensor_info.hot_thresholds = {NAN, 39, 41, 43, 45, 47, 55};
+            sensor_info.multiplier = 1;
+            sensor_info.throttling_info = MakeThrottlingInfo(budget_tolerance);
+            throttling_.registerThermalThrottling(name, sensor_info.throttling_info,
+                                                  cooling_device_info_map_);
+            temperatures_.push_back(Temperature{
+                    .type = TemperatureType::SKIN,
+                    .name = name,
+                    .value = 42.5f + 0.1f * i,
+                    .throttlingStatus = ThrottlingSeverity::MODERATE,
+            });
+        }
+    }
+
+    // One polling pass: every sensor recomputes its request from slightly noisy rail power
+    void update(std::mt19937 *rng) {
+        std::uniform_real_distribution<float> noise(-10, 10);
+        for (auto &power_status_pair : power_status_map_) {
+            power_status_pair.second.last_updated_avg_power = 1500 + noise(*rng);
+        }
+        for (const auto &temp : temperatures_) {
+            throttling_.thermalThrottlingUpdate(temp, sensor_info_map_.at(temp.name),
+                                                ThrottlingSeverity::MODERATE,
+                                                std::chrono::milliseconds(1000), power_status_map_,
+                                                cooling_device_info_map_);
+        }
+    }
+
+  private:
+    static std::shared_ptr<ThrottlingInfo> MakeThrottlingInfo(float budget_tolerance) {
+        auto throttling_info = std::make_shared<ThrottlingInfo>();
+        throttling_info->k_po.fill(50);
+        throttling_info->k_pu.fill(50);
+        throttling_info->k_io.fill(5);
+        throttling_info->k_iu.fill(5);
+        throttling_info->k_d.fill(0);
+        throttling_info->i_max.fill(2000);
+        throttling_info->max_alloc_power.fill(20000);
+        throttling_info->min_alloc_power.fill(1000);
+        throttling_info->s_power = {NAN, 12000, 10000, 8000, 6000, 4000, 2000};
+        throttling_info->i_cutoff.fill(10);
+        throttling_info->i_default = 0;
+        throttling_info->i_default_pct = NAN;
+        throttling_info->tran_cycle = 0;
+        throttling_info->budget_tolerance = budget_tolerance;
+        for (size_t i = 0; i < kCdevCount; ++i) {
+            BindedCdevInfo binded_cdev_info{};
+            binded_cdev_info.limit_info.fill(0);
+            binded_cdev_info.power_thresholds.fill(NAN);
+            binded_cdev_info.release_logic = ReleaseLogic::NONE;
+            binded_cdev_info.cdev_weight_for_pid.fill(1);
+            binded_cdev_info.cdev_ceiling.fill(kCdevMaxState);
+            binded_cdev_info.max_release_step = std::numeric_limits<int>::max();
+            binded_cdev_info.max_throttle_step = std::numeric_limits<int>::max();
+            binded_cdev_info.cdev_floor_with_power_link.fill(0);
+            binded_cdev_info.power_rail = RailName(i);
+            binded_cdev_info.enabled = true;
+            throttling_info->binded_cdev_info_map[CdevName(i)] = binded_cdev_info;
+        }
+        return throttling_info;
+    }
+
+    ThermalThrottling throttling_;
+    std::unordered_map<std::string, SensorInfo> sensor_info_map_;
+    std::unordered_map<std::string, CdevInfo> cooling_device_info_map_;
+    std::unordered_map<std::string, PowerStatus> power_status_map_;
+    std::vector<Temperature> temperatures_;
+};
+
+void RunThrottlingUpdate(benchmark::State &state, float budget_tolerance) {
+    ThrottlingFixture fixture(budget_tolerance);
+    std::mt19937 rng(1234);
+    // Let the splits settle before measuring
+    for (int i = 0; i < 100; ++i) {
+        fixture.update(&rng);
+    }
+    for (auto _ : state) {
+        fixture.update(&rng);
+    }
+    state.SetItemsProcessed(state.iterations() * kSensorCount);
+}
+
+// A pass over 20 throttled sensors x 10 cdevs, splitting the budget on every update
+void BM_ThrottlingUpdate(benchmark::State &state) {
+    RunThrottlingUpdate(state, NAN);
+}
+BENCHMARK(BM_ThrottlingUpdate);
+
+// Same pass, keeping the settled splits while the power moves within the tolerance
+void BM_ThrottlingUpdateWithTolerance(benchmark::State &state) {
+    RunThrottlingUpdate(state, kBudgetTolerance);
+}
+BENCHMARK(BM_ThrottlingUpdateWithTolerance);
+
+// Budgets landing on every state of the table
+std::vector<int> MakePowerBudgets() {
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<int> state(0, kCdevMaxState);
+    const std::vector<float> state2power = MakeState2Power();
+    std::vector<int> power_budgets(4096);
+    for (auto &power_budget : power_budgets) {
+        power_budget = static_cast<int>(state2power[state(rng)]) + 1;
+    }
+    return power_budgets;
+}
+
+// Previous implementation: scan the table from state 0.
+void BM_CdevStateOfPowerScan(benchmark::State &state) {
+    std::vector<float> state2power = MakeState2Power();
+    benchmark::DoNotOptimize(state2power);
+    const std::vector<int> power_budgets = MakePowerBudgets();
+    size_t count = 0;
+    size_t i;
+
+    for (auto _ : state) {
+        const int power_budget = power_budgets[count++ % power_budgets.size()];
+        for (i = 0; i < state2power.size() - 1; ++i) {
+            if (power_budget >= state2power[i]) {
+                break;
+            }
+        }
+        benchmark::DoNotOptimize(i);
+    }
+}
+BENCHMARK(BM_CdevStateOfPowerScan);
+
+void BM_CdevStateOfPower(benchmark::State &state) {
+    CdevInfo cdev_info = {
+            .type = CoolingType::CPU,
+            .read_path = "",
+            .write_path = "",
+            .state2power = MakeState2Power(),
+            .max_state = kCdevMaxState,
+            .state2power_descending = true,
+    };
+    benchmark::DoNotOptimize(cdev_info);
+    const std::vector<int> power_budgets = MakePowerBudgets();
+    size_t count = 0;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+                getCdevStateOfPower(cdev_info, power_budgets[count++ % power_budgets.size()]));
+    }
+}
+BENCHMARK(BM_CdevStateOfPower);
+
+}  // namespace
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "virtualtemp_estimator/virtualtemp_estimator.h"
+
+namespace thermal {
+namespace vtestimator {
+namespace {
+
+constexpr std::string_view kBenchSensorName("VIRTUAL-SKIN-BENCH");
+
+std::vector<float> MakeThermistors(size_t num_linked_sensors, size_t iteration) {
+    std::vector<float> thermistors(num_linked_sensors);
+    for (size_t i = 0; i < num_linked_sensors; ++i) {
+        thermistors[i] = 25000.0f + static_cast<float>((iteration * 37 + i * 101) % 20000);
+    }
+    return thermistors;
+}
+
+// Previous implementation: ring of per-order sample vectors walked newest to oldest.
+void BM_LinearModelNested(benchmark::State &state) {
+    const size_t prev_samples_order = state.range(0);
+    const size_t num_linked_sensors = state.range(1);
+    std::vector<std::vector<float>> coefficients(prev_samples_order,
+                                                 std::vector<float>(num_linked_sensors, 0.01f));
+    std::vector<std::vector<float>> samples(prev_samples_order,
+                                            MakeThermistors(num_linked_sensors, 0));
+    std::vector<std::vector<float>> inputs;
+    for (size_t i = 0; i < 64; ++i) {
+        inputs.push_back(MakeThermistors(num_linked_sensors, i));
+    }
+
+    size_t count = 0;
+    for (auto _ : state) {
+        const std::vector<float> &thermistors = inputs[count % inputs.size()];
+        int input_level = count % prev_samples_order;
+        samples[input_level] = thermistors;
+        float estimated_value = 0;
+        for (size_t i = 0; i < prev_samples_order; ++i) {
+            for (size_t j = 0; j < num_linked_sensors; ++j) {
+                estimated_value += coefficients[i][j] * samples[input_level][j];
+            }
+            input_level--;
+            input_level = (input_level >= 0) ? input_level : (prev_samples_order - 1);
+        }
+        benchmark::DoNotOptimize(estimated_value);
+        count++;
+    }
+}
+BENCHMARK(BM_LinearModelNested)->Args({1, 8})->Args({4, 12})->Args({10, 12})->Args({30, 16});
+
+void BM_LinearModelEstimate(benchmark::State &state) {
+    const size_t prev_samples_order = state.range(0);
+    const size_t num_linked_sensors = state.range(1);
+    VirtualTempEstimator estimator(kBenchSensorName, kUseLinearModel, num_linked_sensors);
+    VtEstimationInitData init_data(kUseLinearModel);
+    init_data.linear_model_init_data.prev_samples_order = prev_samples_order;
+    init_data.linear_model_init_data.use_prev_samples = prev_samples_order > 1;
+    init_data.linear_model_init_data.coefficients.assign(prev_samples_order * num_linked_sensors,
+                                                         0.01f);
+    if (estimator.Initialize(init_data) != kVtEstimatorOk) {
+        state.SkipWithError("Failed to initialize linear model");
+        return;
+    }
+
+    std::vector<std::vector<float>> inputs;
+    for (size_t i = 0; i < 64; ++i) {
+        inputs.push_back(MakeThermistors(num_linked_sensors, i));
+    }
+
+    std::vector<float> output;
+    size_t count = 0;
+    for (auto _ : state) {
+        estimator.Estimate(inputs[count++ % inputs.size()], &output);
+        benchmark::DoNotOptimize(output.data());
+    }
+}
+BENCHMARK(BM_LinearModelEstimate)->Args({1, 8})->Args({4, 12})->Args({10, 12})->Args({30, 16});
+
+}  // namespace
+}  // namespace vtestimator
+}  // namespace thermal
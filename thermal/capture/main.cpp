@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <android-base/stringprintf.h>
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "utils/thermal_capture.h"
+
+using ::aidl::android::hardware::thermal::implementation::DecodeThermalCapture;
+using ::aidl::android::hardware::thermal::implementation::kThermalCaptureSeverityNames;
+using ::aidl::android::hardware::thermal::implementation::ThermalCaptureRecord;
+using ::aidl::android::hardware::thermal::implementation::ThermalCaptureSchema;
+using ::android::base::StringPrintf;
+
+namespace {
+
+std::string severityName(uint8_t severity) {
+    return severity < kThermalCaptureSeverityNames.size()
+                   ? std::string(kThermalCaptureSeverityNames[severity])
+                   : std::to_string(severity);
+}
+
+void usage(const char *name) {
+    LOG(ERROR) << "Usage: " << name << " [-s] <capture file> [output csv]";
+    LOG(ERROR) << "  -s: print the schema only";
+    LOG(ERROR) << "  Writes one row per record to the output csv, or to stdout";
+}
+
+void printSchema(const ThermalCaptureSchema &schema, std::ostream *out) {
+    *out << "records: " << schema.record_count << '\n';
+    for (size_t i = 0; i < schema.sensors.size(); ++i) {
+        *out << "sensor " << i << ": " << schema.sensors[i] << '\n';
+    }
+    for (size_t i = 0; i < schema.cdevs.size(); ++i) {
+        *out << "cdev " << i << ": " << schema.cdevs[i] << '\n';
+    }
+    for (size_t i = 0; i < schema.bindings.size(); ++i) {
+        *out << "binding " << i << ": " << schema.sensors[schema.bindings[i].sensor_id] << " -> "
+             << schema.cdevs[schema.bindings[i].cdev_id] << '\n';
+    }
+}
+
+void writeCsv(const ThermalCaptureSchema &schema, const std::vector<ThermalCaptureRecord> &records,
+              std::ostream *out) {
+    *out << "seq,timestamp_ms";
+    for (const auto &sensor : schema.sensors) {
+        for (const char *field : {"temp", "severity", "updated", "power_budget", "err", "p", "i",
+                                  "d"}) {
+            *out << ',' << sensor << '.' << field;
+        }
+    }
+    for (const auto &binding : schema.bindings) {
+        const std::string name =
+                schema.sensors[binding.sensor_id] + "-" + schema.cdevs[binding.cdev_id];
+        for (const char *field : {"power_budget", "pid_request", "hardlimit_request"}) {
+            *out << ',' << name << '.' << field;
+        }
+    }
+    for (const auto &cdev : schema.cdevs) {
+        *out << ',' << cdev << ".state";
+    }
+    *out << '\n';
+
+    for (const auto &record : records) {
+        *out << record.seq << ',' << record.timestamp_ms;
+        for (const auto &sensor : record.sensors) {
+            *out << ',' << StringPrintf("%0.2f", sensor.temp) << ','
+                 << severityName(sensor.severity) << ','
+                 << static_cast<int>(sensor.updated) << ','
+                 << StringPrintf("%0.2f,%0.2f,%0.2f,%0.2f,%0.2f", sensor.power_budget,
+                                 sensor.err, sensor.p, sensor.i, sensor.d);
+        }
+        for (const auto &binding : record.bindings) {
+            *out << ',' << binding.power_budget << ',' << binding.pid_request << ','
+                 << binding.hardlimit_request;
+        }
+        for (const auto state : record.cdev_states) {
+            *out << ',' << state;
+        }
+        *out << '\n';
+    }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    ::android::base::InitLogging(argv, ::android::base::StderrLogger);
+    int arg = 1;
+    bool schema_only = false;
+    if (arg < argc && !strcmp(argv[arg], "-s")) {
+        schema_only = true;
+        arg++;
+    }
+    if (argc - arg != 1 && argc - arg != 2) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::string data;
+    if (!::android::base::ReadFileToString(argv[arg], &data)) {
+        PLOG(ERROR) << "Failed to read " << argv[arg];
+        return EXIT_FAILURE;
+    }
+    ThermalCaptureSchema schema;
+    std::vector<ThermalCaptureRecord> records;
+    if (!DecodeThermalCapture(data, &schema, &records)) {
+        LOG(ERROR) << "Failed to decode " << argv[arg];
+        return EXIT_FAILURE;
+    }
+
+    std::ofstream file;
+    std::ostream *out = &std::cout;
+    if (argc - arg == 2) {
+        file.open(argv[arg + 1]);
+        out = &file;
+    }
+    if (schema_only) {
+        printSchema(schema, out);
+    } else {
+        writeCsv(schema, records, out);
+    }
+    out->flush();
+    if (!out->good()) {
+        LOG(ERROR) << "Failed to write the decoded capture";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/logging.h>
+#include <android-base/stringprintf.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <set>
+#include <unordered_set>
+
+#include "thermal_replay.h"
+
+using ::aidl::android::hardware::thermal::implementation::BudgetRecord;
+using ::aidl::android::hardware::thermal::implementation::CdevRequestRecord;
+using ::aidl::android::hardware::thermal::implementation::CdevRequestSummary;
+using ::aidl::android::hardware::thermal::implementation::ParseReplayTrace;
+using ::aidl::android::hardware::thermal::implementation::ParseThermalConfig;
+using ::aidl::android::hardware::thermal::implementation::ReplaySample;
+using ::aidl::android::hardware::thermal::implementation::ReplaySampleType;
+using ::aidl::android::hardware::thermal::implementation::SummarizeCdevRequests;
+using ::aidl::android::hardware::thermal::implementation::ThermalReplay;
+using ::android::base::StringPrintf;
+
+namespace {
+
+void usage(const char *name) {
+    LOG(ERROR) << "Usage: " << name << " [-v] [-c] <thermal config> <trace> <output prefix>";
+    LOG(ERROR) << "  Writes <output prefix>_cdev.csv and <output prefix>_budget.csv";
+    LOG(ERROR) << "  -c also replays without the trace's predictions, as reactive PID, into";
+    LOG(ERROR) << "     <output prefix>_reactive_*.csv and compares the cdev requests";
+}
+
+bool writeCdevRecords(const std::string &path, const std::vector<CdevRequestRecord> &records) {
+    std::ofstream out(path);
+    out << "time_ms,cdev,state\n";
+    for (const auto &record : records) {
+        out << record.time.count() << ',' << record.cdev << ',' << record.state << '\n';
+    }
+    return out.good();
+}
+
+bool writeBudgetRecords(const std::string &path, const std::vector<BudgetRecord> &records) {
+    std::ofstream out(path);
+    out << "time_ms,sensor,temp,severity,power_budget,cdev,cdev_power_budget,pid_request,"
+           "predicted_peak\n";
+    for (const auto &record : records) {
+        out << record.time.count() << ',' << record.sensor << ','
+            << StringPrintf("%0.2f", record.temp) << ',' << toString(record.severity) << ','
+            << StringPrintf("%0.2f", record.power_budget) << ',' << record.cdev << ','
+            << record.cdev_power_budget << ',' << record.pid_request << ','
+            << StringPrintf("%0.2f", record.predicted_peak) << '\n';
+    }
+    return out.good();
+}
+
+// Replay the trace with a fresh throttling state and write the records under output_prefix
+bool runReplay(const Json::Value &config, const std::vector<ReplaySample> &samples,
+               const std::string &output_prefix, std::vector<CdevRequestRecord> *cdev_records) {
+    ThermalReplay thermal_replay;
+    if (!thermal_replay.init(config)) {
+        LOG(ERROR) << "Failed to load the thermal config";
+        return false;
+    }
+
+    std::vector<BudgetRecord> budget_records;
+    const auto start = std::chrono::steady_clock::now();
+    thermal_replay.replay(samples, cdev_records, &budget_records);
+    const auto replay_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start);
+
+    if (!writeCdevRecords(output_prefix + "_cdev.csv", *cdev_records) ||
+        !writeBudgetRecords(output_prefix + "_budget.csv", budget_records)) {
+        LOG(ERROR) << "Failed to write the replay output to " << output_prefix;
+        return false;
+    }
+
+    const auto trace_ms = samples.empty() ? std::chrono::milliseconds::zero()
+                                          : samples.back().time - samples.front().time;
+    std::cout << "Replayed " << samples.size() << " samples covering " << trace_ms.count()
+              << "ms in " << replay_ms.count() << "ms: " << cdev_records->size()
+              << " cdev requests, " << budget_records.size() << " budget records" << std::endl;
+    return true;
+}
+
+void printSummary(std::string_view cdev, std::string_view mode,
+                  const std::unordered_map<std::string, CdevRequestSummary> &summaries) {
+    const auto summary_it = summaries.find(std::string(cdev));
+    if (summary_it == summaries.end()) {
+        std::cout << "  " << cdev << " " << mode << ": never requested" << std::endl;
+        return;
+    }
+    const auto &summary = summary_it->second;
+    std::cout << "  " << cdev << " " << mode
+              << ": first throttle at " << summary.first_throttle_time.count()
+              << "ms, max state " << summary.max_state << ", "
+              << StringPrintf("%0.1f", summary.state_ms / 1000.0) << " state*s" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    ::android::base::InitLogging(argv, ::android::base::StderrLogger);
+    int arg = 1;
+    bool compare_reactive = false;
+    // The throttling path logs every update at INFO
+    ::android::base::SetMinimumLogSeverity(::android::base::WARNING);
+    for (; arg < argc && argv[arg][0] == '-'; ++arg) {
+        if (!strcmp(argv[arg], "-v")) {
+            ::android::base::SetMinimumLogSeverity(::android::base::INFO);
+        } else if (!strcmp(argv[arg], "-c")) {
+            compare_reactive = true;
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (argc - arg != 3) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    const std::string config_path = argv[arg];
+    const std::string trace_path = argv[arg + 1];
+    const std::string output_prefix = argv[arg + 2];
+
+    Json::Value config;
+    std::unordered_set<std::string> loaded_config_paths;
+    if (!ParseThermalConfig(config_path, &config, &loaded_config_paths)) {
+        LOG(ERROR) << "Failed to read JSON config " << config_path;
+        return EXIT_FAILURE;
+    }
+    std::ifstream trace(trace_path);
+    std::vector<ReplaySample> samples;
+    if (!trace.is_open() || !ParseReplayTrace(&trace, &samples)) {
+        LOG(ERROR) << "Failed to read trace " << trace_path;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<CdevRequestRecord> cdev_records;
+    if (!runReplay(config, samples, output_prefix, &cdev_records)) {
+        return EXIT_FAILURE;
+    }
+    if (!compare_reactive) {
+        return EXIT_SUCCESS;
+    }
+
+    // Without predictions every sensor throttles with reactive PID
+    std::vector<ReplaySample> reactive_samples;
+    std::copy_if(samples.begin(), samples.end(), std::back_inserter(reactive_samples),
+                 [](const ReplaySample &sample) {
+                     return sample.type != ReplaySampleType::PREDICTION;
+                 });
+    std::vector<CdevRequestRecord> reactive_cdev_records;
+    if (!runReplay(config, reactive_samples, output_prefix + "_reactive",
+                   &reactive_cdev_records)) {
+        return EXIT_FAILURE;
+    }
+
+    const auto end_time = samples.empty() ? std::chrono::milliseconds::zero()
+                                          : samples.back().time;
+    const auto summaries = SummarizeCdevRequests(cdev_records, end_time);
+    const auto reactive_summaries = SummarizeCdevRequests(reactive_cdev_records, end_time);
+    std::set<std::string> cdevs;
+    for (const auto *summary_map : {&summaries, &reactive_summaries}) {
+        for (const auto &summary_pair : *summary_map) {
+            cdevs.insert(summary_pair.first);
+        }
+    }
+    std::cout << "Cdev requests, as configured vs reactive PID:" << std::endl;
+    for (const auto &cdev : cdevs) {
+        printSummary(cdev, "configured", summaries);
+        printSummary(cdev, "reactive", reactive_summaries);
+    }
+    return EXIT_SUCCESS;
+}
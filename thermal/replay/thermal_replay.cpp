@@ -0,0 +1,429 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "thermal_replay.h"
+
+#include <android-base/logging.h>
+#include <android-base/strings.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+namespace {
+
+constexpr std::string_view kTempLogSuffix(" raw data:");
+constexpr std::string_view kPowerLogPrefix("Power rails [");
+
+bool ParseValue(std::string_view str, float *value) {
+    const std::string value_str = ::android::base::Trim(std::string(str));
+    char *end = nullptr;
+    *value = std::strtof(value_str.c_str(), &end);
+    return !value_str.empty() && end == value_str.c_str() + value_str.size();
+}
+
+// "<value>,<value>,..."
+bool ParseValues(std::string_view str, std::vector<float> *values) {
+    for (const auto &value_str : ::android::base::Split(std::string(str), ",")) {
+        float value;
+        if (!ParseValue(value_str, &value)) {
+            return false;
+        }
+        values->push_back(value);
+    }
+    return true;
+}
+
+// "<time_ms> temp|power <name> <value>" or "<time_ms> predict <name> <value>,<value>,..."
+bool ParseNativeLine(std::string_view line, std::vector<ReplaySample> *samples) {
+    std::istringstream fields{std::string(line)};
+    int64_t time_ms;
+    std::string type, name, value_str;
+    if (!(fields >> time_ms >> type >> name >> value_str)) {
+        return false;
+    }
+
+    if (type == "predict") {
+        std::vector<float> predictions;
+        if (!ParseValues(value_str, &predictions)) {
+            return false;
+        }
+        samples->push_back({std::chrono::milliseconds(time_ms), ReplaySampleType::PREDICTION,
+                            name, NAN, std::move(predictions)});
+        return true;
+    }
+
+    float value;
+    if (!ParseValue(value_str, &value)) {
+        return false;
+    }
+
+    ReplaySampleType sample_type;
+    if (type == "temp") {
+        sample_type = ReplaySampleType::TEMPERATURE;
+    } else if (type == "power") {
+        sample_type = ReplaySampleType::POWER;
+    } else {
+        return false;
+    }
+    samples->push_back({std::chrono::milliseconds(time_ms), sample_type, name, value, {}});
+    return true;
+}
+
+// "MM-DD HH:MM:SS.mmm  PID  TID L TAG: message", only relative times matter for a replay
+bool ParseLogcatLine(std::string_view line, std::chrono::milliseconds *time,
+                     std::string_view *message) {
+    int month, day, hour, minute, second, millis;
+    if (std::sscanf(std::string(line.substr(0, 18)).c_str(), "%d-%d %d:%d:%d.%d", &month, &day,
+                    &hour, &minute, &second, &millis) != 6) {
+        return false;
+    }
+    const size_t message_pos = line.find(": ", 18);
+    if (message_pos == std::string_view::npos) {
+        return false;
+    }
+    *time = std::chrono::milliseconds(
+            ((((static_cast<int64_t>(month) * 31 + day) * 24 + hour) * 60 + minute) * 60 +
+             second) * 1000 +
+            millis);
+    *message = line.substr(message_pos + 2);
+    return true;
+}
+
+// "<sensor>:<value> raw data: ..."
+bool ParseTempLog(std::chrono::milliseconds time, std::string_view message,
+                  std::vector<ReplaySample> *samples) {
+    const size_t suffix_pos = message.find(kTempLogSuffix);
+    if (suffix_pos == std::string_view::npos) {
+        return false;
+    }
+    const std::string_view reading = message.substr(0, suffix_pos);
+    const size_t colon_pos = reading.rfind(':');
+    float value;
+    if (colon_pos == std::string_view::npos || colon_pos == 0 ||
+        !ParseValue(reading.substr(colon_pos + 1), &value)) {
+        return false;
+    }
+    samples->push_back({time, ReplaySampleType::TEMPERATURE,
+                        std::string(reading.substr(0, colon_pos)), value, {}});
+    return true;
+}
+
+// "Power rails [<rail>: <value> mW] [<rail>: <value> mW] ..."
+bool ParsePowerLog(std::chrono::milliseconds time, std::string_view message,
+                   std::vector<ReplaySample> *samples) {
+    if (!::android::base::StartsWith(message, kPowerLogPrefix)) {
+        return false;
+    }
+    bool parsed = false;
+    size_t pos = 0;
+    while ((pos = message.find('[', pos)) != std::string_view::npos) {
+        const size_t end_pos = message.find(" mW]", pos);
+        const size_t colon_pos = message.rfind(": ", end_pos);
+        if (end_pos == std::string_view::npos || colon_pos == std::string_view::npos ||
+            colon_pos < pos) {
+            break;
+        }
+        float value;
+        if (ParseValue(message.substr(colon_pos + 2, end_pos - colon_pos - 2), &value)) {
+            samples->push_back({time, ReplaySampleType::POWER,
+                                std::string(message.substr(pos + 1, colon_pos - pos - 1)), value,
+                                {}});
+            parsed = true;
+        }
+        pos = end_pos;
+    }
+    return parsed;
+}
+
+}  // namespace
+
+bool ParseReplayTraceLine(std::string_view line, std::vector<ReplaySample> *samples) {
+    if (ParseNativeLine(line, samples)) {
+        return true;
+    }
+
+    std::chrono::milliseconds time;
+    std::string_view message;
+    if (!ParseLogcatLine(line, &time, &message)) {
+        return false;
+    }
+    return ParseTempLog(time, message, samples) || ParsePowerLog(time, message, samples);
+}
+
+bool ParseReplayTrace(std::istream *in, std::vector<ReplaySample> *samples) {
+    std::string line;
+    size_t skipped = 0;
+    while (std::getline(*in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        if (!ParseReplayTraceLine(line, samples)) {
+            skipped++;
+        }
+    }
+    if (in->bad()) {
+        LOG(ERROR) << "Failed to read the trace";
+        return false;
+    }
+    std::stable_sort(samples->begin(), samples->end(),
+                     [](const ReplaySample &a, const ReplaySample &b) { return a.time < b.time; });
+    LOG(INFO) << "Parsed " << samples->size() << " samples, skipped " << skipped << " lines";
+    return true;
+}
+
+std::unordered_map<std::string, CdevRequestSummary> SummarizeCdevRequests(
+        const std::vector<CdevRequestRecord> &records, std::chrono::milliseconds end_time) {
+    const CdevRequestSummary not_throttled = {
+            .first_throttle_time = std::chrono::milliseconds(-1),
+            .max_state = 0,
+            .state_ms = 0,
+    };
+    std::unordered_map<std::string, CdevRequestSummary> summaries;
+    // The state and since when it is requested, per cdev
+    std::unordered_map<std::string, std::pair<int, std::chrono::milliseconds>> requests;
+    for (const auto &record : records) {
+        auto &summary = summaries.try_emplace(record.cdev, not_throttled).first->second;
+        auto &request = requests.try_emplace(record.cdev, 0, record.time).first->second;
+        summary.state_ms += request.first * (record.time - request.second).count();
+        request = {record.state, record.time};
+        if (record.state > 0 && summary.first_throttle_time.count() < 0) {
+            summary.first_throttle_time = record.time;
+        }
+        summary.max_state = std::max(summary.max_state, record.state);
+    }
+    for (const auto &request_pair : requests) {
+        const auto &request = request_pair.second;
+        if (end_time > request.second) {
+            summaries.at(request_pair.first).state_ms +=
+                    request.first * (end_time - request.second).count();
+        }
+    }
+    return summaries;
+}
+
+bool ThermalReplay::init(const Json::Value &config) {
+    if (!ParseCoolingDevice(config, &cooling_device_info_map_)) {
+        LOG(ERROR) << "Failed to parse cooling device info config";
+        return false;
+    }
+
+    if (!ParseSensorInfo(config, &sensor_info_map_)) {
+        LOG(ERROR) << "Failed to parse sensor info config";
+        return false;
+    }
+
+    // Without sysfs, the max state comes from the State2Power table
+    for (auto &cooling_device_info_pair : cooling_device_info_map_) {
+        auto &cdev_info = cooling_device_info_pair.second;
+        cdev_info.max_state = cdev_info.state2power.empty()
+                                      ? std::numeric_limits<int>::max()
+                                      : static_cast<int>(cdev_info.state2power.size()) - 1;
+        cdev_info.state2power_descending = true;
+        for (size_t i = 1; i < cdev_info.state2power.size(); ++i) {
+            if (!(cdev_info.state2power[i] <= cdev_info.state2power[i - 1])) {
+                cdev_info.state2power_descending = false;
+            }
+        }
+    }
+
+    for (auto &name_info_pair : sensor_info_map_) {
+        sensor_status_map_[name_info_pair.first] = {
+                .severity = ThrottlingSeverity::NONE,
+                .prev_hot_severity = ThrottlingSeverity::NONE,
+                .prev_cold_severity = ThrottlingSeverity::NONE,
+                .last_update_time = std::chrono::milliseconds::zero(),
+                .updated = false,
+        };
+
+        const auto &throttling_info = name_info_pair.second.throttling_info;
+        if (throttling_info == nullptr) {
+            continue;
+        }
+        if (!prepareBindedCdevs(name_info_pair.first, &throttling_info->binded_cdev_info_map)) {
+            return false;
+        }
+        for (auto &profile_pair : throttling_info->profile_map) {
+            if (!prepareBindedCdevs(name_info_pair.first, &profile_pair.second)) {
+                return false;
+            }
+        }
+        // Rails stay under collecting until their first sample, as in PowerFiles
+        for (const auto &excluded_power_info_pair : throttling_info->excluded_power_info_map) {
+            power_status_map_[excluded_power_info_pair.first].last_updated_avg_power = NAN;
+        }
+        if (!thermal_throttling_.registerThermalThrottling(
+                    name_info_pair.first, throttling_info, cooling_device_info_map_)) {
+            LOG(ERROR) << name_info_pair.first << " failed to register thermal throttling";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ThermalReplay::prepareBindedCdevs(
+        std::string_view sensor_name,
+        std::unordered_map<std::string, BindedCdevInfo> *binded_cdev_info_map) {
+    for (auto &binded_cdev_info_pair : *binded_cdev_info_map) {
+        auto &binded_cdev_info = binded_cdev_info_pair.second;
+        const auto cdev_it = cooling_device_info_map_.find(binded_cdev_info_pair.first);
+        if (cdev_it == cooling_device_info_map_.end()) {
+            LOG(ERROR) << "Could not find " << sensor_name << "'s binded CDEV "
+                       << binded_cdev_info_pair.first;
+            return false;
+        }
+        const bool pid_binded = std::any_of(binded_cdev_info.cdev_weight_for_pid.begin(),
+                                            binded_cdev_info.cdev_weight_for_pid.end(),
+                                            [](float cdev_weight) { return !std::isnan(cdev_weight); });
+        if (pid_binded && cdev_it->second.state2power.empty()) {
+            LOG(ERROR) << sensor_name << "'s PID cdev " << cdev_it->first
+                       << " has no State2Power in the config";
+            return false;
+        }
+        for (auto &cdev_ceiling : binded_cdev_info.cdev_ceiling) {
+            cdev_ceiling = std::min(cdev_ceiling, cdev_it->second.max_state);
+        }
+        if (!binded_cdev_info.power_rail.empty()) {
+            power_status_map_[binded_cdev_info.power_rail].last_updated_avg_power = NAN;
+        }
+    }
+    return true;
+}
+
+void ThermalReplay::updateSensor(const ReplaySample &sample,
+                                 std::vector<CdevRequestRecord> *cdev_records,
+                                 std::vector<BudgetRecord> *budget_records) {
+    const auto sensor_info_it = sensor_info_map_.find(sample.name);
+    if (sensor_info_it == sensor_info_map_.end() || std::isnan(sample.value)) {
+        return;
+    }
+    const auto &sensor_info = sensor_info_it->second;
+    auto &sensor_status = sensor_status_map_.at(sample.name);
+
+    // Same severity rules as ThermalHelperImpl::readTemperature()
+    const auto status = sensor_info.severity_table.classify(
+            sample.value, sensor_status.prev_hot_severity, sensor_status.prev_cold_severity);
+    sensor_status.prev_hot_severity = status.first;
+    sensor_status.prev_cold_severity = status.second;
+    sensor_status.severity = std::max(status.first, status.second);
+    if (!sensor_info.severity_reference.empty() &&
+        sensor_status_map_.count(sensor_info.severity_reference)) {
+        sensor_status.severity = std::max(
+                sensor_status.severity,
+                sensor_status_map_.at(sensor_info.severity_reference).severity);
+    }
+
+    const auto time_elapsed_ms = sensor_status.updated
+                                         ? sample.time - sensor_status.last_update_time
+                                         : std::chrono::milliseconds::zero();
+    sensor_status.last_update_time = sample.time;
+    sensor_status.updated = true;
+
+    if (sensor_info.throttling_info == nullptr) {
+        return;
+    }
+
+    const Temperature temp = {
+            .type = sensor_info.type,
+            .name = sample.name,
+            .value = sample.value,
+            .throttlingStatus = sensor_status.severity,
+    };
+    // Predictions are read from the predictor sensor as ThermalHelperImpl does
+    static const std::vector<float> kNoPredictions;
+    const bool model_predictive = isModelPredictiveThrottling(sensor_info);
+    const auto predictions_it =
+            sensor_info.predictor_info == nullptr
+                    ? sensor_predictions_map_.end()
+                    : sensor_predictions_map_.find(sensor_info.predictor_info->sensor);
+    const auto &sensor_predictions = predictions_it == sensor_predictions_map_.end()
+                                             ? kNoPredictions
+                                             : predictions_it->second;
+    const bool throttling_updated = sensor_status.severity != ThrottlingSeverity::NONE ||
+                                    (model_predictive && !sensor_predictions.empty());
+    if (!throttling_updated) {
+        thermal_throttling_.clearThrottlingData(sample.name);
+    } else {
+        thermal_throttling_.thermalThrottlingUpdate(temp, sensor_info, sensor_status.severity,
+                                                    time_elapsed_ms, power_status_map_,
+                                                    cooling_device_info_map_, false,
+                                                    sensor_predictions);
+    }
+
+    std::vector<std::string> cooling_devices_to_update;
+    thermal_throttling_.computeCoolingDevicesRequest(sample.name, sensor_info,
+                                                     sensor_status.severity,
+                                                     &cooling_devices_to_update,
+                                                     &thermal_stats_helper_);
+    for (const auto &cdev_name : cooling_devices_to_update) {
+        int max_state;
+        if (thermal_throttling_.getCdevMaxRequest(cdev_name, &max_state)) {
+            cdev_records->push_back({sample.time, cdev_name, max_state});
+        }
+    }
+
+    if (!throttling_updated) {
+        return;
+    }
+    const auto &throttling_status =
+            thermal_throttling_.GetThermalThrottlingStatusMap().at(sample.name);
+    for (const auto &pid_power_budget_pair : throttling_status.pid_power_budget_map) {
+        budget_records->push_back({
+                .time = sample.time,
+                .sensor = sample.name,
+                .temp = sample.value,
+                .severity = sensor_status.severity,
+                .power_budget = throttling_status.prev_power_budget,
+                .cdev = pid_power_budget_pair.first,
+                .cdev_power_budget = pid_power_budget_pair.second,
+                .pid_request = throttling_status.pid_cdev_request_map.at(
+                        pid_power_budget_pair.first),
+                .predicted_peak = throttling_status.predicted_peak,
+        });
+    }
+}
+
+void ThermalReplay::replay(const std::vector<ReplaySample> &samples,
+                           std::vector<CdevRequestRecord> *cdev_records,
+                           std::vector<BudgetRecord> *budget_records) {
+    for (const auto &sample : samples) {
+        switch (sample.type) {
+            case ReplaySampleType::POWER:
+                power_status_map_[sample.name].last_updated_avg_power = sample.value;
+                break;
+            case ReplaySampleType::TEMPERATURE:
+                updateSensor(sample, cdev_records, budget_records);
+                break;
+            case ReplaySampleType::PREDICTION:
+                sensor_predictions_map_[sample.name] = sample.predictions;
+                break;
+        }
+    }
+}
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
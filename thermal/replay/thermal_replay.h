@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <json/value.h>
+
+#include <chrono>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/power_files.h"
+#include "utils/thermal_info.h"
+#include "utils/thermal_stats_helper.h"
+#include "utils/thermal_throttling.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+enum class ReplaySampleType : uint32_t {
+    TEMPERATURE = 0,
+    POWER,
+    PREDICTION,
+};
+
+struct ReplaySample {
+    std::chrono::milliseconds time;
+    ReplaySampleType type;
+    // Sensor name for temperatures, power rail name for power
+    std::string name;
+    // Temperature as reported by the HAL (multiplier applied), or average power in mW
+    float value;
+    // Predictor outputs of a virtual sensor, before the multiplier
+    std::vector<float> predictions;
+};
+
+// A change in the aggregated request of a cooling device
+struct CdevRequestRecord {
+    std::chrono::milliseconds time;
+    std::string cdev;
+    int state;
+};
+
+// The PID state of a throttling sensor after an update, one record per PID cooling device
+struct BudgetRecord {
+    std::chrono::milliseconds time;
+    std::string sensor;
+    float temp;
+    ThrottlingSeverity severity;
+    float power_budget;
+    std::string cdev;
+    int cdev_power_budget;
+    int pid_request;
+    // Highest predicted temperature, NAN unless the request was planned from predictions
+    float predicted_peak;
+};
+
+// How hard a cooling device was throttled over a replay
+struct CdevRequestSummary {
+    // Time of the first non-zero request, -1 if the cdev was never throttled
+    std::chrono::milliseconds first_throttle_time;
+    int max_state;
+    // Integral of the requested state over time, in state * ms
+    int64_t state_ms;
+};
+
+// Parse a single trace line into samples. Two forms are understood:
+//   "<time_ms> temp <sensor> <value>", "<time_ms> power <rail> <mW>" and
+//   "<time_ms> predict <sensor> <value>,<value>,...", one sample per line
+//   logcat threadtime lines of the HAL's "<sensor>:<value> raw data:" and "Power rails [...]"
+//   logs, timed from the month, day and time of day.
+// Returns false if the line holds neither.
+bool ParseReplayTraceLine(std::string_view line, std::vector<ReplaySample> *samples);
+// Parse a whole trace, skipping unknown lines, and sort the samples by time.
+bool ParseReplayTrace(std::istream *in, std::vector<ReplaySample> *samples);
+// Summarize the requests of every cdev in the records, up to end_time
+std::unordered_map<std::string, CdevRequestSummary> SummarizeCdevRequests(
+        const std::vector<CdevRequestRecord> &records, std::chrono::milliseconds end_time);
+
+// Runs recorded sensor and power rail series through the throttling pipeline of the polling
+// loop, without sysfs or ODPM, as fast as the samples can be processed.
+class ThermalReplay {
+  public:
+    ThermalReplay() = default;
+    ~ThermalReplay() = default;
+    // Disallow copy and assign.
+    ThermalReplay(const ThermalReplay &) = delete;
+    void operator=(const ThermalReplay &) = delete;
+
+    // Load sensors and cooling devices from a thermal config. Cooling devices binded to PID
+    // throttling need their State2Power in the config since there is no sysfs to read it from.
+    bool init(const Json::Value &config);
+    // Replay samples sorted by time. Every temperature sample is handled as a poll of its
+    // sensor, power and prediction samples hold until the next sample of their rail or sensor.
+    void replay(const std::vector<ReplaySample> &samples,
+                std::vector<CdevRequestRecord> *cdev_records,
+                std::vector<BudgetRecord> *budget_records);
+
+  private:
+    struct ReplaySensorStatus {
+        ThrottlingSeverity severity;
+        ThrottlingSeverity prev_hot_severity;
+        ThrottlingSeverity prev_cold_severity;
+        std::chrono::milliseconds last_update_time;
+        bool updated;
+    };
+
+    // Clamp the ceilings to the max states and register the binded power rails
+    bool prepareBindedCdevs(std::string_view sensor_name,
+                            std::unordered_map<std::string, BindedCdevInfo> *binded_cdev_info_map);
+    void updateSensor(const ReplaySample &sample, std::vector<CdevRequestRecord> *cdev_records,
+                      std::vector<BudgetRecord> *budget_records);
+
+    std::unordered_map<std::string, SensorInfo> sensor_info_map_;
+    std::unordered_map<std::string, CdevInfo> cooling_device_info_map_;
+    std::unordered_map<std::string, ReplaySensorStatus> sensor_status_map_;
+    std::unordered_map<std::string, PowerStatus> power_status_map_;
+    // Latest predictor outputs of each virtual sensor
+    std::unordered_map<std::string, std::vector<float>> sensor_predictions_map_;
+    ThermalThrottling thermal_throttling_;
+    // Never initialized, so cdev request stats are dropped
+    ThermalStatsHelper thermal_stats_helper_;
+};
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
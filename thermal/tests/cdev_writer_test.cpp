@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/file.h>
+#include <gtest/gtest.h>
+
+#include "utils/cdev_writer.h"
+
+namespace aidl::android::hardware::thermal::implementation {
+
+class CdevWriterTest : public testing::Test {
+  protected:
+    void SetUp() override { ASSERT_TRUE(writer.addCdev("cpu", cdev_file.path)); }
+
+    std::string readCdevFile() {
+        std::string data;
+        EXPECT_TRUE(::android::base::ReadFileToString(cdev_file.path, &data));
+        return data;
+    }
+
+    TemporaryFile cdev_file;
+    CdevWriter writer;
+};
+
+TEST_F(CdevWriterTest, WritesLastRequestOfPass) {
+    ASSERT_TRUE(writer.requestState("cpu", 3));
+    ASSERT_TRUE(writer.requestState("cpu", 5));
+    EXPECT_EQ(writer.flush(), 0u);
+    EXPECT_EQ(readCdevFile(), "5");
+
+    const auto stats = writer.getCdevWriteStats();
+    EXPECT_EQ(stats.coalesced, 1u);
+    EXPECT_EQ(stats.written, 1u);
+}
+
+TEST_F(CdevWriterTest, SkipsStateAlreadyWritten) {
+    writer.requestState("cpu", 4);
+    writer.flush();
+    // Any write would show up over this marker
+    ASSERT_TRUE(::android::base::WriteStringToFile("x", cdev_file.path));
+
+    writer.requestState("cpu", 4);
+    writer.flush();
+    EXPECT_EQ(readCdevFile(), "x");
+    EXPECT_EQ(writer.getCdevWriteStats().skipped, 1u);
+
+    writer.requestState("cpu", 2);
+    writer.flush();
+    EXPECT_EQ(readCdevFile(), "2");
+}
+
+TEST_F(CdevWriterTest, FailedWriteIsRetried) {
+    ASSERT_TRUE(writer.addCdev("missing", "/nonexistent/cur_state"));
+    writer.requestState("missing", 1);
+    EXPECT_EQ(writer.flush(), 1u);
+    writer.requestState("missing", 1);
+    EXPECT_EQ(writer.flush(), 1u);
+    EXPECT_EQ(writer.getCdevWriteStats().failed, 2u);
+}
+
+TEST_F(CdevWriterTest, UnknownCdevIsRejected) {
+    EXPECT_FALSE(writer.requestState("gpu", 1));
+    EXPECT_FALSE(writer.addCdev("cpu", "/other/path"));
+}
+
+}  // namespace aidl::android::hardware::thermal::implementation
@@ -62,6 +62,8 @@ class MockThermalHelper : public ThermalHelper {
     MOCK_METHOD((const std::unordered_map<std::string,
                                           std::unordered_map<std::string, ThermalStats<int>>>),
                 GetSensorCoolingDeviceRequestStatsSnapshot, (), (override));
+    MOCK_METHOD(PollingStats, GetPollingStats, (), (const, override));
+    MOCK_METHOD(std::shared_ptr<const ThermalSnapshot>, GetThermalSnapshot, (), (const, override));
     MOCK_METHOD(bool, isAidlPowerHalExist, (), (override));
     MOCK_METHOD(bool, isPowerHalConnected, (), (override));
     MOCK_METHOD(bool, isPowerHalExtConnected, (), (override));
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "utils/polling_scheduler.h"
+
+namespace aidl::android::hardware::thermal::implementation {
+
+using std::chrono::milliseconds;
+
+class PollingSchedulerTest : public testing::Test {
+  protected:
+    void SetUp() override {
+        hot_thresholds.fill(NAN);
+        hot_thresholds[static_cast<size_t>(ThrottlingSeverity::LIGHT)] = 40;
+        hot_thresholds[static_cast<size_t>(ThrottlingSeverity::SEVERE)] = 50;
+    }
+
+    PollingScheduler scheduler;
+    ThrottlingArray hot_thresholds;
+    const boot_clock::time_point start = boot_clock::now();
+};
+
+TEST_F(PollingSchedulerTest, OnlyDueSensorsAreCollected) {
+    std::vector<std::string> due;
+    scheduler.registerSensor("fast");
+    scheduler.registerSensor("slow");
+
+    scheduler.collectDueSensors(start, &due);
+    ASSERT_EQ(due.size(), 2u);
+    scheduler.schedulePolled("fast", start, 25, hot_thresholds, milliseconds(1000), nullptr);
+    scheduler.schedulePolled("slow", start, 25, hot_thresholds, milliseconds(5000), nullptr);
+    EXPECT_EQ(scheduler.timeUntilNextDeadline(start), milliseconds(1000));
+
+    scheduler.collectDueSensors(start + milliseconds(1000), &due);
+    ASSERT_EQ(due.size(), 1u);
+    EXPECT_EQ(due[0], "fast");
+
+    const auto stats = scheduler.GetPollingStats();
+    EXPECT_EQ(stats.wakeups, 2u);
+    EXPECT_EQ(stats.sensors_polled, 2u);
+    EXPECT_EQ(stats.sensors_deferred, 1u);
+}
+
+TEST_F(PollingSchedulerTest, ScheduleNowPullsDeadlineIn) {
+    std::vector<std::string> due;
+    scheduler.registerSensor("sensor");
+    scheduler.collectDueSensors(start, &due);
+    scheduler.schedulePolled("sensor", start, 25, hot_thresholds, milliseconds(5000), nullptr);
+
+    scheduler.scheduleNow("sensor");
+    EXPECT_EQ(scheduler.timeUntilNextDeadline(start), milliseconds(0));
+    scheduler.collectDueSensors(start, &due);
+    ASSERT_EQ(due.size(), 1u);
+
+    // The superseded deadline must not fire again
+    scheduler.schedulePolled("sensor", start, 25, hot_thresholds, milliseconds(5000), nullptr);
+    scheduler.collectDueSensors(start + milliseconds(4999), &due);
+    EXPECT_TRUE(due.empty());
+}
+
+TEST_F(PollingSchedulerTest, UnscheduledSensorNeverWakes) {
+    std::vector<std::string> due;
+    scheduler.registerSensor("sensor");
+    scheduler.collectDueSensors(start, &due);
+    scheduler.schedulePolled("sensor", start, 25, hot_thresholds, milliseconds::max(), nullptr);
+    EXPECT_EQ(scheduler.timeUntilNextDeadline(start), milliseconds::max());
+}
+
+TEST_F(PollingSchedulerTest, AdaptiveDelayTracksHeadroomAndTrend) {
+    const AdaptivePollingInfo info{milliseconds(30000), 20};
+    const milliseconds polling_delay(5000);
+
+    // Far from the threshold and flat: fully stretched
+    EXPECT_EQ(ComputeAdaptivePollingDelay(info, polling_delay, 40, 15, 0), milliseconds(30000));
+    // Half the headroom: halfway between the delays
+    EXPECT_EQ(ComputeAdaptivePollingDelay(info, polling_delay, 40, 30, 0), milliseconds(17500));
+    // At or over the threshold: base delay
+    EXPECT_EQ(ComputeAdaptivePollingDelay(info, polling_delay, 40, 41, 0), polling_delay);
+    // Rising 1 degree per second with 10 degrees left: at most 5s
+    EXPECT_EQ(ComputeAdaptivePollingDelay(info, polling_delay, 40, 30, 0.001), milliseconds(5000));
+}
+
+TEST_F(PollingSchedulerTest, AdaptivePollingCountsSavedPolls) {
+    const AdaptivePollingInfo info{milliseconds(30000), 20};
+    std::vector<std::string> due;
+    scheduler.registerSensor("skin");
+    scheduler.collectDueSensors(start, &due);
+
+    EXPECT_EQ(scheduler.schedulePolled("skin", start, 15, hot_thresholds, milliseconds(5000),
+                                       &info),
+              milliseconds(30000));
+    EXPECT_EQ(scheduler.GetPollingStats().adaptive_polls_saved, 5u);
+}
+
+}  // namespace aidl::android::hardware::thermal::implementation
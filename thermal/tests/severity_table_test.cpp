@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <random>
+
+#include "utils/thermal_info.h"
+
+namespace aidl::android::hardware::thermal::implementation {
+
+namespace {
+
+// The per-severity walk the table replaces
+std::pair<ThrottlingSeverity, ThrottlingSeverity> ClassifyByWalk(
+        const ThrottlingArray &hot_thresholds, const ThrottlingArray &cold_thresholds,
+        const ThrottlingArray &hot_hysteresis, const ThrottlingArray &cold_hysteresis,
+        ThrottlingSeverity prev_hot_severity, ThrottlingSeverity prev_cold_severity,
+        float value) {
+    ThrottlingSeverity ret_hot = ThrottlingSeverity::NONE;
+    ThrottlingSeverity ret_hot_hysteresis = ThrottlingSeverity::NONE;
+    ThrottlingSeverity ret_cold = ThrottlingSeverity::NONE;
+    ThrottlingSeverity ret_cold_hysteresis = ThrottlingSeverity::NONE;
+
+    for (size_t i = static_cast<size_t>(ThrottlingSeverity::SHUTDOWN);
+         i > static_cast<size_t>(ThrottlingSeverity::NONE); --i) {
+        if (!std::isnan(hot_thresholds[i]) && hot_thresholds[i] <= value &&
+            ret_hot == ThrottlingSeverity::NONE) {
+            ret_hot = static_cast<ThrottlingSeverity>(i);
+        }
+        if (!std::isnan(hot_thresholds[i]) && (hot_thresholds[i] - hot_hysteresis[i]) < value &&
+            ret_hot_hysteresis == ThrottlingSeverity::NONE) {
+            ret_hot_hysteresis = static_cast<ThrottlingSeverity>(i);
+        }
+        if (!std::isnan(cold_thresholds[i]) && cold_thresholds[i] >= value &&
+            ret_cold == ThrottlingSeverity::NONE) {
+            ret_cold = static_cast<ThrottlingSeverity>(i);
+        }
+        if (!std::isnan(cold_thresholds[i]) && (cold_thresholds[i] + cold_hysteresis[i]) > value &&
+            ret_cold_hysteresis == ThrottlingSeverity::NONE) {
+            ret_cold_hysteresis = static_cast<ThrottlingSeverity>(i);
+        }
+    }
+    if (static_cast<size_t>(ret_hot) < static_cast<size_t>(prev_hot_severity)) {
+        ret_hot = ret_hot_hysteresis;
+    }
+    if (static_cast<size_t>(ret_cold) < static_cast<size_t>(prev_cold_severity)) {
+        ret_cold = ret_cold_hysteresis;
+    }
+
+    return std::make_pair(ret_hot, ret_cold);
+}
+
+struct Thresholds {
+    ThrottlingArray hot;
+    ThrottlingArray cold;
+    ThrottlingArray hot_hysteresis;
+    ThrottlingArray cold_hysteresis;
+};
+
+ThrottlingArray MakeArray(std::initializer_list<float> values) {
+    ThrottlingArray array;
+    std::copy(values.begin(), values.end(), array.begin());
+    return array;
+}
+
+// Compare the table against the walk for every previous severity at the given readings
+void ExpectSameAsWalk(const Thresholds &t, const std::vector<float> &values) {
+    const SeverityTable table = BuildSeverityTable(t.hot, t.cold, t.hot_hysteresis,
+                                                   t.cold_hysteresis);
+    for (const float value : values) {
+        for (const auto prev_hot : ::ndk::enum_range<ThrottlingSeverity>()) {
+            for (const auto prev_cold : ::ndk::enum_range<ThrottlingSeverity>()) {
+                ASSERT_EQ(table.classify(value, prev_hot, prev_cold),
+                          ClassifyByWalk(t.hot, t.cold, t.hot_hysteresis, t.cold_hysteresis,
+                                         prev_hot, prev_cold, value))
+                        << "value " << value << " prev_hot " << toString(prev_hot)
+                        << " prev_cold " << toString(prev_cold);
+            }
+        }
+    }
+}
+
+// Readings on, just around and between every boundary of the config
+std::vector<float> ProbeValues(const Thresholds &t) {
+    std::vector<float> values = {NAN, -std::numeric_limits<float>::infinity(),
+                                 std::numeric_limits<float>::infinity(), 0};
+    for (size_t i = 0; i < kThrottlingSeverityCount; ++i) {
+        for (const float boundary : {t.hot[i], t.hot[i] - t.hot_hysteresis[i], t.cold[i],
+                                     t.cold[i] + t.cold_hysteresis[i]}) {
+            if (std::isnan(boundary)) {
+                continue;
+            }
+            values.push_back(boundary);
+            values.push_back(std::nextafter(boundary, -INFINITY));
+            values.push_back(std::nextafter(boundary, INFINITY));
+            values.push_back(boundary - 0.5f);
+            values.push_back(boundary + 0.5f);
+        }
+    }
+    return values;
+}
+
+}  // namespace
+
+TEST(SeverityTableTest, TypicalSkinConfig) {
+    const Thresholds t = {
+            .hot = MakeArray({NAN, 39, 41, 43, 45, 47, 55}),
+            .cold = MakeArray({NAN, NAN, NAN, NAN, NAN, NAN, NAN}),
+            .hot_hysteresis = MakeArray({0, 0.9, 0.9, 0.9, 0.9, 0.9, 0.9}),
+            .cold_hysteresis = MakeArray({0, 0, 0, 0, 0, 0, 0}),
+    };
+    ExpectSameAsWalk(t, ProbeValues(t));
+
+    const SeverityTable table =
+            BuildSeverityTable(t.hot, t.cold, t.hot_hysteresis, t.cold_hysteresis);
+    EXPECT_EQ(table.classify(44, ThrottlingSeverity::NONE, ThrottlingSeverity::NONE).first,
+              ThrottlingSeverity::SEVERE);
+    // Dropping below SEVERE is held off by the hysteresis
+    EXPECT_EQ(table.classify(42.5, ThrottlingSeverity::SEVERE, ThrottlingSeverity::NONE).first,
+              ThrottlingSeverity::SEVERE);
+    EXPECT_EQ(table.classify(42, ThrottlingSeverity::SEVERE, ThrottlingSeverity::NONE).first,
+              ThrottlingSeverity::MODERATE);
+}
+
+TEST(SeverityTableTest, HotAndColdWithGaps) {
+    const Thresholds t = {
+            .hot = MakeArray({NAN, NAN, 60, NAN, 80, NAN, 100}),
+            .cold = MakeArray({NAN, 10, NAN, 0, NAN, -10, NAN}),
+            .hot_hysteresis = MakeArray({0, 0, 5, 0, 5, 0, 5}),
+            .cold_hysteresis = MakeArray({0, 2, 0, 2, 0, 2, 0}),
+    };
+    ExpectSameAsWalk(t, ProbeValues(t));
+}
+
+TEST(SeverityTableTest, NonMonotonicBoundaries) {
+    // Hysteresis wide enough to reorder the release points, and out of order thresholds
+    const Thresholds t = {
+            .hot = MakeArray({NAN, 50, 45, 60, 58, NAN, 70}),
+            .cold = MakeArray({NAN, -5, 0, -20, -15, NAN, -30}),
+            .hot_hysteresis = MakeArray({0, 1, 10, 20, 1, 0, NAN}),
+            .cold_hysteresis = MakeArray({0, 30, 1, 1, NAN, 0, 2}),
+    };
+    ExpectSameAsWalk(t, ProbeValues(t));
+}
+
+TEST(SeverityTableTest, NoThresholds) {
+    Thresholds t;
+    t.hot.fill(NAN);
+    t.cold.fill(NAN);
+    t.hot_hysteresis.fill(0);
+    t.cold_hysteresis.fill(0);
+    ExpectSameAsWalk(t, ProbeValues(t));
+}
+
+TEST(SeverityTableTest, RandomConfigs) {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> threshold(-40, 120);
+    std::uniform_real_distribution<float> hysteresis(0, 15);
+    std::bernoulli_distribution missing(0.3);
+
+    for (int round = 0; round < 500; ++round) {
+        Thresholds t;
+        for (size_t i = 0; i < kThrottlingSeverityCount; ++i) {
+            t.hot[i] = missing(rng) ? NAN : threshold(rng);
+            t.cold[i] = missing(rng) ? NAN : threshold(rng);
+            t.hot_hysteresis[i] = missing(rng) ? 0 : hysteresis(rng);
+            t.cold_hysteresis[i] = missing(rng) ? 0 : hysteresis(rng);
+        }
+        ExpectSameAsWalk(t, ProbeValues(t));
+        if (HasFatalFailure()) {
+            return;
+        }
+    }
+}
+
+}  // namespace aidl::android::hardware::thermal::implementation
@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/file.h>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "utils/thermal_capture_writer.h"
+
+namespace aidl::android::hardware::thermal::implementation {
+
+class ThermalCaptureTest : public testing::Test {
+  protected:
+    void SetUp() override {
+        sensor_info_map_["skin"] = SensorInfo{};
+        sensor_info_map_["battery"] = SensorInfo{};
+        cooling_device_info_map_["cpu"] = CdevInfo{};
+        cooling_device_info_map_["gpu"] = CdevInfo{};
+        cooling_device_info_map_["display"] = CdevInfo{};
+
+        auto &status = throttling_status_map_["skin"];
+        status.pid_power_budget_map = {{"cpu", 0}, {"gpu", 0}};
+        status.pid_cdev_request_map = {{"cpu", 0}, {"gpu", 0}};
+        status.hardlimit_cdev_request_map = {{"display", 0}};
+        capture_path_ = std::string(capture_dir_.path) + "/thermal_capture.bin";
+    }
+
+    bool initCapture(ThermalCapture *capture, size_t record_count) {
+        return capture->init(capture_path_, record_count, sensor_info_map_,
+                             cooling_device_info_map_, throttling_status_map_);
+    }
+
+    bool decode(const std::string &path, ThermalCaptureSchema *schema,
+                std::vector<ThermalCaptureRecord> *records) {
+        std::string data;
+        return ::android::base::ReadFileToString(path, &data) &&
+               DecodeThermalCapture(data, schema, records);
+    }
+
+    // Stage a throttling pass of skin at the given temperature
+    void stageSkin(ThermalCapture *capture, float temp, int cpu_budget) {
+        auto &status = throttling_status_map_["skin"];
+        status.prev_power_budget = cpu_budget * 2;
+        status.prev_err = 40 - temp;
+        status.p_budget = 1;
+        status.i_budget = 2;
+        status.d_budget = 3;
+        status.pid_power_budget_map["cpu"] = cpu_budget;
+        status.pid_cdev_request_map["cpu"] = 4;
+        status.hardlimit_cdev_request_map["display"] = 1;
+        capture->updateSensor("skin", temp, ThrottlingSeverity::MODERATE, &status);
+    }
+
+    TemporaryDir capture_dir_;
+    std::string capture_path_;
+    std::unordered_map<std::string, SensorInfo> sensor_info_map_;
+    std::unordered_map<std::string, CdevInfo> cooling_device_info_map_;
+    std::unordered_map<std::string, ThermalThrottlingStatus> throttling_status_map_;
+};
+
+TEST_F(ThermalCaptureTest, SchemaIsIndexedByName) {
+    ThermalCapture capture;
+    ASSERT_TRUE(initCapture(&capture, 8));
+
+    ThermalCaptureSchema schema;
+    std::vector<ThermalCaptureRecord> records;
+    ASSERT_TRUE(decode(capture_path_, &schema, &records));
+    EXPECT_EQ(schema.sensors, (std::vector<std::string>{"battery", "skin"}));
+    EXPECT_EQ(schema.cdevs, (std::vector<std::string>{"cpu", "display", "gpu"}));
+    ASSERT_EQ(schema.bindings.size(), 3u);
+    for (const auto &binding : schema.bindings) {
+        EXPECT_EQ(schema.sensors[binding.sensor_id], "skin");
+    }
+    EXPECT_EQ(schema.cdevs[schema.bindings[0].cdev_id], "cpu");
+    EXPECT_EQ(schema.record_count, 8u);
+    EXPECT_TRUE(records.empty());
+}
+
+TEST_F(ThermalCaptureTest, RecordCountIsClamped) {
+    ThermalCapture capture;
+    ASSERT_TRUE(initCapture(&capture, std::numeric_limits<uint32_t>::max()));
+
+    ThermalCaptureSchema schema;
+    std::vector<ThermalCaptureRecord> records;
+    ASSERT_TRUE(decode(capture_path_, &schema, &records));
+    EXPECT_EQ(schema.record_count, kThermalCaptureMaxRecords);
+}
+
+TEST_F(ThermalCaptureTest, RecordsCarryPassValues) {
+    ThermalCapture capture;
+    ASSERT_TRUE(initCapture(&capture, 8));
+    const auto start = boot_clock::now();
+
+    stageSkin(&capture, 42.5, 1500);
+    capture.updateSensor("battery", 30, ThrottlingSeverity::NONE, nullptr);
+    capture.updateCdev("cpu", 4);
+    capture.updateCdev("display", 1);
+    capture.commit(start);
+    // Only battery is polled in the second pass
+    capture.updateSensor("battery", 31, ThrottlingSeverity::NONE, nullptr);
+    capture.commit(start + std::chrono::milliseconds(100));
+
+    ThermalCaptureSchema schema;
+    std::vector<ThermalCaptureRecord> records;
+    ASSERT_TRUE(decode(capture_path_, &schema, &records));
+    ASSERT_EQ(records.size(), 2u);
+    EXPECT_EQ(records[1].timestamp_ms - records[0].timestamp_ms, 100);
+
+    const auto &skin = records[0].sensors[1];
+    EXPECT_FLOAT_EQ(skin.temp, 42.5);
+    EXPECT_EQ(skin.severity, static_cast<uint8_t>(ThrottlingSeverity::MODERATE));
+    EXPECT_FLOAT_EQ(skin.power_budget, 3000);
+    EXPECT_FLOAT_EQ(skin.err, -2.5);
+    EXPECT_FLOAT_EQ(skin.d, 3);
+    EXPECT_EQ(skin.updated, 1);
+    EXPECT_EQ(records[0].bindings[0].power_budget, 1500);
+    EXPECT_EQ(records[0].bindings[0].pid_request, 4);
+    EXPECT_EQ(records[0].bindings[1].hardlimit_request, 1);
+    EXPECT_EQ(records[0].cdev_states, (std::vector<int32_t>{4, 1, 0}));
+
+    // skin carries over, unmarked
+    EXPECT_FLOAT_EQ(records[1].sensors[1].temp, 42.5);
+    EXPECT_EQ(records[1].sensors[1].updated, 0);
+    EXPECT_FLOAT_EQ(records[1].sensors[0].temp, 31);
+    EXPECT_EQ(records[1].sensors[0].updated, 1);
+    EXPECT_TRUE(std::isnan(records[1].sensors[0].power_budget));
+}
+
+TEST_F(ThermalCaptureTest, RingKeepsLatestRecords) {
+    ThermalCapture capture;
+    ASSERT_TRUE(initCapture(&capture, 4));
+    const auto start = boot_clock::now();
+    for (int i = 0; i < 10; ++i) {
+        stageSkin(&capture, 40 + i, 1000 + i);
+        capture.commit(start + std::chrono::milliseconds(i));
+    }
+
+    ThermalCaptureSchema schema;
+    std::vector<ThermalCaptureRecord> records;
+    ASSERT_TRUE(decode(capture_path_, &schema, &records));
+    ASSERT_EQ(records.size(), 4u);
+    for (size_t i = 0; i < records.size(); ++i) {
+        EXPECT_EQ(records[i].seq, 7 + i);
+        EXPECT_FLOAT_EQ(records[i].sensors[1].temp, 46 + i);
+        EXPECT_EQ(records[i].bindings[0].power_budget, static_cast<int>(1006 + i));
+    }
+}
+
+TEST_F(ThermalCaptureTest, TornRecordIsSkipped) {
+    ThermalCapture capture;
+    ASSERT_TRUE(initCapture(&capture, 4));
+    for (int i = 0; i < 3; ++i) {
+        capture.commit(boot_clock::now());
+    }
+
+    std::string data;
+    ASSERT_TRUE(::android::base::ReadFileToString(capture_path_, &data));
+    ThermalCaptureHeader header;
+    memcpy(&header, data.data(), sizeof(header));
+    // The second record as seen while it is rewritten
+    const uint64_t writing = 0;
+    data.replace(header.header_size + header.record_size, sizeof(writing),
+                 reinterpret_cast<const char *>(&writing), sizeof(writing));
+
+    ThermalCaptureSchema schema;
+    std::vector<ThermalCaptureRecord> records;
+    ASSERT_TRUE(DecodeThermalCapture(data, &schema, &records));
+    ASSERT_EQ(records.size(), 2u);
+    EXPECT_EQ(records[0].seq, 1u);
+    EXPECT_EQ(records[1].seq, 3u);
+}
+
+TEST_F(ThermalCaptureTest, PreviousCaptureIsKept) {
+    {
+        ThermalCapture capture;
+        ASSERT_TRUE(initCapture(&capture, 4));
+        capture.commit(boot_clock::now());
+    }
+    ThermalCapture capture;
+    ASSERT_TRUE(initCapture(&capture, 4));
+
+    ThermalCaptureSchema schema;
+    std::vector<ThermalCaptureRecord> records;
+    ASSERT_TRUE(decode(capture_path_ + ".prev", &schema, &records));
+    EXPECT_EQ(records.size(), 1u);
+    ASSERT_TRUE(decode(capture_path_, &schema, &records));
+    EXPECT_TRUE(records.empty());
+}
+
+TEST_F(ThermalCaptureTest, InvalidCaptureIsRejected) {
+    ThermalCaptureSchema schema;
+    std::vector<ThermalCaptureRecord> records;
+    EXPECT_FALSE(DecodeThermalCapture("", &schema, &records));
+    EXPECT_FALSE(DecodeThermalCapture(std::string(256, 'x'), &schema, &records));
+
+    ThermalCapture capture;
+    ASSERT_TRUE(initCapture(&capture, 4));
+    std::string data;
+    ASSERT_TRUE(::android::base::ReadFileToString(capture_path_, &data));
+    EXPECT_TRUE(DecodeThermalCapture(data, &schema, &records));
+    data.resize(data.size() - 1);
+    EXPECT_FALSE(DecodeThermalCapture(data, &schema, &records));
+}
+
+}  // namespace aidl::android::hardware::thermal::implementation
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/file.h>
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <limits>
+
+#include "utils/thermal_config_cache.h"
+#include "utils/thermal_info.h"
+
+namespace aidl::android::hardware::thermal::implementation {
+
+class ThermalConfigCacheTest : public testing::Test {
+  protected:
+    void SetUp() override {
+        // Includes are resolved under /vendor/etc, so the included file is only listed
+        main_path_ = std::string(config_dir_.path) + "/thermal_info_config.json";
+        include_path_ = std::string(config_dir_.path) + "/thermal_info_config_base.json";
+        cache_path_ = std::string(config_dir_.path) + "/thermal_config_cache.bin";
+        ASSERT_TRUE(::android::base::WriteStringToFile(R"({
+            "Comment": "cache test",
+            "Sensors": [{
+                "Name": "skin",
+                "Type": "SKIN",
+                "Multiplier": 0.001,
+                "PollingDelay": 300000,
+                "Offset": -5,
+                "Id": 18446744073709551615,
+                "Hidden": false,
+                "SendCallback": true,
+                "Formula": null,
+                "HotThreshold": ["NAN", 39.5, 41, 43, 45, 47, 55],
+                "Combination": [],
+                "PIDInfo": {}
+            }]
+        })",
+                                                       main_path_));
+        ASSERT_TRUE(::android::base::WriteStringToFile(R"({"CoolingDevices": []})",
+                                                       include_path_));
+        std::unordered_set<std::string> loaded_config_paths;
+        ASSERT_TRUE(ParseThermalConfig(main_path_, &config_, &loaded_config_paths));
+        loaded_config_paths_ = {main_path_, include_path_};
+    }
+
+    bool saveCache() {
+        return SaveThermalConfigCache(cache_path_, main_path_, config_, loaded_config_paths_);
+    }
+
+    TemporaryDir config_dir_;
+    std::string main_path_;
+    std::string include_path_;
+    std::string cache_path_;
+    Json::Value config_;
+    std::unordered_set<std::string> loaded_config_paths_;
+};
+
+TEST_F(ThermalConfigCacheTest, LoadsTheSavedConfig) {
+    ASSERT_TRUE(saveCache());
+
+    Json::Value config;
+    ASSERT_TRUE(LoadThermalConfigCache(cache_path_, main_path_, &config));
+    EXPECT_EQ(config, config_);
+    const Json::Value &sensor = config["Sensors"][0];
+    EXPECT_EQ(sensor["Multiplier"].type(), Json::realValue);
+    EXPECT_EQ(sensor["PollingDelay"].type(), config_["Sensors"][0]["PollingDelay"].type());
+    EXPECT_EQ(sensor["Offset"].asInt(), -5);
+    EXPECT_EQ(sensor["Id"].asLargestUInt(), std::numeric_limits<uint64_t>::max());
+    EXPECT_EQ(sensor["HotThreshold"][0].asString(), "NAN");
+    EXPECT_FLOAT_EQ(sensor["HotThreshold"][1].asFloat(), 39.5);
+    EXPECT_TRUE(sensor["Formula"].isNull());
+    EXPECT_TRUE(sensor["Combination"].isArray());
+    EXPECT_TRUE(sensor["PIDInfo"].isObject());
+    EXPECT_FALSE(config["Sensors"][0].isMember("LogLevel"));
+}
+
+TEST_F(ThermalConfigCacheTest, MissingCacheIsNotLoaded) {
+    Json::Value config("untouched");
+    EXPECT_FALSE(LoadThermalConfigCache(cache_path_, main_path_, &config));
+    EXPECT_EQ(config.asString(), "untouched");
+}
+
+TEST_F(ThermalConfigCacheTest, ChangedConfigInvalidatesTheCache) {
+    ASSERT_TRUE(saveCache());
+    Json::Value config("untouched");
+
+    // Same size, different content
+    ASSERT_TRUE(::android::base::WriteStringToFile(R"({"CoolingDevices": {}})", include_path_));
+    EXPECT_FALSE(LoadThermalConfigCache(cache_path_, main_path_, &config));
+    ASSERT_TRUE(::android::base::WriteStringToFile(R"({"CoolingDevices": []})", include_path_));
+    EXPECT_TRUE(LoadThermalConfigCache(cache_path_, main_path_, &config));
+
+    ASSERT_EQ(unlink(include_path_.c_str()), 0);
+    config = "untouched";
+    EXPECT_FALSE(LoadThermalConfigCache(cache_path_, main_path_, &config));
+    EXPECT_EQ(config.asString(), "untouched");
+}
+
+TEST_F(ThermalConfigCacheTest, CacheOfAnotherConfigIsNotLoaded) {
+    ASSERT_TRUE(saveCache());
+    Json::Value config;
+    EXPECT_FALSE(LoadThermalConfigCache(cache_path_, include_path_, &config));
+}
+
+TEST_F(ThermalConfigCacheTest, ConfigMustBeAmongTheLoadedPaths) {
+    loaded_config_paths_ = {include_path_};
+    EXPECT_FALSE(saveCache());
+}
+
+TEST_F(ThermalConfigCacheTest, CorruptedCacheIsNotLoaded) {
+    ASSERT_TRUE(saveCache());
+    std::string cache;
+    ASSERT_TRUE(::android::base::ReadFileToString(cache_path_, &cache));
+
+    for (size_t size = 0; size < cache.size(); ++size) {
+        ASSERT_TRUE(::android::base::WriteStringToFile(cache.substr(0, size), cache_path_));
+        Json::Value config;
+        EXPECT_FALSE(LoadThermalConfigCache(cache_path_, main_path_, &config)) << size;
+    }
+
+    ASSERT_TRUE(::android::base::WriteStringToFile(cache + '\0', cache_path_));
+    Json::Value config;
+    EXPECT_FALSE(LoadThermalConfigCache(cache_path_, main_path_, &config));
+
+    cache[0] = 'X';
+    ASSERT_TRUE(::android::base::WriteStringToFile(cache, cache_path_));
+    EXPECT_FALSE(LoadThermalConfigCache(cache_path_, main_path_, &config));
+}
+
+}  // namespace aidl::android::hardware::thermal::implementation
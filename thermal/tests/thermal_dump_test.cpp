@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/file.h>
+#include <gtest/gtest.h>
+#include <json/reader.h>
+
+#include <cmath>
+
+#include "Thermal.h"
+#include "mock_thermal_helper.h"
+
+namespace aidl::android::hardware::thermal::implementation {
+
+using testing::Return;
+using testing::ReturnRef;
+
+class ThermalDumpTest : public testing::Test {
+  protected:
+    void SetUp() override {
+        auto &sensor_info = sensor_info_map_["skin"];
+        sensor_info.type = TemperatureType::SKIN;
+        sensor_info.is_watch = true;
+        sensor_info.hot_thresholds = {NAN, 39, 41, 43, 45, 47, 55};
+        sensor_info.cold_thresholds.fill(NAN);
+        sensor_info.hot_hysteresis.fill(0.9);
+        sensor_info.cold_hysteresis.fill(0);
+        sensor_info_map_["battery"].type = TemperatureType::BATTERY;
+        cdev_info_map_["cpu"].type = CoolingType::CPU;
+
+        ON_CALL(*helper_, isInitializedOk).WillByDefault(Return(true));
+        ON_CALL(*helper_, GetSensorInfoMap).WillByDefault(ReturnRef(sensor_info_map_));
+        ON_CALL(*helper_, GetCdevInfoMap).WillByDefault(ReturnRef(cdev_info_map_));
+        ON_CALL(*helper_, GetPowerRailInfoMap).WillByDefault(ReturnRef(power_rail_info_map_));
+        ON_CALL(*helper_, GetThermalSnapshot).WillByDefault([this] { return makeSnapshot(); });
+
+        // dump() must stay off the live state and sysfs
+        EXPECT_CALL(*helper_, readTemperature).Times(0);
+        EXPECT_CALL(*helper_, fillCurrentCoolingDevices).Times(0);
+        EXPECT_CALL(*helper_, GetSensorStatusMap).Times(0);
+        EXPECT_CALL(*helper_, GetThermalThrottlingStatusMap).Times(0);
+        EXPECT_CALL(*helper_, GetPowerStatusMap).Times(0);
+    }
+
+    std::shared_ptr<const ThermalSnapshot> makeSnapshot() {
+        const auto now = boot_clock::now();
+        Temperature skin_temp;
+        skin_temp.name = "skin";
+        skin_temp.type = TemperatureType::SKIN;
+        skin_temp.value = 42.5;
+        skin_temp.throttlingStatus = ThrottlingSeverity::MODERATE;
+        auto throttling_status = std::make_shared<ThermalThrottlingStatus>();
+        throttling_status->prev_power_budget = 3000;
+        throttling_status->pid_power_budget_map["cpu"] = 1500;
+        throttling_status->cdev_status_map["cpu"] = 3;
+
+        Temperature battery_temp;
+        battery_temp.name = "battery";
+        battery_temp.type = TemperatureType::BATTERY;
+        battery_temp.value = NAN;
+
+        auto emul_settings = std::make_shared<std::map<std::string, EmulSetting>>();
+        (*emul_settings)["skin"] = {.temp = 42.5, .severity = -1, .max_throttling = false};
+        auto power_status_map = std::make_shared<std::unordered_map<std::string, PowerStatus>>();
+        (*power_status_map)["rail"].last_updated_avg_power = 800;
+
+        std::vector<std::shared_ptr<const SensorSnapshot>> sensors = {
+                std::make_shared<const SensorSnapshot>(SensorSnapshot{
+                        .name = "battery",
+                        .temp = battery_temp,
+                        .severity = ThrottlingSeverity::NONE,
+                        .update_time = boot_clock::time_point::min(),
+                        .throttling_status = nullptr,
+                }),
+                std::make_shared<const SensorSnapshot>(SensorSnapshot{
+                        .name = "skin",
+                        .temp = skin_temp,
+                        .severity = ThrottlingSeverity::MODERATE,
+                        .update_time = now,
+                        .throttling_status = throttling_status,
+                })};
+        sensors.insert(sensors.end(), extra_sensors_.begin(), extra_sensors_.end());
+
+        return std::make_shared<const ThermalSnapshot>(ThermalSnapshot{
+                .pass_count = 7,
+                .pass_time = now,
+                .sensors = std::move(sensors),
+                .cdev_requests = std::make_shared<const std::unordered_map<std::string, int>>(
+                        std::unordered_map<std::string, int>{{"cpu", 3}}),
+                .power_status_map = power_status_map,
+                .emul_settings = emul_settings,
+                .polling_stats = {.wakeups = 11,
+                                  .sensors_polled = 20,
+                                  .sensors_deferred = 4,
+                                  .adaptive_polls_saved = 2},
+        });
+    }
+
+    std::string dump(std::vector<const char *> args) {
+        TemporaryFile dump_file;
+        EXPECT_EQ(thermal_->dump(dump_file.fd, args.data(), args.size()), STATUS_OK);
+        std::string data;
+        EXPECT_TRUE(::android::base::ReadFileToString(dump_file.path, &data));
+        return data;
+    }
+
+    std::unordered_map<std::string, SensorInfo> sensor_info_map_;
+    std::unordered_map<std::string, CdevInfo> cdev_info_map_;
+    std::unordered_map<std::string, PowerRailInfo> power_rail_info_map_;
+    // Sensors appended to the snapshot
+    std::vector<std::shared_ptr<const SensorSnapshot>> extra_sensors_;
+    std::shared_ptr<testing::NiceMock<MockThermalHelper>> helper_ =
+            std::make_shared<testing::NiceMock<MockThermalHelper>>();
+    std::shared_ptr<Thermal> thermal_ = ndk::SharedRefBase::make<Thermal>(helper_);
+};
+
+TEST_F(ThermalDumpTest, TextDumpComesFromSnapshot) {
+    const std::string output = dump({});
+    EXPECT_NE(output.find("getThermalSnapshot:\n Pass: 7"), std::string::npos);
+    EXPECT_NE(output.find(" Name: skin CachedValue: 42.5"), std::string::npos);
+    EXPECT_NE(output.find(" Name: skin EmulTemp: 42.5"), std::string::npos);
+    EXPECT_NE(output.find("Name: skin CurrentValue: 42.5 ThrottlingStatus: MODERATE"),
+              std::string::npos);
+    // Not polled yet
+    EXPECT_EQ(output.find("Name: battery CurrentValue"), std::string::npos);
+    EXPECT_NE(output.find("Name: cpu RequestedValue: 3"), std::string::npos);
+    EXPECT_NE(output.find("  power budget request state\n   cpu: 1500"), std::string::npos);
+    EXPECT_NE(output.find(" Wakeups: 11"), std::string::npos);
+    EXPECT_NE(output.find("Name: skin hotThrottlingThreshold: [nan 39 41"), std::string::npos);
+}
+
+TEST_F(ThermalDumpTest, JsonDump) {
+    const std::string output = dump({"-json"});
+    Json::Value root;
+    Json::CharReaderBuilder builder;
+    std::string errs;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    ASSERT_TRUE(reader->parse(output.data(), output.data() + output.size(), &root, &errs))
+            << errs;
+
+    EXPECT_EQ(root["pass"].asUInt64(), 7u);
+    ASSERT_EQ(root["sensors"].size(), 2u);
+    EXPECT_FALSE(root["sensors"][0].isMember("value"));
+    const auto &skin = root["sensors"][1];
+    EXPECT_EQ(skin["name"].asString(), "skin");
+    EXPECT_FLOAT_EQ(skin["value"].asFloat(), 42.5);
+    EXPECT_EQ(skin["severity"].asString(), "MODERATE");
+    EXPECT_FLOAT_EQ(skin["throttling"]["power_budget"].asFloat(), 3000);
+    EXPECT_EQ(skin["throttling"]["pid_power_budget"]["cpu"].asInt(), 1500);
+    EXPECT_FLOAT_EQ(skin["emul_temp"].asFloat(), 42.5);
+    ASSERT_EQ(root["cooling_devices"].size(), 1u);
+    EXPECT_EQ(root["cooling_devices"][0]["type"].asString(), "CPU");
+    EXPECT_EQ(root["cooling_devices"][0]["request"].asInt(), 3);
+    EXPECT_FLOAT_EQ(root["power_rails"][0]["avg_power_mw"].asFloat(), 800);
+    EXPECT_EQ(root["polling_stats"]["sensors_deferred"].asUInt64(), 4u);
+}
+
+TEST_F(ThermalDumpTest, PredictiveSensorPlanningAtNoneIsNotStale) {
+    SensorInfo mpc_info;
+    mpc_info.throttling_info = std::make_shared<ThrottlingInfo>();
+    mpc_info.predictor_info = std::make_unique<PredictorInfo>();
+    mpc_info.predictor_info->support_mpc_throttling = true;
+    SensorInfo plain_info;
+    plain_info.throttling_info = std::make_shared<ThrottlingInfo>();
+
+    Temperature temp;
+    temp.name = "soc";
+    temp.value = 38;
+    ThermalThrottlingStatus released_status;
+    released_status.pid_cdev_request_map["cpu"] = 0;
+    const SensorSnapshot prev = {
+            .name = "soc",
+            .temp = temp,
+            .severity = ThrottlingSeverity::NONE,
+            .update_time = boot_clock::now(),
+            .throttling_status = std::make_shared<const ThermalThrottlingStatus>(released_status),
+    };
+    // Still at NONE, the prediction planned a cut on cpu
+    ThermalThrottlingStatus planned_status = released_status;
+    planned_status.pid_cdev_request_map["cpu"] = 2;
+    planned_status.predicted_peak = 45;
+
+    // Any other released sensor keeps sharing its status
+    const auto plain = makeSensorSnapshot(prev, plain_info, temp, ThrottlingSeverity::NONE,
+                                          boot_clock::now(), &planned_status);
+    EXPECT_EQ(plain->throttling_status, prev.throttling_status);
+
+    const auto mpc = makeSensorSnapshot(prev, mpc_info, temp, ThrottlingSeverity::NONE,
+                                        boot_clock::now(), &planned_status);
+    ASSERT_NE(mpc->throttling_status, nullptr);
+    EXPECT_FLOAT_EQ(mpc->throttling_status->predicted_peak, 45);
+    extra_sensors_.push_back(mpc);
+
+    const std::string output = dump({});
+    EXPECT_NE(output.find(" Name: soc\n  pid cdev request state\n   cpu: 2"), std::string::npos)
+            << output;
+}
+
+}  // namespace aidl::android::hardware::thermal::implementation
@@ -0,0 +1,246 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/file.h>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <sstream>
+
+#include "replay/thermal_replay.h"
+
+namespace aidl::android::hardware::thermal::implementation {
+
+using std::chrono::milliseconds;
+
+namespace {
+
+constexpr std::string_view kReplayConfig = R"({
+  "Sensors": [
+    {
+      "Name": "skin",
+      "Type": "SKIN",
+      "HotThreshold": ["NAN", 39, 41, 43, 45, 47, 55],
+      "HotHysteresis": [0, 0.9, 0.9, 0.9, 0.9, 0.9, 0.9],
+      "Multiplier": 0.001,
+      "PollingDelay": 300000,
+      "PassiveDelay": 7000,
+      "TempPath": "/dev/null",
+      "PIDInfo": {
+        "K_Po": ["NAN", 50, 50, 50, 50, 50, 50],
+        "K_Pu": ["NAN", 50, 50, 50, 50, 50, 50],
+        "K_I": ["NAN", 5, 5, 5, 5, 5, 5],
+        "K_D": ["NAN", 0, 0, 0, 0, 0, 0],
+        "I_Max": ["NAN", 2000, 2000, 2000, 2000, 2000, 2000],
+        "MaxAllocPower": ["NAN", 8000, 8000, 8000, 8000, 8000, 8000],
+        "MinAllocPower": ["NAN", 500, 500, 500, 500, 500, 500],
+        "S_Power": ["NAN", "NAN", 4000, "NAN", "NAN", "NAN", "NAN"],
+        "I_Cutoff": ["NAN", 2, 2, 2, 2, 2, 2]
+      },
+      "BindedCdevInfo": [
+        {"CdevRequest": "cpu", "CdevWeightForPID": ["NAN", 1, 1, 1, 1, 1, 1], "PowerRail": "CPU"},
+        {"CdevRequest": "gpu", "CdevWeightForPID": ["NAN", 1, 1, 1, 1, 1, 1], "PowerRail": "GPU"}
+      ]
+    }
+  ],
+  "CoolingDevices": [
+    {"Name": "cpu", "Type": "CPU", "State2Power": [3000, 2500, 2000, 1500, 1000, 500]},
+    {"Name": "gpu", "Type": "GPU", "State2Power": [2000, 1600, 1200, 800, 400]}
+  ]
+})";
+
+bool LoadReplayConfig(Json::Value *config) {
+    TemporaryFile config_file;
+    return ::android::base::WriteStringToFile(std::string(kReplayConfig), config_file.path) &&
+           LoadThermalConfig(config_file.path, config);
+}
+
+}  // namespace
+
+TEST(ThermalReplayTest, ParseNativeLines) {
+    std::vector<ReplaySample> samples;
+    EXPECT_TRUE(ParseReplayTraceLine("1000 temp skin 41.5", &samples));
+    EXPECT_TRUE(ParseReplayTraceLine("1000 power CPU 1234.5", &samples));
+    EXPECT_FALSE(ParseReplayTraceLine("1000 fan skin 41.5", &samples));
+    EXPECT_FALSE(ParseReplayTraceLine("1000 temp skin hot", &samples));
+    EXPECT_TRUE(ParseReplayTraceLine("2000 predict skin_predictor 41000,42000.5", &samples));
+    EXPECT_FALSE(ParseReplayTraceLine("2000 predict skin_predictor 41000,,42000", &samples));
+    ASSERT_EQ(samples.size(), 3u);
+    EXPECT_EQ(samples[0].time, milliseconds(1000));
+    EXPECT_EQ(samples[0].type, ReplaySampleType::TEMPERATURE);
+    EXPECT_EQ(samples[0].name, "skin");
+    EXPECT_FLOAT_EQ(samples[0].value, 41.5);
+    EXPECT_EQ(samples[1].type, ReplaySampleType::POWER);
+    EXPECT_EQ(samples[1].name, "CPU");
+    EXPECT_FLOAT_EQ(samples[1].value, 1234.5);
+    EXPECT_EQ(samples[2].type, ReplaySampleType::PREDICTION);
+    EXPECT_EQ(samples[2].name, "skin_predictor");
+    EXPECT_EQ(samples[2].predictions, (std::vector<float>{41000, 42000.5}));
+}
+
+TEST(ThermalReplayTest, ParseLogcatLines) {
+    std::vector<ReplaySample> samples;
+    EXPECT_TRUE(ParseReplayTraceLine(
+            "10-16 12:00:01.250  1234  1250 I pixel-thermal: VIRTUAL-SKIN:41.25 raw data: "
+            "skin0:41000 skin1:41500 ",
+            &samples));
+    EXPECT_TRUE(ParseReplayTraceLine("10-16 12:00:02.000  1234  1250 I pixel-thermal: Power "
+                                     "rails [S2M_VDD_CPUCL2: 1500.25 mW] [S3M_VDD_GPU: 700.00 mW] ",
+                                     &samples));
+    EXPECT_FALSE(ParseReplayTraceLine("10-16 12:00:02.000  1234  1250 I pixel-thermal: Power "
+                                      "rails total power: 2200.25 mW for 60000 ms",
+                                      &samples));
+    EXPECT_FALSE(ParseReplayTraceLine("--------- beginning of main", &samples));
+    ASSERT_EQ(samples.size(), 3u);
+    EXPECT_EQ(samples[0].name, "VIRTUAL-SKIN");
+    EXPECT_FLOAT_EQ(samples[0].value, 41.25);
+    EXPECT_EQ(samples[1].time - samples[0].time, milliseconds(750));
+    EXPECT_EQ(samples[1].name, "S2M_VDD_CPUCL2");
+    EXPECT_FLOAT_EQ(samples[1].value, 1500.25);
+    EXPECT_EQ(samples[2].name, "S3M_VDD_GPU");
+    EXPECT_FLOAT_EQ(samples[2].value, 700);
+}
+
+TEST(ThermalReplayTest, ParseTraceSortsByTime) {
+    std::istringstream trace("# comment\n2000 temp skin 40\n1000 temp skin 39\nnot a sample\n");
+    std::vector<ReplaySample> samples;
+    ASSERT_TRUE(ParseReplayTrace(&trace, &samples));
+    ASSERT_EQ(samples.size(), 2u);
+    EXPECT_EQ(samples[0].time, milliseconds(1000));
+    EXPECT_EQ(samples[1].time, milliseconds(2000));
+}
+
+TEST(ThermalReplayTest, ReplayThrottlesAndReleases) {
+    Json::Value config;
+    ASSERT_TRUE(LoadReplayConfig(&config));
+    ThermalReplay thermal_replay;
+    ASSERT_TRUE(thermal_replay.init(config));
+
+    // Heat up past the MODERATE target for two minutes, then cool down
+    std::vector<ReplaySample> samples;
+    for (int i = 0; i < 240; ++i) {
+        const milliseconds time(i * 1000);
+        samples.push_back({time, ReplaySampleType::POWER, "CPU", 2500, {}});
+        samples.push_back({time, ReplaySampleType::POWER, "GPU", 1500, {}});
+        samples.push_back(
+                {time, ReplaySampleType::TEMPERATURE, "skin", i < 120 ? 42.5f : 37.0f, {}});
+    }
+    std::vector<CdevRequestRecord> cdev_records;
+    std::vector<BudgetRecord> budget_records;
+    thermal_replay.replay(samples, &cdev_records, &budget_records);
+
+    ASSERT_FALSE(cdev_records.empty());
+    ASSERT_FALSE(budget_records.empty());
+    for (const auto &record : budget_records) {
+        EXPECT_LT(record.time, milliseconds(120000));
+        EXPECT_EQ(record.severity, ThrottlingSeverity::MODERATE);
+        EXPECT_FALSE(std::isnan(record.power_budget));
+    }
+    // Every cdev is released once the sensor is back under its thresholds
+    std::unordered_map<std::string, int> last_state;
+    for (const auto &record : cdev_records) {
+        last_state[record.cdev] = record.state;
+    }
+    for (const auto &cdev_state_pair : last_state) {
+        EXPECT_EQ(cdev_state_pair.second, 0) << cdev_state_pair.first;
+    }
+    EXPECT_EQ(cdev_records.back().time, milliseconds(120000));
+}
+
+TEST(ThermalReplayTest, PidCdevWithoutState2PowerIsRejected) {
+    Json::Value config;
+    ASSERT_TRUE(LoadReplayConfig(&config));
+    config["CoolingDevices"][0].removeMember("State2Power");
+    ThermalReplay thermal_replay;
+    EXPECT_FALSE(thermal_replay.init(config));
+}
+
+TEST(ThermalReplayTest, PredictionsThrottleEarlierThanReactivePid) {
+    Json::Value config;
+    ASSERT_TRUE(LoadReplayConfig(&config));
+    Json::Value &predictor_info = config["Sensors"][0]["PredictorInfo"];
+    predictor_info["Sensor"] = "skin_predictor";
+    predictor_info["ModelPredictive"]["PredictionIntervalMs"] = 1000;
+    predictor_info["ModelPredictive"]["ThermalResistance"] = 0.005;
+    predictor_info["ModelPredictive"]["TimeConstantMs"] = 10000;
+    // Control to the LIGHT threshold of 39 degrees ahead of it
+    config["Sensors"][0]["PIDInfo"]["S_Power"][1] = 4000;
+
+    // Heat up from 36 to 42 degrees over a minute, each poll predicting the next ten seconds
+    std::vector<ReplaySample> samples;
+    const auto temp_at = [](int second) { return 36 + 0.1f * std::min(second, 60); };
+    for (int i = 0; i < 90; ++i) {
+        const milliseconds time(i * 1000);
+        std::vector<float> predictions;
+        for (int j = 1; j <= 10; ++j) {
+            predictions.push_back(temp_at(i + j) * 1000);
+        }
+        samples.push_back({time, ReplaySampleType::POWER, "CPU", 2500, {}});
+        samples.push_back({time, ReplaySampleType::POWER, "GPU", 1500, {}});
+        samples.push_back({time, ReplaySampleType::PREDICTION, "skin_predictor", NAN,
+                           std::move(predictions)});
+        samples.push_back({time, ReplaySampleType::TEMPERATURE, "skin", temp_at(i), {}});
+    }
+    std::vector<ReplaySample> reactive_samples;
+    for (const auto &sample : samples) {
+        if (sample.type != ReplaySampleType::PREDICTION) {
+            reactive_samples.push_back(sample);
+        }
+    }
+
+    const auto replay = [&config](const std::vector<ReplaySample> &replay_samples,
+                                  std::vector<CdevRequestRecord> *cdev_records,
+                                  std::vector<BudgetRecord> *budget_records) {
+        ThermalReplay thermal_replay;
+        ASSERT_TRUE(thermal_replay.init(config));
+        thermal_replay.replay(replay_samples, cdev_records, budget_records);
+    };
+    std::vector<CdevRequestRecord> cdev_records, reactive_cdev_records;
+    std::vector<BudgetRecord> budget_records, reactive_budget_records;
+    replay(samples, &cdev_records, &budget_records);
+    replay(reactive_samples, &reactive_cdev_records, &reactive_budget_records);
+
+    // Reactive PID waits for the LIGHT threshold, 30s in, the plan sees it coming 10s earlier
+    for (const auto &record : reactive_cdev_records) {
+        EXPECT_GE(record.time, milliseconds(30000));
+    }
+    const auto summaries = SummarizeCdevRequests(cdev_records, milliseconds(90000));
+    ASSERT_TRUE(summaries.count("cpu"));
+    EXPECT_LT(summaries.at("cpu").first_throttle_time, milliseconds(30000));
+    ASSERT_FALSE(budget_records.empty());
+    EXPECT_FALSE(std::isnan(budget_records.back().predicted_peak));
+    for (const auto &record : reactive_budget_records) {
+        EXPECT_TRUE(std::isnan(record.predicted_peak));
+    }
+}
+
+TEST(ThermalReplayTest, SummarizeCdevRequests) {
+    const std::vector<CdevRequestRecord> records = {
+            {milliseconds(1000), "cpu", 2},
+            {milliseconds(3000), "cpu", 1},
+            {milliseconds(4000), "gpu", 0},
+            {milliseconds(6000), "cpu", 0},
+    };
+    const auto summaries = SummarizeCdevRequests(records, milliseconds(10000));
+    ASSERT_EQ(summaries.size(), 2u);
+    EXPECT_EQ(summaries.at("cpu").first_throttle_time, milliseconds(1000));
+    EXPECT_EQ(summaries.at("cpu").max_state, 2);
+    EXPECT_EQ(summaries.at("cpu").state_ms, 2 * 2000 + 1 * 3000);
+    EXPECT_EQ(summaries.at("gpu").first_throttle_time, milliseconds(-1));
+    EXPECT_EQ(summaries.at("gpu").state_ms, 0);
+}
+
+}  // namespace aidl::android::hardware::thermal::implementation
@@ -0,0 +1,264 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <aidl/android/frameworks/stats/BnStats.h>
+#include <gtest/gtest.h>
+#include <json/reader.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "utils/thermal_stats_helper.h"
+
+namespace aidl::android::hardware::thermal::implementation {
+
+using aidl::android::frameworks::stats::BnStats;
+namespace PixelAtoms = ::android::hardware::google::pixel::PixelAtoms;
+
+constexpr std::string_view kStatsConfig = R"({
+    "Stats": {
+        "Sensors": {
+            "DefaultThresholdEnableAll": true,
+            "RecordWithThreshold": [{"Name": "skin", "Thresholds": [30, 40]}],
+            "Abnormality": {
+                "Outlier": {"Configs": [{"Monitor": ["battery"], "TempRange": [0, 60]}]}
+            }
+        },
+        "CoolingDevices": {"RecordVotePerSensor": {"DefaultThresholdEnableAll": true}}
+    }
+})";
+
+// IStats which takes `delay` per atom, and can be held in a call or made to fail
+class SlowStats : public BnStats {
+  public:
+    ndk::ScopedAStatus reportVendorAtom(const VendorAtom &atom) override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        call_times_.push_back(boot_clock::now());
+        cv_.notify_all();
+        cv_.wait(lock, [this] { return !blocked_; });
+        lock.unlock();
+        std::this_thread::sleep_for(delay_);
+        lock.lock();
+        if (failures_left_ > 0) {
+            failures_left_--;
+            return ndk::ScopedAStatus::fromServiceSpecificError(-1);
+        }
+        atoms_.push_back(atom);
+        cv_.notify_all();
+        return ndk::ScopedAStatus::ok();
+    }
+
+    void setBlocked(bool blocked) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        blocked_ = blocked;
+        cv_.notify_all();
+    }
+    void setFailures(int failures) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        failures_left_ = failures;
+    }
+    bool waitForCalls(size_t count) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_for(lock, 5s, [&] { return call_times_.size() >= count; });
+    }
+    bool waitForAtoms(size_t count) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_for(lock, 5s, [&] { return atoms_.size() >= count; });
+    }
+    std::vector<VendorAtom> atoms() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return atoms_;
+    }
+    std::vector<boot_clock::time_point> callTimes() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return call_times_;
+    }
+
+  private:
+    const std::chrono::milliseconds delay_ = 20ms;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool blocked_ = false;
+    int failures_left_ = 0;
+    std::vector<boot_clock::time_point> call_times_;
+    std::vector<VendorAtom> atoms_;
+};
+
+class ThermalStatsHelperTest : public testing::Test {
+  protected:
+    void SetUp() override {
+        auto &skin = sensor_info_map_["skin"];
+        skin.is_watch = true;
+        skin.throttling_info = std::make_shared<ThrottlingInfo>();
+        skin.throttling_info->binded_cdev_info_map["cpu"] = BindedCdevInfo{};
+        auto &battery = sensor_info_map_["battery"];
+        battery.is_watch = false;
+        battery.throttling_info = std::make_shared<ThrottlingInfo>();
+        cooling_device_info_map_["cpu"].max_state = 3;
+
+        Json::CharReaderBuilder builder;
+        std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+        std::string errs;
+        ASSERT_TRUE(reader->parse(kStatsConfig.data(), kStatsConfig.data() + kStatsConfig.size(),
+                                  &config_, &errs))
+                << errs;
+    }
+
+    void TearDown() override { stats_->setBlocked(false); }
+
+    std::unique_ptr<ThermalStatsHelper> makeHelper(StatsReportingPolicy policy) {
+        auto helper = std::make_unique<ThermalStatsHelper>([this] { return stats_; }, policy);
+        EXPECT_TRUE(helper->initializeStats(config_, sensor_info_map_, cooling_device_info_map_,
+                                            nullptr));
+        return helper;
+    }
+
+    static const VendorAtom *findAtom(const std::vector<VendorAtom> &atoms, int32_t atom_id,
+                                      const std::string &name) {
+        for (const auto &atom : atoms) {
+            if (atom.atomId == atom_id && atom.values[0].getTag() == VendorAtomValue::stringValue &&
+                atom.values[0].get<VendorAtomValue::stringValue>() == name) {
+                return &atom;
+            }
+        }
+        return nullptr;
+    }
+
+    Json::Value config_;
+    std::unordered_map<std::string, SensorInfo> sensor_info_map_;
+    std::unordered_map<std::string, CdevInfo> cooling_device_info_map_;
+    std::shared_ptr<SlowStats> stats_ = ndk::SharedRefBase::make<SlowStats>();
+};
+
+TEST_F(ThermalStatsHelperTest, ResidencyIsReportedOnce) {
+    auto helper = makeHelper(StatsReportingPolicy());
+    helper->updateSensorTempStatsByThreshold("skin", 35);
+    helper->updateSensorTempStatsBySeverity("skin", ThrottlingSeverity::MODERATE);
+    helper->updateSensorCdevRequestStats("skin", "cpu", 2);
+    std::this_thread::sleep_for(50ms);
+    helper->updateSensorCdevRequestStats("skin", "cpu", 0);
+
+    helper->requestReport();
+    ASSERT_TRUE(stats_->waitForAtoms(3));
+    const auto atoms = stats_->atoms();
+    ASSERT_EQ(atoms.size(), 3u);
+
+    const auto *by_threshold =
+            findAtom(atoms, PixelAtoms::Atom::kVendorTempResidencyStats, "skin-TH-0");
+    ASSERT_NE(by_threshold, nullptr);
+    // name, time since last report, padded residency, max/min temp and their timestamps
+    ASSERT_EQ(by_threshold->values.size(), 2 + kMaxStatsResidencyCount + 4);
+    EXPECT_GE(by_threshold->values[2 + 1].get<VendorAtomValue::longValue>(), 50);
+    EXPECT_FLOAT_EQ(
+            by_threshold->values[2 + kMaxStatsResidencyCount].get<VendorAtomValue::floatValue>(),
+            35);
+
+    const auto *by_severity = findAtom(atoms, PixelAtoms::Atom::kVendorTempResidencyStats, "skin");
+    ASSERT_NE(by_severity, nullptr);
+    EXPECT_GE(by_severity->values[2 + static_cast<int>(ThrottlingSeverity::MODERATE)]
+                      .get<VendorAtomValue::longValue>(),
+              50);
+
+    const auto *by_request =
+            findAtom(atoms, PixelAtoms::Atom::kVendorSensorCoolingDeviceStats, "skin");
+    ASSERT_NE(by_request, nullptr);
+    EXPECT_EQ(by_request->values[1].get<VendorAtomValue::stringValue>(), "cpu");
+    // name, cdev, time since last report and one bucket per state
+    ASSERT_EQ(by_request->values.size(), 3u + 4u);
+    EXPECT_GE(by_request->values[3 + 2].get<VendorAtomValue::longValue>(), 50);
+
+    // The delivered residency is not carried into the next report, once the reporter is done
+    const auto unreported_ms = [&] {
+        return helper->GetSensorCoolingDeviceRequestStatsSnapshot()
+                .at("skin")
+                .at("cpu")
+                .stats_by_default_threshold->time_in_state_ms[2]
+                .count();
+    };
+    const auto deadline = boot_clock::now() + 1s;
+    while (unreported_ms() != 0 && boot_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+    EXPECT_EQ(unreported_ms(), 0);
+}
+
+TEST_F(ThermalStatsHelperTest, SlowClientDoesNotBlockUpdates) {
+    auto helper = makeHelper(StatsReportingPolicy());
+    stats_->setBlocked(true);
+    helper->requestReport();
+    // The reporter thread is now stuck in the binder call
+    ASSERT_TRUE(stats_->waitForCalls(1));
+
+    const auto start = boot_clock::now();
+    for (int i = 0; i < 1000; ++i) {
+        helper->updateSensorTempStatsByThreshold("skin", 25 + i % 20);
+        helper->updateSensorTempStatsBySeverity("skin",
+                                                static_cast<ThrottlingSeverity>(i % 3));
+        helper->updateSensorCdevRequestStats("skin", "cpu", i % 4);
+    }
+    // An outlier queues its atom behind the stuck call
+    helper->updateSensorTempStatsByThreshold("battery", 80);
+    EXPECT_FALSE(helper->GetSensorTempStatsSnapshot().empty());
+    EXPECT_LT(boot_clock::now() - start, 1s);
+
+    stats_->setBlocked(false);
+    ASSERT_TRUE(stats_->waitForAtoms(4));
+    const auto atoms = stats_->atoms();
+    EXPECT_TRUE(std::any_of(atoms.begin(), atoms.end(), [](const VendorAtom &atom) {
+        return atom.atomId == PixelAtoms::Atom::kThermalSensorAbnormalityDetected &&
+               atom.values[ThermalSensorAbnormalityDetected::kSensorFieldNumber -
+                           kVendorAtomOffset]
+                               .get<VendorAtomValue::stringValue>() == "battery";
+    }));
+}
+
+TEST_F(ThermalStatsHelperTest, FailedAtomsAreRetriedWithBackoff) {
+    StatsReportingPolicy policy;
+    policy.initial_backoff = 30ms;
+    auto helper = makeHelper(policy);
+    stats_->setFailures(2);
+    helper->requestReport();
+    ASSERT_TRUE(stats_->waitForAtoms(3));
+
+    // The first atom failed twice, the rest of the batch waited for it
+    const auto call_times = stats_->callTimes();
+    ASSERT_EQ(call_times.size(), 5u);
+    EXPECT_GE(call_times[1] - call_times[0], 30ms);
+    EXPECT_GE(call_times[2] - call_times[1], 60ms);
+}
+
+TEST_F(ThermalStatsHelperTest, AbnormalityQueueIsBounded) {
+    StatsReportingPolicy policy;
+    policy.max_queued_atoms = 2;
+    auto helper = makeHelper(policy);
+    stats_->setBlocked(true);
+    EXPECT_TRUE(helper->reportThermalAbnormality(ThermalSensorAbnormalityDetected::SENSOR_STUCK,
+                                                 "battery", 30));
+    ASSERT_TRUE(stats_->waitForCalls(1));
+
+    EXPECT_TRUE(helper->reportThermalAbnormality(ThermalSensorAbnormalityDetected::SENSOR_STUCK,
+                                                 "battery", 30));
+    EXPECT_TRUE(helper->reportThermalAbnormality(ThermalSensorAbnormalityDetected::SENSOR_STUCK,
+                                                 "battery", 30));
+    EXPECT_FALSE(helper->reportThermalAbnormality(ThermalSensorAbnormalityDetected::SENSOR_STUCK,
+                                                  "battery", 30));
+    stats_->setBlocked(false);
+    EXPECT_TRUE(stats_->waitForAtoms(3));
+}
+
+}  // namespace aidl::android::hardware::thermal::implementation
@@ -0,0 +1,275 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+
+#include "utils/thermal_throttling.h"
+
+namespace aidl::android::hardware::thermal::implementation {
+
+namespace {
+
+// The state2power scan getCdevStateOfPower() replaces
+size_t StateOfPowerByScan(const std::vector<float> &state2power, int power_budget) {
+    size_t i;
+    for (i = 0; i < state2power.size() - 1; ++i) {
+        if (power_budget >= state2power[i]) {
+            break;
+        }
+    }
+    return i;
+}
+
+CdevInfo MakeCdevInfo(std::vector<float> state2power) {
+    CdevInfo cdev_info = {
+            .type = CoolingType::CPU,
+            .read_path = "",
+            .write_path = "",
+            .state2power = std::move(state2power),
+            .max_state = 0,
+            .state2power_descending = true,
+    };
+    cdev_info.max_state = static_cast<int>(cdev_info.state2power.size()) - 1;
+    for (size_t i = 1; i < cdev_info.state2power.size(); ++i) {
+        if (!(cdev_info.state2power[i] <= cdev_info.state2power[i - 1])) {
+            cdev_info.state2power_descending = false;
+        }
+    }
+    return cdev_info;
+}
+
+void ExpectSameAsScan(const CdevInfo &cdev_info) {
+    std::vector<int> power_budgets = {std::numeric_limits<int>::min(), -1, 0,
+                                      std::numeric_limits<int>::max()};
+    for (const float power : cdev_info.state2power) {
+        if (std::isnan(power)) {
+            continue;
+        }
+        for (const int delta : {-1, 0, 1}) {
+            power_budgets.push_back(static_cast<int>(power) + delta);
+        }
+    }
+    for (const int power_budget : power_budgets) {
+        ASSERT_EQ(getCdevStateOfPower(cdev_info, power_budget),
+                  StateOfPowerByScan(cdev_info.state2power, power_budget))
+                << "power budget " << power_budget;
+    }
+}
+
+}  // namespace
+
+TEST(CdevStateOfPowerTest, DescendingTables) {
+    ExpectSameAsScan(MakeCdevInfo({1000}));
+    ExpectSameAsScan(MakeCdevInfo({1000, 0}));
+    ExpectSameAsScan(MakeCdevInfo({3000, 2000, 2000, 2000, 1000, 500, 500, 0}));
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> step(0, 300);
+    std::uniform_int_distribution<int> size(1, 100);
+    for (int round = 0; round < 200; ++round) {
+        std::vector<float> state2power(size(rng));
+        float power = 20000;
+        for (auto &state_power : state2power) {
+            state_power = power;
+            power -= std::floor(step(rng));
+        }
+        const CdevInfo cdev_info = MakeCdevInfo(state2power);
+        ASSERT_TRUE(cdev_info.state2power_descending);
+        ExpectSameAsScan(cdev_info);
+        if (HasFatalFailure()) {
+            return;
+        }
+    }
+}
+
+TEST(CdevStateOfPowerTest, UnorderedTablesFallBackToScan) {
+    const CdevInfo rising = MakeCdevInfo({1000, 2000, 500, 3000, 0});
+    EXPECT_FALSE(rising.state2power_descending);
+    ExpectSameAsScan(rising);
+
+    const CdevInfo with_nan = MakeCdevInfo({3000, NAN, 1000, 0});
+    EXPECT_FALSE(with_nan.state2power_descending);
+    ExpectSameAsScan(with_nan);
+}
+
+class PowerAllocationTest : public testing::Test {
+  protected:
+    static constexpr int kMaxState = 9;
+
+    void SetUp() override {
+        cooling_device_info_map_["cdev0"] = MakeCdevInfo(
+                {2000, 1800, 1600, 1400, 1200, 1000, 800, 600, 400, 200});
+        cooling_device_info_map_["cdev1"] = cooling_device_info_map_["cdev0"];
+        power_status_map_["rail0"].last_updated_avg_power = 1500;
+        power_status_map_["rail1"].last_updated_avg_power = 1500;
+
+        sensor_info_.type = TemperatureType::SKIN;
+        sensor_info_.hot_thresholds = {NAN, 39, 41, 43, 45, 47, 55};
+        sensor_info_.multiplier = 1;
+        auto throttling_info = std::make_shared<ThrottlingInfo>();
+        throttling_info->k_po.fill(50);
+        throttling_info->k_pu.fill(50);
+        throttling_info->k_io.fill(0);
+        throttling_info->k_iu.fill(0);
+        throttling_info->k_d.fill(0);
+        throttling_info->i_max.fill(0);
+        throttling_info->max_alloc_power.fill(10000);
+        throttling_info->min_alloc_power.fill(0);
+        throttling_info->s_power = {NAN, 4000, 3000, 2000, 1000, 1000, 1000};
+        throttling_info->i_cutoff.fill(10);
+        throttling_info->i_default_pct = NAN;
+        throttling_info->budget_tolerance = 50;
+        for (const auto &cdev_rail : {std::make_pair("cdev0", "rail0"),
+                                      std::make_pair("cdev1", "rail1")}) {
+            BindedCdevInfo binded_cdev_info{};
+            binded_cdev_info.limit_info.fill(0);
+            binded_cdev_info.power_thresholds.fill(NAN);
+            binded_cdev_info.release_logic = ReleaseLogic::NONE;
+            binded_cdev_info.cdev_weight_for_pid.fill(1);
+            binded_cdev_info.cdev_ceiling.fill(kMaxState);
+            binded_cdev_info.max_release_step = std::numeric_limits<int>::max();
+            binded_cdev_info.max_throttle_step = std::numeric_limits<int>::max();
+            binded_cdev_info.cdev_floor_with_power_link.fill(0);
+            binded_cdev_info.power_rail = cdev_rail.second;
+            binded_cdev_info.enabled = true;
+            throttling_info->binded_cdev_info_map[cdev_rail.first] = binded_cdev_info;
+        }
+        sensor_info_.throttling_info = throttling_info;
+        ASSERT_TRUE(throttling_.registerThermalThrottling("skin", sensor_info_.throttling_info,
+                                                          cooling_device_info_map_));
+    }
+
+    void update() {
+        throttling_.thermalThrottlingUpdate(
+                Temperature{.type = TemperatureType::SKIN,
+                            .name = "skin",
+                            .value = 45,
+                            .throttlingStatus = ThrottlingSeverity::SEVERE},
+                sensor_info_, ThrottlingSeverity::SEVERE, std::chrono::milliseconds(1000),
+                power_status_map_, cooling_device_info_map_);
+    }
+
+    const ThermalThrottlingStatus &status() {
+        return throttling_.GetThermalThrottlingStatusMap().at("skin");
+    }
+
+    ThermalThrottling throttling_;
+    SensorInfo sensor_info_{};
+    std::unordered_map<std::string, CdevInfo> cooling_device_info_map_;
+    std::unordered_map<std::string, PowerStatus> power_status_map_;
+};
+
+TEST_F(PowerAllocationTest, SettledSplitIsKeptWithinTolerance) {
+    // The split settles once a full pass leaves the requests where they are
+    for (int i = 0; i < 20 && std::isnan(status().allocated_power_budget); ++i) {
+        update();
+    }
+    ASSERT_FALSE(std::isnan(status().allocated_power_budget));
+    const auto pid_cdev_request_map = status().pid_cdev_request_map;
+    const auto allocated_rail_power = status().allocated_rail_power;
+
+    // Rail power moving within the tolerance keeps the split as it is
+    power_status_map_["rail0"].last_updated_avg_power = 1530;
+    update();
+    EXPECT_EQ(status().allocated_rail_power, allocated_rail_power);
+    EXPECT_EQ(status().pid_cdev_request_map, pid_cdev_request_map);
+
+    // Moving beyond it splits the budget again
+    power_status_map_["rail0"].last_updated_avg_power = 1600;
+    update();
+    EXPECT_NE(status().allocated_rail_power, allocated_rail_power);
+}
+
+TEST_F(PowerAllocationTest, SplitIsRecomputedWithoutTolerance) {
+    sensor_info_.throttling_info->budget_tolerance = NAN;
+    for (int i = 0; i < 20; ++i) {
+        update();
+    }
+    const auto allocated_rail_power = status().allocated_rail_power;
+
+    power_status_map_["rail0"].last_updated_avg_power = 1501;
+    update();
+    EXPECT_NE(status().allocated_rail_power, allocated_rail_power);
+}
+
+class PredictiveThrottlingTest : public PowerAllocationTest {
+  protected:
+    void SetUp() override {
+        PowerAllocationTest::SetUp();
+        sensor_info_.predictor_info.reset(new PredictorInfo{
+                .sensor = "skin_predictor",
+                .support_pid_compensation = false,
+                .prediction_weights = {},
+                .k_p_compensate = {},
+                .support_mpc_throttling = true,
+                .prediction_interval = std::chrono::milliseconds(1000),
+                .thermal_resistance = 0.005,
+                .thermal_time_constant = std::chrono::milliseconds(10000),
+        });
+    }
+
+    // Ten predictions a second apart, ramping linearly from `from` to `to`
+    void updateWithRamp(float from, float to, ThrottlingSeverity severity) {
+        std::vector<float> predictions;
+        for (int i = 0; i < 10; ++i) {
+            predictions.push_back(from + (to - from) * i / 9);
+        }
+        throttling_.thermalThrottlingUpdate(
+                Temperature{.type = TemperatureType::SKIN,
+                            .name = "skin",
+                            .value = from,
+                            .throttlingStatus = severity},
+                sensor_info_, severity, std::chrono::milliseconds(1000), power_status_map_,
+                cooling_device_info_map_, false, predictions);
+    }
+};
+
+TEST_F(PredictiveThrottlingTest, ThrottlesAheadOfThresholds) {
+    // Below every threshold, but predicted to cross the LIGHT target of 39 by 1 degree. Cutting
+    // 2 * 200mW lowers the peak by 0.005 * (1 - exp(-1)) * 400 = 1.26 degrees.
+    updateWithRamp(38, 40, ThrottlingSeverity::NONE);
+    EXPECT_FLOAT_EQ(status().predicted_peak, 40);
+    EXPECT_EQ(status().pid_cdev_request_map.at("cdev0"), 1);
+    EXPECT_EQ(status().pid_cdev_request_map.at("cdev1"), 1);
+
+    // Predicted to stay under the target, the requests are released
+    updateWithRamp(37, 37, ThrottlingSeverity::NONE);
+    EXPECT_EQ(status().pid_cdev_request_map.at("cdev0"), 0);
+    EXPECT_EQ(status().pid_cdev_request_map.at("cdev1"), 0);
+}
+
+TEST_F(PredictiveThrottlingTest, PlanMovesByMaxThrottleStep) {
+    for (auto &binded_cdev_info_pair : sensor_info_.throttling_info->binded_cdev_info_map) {
+        binded_cdev_info_pair.second.max_throttle_step = 2;
+    }
+    updateWithRamp(44, 60, ThrottlingSeverity::SEVERE);
+    EXPECT_EQ(status().pid_cdev_request_map.at("cdev0"), 2);
+    updateWithRamp(44, 60, ThrottlingSeverity::SEVERE);
+    EXPECT_EQ(status().pid_cdev_request_map.at("cdev0"), 4);
+}
+
+TEST_F(PredictiveThrottlingTest, FallsBackToPidWithoutPredictions) {
+    updateWithRamp(44, 60, ThrottlingSeverity::SEVERE);
+    ASSERT_FALSE(std::isnan(status().predicted_peak));
+    update();
+    EXPECT_TRUE(std::isnan(status().predicted_peak));
+    EXPECT_FALSE(std::isnan(status().p_budget));
+}
+
+}  // namespace aidl::android::hardware::thermal::implementation
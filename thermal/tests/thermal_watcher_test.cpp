@@ -0,0 +1,255 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/logging.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <linux/netlink.h>
+#include <linux/thermal.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "utils/thermal_watcher.h"
+
+namespace aidl::android::hardware::thermal::implementation {
+
+using std::chrono::milliseconds;
+
+constexpr milliseconds kIdleSleep(60000);
+constexpr milliseconds kEventTimeout(5000);
+constexpr milliseconds kNoEventTimeout(500);
+
+// Thermal uevents carry NAME=, TEMP= and TRIP=, which only the thermal core sets on a trip, and
+// the watcher drops netlink uevents that were not sent by the kernel. A test cannot make the
+// kernel emit such a uevent, so the monitored uevents are injected over a socketpair instead,
+// with the same credentials the netlink socket would pass.
+class ThermalWatcherTest : public testing::Test {
+  protected:
+    void SetUp() override {
+        int fds[2];
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0, fds), 0);
+        uevent_fd_.reset(fds[0]);
+        sender_fd_.reset(fds[1]);
+        // Uevents are only accepted along with root credentials
+        const int on = 1;
+        ASSERT_EQ(setsockopt(uevent_fd_.get(), SOL_SOCKET, SO_PASSCRED, &on, sizeof(on)), 0);
+
+        watcher_ = new ThermalWatcher(
+                [this](const std::unordered_map<std::string, float> &uevent_sensor_map) {
+                    std::lock_guard<std::mutex> _lock(mutex_);
+                    events_.push_back({boot_clock::now(), uevent_sensor_map});
+                    cv_.notify_all();
+                    return kIdleSleep;
+                });
+    }
+
+    void TearDown() override {
+        watcher_->requestExit();
+        watcher_->wake();
+        watcher_->requestExitAndWait();
+        if (genl_sender_ != nullptr) {
+            nl_socket_free(genl_sender_);
+        }
+    }
+
+    void start(const std::set<std::string> &sensors_to_watch) {
+        watcher_->registerUeventFd(std::move(uevent_fd_), sensors_to_watch);
+        ASSERT_TRUE(watcher_->startWatchingDeviceFiles());
+    }
+
+    // Send a uevent laid out the way the thermal core emits it
+    void sendUevent(std::string_view name, std::string_view subsystem = "thermal") {
+        std::string msg = "change@/devices/virtual/thermal/thermal_zone0";
+        for (const auto &field :
+             {std::string("ACTION=change"),
+              std::string("DEVPATH=/devices/virtual/thermal/thermal_zone0"),
+              "SUBSYSTEM=" + std::string(subsystem), "NAME=" + std::string(name),
+              std::string("TEMP=45000"), std::string("TRIP=0")}) {
+            msg.push_back('\0');
+            msg.append(field);
+        }
+        ASSERT_EQ(send(sender_fd_.get(), msg.data(), msg.size(), 0),
+                  static_cast<ssize_t>(msg.size()));
+    }
+
+    // Watch a generic netlink socket joined to no group, with the given thermal zone types, and
+    // connect genl_sender_ to it. The watcher keeps the socket, as it does the one it opens.
+    void startGenl(std::unordered_map<int, std::string> tz_types,
+                   const std::set<std::string> &sensors_to_watch) {
+        struct nl_sock *sock = nl_socket_alloc();
+        ASSERT_NE(sock, nullptr);
+        ASSERT_EQ(genl_connect(sock), 0);
+        genl_sender_ = nl_socket_alloc();
+        ASSERT_NE(genl_sender_, nullptr);
+        ASSERT_EQ(genl_connect(genl_sender_), 0);
+        nl_socket_set_peer_port(genl_sender_, nl_socket_get_local_port(sock));
+
+        watcher_->registerGenlSocket(sock, std::move(tz_types), sensors_to_watch);
+        ASSERT_TRUE(watcher_->startWatchingDeviceFiles());
+    }
+
+    // Send a trip event laid out the way the thermal core emits it
+    void sendGenlTripEvent(uint8_t cmd, uint32_t tz_id, int32_t temp) {
+        std::unique_ptr<nl_msg, decltype(&nlmsg_free)> msg(nlmsg_alloc(), nlmsg_free);
+        ASSERT_NE(msg, nullptr);
+        ASSERT_NE(genlmsg_put(msg.get(), NL_AUTO_PORT, NL_AUTO_SEQ, GENL_MIN_ID, 0, 0, cmd,
+                              THERMAL_GENL_VERSION),
+                  nullptr);
+        ASSERT_EQ(nla_put_u32(msg.get(), THERMAL_GENL_ATTR_TZ_ID, tz_id), 0);
+        ASSERT_EQ(nla_put_u32(msg.get(), THERMAL_GENL_ATTR_TZ_TRIP_ID, 0), 0);
+        ASSERT_EQ(nla_put_s32(msg.get(), THERMAL_GENL_ATTR_TZ_TEMP, temp), 0);
+        ASSERT_GE(nl_send_auto(genl_sender_, msg.get()), 0);
+    }
+
+    // Wait until the callback has run count times in total
+    bool waitForEvents(size_t count, milliseconds timeout = kEventTimeout) {
+        std::unique_lock<std::mutex> _lock(mutex_);
+        return cv_.wait_for(_lock, timeout, [&] { return events_.size() >= count; });
+    }
+
+    struct CallbackEvent {
+        boot_clock::time_point time;
+        std::unordered_map<std::string, float> sensor_map;
+    };
+
+    unique_fd uevent_fd_;
+    unique_fd sender_fd_;
+    ::android::sp<ThermalWatcher> watcher_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<CallbackEvent> events_;
+    struct nl_sock *genl_sender_ = nullptr;
+};
+
+TEST_F(ThermalWatcherTest, OnlyMonitoredThermalUeventsAreReported) {
+    sendUevent("skin");
+    sendUevent("battery");
+    sendUevent("skin", "power_supply");
+    sendUevent("cpu");
+
+    start({"skin", "cpu"});
+    // The first pass runs the callback unconditionally, the second one drains the socket
+    ASSERT_TRUE(waitForEvents(2));
+
+    std::lock_guard<std::mutex> _lock(mutex_);
+    const auto &sensor_map = events_[1].sensor_map;
+    ASSERT_EQ(sensor_map.size(), 2u);
+    EXPECT_TRUE(std::isnan(sensor_map.at("skin")));
+    EXPECT_TRUE(std::isnan(sensor_map.at("cpu")));
+}
+
+TEST_F(ThermalWatcherTest, PendingUeventsAreDrainedInOnePass) {
+    std::set<std::string> sensors;
+    for (int i = 0; i < 20; ++i) {
+        sensors.insert("sensor" + std::to_string(i));
+        sendUevent("sensor" + std::to_string(i));
+    }
+
+    start(sensors);
+    ASSERT_TRUE(waitForEvents(2));
+
+    std::lock_guard<std::mutex> _lock(mutex_);
+    EXPECT_EQ(events_[1].sensor_map.size(), sensors.size());
+}
+
+TEST_F(ThermalWatcherTest, UeventsFromUserspaceNetlinkAreDropped) {
+    // Watch a uevent netlink socket joined to no group, so only the test sends to it
+    unique_fd netlink_fd(socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT));
+    ASSERT_GE(netlink_fd.get(), 0);
+    struct sockaddr_nl addr = {.nl_family = AF_NETLINK};
+    ASSERT_EQ(bind(netlink_fd.get(), reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)), 0);
+    socklen_t addr_len = sizeof(addr);
+    ASSERT_EQ(getsockname(netlink_fd.get(), reinterpret_cast<struct sockaddr *>(&addr),
+                          &addr_len),
+              0);
+    const int on = 1;
+    ASSERT_EQ(setsockopt(netlink_fd.get(), SOL_SOCKET, SO_PASSCRED, &on, sizeof(on)), 0);
+    sender_fd_.reset(socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT));
+    ASSERT_GE(sender_fd_.get(), 0);
+    const struct sockaddr_nl dest = {.nl_family = AF_NETLINK, .nl_pid = addr.nl_pid};
+    ASSERT_EQ(connect(sender_fd_.get(), reinterpret_cast<const struct sockaddr *>(&dest),
+                      sizeof(dest)),
+              0);
+    uevent_fd_ = std::move(netlink_fd);
+
+    start({"skin"});
+    ASSERT_TRUE(waitForEvents(1));
+    // A monitored uevent, but unicast from a process rather than multicast by the kernel
+    sendUevent("skin");
+    EXPECT_FALSE(waitForEvents(2, kNoEventTimeout));
+}
+
+// Thermal genl trip events are multicast by the thermal core, which a test cannot make trip a
+// zone. The crafted events are unicast to the watched socket from another one instead.
+TEST_F(ThermalWatcherTest, OnlyGenlEventsOfMonitoredZonesAreReported) {
+    // Zone 100000 is in neither the map nor sysfs
+    constexpr uint32_t kUnknownTzId = 100000;
+
+    startGenl({{3, "skin"}, {4, "battery"}}, {"skin"});
+    ASSERT_TRUE(waitForEvents(1));
+    sendGenlTripEvent(THERMAL_GENL_EVENT_TZ_TRIP_UP, kUnknownTzId, 45000);
+    sendGenlTripEvent(THERMAL_GENL_EVENT_TZ_TRIP_DOWN, 4, 38000);
+    sendGenlTripEvent(THERMAL_GENL_EVENT_TZ_TRIP_UP, 3, 41000);
+    ASSERT_TRUE(waitForEvents(2));
+
+    {
+        std::lock_guard<std::mutex> _lock(mutex_);
+        for (size_t i = 1; i < events_.size(); ++i) {
+            const auto &sensor_map = events_[i].sensor_map;
+            ASSERT_EQ(sensor_map.size(), 1u);
+            EXPECT_FLOAT_EQ(sensor_map.at("skin"), 41000);
+        }
+    }
+
+    // Events of unmonitored or unknown zones alone don't run the callback
+    const size_t event_count = events_.size();
+    sendGenlTripEvent(THERMAL_GENL_EVENT_TZ_TRIP_DOWN, kUnknownTzId, 40000);
+    sendGenlTripEvent(THERMAL_GENL_EVENT_TZ_TRIP_UP, 4, 39000);
+    EXPECT_FALSE(waitForEvents(event_count + 1, kNoEventTimeout));
+}
+
+// The latency ends at the callback, which runs the HAL's sensor and throttling pass
+TEST_F(ThermalWatcherTest, EventToCallbackLatency) {
+    constexpr size_t kRounds = 100;
+    std::vector<int64_t> latencies_us;
+
+    start({"skin"});
+    ASSERT_TRUE(waitForEvents(1));
+    for (size_t i = 0; i < kRounds; ++i) {
+        const auto sent = boot_clock::now();
+        sendUevent("skin");
+        ASSERT_TRUE(waitForEvents(i + 2));
+
+        std::lock_guard<std::mutex> _lock(mutex_);
+        ASSERT_EQ(events_.back().sensor_map.count("skin"), 1u);
+        latencies_us.push_back(
+                std::chrono::duration_cast<std::chrono::microseconds>(events_.back().time - sent)
+                        .count());
+    }
+
+    std::sort(latencies_us.begin(), latencies_us.end());
+    const auto median_us = latencies_us[kRounds / 2];
+    const auto max_us = latencies_us.back();
+    LOG(INFO) << "Uevent to callback latency: median " << median_us << "us, max " << max_us
+              << "us";
+    RecordProperty("median_latency_us", std::to_string(median_us));
+    RecordProperty("max_latency_us", std::to_string(max_us));
+    EXPECT_LT(max_us, 500000);
+}
+
+}  // namespace aidl::android::hardware::thermal::implementation
@@ -19,11 +19,14 @@
 
 #include <android-base/file.h>
 #include <android-base/logging.h>
+#include <android-base/parseint.h>
 #include <android-base/properties.h>
 #include <android-base/stringprintf.h>
 #include <android-base/strings.h>
 #include <utils/Trace.h>
 
+#include <algorithm>
+#include <future>
 #include <iterator>
 #include <set>
 #include <sstream>
@@ -52,6 +55,9 @@ constexpr std::string_view kConfigProperty("vendor.thermal.config");
 constexpr std::string_view kConfigDefaultFileName("thermal_info_config.json");
 constexpr std::string_view kThermalGenlProperty("persist.vendor.enable.thermal.genl");
 constexpr std::string_view kThermalDisabledProperty("vendor.disable.thermalhal.control");
+constexpr std::string_view kThermalCaptureRecordsProperty("persist.vendor.thermal.capture.records");
+constexpr std::string_view kThermalCapturePath("/data/vendor/thermal/thermal_capture.bin");
+constexpr std::string_view kThermalConfigCachePath("/data/vendor/thermal/thermal_config_cache.bin");
 
 namespace {
 using ::android::base::StringPrintf;
@@ -152,11 +158,21 @@ ThermalHelperImpl::ThermalHelperImpl(const NotificationCallback &cb)
     bool thermal_throttling_disabled =
             ::android::base::GetBoolProperty(kThermalDisabledProperty.data(), false);
     bool ret = true;
+    // The sysfs scans do not depend on the config, run them while it is parsed
+    auto tz_map_future = std::async(std::launch::async, parseThermalPathMap, kSensorPrefix);
+    auto cdev_map_future =
+            std::async(std::launch::async, parseThermalPathMap, kCoolingDevicePrefix);
     Json::Value config;
-    std::unordered_set<std::string> loaded_config_paths;
-    if (!ParseThermalConfig(config_path, &config, &loaded_config_paths)) {
-        LOG(ERROR) << "Failed to read JSON config";
-        ret = false;
+    // Decoding the cached config takes about half the time of parsing the JSON text
+    if (!LoadThermalConfigCache(kThermalConfigCachePath, config_path, &config)) {
+        std::unordered_set<std::string> loaded_config_paths;
+        if (!ParseThermalConfig(config_path, &config, &loaded_config_paths)) {
+            LOG(ERROR) << "Failed to read JSON config";
+            ret = false;
+        } else {
+            SaveThermalConfigCache(kThermalConfigCachePath, config_path, config,
+                                   loaded_config_paths);
+        }
     }
 
     const std::string &comment = config["Comment"].asString();
@@ -172,19 +188,23 @@ ThermalHelperImpl::ThermalHelperImpl(const NotificationCallback &cb)
         ret = false;
     }
 
-    auto tz_map = parseThermalPathMap(kSensorPrefix.data());
+    // The power rails only touch power_files_, register them alongside the sensors and cdevs
+    auto power_rails_future = std::async(std::launch::async, [this, &config] {
+        return power_files_.registerPowerRailsToWatch(config);
+    });
+
+    const auto tz_map = tz_map_future.get();
     if (!initializeSensorMap(tz_map)) {
         LOG(ERROR) << "Failed to initialize sensor map";
         ret = false;
     }
 
-    auto cdev_map = parseThermalPathMap(kCoolingDevicePrefix.data());
-    if (!initializeCoolingDevices(cdev_map)) {
+    if (!initializeCoolingDevices(cdev_map_future.get())) {
         LOG(ERROR) << "Failed to initialize cooling device map";
         ret = false;
     }
 
-    if (!power_files_.registerPowerRailsToWatch(config)) {
+    if (!power_rails_future.get()) {
         LOG(ERROR) << "Failed to register power rails";
         ret = false;
     }
@@ -307,7 +327,16 @@ ThermalHelperImpl::ThermalHelperImpl(const NotificationCallback &cb)
                 break;
             }
 
-            if (name_status_pair.second.predictor_info->support_pid_compensation) {
+            if (name_status_pair.second.predictor_info->support_mpc_throttling &&
+                name_status_pair.second.throttling_info == nullptr) {
+                LOG(ERROR) << name_status_pair.first
+                           << " has model predictive throttling but no throttling info";
+                ret = false;
+                break;
+            }
+
+            if (name_status_pair.second.predictor_info->support_pid_compensation ||
+                name_status_pair.second.predictor_info->support_mpc_throttling) {
                 std::vector<float> output_template;
                 size_t prediction_weight_count =
                         name_status_pair.second.predictor_info->prediction_weights.size();
@@ -324,7 +353,8 @@ ThermalHelperImpl::ThermalHelperImpl(const NotificationCallback &cb)
                     break;
                 }
 
-                if (prediction_weight_count != output_template.size()) {
+                if (name_status_pair.second.predictor_info->support_pid_compensation &&
+                    prediction_weight_count != output_template.size()) {
                     LOG(ERROR) << "Sensor [" << name_status_pair.first << "]: "
                                << "prediction weights size (" << prediction_weight_count
                                << ") doesn't match predictor [" << predict_sensor_name
@@ -342,6 +372,8 @@ ThermalHelperImpl::ThermalHelperImpl(const NotificationCallback &cb)
         power_hal_service_.updateSupportedPowerHints(sensor_info_map_);
     }
 
+    initThermalSnapshot();
+
     if (thermal_throttling_disabled) {
         if (ret) {
             clearAllThrottling();
@@ -357,6 +389,29 @@ ThermalHelperImpl::ThermalHelperImpl(const NotificationCallback &cb)
     }
     is_initialized_ = ret;
 
+    // Every watched sensor starts due so the first watcher pass reads it
+    for (const auto &[sensor_name, sensor_info] : sensor_info_map_) {
+        if (!sensor_info.is_watch) {
+            continue;
+        }
+        polling_scheduler_.registerSensor(sensor_name);
+        if (sensor_info.virtual_sensor_info != nullptr) {
+            for (const auto &trigger_sensor : sensor_info.virtual_sensor_info->trigger_sensors) {
+                trigger_sensor_map_[trigger_sensor].emplace_back(sensor_name);
+            }
+        }
+    }
+
+    // Opt-in binary capture of every watcher pass, the ring size is clamped by init()
+    const int capture_records =
+            ::android::base::GetIntProperty(kThermalCaptureRecordsProperty.data(), 0);
+    if (capture_records > 0 &&
+        !thermal_capture_.init(kThermalCapturePath, capture_records, sensor_info_map_,
+                               cooling_device_info_map_,
+                               thermal_throttling_.GetThermalThrottlingStatusMap())) {
+        LOG(ERROR) << "Failed to start thermal capture";
+    }
+
     const bool thermal_genl_enabled =
             ::android::base::GetBoolProperty(kThermalGenlProperty.data(), false);
 
@@ -392,6 +447,30 @@ bool getThermalZoneTypeById(int tz_id, std::string *type) {
     return true;
 }
 
+std::unordered_map<int, std::string> getThermalZoneTypeMap() {
+    std::unordered_map<int, std::string> type_map;
+    std::unique_ptr<DIR, int (*)(DIR *)> dir(opendir(kThermalSensorsRoot.data()), closedir);
+    if (!dir) {
+        PLOG(ERROR) << "Failed to open " << kThermalSensorsRoot;
+        return type_map;
+    }
+
+    while (struct dirent *dp = readdir(dir.get())) {
+        int tz_id;
+        if (dp->d_type != DT_DIR || !::android::base::StartsWith(dp->d_name, kSensorPrefix) ||
+            !::android::base::ParseInt(dp->d_name + kSensorPrefix.size(), &tz_id)) {
+            continue;
+        }
+
+        std::string tz_type;
+        if (getThermalZoneTypeById(tz_id, &tz_type)) {
+            type_map.emplace(tz_id, std::move(tz_type));
+        }
+    }
+
+    return type_map;
+}
+
 void ThermalHelperImpl::checkUpdateSensorForEmul(std::string_view target_sensor,
                                                  const bool max_throttling) {
     // Force update all the sensors which are related to the target emul sensor
@@ -409,6 +488,7 @@ void ThermalHelperImpl::checkUpdateSensorForEmul(std::string_view target_sensor,
         auto &sensor_status = sensor_status_map_.at(sensor_name.data());
         sensor_status.override_status.max_throttling = max_throttling;
         sensor_status.override_status.pending_update = true;
+        polling_scheduler_.scheduleNow(sensor_name);
 
         checkUpdateSensorForEmul(sensor_name, max_throttling);
     }
@@ -432,8 +512,10 @@ bool ThermalHelperImpl::emulTemp(std::string_view target_sensor, const float tem
     sensor_status.override_status.emul_temp.reset(new EmulTemp{temp, -1});
     sensor_status.override_status.max_throttling = max_throttling;
     sensor_status.override_status.pending_update = true;
+    polling_scheduler_.scheduleNow(target_sensor);
 
     checkUpdateSensorForEmul(target_sensor.data(), max_throttling);
+    publishEmulSettings();
 
     thermal_watcher_->wake();
     return true;
@@ -466,8 +548,10 @@ bool ThermalHelperImpl::emulSeverity(std::string_view target_sensor, const int s
     sensor_status.override_status.emul_temp.reset(new EmulTemp{temp, severity});
     sensor_status.override_status.max_throttling = max_throttling;
     sensor_status.override_status.pending_update = true;
+    polling_scheduler_.scheduleNow(target_sensor);
 
     checkUpdateSensorForEmul(target_sensor.data(), max_throttling);
+    publishEmulSettings();
 
     thermal_watcher_->wake();
     return true;
@@ -481,17 +565,20 @@ bool ThermalHelperImpl::emulClear(std::string_view target_sensor) {
         for (auto &[sensor_name, sensor_status] : sensor_status_map_) {
             sensor_status.override_status = {
                     .emul_temp = nullptr, .max_throttling = false, .pending_update = true};
+            polling_scheduler_.scheduleNow(sensor_name);
             checkUpdateSensorForEmul(sensor_name, false);
         }
     } else if (sensor_status_map_.count(target_sensor.data())) {
         auto &sensor_status = sensor_status_map_.at(target_sensor.data());
         sensor_status.override_status = {
                 .emul_temp = nullptr, .max_throttling = false, .pending_update = true};
+        polling_scheduler_.scheduleNow(target_sensor);
         checkUpdateSensorForEmul(target_sensor.data(), false);
     } else {
         LOG(ERROR) << "Cannot find target emul sensor: " << target_sensor.data();
         return false;
     }
+    publishEmulSettings();
 
     thermal_watcher_->wake();
     return true;
@@ -554,9 +641,8 @@ bool ThermalHelperImpl::readTemperature(std::string_view sensor_name, Temperatur
         std::unique_lock<std::shared_mutex> _lock(sensor_status_map_mutex_);
         prev_hot_severity = sensor_status.prev_hot_severity;
         prev_cold_severity = sensor_status.prev_cold_severity;
-        status = getSeverityFromThresholds(sensor_info.hot_thresholds, sensor_info.cold_thresholds,
-                                           sensor_info.hot_hysteresis, sensor_info.cold_hysteresis,
-                                           prev_hot_severity, prev_cold_severity, out->value);
+        status = sensor_info.severity_table.classify(out->value, prev_hot_severity,
+                                                     prev_cold_severity);
 
         out->throttlingStatus =
                 static_cast<size_t>(status.first) > static_cast<size_t>(status.second)
@@ -626,59 +712,145 @@ bool ThermalHelperImpl::readTemperatureThreshold(std::string_view sensor_name,
 
 void ThermalHelperImpl::updateCoolingDevices(const std::vector<std::string> &updated_cdev) {
     int max_state;
+    auto cdev_requests = std::make_shared<std::unordered_map<std::string, int>>(
+            *cdev_request_snapshot_);
 
+    // A cdev shared by several sensors can be listed more than once, the writer coalesces them
     for (const auto &target_cdev : updated_cdev) {
         if (thermal_throttling_.getCdevMaxRequest(target_cdev, &max_state)) {
-            if (cooling_devices_.writeCdevFile(target_cdev, std::to_string(max_state))) {
-                ATRACE_INT(target_cdev.c_str(), max_state);
-                LOG(INFO) << "Successfully update cdev " << target_cdev << " sysfs to "
-                          << max_state;
-            } else {
-                LOG(ERROR) << "Failed to update cdev " << target_cdev << " sysfs to " << max_state;
-            }
+            cdev_writer_.requestState(target_cdev, max_state);
+            thermal_capture_.updateCdev(target_cdev, max_state);
+            (*cdev_requests)[target_cdev] = max_state;
         }
     }
+    cdev_writer_.flush();
+    cdev_request_snapshot_ = std::move(cdev_requests);
 }
 
-std::pair<ThrottlingSeverity, ThrottlingSeverity> ThermalHelperImpl::getSeverityFromThresholds(
-        const ThrottlingArray &hot_thresholds, const ThrottlingArray &cold_thresholds,
-        const ThrottlingArray &hot_hysteresis, const ThrottlingArray &cold_hysteresis,
-        ThrottlingSeverity prev_hot_severity, ThrottlingSeverity prev_cold_severity,
-        float value) const {
-    ThrottlingSeverity ret_hot = ThrottlingSeverity::NONE;
-    ThrottlingSeverity ret_hot_hysteresis = ThrottlingSeverity::NONE;
-    ThrottlingSeverity ret_cold = ThrottlingSeverity::NONE;
-    ThrottlingSeverity ret_cold_hysteresis = ThrottlingSeverity::NONE;
+void ThermalHelperImpl::initThermalSnapshot() {
+    std::vector<std::string> sensor_names;
+    for (const auto &name_info_pair : sensor_info_map_) {
+        sensor_names.emplace_back(name_info_pair.first);
+    }
+    std::sort(sensor_names.begin(), sensor_names.end());
+    const auto &throttling_status_map = thermal_throttling_.GetThermalThrottlingStatusMap();
+    for (const auto &sensor_name : sensor_names) {
+        const auto &sensor_info = sensor_info_map_.at(sensor_name);
+        const auto throttling_status_it = throttling_status_map.find(sensor_name);
+        Temperature temp;
+        temp.name = sensor_name;
+        temp.type = sensor_info.type;
+        temp.value = NAN;
+        temp.throttlingStatus = ThrottlingSeverity::NONE;
+        sensor_snapshot_index_[sensor_name] = sensor_snapshots_.size();
+        sensor_snapshots_.emplace_back(std::make_shared<const SensorSnapshot>(SensorSnapshot{
+                .name = sensor_name,
+                .temp = temp,
+                .severity = ThrottlingSeverity::NONE,
+                .update_time = boot_clock::time_point::min(),
+                .throttling_status = throttling_status_it == throttling_status_map.end()
+                                             ? nullptr
+                                             : std::make_shared<const ThermalThrottlingStatus>(
+                                                       throttling_status_it->second),
+        }));
+    }
 
-    // Here we want to control the iteration from high to low, and ::ndk::enum_range doesn't support
-    // a reverse iterator yet.
-    for (size_t i = static_cast<size_t>(ThrottlingSeverity::SHUTDOWN);
-         i > static_cast<size_t>(ThrottlingSeverity::NONE); --i) {
-        if (!std::isnan(hot_thresholds[i]) && hot_thresholds[i] <= value &&
-            ret_hot == ThrottlingSeverity::NONE) {
-            ret_hot = static_cast<ThrottlingSeverity>(i);
-        }
-        if (!std::isnan(hot_thresholds[i]) && (hot_thresholds[i] - hot_hysteresis[i]) < value &&
-            ret_hot_hysteresis == ThrottlingSeverity::NONE) {
-            ret_hot_hysteresis = static_cast<ThrottlingSeverity>(i);
-        }
-        if (!std::isnan(cold_thresholds[i]) && cold_thresholds[i] >= value &&
-            ret_cold == ThrottlingSeverity::NONE) {
-            ret_cold = static_cast<ThrottlingSeverity>(i);
-        }
-        if (!std::isnan(cold_thresholds[i]) && (cold_thresholds[i] + cold_hysteresis[i]) > value &&
-            ret_cold_hysteresis == ThrottlingSeverity::NONE) {
-            ret_cold_hysteresis = static_cast<ThrottlingSeverity>(i);
-        }
+    auto cdev_requests = std::make_shared<std::unordered_map<std::string, int>>();
+    for (const auto &cdev_info_pair : cooling_device_info_map_) {
+        (*cdev_requests)[cdev_info_pair.first] = 0;
     }
-    if (static_cast<size_t>(ret_hot) < static_cast<size_t>(prev_hot_severity)) {
-        ret_hot = ret_hot_hysteresis;
+    cdev_request_snapshot_ = std::move(cdev_requests);
+    power_status_snapshot_ = std::make_shared<const std::unordered_map<std::string, PowerStatus>>(
+            power_files_.GetPowerStatusMap());
+    {
+        std::lock_guard<std::mutex> _lock(thermal_snapshot_mutex_);
+        emul_settings_snapshot_ = std::make_shared<const std::map<std::string, EmulSetting>>();
     }
-    if (static_cast<size_t>(ret_cold) < static_cast<size_t>(prev_cold_severity)) {
-        ret_cold = ret_cold_hysteresis;
+    publishThermalSnapshot(boot_clock::now(), false);
+}
+
+std::shared_ptr<const SensorSnapshot> makeSensorSnapshot(
+        const SensorSnapshot &prev, const SensorInfo &sensor_info, const Temperature &temp,
+        ThrottlingSeverity severity, boot_clock::time_point now,
+        const ThermalThrottlingStatus *throttling_status) {
+    // A released sensor's throttling status stays cleared, keep sharing it. A model predictive
+    // sensor still plans its cdev requests and predicted peak at NONE, take its live status.
+    std::shared_ptr<const ThermalThrottlingStatus> shared_throttling_status;
+    if (severity == ThrottlingSeverity::NONE && prev.severity == severity &&
+        !isModelPredictiveThrottling(sensor_info)) {
+        shared_throttling_status = prev.throttling_status;
+    } else if (throttling_status != nullptr) {
+        shared_throttling_status =
+                std::make_shared<const ThermalThrottlingStatus>(*throttling_status);
+    }
+    return std::make_shared<const SensorSnapshot>(SensorSnapshot{
+            .name = prev.name,
+            .temp = temp,
+            .severity = severity,
+            .update_time = now,
+            .throttling_status = std::move(shared_throttling_status),
+    });
+}
+
+void ThermalHelperImpl::updateSensorSnapshot(const std::string &sensor_name,
+                                             const Temperature &temp, ThrottlingSeverity severity,
+                                             boot_clock::time_point now) {
+    const auto index_it = sensor_snapshot_index_.find(sensor_name);
+    if (index_it == sensor_snapshot_index_.end()) {
+        return;
+    }
+    auto &sensor_snapshot = sensor_snapshots_[index_it->second];
+    const auto &throttling_status_map = thermal_throttling_.GetThermalThrottlingStatusMap();
+    const auto throttling_status_it = throttling_status_map.find(sensor_name);
+    sensor_snapshot = makeSensorSnapshot(
+            *sensor_snapshot, sensor_info_map_.at(sensor_name), temp, severity, now,
+            throttling_status_it == throttling_status_map.end() ? nullptr
+                                                                : &throttling_status_it->second);
+}
+
+void ThermalHelperImpl::publishThermalSnapshot(boot_clock::time_point now,
+                                               bool power_data_is_updated) {
+    ATRACE_CALL();
+    if (power_data_is_updated) {
+        power_status_snapshot_ =
+                std::make_shared<const std::unordered_map<std::string, PowerStatus>>(
+                        power_files_.GetPowerStatusMap());
+    }
+    auto snapshot = std::make_shared<ThermalSnapshot>(ThermalSnapshot{
+            .pass_count = snapshot_pass_count_++,
+            .pass_time = now,
+            .sensors = sensor_snapshots_,
+            .cdev_requests = cdev_request_snapshot_,
+            .power_status_map = power_status_snapshot_,
+            .emul_settings = nullptr,
+            .polling_stats = polling_scheduler_.GetPollingStats(),
+    });
+
+    std::lock_guard<std::mutex> _lock(thermal_snapshot_mutex_);
+    snapshot->emul_settings = emul_settings_snapshot_;
+    thermal_snapshot_ = std::move(snapshot);
+}
+
+void ThermalHelperImpl::publishEmulSettings() {
+    auto emul_settings = std::make_shared<std::map<std::string, EmulSetting>>();
+    for (const auto &[sensor_name, sensor_status] : sensor_status_map_) {
+        if (sensor_status.override_status.emul_temp == nullptr) {
+            continue;
+        }
+        (*emul_settings)[sensor_name] = {
+                .temp = sensor_status.override_status.emul_temp->temp,
+                .severity = sensor_status.override_status.emul_temp->severity,
+                .max_throttling = sensor_status.override_status.max_throttling,
+        };
     }
 
-    return std::make_pair(ret_hot, ret_cold);
+    std::lock_guard<std::mutex> _lock(thermal_snapshot_mutex_);
+    emul_settings_snapshot_ = emul_settings;
+    if (thermal_snapshot_ != nullptr) {
+        auto snapshot = std::make_shared<ThermalSnapshot>(*thermal_snapshot_);
+        snapshot->emul_settings = std::move(emul_settings);
+        thermal_snapshot_ = std::move(snapshot);
+    }
 }
 
 bool ThermalHelperImpl::isSubSensorValid(std::string_view sensor_data,
@@ -705,14 +877,18 @@ bool ThermalHelperImpl::isSubSensorValid(std::string_view sensor_data,
 void ThermalHelperImpl::clearAllThrottling(void) {
     // Clear the CDEV request
     for (const auto &cdev_info_pair : cooling_device_info_map_) {
-        cooling_devices_.writeCdevFile(cdev_info_pair.first, "0");
+        cdev_writer_.requestState(cdev_info_pair.first, 0);
     }
+    cdev_writer_.flush();
 
     for (auto &sensor_info_pair : sensor_info_map_) {
         sensor_info_pair.second.is_watch = false;
         sensor_info_pair.second.throttling_info.reset();
         sensor_info_pair.second.hot_thresholds.fill(NAN);
         sensor_info_pair.second.cold_thresholds.fill(NAN);
+        sensor_info_pair.second.severity_table = BuildSeverityTable(
+                sensor_info_pair.second.hot_thresholds, sensor_info_pair.second.cold_thresholds,
+                sensor_info_pair.second.hot_hysteresis, sensor_info_pair.second.cold_hysteresis);
         Temperature temp = {
                 .type = sensor_info_pair.second.type,
                 .name = sensor_info_pair.first,
@@ -801,6 +977,7 @@ bool ThermalHelperImpl::initializeCoolingDevices(
         }
 
         // Check if there's any wrong ordered state2power value to avoid cdev stuck issue
+        cooling_device_info_pair.second.state2power_descending = true;
         for (size_t i = 0; i < cooling_device_info_pair.second.state2power.size(); ++i) {
             LOG(INFO) << "Cooling device " << cooling_device_info_pair.first << " state:" << i
                       << " power: " << cooling_device_info_pair.second.state2power[i];
@@ -809,6 +986,11 @@ bool ThermalHelperImpl::initializeCoolingDevices(
                 LOG(ERROR) << "Higher power with higher state on cooling device "
                            << cooling_device_info_pair.first << "'s state" << i;
             }
+            // NaN entries also rule out the binary search
+            if (i > 0 && !(cooling_device_info_pair.second.state2power[i] <=
+                           cooling_device_info_pair.second.state2power[i - 1])) {
+                cooling_device_info_pair.second.state2power_descending = false;
+            }
         }
 
         // Get max cooling device request state
@@ -837,8 +1019,6 @@ bool ThermalHelperImpl::initializeCoolingDevices(
         }
 
         // Add cooling device path for thermalHAL to request state
-        cooling_device_name =
-                ::android::base::StringPrintf("%s_%s", cooling_device_name.c_str(), "w");
         std::string write_path;
         if (!cooling_device_info_pair.second.write_path.empty()) {
             write_path = cooling_device_info_pair.second.write_path.data();
@@ -847,7 +1027,7 @@ bool ThermalHelperImpl::initializeCoolingDevices(
                                                        kCoolingDeviceCurStateSuffix.data());
         }
 
-        if (!cooling_devices_.addThermalFile(cooling_device_name, write_path)) {
+        if (!cdev_writer_.addCdev(cooling_device_name, write_path)) {
             LOG(ERROR) << "Could not add " << cooling_device_name
                        << " write path to cooling device map";
             return false;
@@ -1398,7 +1578,6 @@ std::chrono::milliseconds ThermalHelperImpl::thermalWatcherCallbackFunc(
     std::vector<Temperature> temps;
     std::vector<std::string> cooling_devices_to_update;
     boot_clock::time_point now = boot_clock::now();
-    auto min_sleep_ms = std::chrono::milliseconds::max();
     bool power_data_is_updated = false;
 
     for (const auto &[sensor, temp] : uevent_sensor_map) {
@@ -1407,25 +1586,29 @@ std::chrono::milliseconds ThermalHelperImpl::thermalWatcherCallbackFunc(
             sensor_status_map_[sensor].thermal_cached.temp = temp;
             sensor_status_map_[sensor].thermal_cached.timestamp = now;
         }
+        // Update triggered from genlink or uevent, also for the virtual sensors it triggers
+        polling_scheduler_.scheduleNow(sensor);
+        const auto trigger_it = trigger_sensor_map_.find(sensor);
+        if (trigger_it != trigger_sensor_map_.end()) {
+            for (const auto &virtual_sensor : trigger_it->second) {
+                polling_scheduler_.scheduleNow(virtual_sensor);
+            }
+        }
     }
 
     ATRACE_CALL();
-    // Go through all virtual and physical sensor and update if needed
-    for (auto &name_status_pair : sensor_status_map_) {
-        bool force_update = false;
+    // Go through the virtual and physical sensors which are due for an update
+    polling_scheduler_.collectDueSensors(now, &due_sensors_);
+    for (const auto &sensor_name : due_sensors_) {
         bool force_no_cache = false;
         Temperature temp;
-        SensorStatus &sensor_status = name_status_pair.second;
-        const SensorInfo &sensor_info = sensor_info_map_.at(name_status_pair.first);
+        SensorStatus &sensor_status = sensor_status_map_.at(sensor_name);
+        const SensorInfo &sensor_info = sensor_info_map_.at(sensor_name);
         bool max_throttling = false;
-
-        // Only handle the sensors in allow list
-        if (!sensor_info.is_watch) {
-            continue;
-        }
+        bool trigger_sensor_throttling = false;
 
         ATRACE_NAME(StringPrintf("ThermalHelper::thermalWatcherCallbackFunc - %s",
-                                 name_status_pair.first.data())
+                                 sensor_name.data())
                             .c_str());
 
         std::chrono::milliseconds time_elapsed_ms = std::chrono::milliseconds::zero();
@@ -1440,72 +1623,36 @@ std::chrono::milliseconds ThermalHelperImpl::thermalWatcherCallbackFunc(
                         sensor_status_map_.at(sensor_info.virtual_sensor_info->trigger_sensors[i]);
                 if (trigger_sensor_status.severity != ThrottlingSeverity::NONE) {
                     sleep_ms = sensor_info.passive_delay;
+                    trigger_sensor_throttling = true;
                     break;
                 }
             }
         }
-        // Force update if it's first time we update temperature value after device boot
-        if (sensor_status.last_update_time == boot_clock::time_point::min()) {
-            force_update = true;
 
-        } else {
-            // Handle other update event
+        if (sensor_status.last_update_time != boot_clock::time_point::min()) {
             time_elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
                     now - sensor_status.last_update_time);
-            // Update triggered from genlink or uevent
-            if (uevent_sensor_map.size()) {
-                // Checking virtual sensor
-                if (sensor_info.virtual_sensor_info != nullptr) {
-                    for (size_t i = 0; i < sensor_info.virtual_sensor_info->trigger_sensors.size();
-                         i++) {
-                        if (uevent_sensor_map.find(
-                                    sensor_info.virtual_sensor_info->trigger_sensors[i]) !=
-                            uevent_sensor_map.end()) {
-                            force_update = true;
-                            break;
-                        }
-                    }
-                } else if (uevent_sensor_map.find(name_status_pair.first) !=
-                           uevent_sensor_map.end()) {
-                    // Checking physical sensor
-                    force_update = true;
-                    if (std::isnan(uevent_sensor_map.at(name_status_pair.first))) {
-                        // Handle the case that uevent does not contain temperature
-                        force_no_cache = true;
-                    }
-                }
-            } else if (time_elapsed_ms > sleep_ms) {
-                // Update triggered from normal polling cylce
-                force_update = true;
+        }
+        // Handle the case that uevent does not contain temperature
+        if (sensor_info.virtual_sensor_info == nullptr) {
+            const auto uevent_it = uevent_sensor_map.find(sensor_name);
+            if (uevent_it != uevent_sensor_map.end() && std::isnan(uevent_it->second)) {
+                force_no_cache = true;
             }
         }
         {
             std::lock_guard<std::shared_mutex> _lock(sensor_status_map_mutex_);
             max_throttling = sensor_status.override_status.max_throttling;
-            if (sensor_status.override_status.pending_update) {
-                force_update = sensor_status.override_status.pending_update;
-                sensor_status.override_status.pending_update = false;
-            }
+            sensor_status.override_status.pending_update = false;
         }
-        LOG(VERBOSE) << "sensor " << name_status_pair.first
-                     << ": time_elapsed=" << time_elapsed_ms.count()
-                     << ", sleep_ms=" << sleep_ms.count() << ", force_update = " << force_update
+        LOG(VERBOSE) << "sensor " << sensor_name << ": time_elapsed=" << time_elapsed_ms.count()
+                     << ", sleep_ms=" << sleep_ms.count()
                      << ", force_no_cache = " << force_no_cache;
 
-        if (!force_update) {
-            auto timeout_remaining = sleep_ms - time_elapsed_ms;
-            if (min_sleep_ms > timeout_remaining) {
-                min_sleep_ms = timeout_remaining;
-            }
-            LOG(VERBOSE) << "sensor " << name_status_pair.first
-                         << ": timeout_remaining=" << timeout_remaining.count();
-            continue;
-        }
-
         std::pair<ThrottlingSeverity, ThrottlingSeverity> throttling_status;
-        if (!readTemperature(name_status_pair.first, &temp, force_no_cache)) {
-            LOG(ERROR) << __func__
-                       << ": error reading temperature for sensor: " << name_status_pair.first;
+        if (!readTemperature(sensor_name, &temp, force_no_cache)) {
+            LOG(ERROR) << __func__ << ": error reading temperature for sensor: " << sensor_name;
+            polling_scheduler_.scheduleAfter(sensor_name, now, sleep_ms);
             continue;
         }
 
@@ -1525,19 +1672,24 @@ std::chrono::milliseconds ThermalHelperImpl::thermalWatcherCallbackFunc(
             power_data_is_updated = true;
         }
 
-        if (sensor_status.severity == ThrottlingSeverity::NONE) {
-            thermal_throttling_.clearThrottlingData(name_status_pair.first);
-        } else {
-            // prepare for predictions for throttling compensation
-            std::vector<float> sensor_predictions;
-            if (sensor_info.predictor_info != nullptr &&
-                sensor_info.predictor_info->support_pid_compensation) {
-                if (!readTemperaturePredictions(name_status_pair.first, &sensor_predictions)) {
-                    LOG(ERROR) << "Failed to read predictions of " << name_status_pair.first
-                               << " for throttling compensation";
-                }
+        // prepare for predictions for throttling compensation or planning
+        std::vector<float> sensor_predictions;
+        const bool model_predictive = isModelPredictiveThrottling(sensor_info);
+        if (sensor_info.predictor_info != nullptr &&
+            ((sensor_info.predictor_info->support_pid_compensation &&
+              sensor_status.severity != ThrottlingSeverity::NONE) ||
+             model_predictive)) {
+            if (!readTemperaturePredictions(sensor_name, &sensor_predictions)) {
+                LOG(ERROR) << "Failed to read predictions of " << sensor_name
+                           << " for throttling";
             }
+        }
 
+        // A model predictive sensor keeps planning below its thresholds while it has predictions
+        if (sensor_status.severity == ThrottlingSeverity::NONE &&
+            (!model_predictive || sensor_predictions.empty())) {
+            thermal_throttling_.clearThrottlingData(sensor_name);
+        } else {
             // update thermal throttling request
             thermal_throttling_.thermalThrottlingUpdate(
                     temp, sensor_info, sensor_status.severity, time_elapsed_ms,
@@ -1546,14 +1698,37 @@ std::chrono::milliseconds ThermalHelperImpl::thermalWatcherCallbackFunc(
         }
 
         thermal_throttling_.computeCoolingDevicesRequest(
-                name_status_pair.first, sensor_info, sensor_status.severity,
+                sensor_name, sensor_info, sensor_status.severity,
                 &cooling_devices_to_update, &thermal_stats_helper_);
-        if (min_sleep_ms > sleep_ms) {
-            min_sleep_ms = sleep_ms;
+
+        updateSensorSnapshot(sensor_name, temp, sensor_status.severity, now);
+
+        if (thermal_capture_.isEnabled()) {
+            const auto &throttling_status_map = thermal_throttling_.GetThermalThrottlingStatusMap();
+            const auto throttling_status_it = throttling_status_map.find(sensor_name);
+            thermal_capture_.updateSensor(sensor_name, temp.value, sensor_status.severity,
+                                          throttling_status_it == throttling_status_map.end()
+                                                  ? nullptr
+                                                  : &throttling_status_it->second);
         }
 
-        LOG(VERBOSE) << "Sensor " << name_status_pair.first << ": sleep_ms=" << sleep_ms.count()
-                     << ", min_sleep_ms voting result=" << min_sleep_ms.count();
+        // Virtual sensors triggered by a throttling sensor switch to their passive delay
+        const auto trigger_it = trigger_sensor_map_.find(sensor_name);
+        if (sensor_status.severity != ThrottlingSeverity::NONE &&
+            trigger_it != trigger_sensor_map_.end()) {
+            for (const auto &virtual_sensor : trigger_it->second) {
+                polling_scheduler_.scheduleAfter(
+                        virtual_sensor, now, sensor_info_map_.at(virtual_sensor).passive_delay);
+            }
+        }
+
+        const bool use_adaptive_polling =
+                sensor_status.severity == ThrottlingSeverity::NONE && !trigger_sensor_throttling;
+        sleep_ms = polling_scheduler_.schedulePolled(
+                sensor_name, now, temp.value, sensor_info.hot_thresholds, sleep_ms,
+                use_adaptive_polling ? sensor_info.adaptive_polling_info.get() : nullptr);
+
+        LOG(VERBOSE) << "Sensor " << sensor_name << ": sleep_ms=" << sleep_ms.count();
         sensor_status.last_update_time = now;
     }
 
@@ -1573,9 +1748,9 @@ std::chrono::milliseconds ThermalHelperImpl::thermalWatcherCallbackFunc(
         updateCoolingDevices(cooling_devices_to_update);
     }
 
-    int count_failed_reporting = thermal_stats_helper_.reportStats();
-    if (count_failed_reporting != 0) {
-        LOG(ERROR) << "Failed to report " << count_failed_reporting << " thermal stats";
+    if (!due_sensors_.empty()) {
+        thermal_capture_.commit(now);
+        publishThermalSnapshot(now, power_data_is_updated);
     }
 
     const auto since_last_power_log_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -1584,7 +1759,7 @@ std::chrono::milliseconds ThermalHelperImpl::thermalWatcherCallbackFunc(
         power_files_.logPowerStatus(now);
     }
 
-    return min_sleep_ms;
+    return polling_scheduler_.timeUntilNextDeadline(boot_clock::now());
 }
 
 }  // namespace implementation
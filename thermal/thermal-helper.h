@@ -21,6 +21,7 @@
 #include <array>
 #include <chrono>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <shared_mutex>
 #include <string>
@@ -29,8 +30,12 @@
 #include <unordered_map>
 #include <vector>
 
+#include "utils/cdev_writer.h"
+#include "utils/polling_scheduler.h"
 #include "utils/power_files.h"
 #include "utils/powerhal_helper.h"
+#include "utils/thermal_capture_writer.h"
+#include "utils/thermal_config_cache.h"
 #include "utils/thermal_files.h"
 #include "utils/thermal_info.h"
 #include "utils/thermal_stats_helper.h"
@@ -49,6 +54,8 @@ using NotificationCallback = std::function<void(const Temperature &t)>;
 
 // Get thermal_zone type
 bool getThermalZoneTypeById(int tz_id, std::string *);
+// Get the type of every thermal_zone, keyed by thermal_zone id
+std::unordered_map<int, std::string> getThermalZoneTypeMap();
 
 struct ThermalSample {
     float temp;
@@ -76,6 +83,45 @@ struct SensorStatus {
     OverrideStatus override_status;
 };
 
+struct EmulSetting {
+    float temp;
+    int severity;
+    bool max_throttling;
+};
+
+// State of a sensor as of the watcher pass which last polled it
+struct SensorSnapshot {
+    std::string name;
+    Temperature temp;
+    ThrottlingSeverity severity;
+    // boot_clock::time_point::min() until the sensor is polled
+    boot_clock::time_point update_time;
+    // Null if the sensor has no throttling
+    std::shared_ptr<const ThermalThrottlingStatus> throttling_status;
+};
+
+// Thermal state published by the watcher thread after each pass, for dump() to read without
+// touching the live maps. Sections which did not change in a pass are shared with the previous
+// snapshot.
+struct ThermalSnapshot {
+    uint64_t pass_count;
+    boot_clock::time_point pass_time;
+    // Every sensor, sorted by name
+    std::vector<std::shared_ptr<const SensorSnapshot>> sensors;
+    // Last state requested for each cooling device
+    std::shared_ptr<const std::unordered_map<std::string, int>> cdev_requests;
+    std::shared_ptr<const std::unordered_map<std::string, PowerStatus>> power_status_map;
+    std::shared_ptr<const std::map<std::string, EmulSetting>> emul_settings;
+    PollingStats polling_stats;
+};
+
+// Build the entry of a sensor polled in the current pass. A sensor released in both passes keeps
+// sharing the throttling status of prev, unless it plans its cdevs by prediction also at NONE.
+std::shared_ptr<const SensorSnapshot> makeSensorSnapshot(
+        const SensorSnapshot &prev, const SensorInfo &sensor_info, const Temperature &temp,
+        ThrottlingSeverity severity, boot_clock::time_point now,
+        const ThermalThrottlingStatus *throttling_status);
+
 class ThermalHelper {
   public:
     virtual ~ThermalHelper() = default;
@@ -109,6 +155,8 @@ class ThermalHelper {
     virtual const std::unordered_map<std::string,
                                      std::unordered_map<std::string, ThermalStats<int>>>
     GetSensorCoolingDeviceRequestStatsSnapshot() = 0;
+    virtual PollingStats GetPollingStats() const = 0;
+    virtual std::shared_ptr<const ThermalSnapshot> GetThermalSnapshot() const = 0;
     virtual bool isAidlPowerHalExist() = 0;
     virtual bool isPowerHalConnected() = 0;
     virtual bool isPowerHalExtConnected() = 0;
@@ -187,6 +235,13 @@ class ThermalHelperImpl : public ThermalHelper {
     GetSensorCoolingDeviceRequestStatsSnapshot() override {
         return thermal_stats_helper_.GetSensorCoolingDeviceRequestStatsSnapshot();
     }
+    // Get watcher polling stats
+    PollingStats GetPollingStats() const override { return polling_scheduler_.GetPollingStats(); }
+    // Get the state published by the last watcher pass
+    std::shared_ptr<const ThermalSnapshot> GetThermalSnapshot() const override {
+        std::lock_guard<std::mutex> _lock(thermal_snapshot_mutex_);
+        return thermal_snapshot_;
+    }
 
     bool isAidlPowerHalExist() override { return power_hal_service_.isAidlPowerHalExist(); }
     bool isPowerHalConnected() override { return power_hal_service_.isPowerHalConnected(); }
@@ -203,12 +258,6 @@ class ThermalHelperImpl : public ThermalHelper {
     // For thermal_watcher_'s polling thread, return the sleep interval
     std::chrono::milliseconds thermalWatcherCallbackFunc(
             const std::unordered_map<std::string, float> &uevent_sensor_map);
-    // Return hot and cold severity status as std::pair
-    std::pair<ThrottlingSeverity, ThrottlingSeverity> getSeverityFromThresholds(
-            const ThrottlingArray &hot_thresholds, const ThrottlingArray &cold_thresholds,
-            const ThrottlingArray &hot_hysteresis, const ThrottlingArray &cold_hysteresis,
-            ThrottlingSeverity prev_hot_severity, ThrottlingSeverity prev_cold_severity,
-            float value) const;
     // Read sensor data according to the type
     bool readDataByType(std::string_view sensor_data, float *reading_value,
                         const SensorFusionType type, const bool force_no_cache,
@@ -227,11 +276,22 @@ class ThermalHelperImpl : public ThermalHelper {
             std::unordered_map<std::string, BindedCdevInfo> *binded_cdev_info_map);
     void checkUpdateSensorForEmul(std::string_view target_sensor, const bool max_throttling);
     ThrottlingSeverity getSeverityReference(std::string_view sensor_name);
+    // Publish an initial snapshot with every sensor unpolled
+    void initThermalSnapshot();
+    // Take the state of a sensor polled in the current watcher pass
+    void updateSensorSnapshot(const std::string &sensor_name, const Temperature &temp,
+                              ThrottlingSeverity severity, boot_clock::time_point now);
+    // Publish the state of the current watcher pass
+    void publishThermalSnapshot(boot_clock::time_point now, bool power_data_is_updated);
+    // Publish the emul settings, called with sensor_status_map_mutex_ held
+    void publishEmulSettings();
 
     sp<ThermalWatcher> thermal_watcher_;
     PowerFiles power_files_;
     ThermalFiles thermal_sensors_;
     ThermalFiles cooling_devices_;
+    CdevWriter cdev_writer_;
+    ThermalCapture thermal_capture_;
     ThermalThrottling thermal_throttling_;
     bool is_initialized_;
     const NotificationCallback cb_;
@@ -243,6 +303,21 @@ class ThermalHelperImpl : public ThermalHelper {
     ThermalStatsHelper thermal_stats_helper_;
     mutable std::shared_mutex sensor_status_map_mutex_;
     std::unordered_map<std::string, SensorStatus> sensor_status_map_;
+    PollingScheduler polling_scheduler_;
+    // Maps a trigger sensor to the watched virtual sensors it triggers
+    std::unordered_map<std::string, std::vector<std::string>> trigger_sensor_map_;
+    // Sensors due on the current watcher pass, reused across passes
+    std::vector<std::string> due_sensors_;
+    // Sections of the next snapshot, owned by the watcher thread
+    std::unordered_map<std::string, size_t> sensor_snapshot_index_;
+    std::vector<std::shared_ptr<const SensorSnapshot>> sensor_snapshots_;
+    std::shared_ptr<const std::unordered_map<std::string, int>> cdev_request_snapshot_;
+    std::shared_ptr<const std::unordered_map<std::string, PowerStatus>> power_status_snapshot_;
+    uint64_t snapshot_pass_count_ = 0;
+    // Only held to swap the published pointers
+    mutable std::mutex thermal_snapshot_mutex_;
+    std::shared_ptr<const ThermalSnapshot> thermal_snapshot_;
+    std::shared_ptr<const std::map<std::string, EmulSetting>> emul_settings_snapshot_;
 };
 
 }  // namespace implementation
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define ATRACE_TAG (ATRACE_TAG_THERMAL | ATRACE_TAG_HAL)
+
+#include "cdev_writer.h"
+
+#include <android-base/logging.h>
+#include <android-base/stringprintf.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <utils/Trace.h>
+
+#include <charconv>
+#include <limits>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+namespace {
+
+constexpr int kUnknownState = std::numeric_limits<int>::min();
+
+}  // namespace
+
+bool CdevWriter::addCdev(std::string_view cdev_name, std::string_view write_path) {
+    return cdev_node_map_
+            .try_emplace(std::string(cdev_name),
+                         CdevNode{
+                                 .name = std::string(cdev_name),
+                                 .write_path = std::string(write_path),
+                                 .fd = unique_fd(),
+                                 .last_state = kUnknownState,
+                                 .pending_state = kUnknownState,
+                                 .pending = false,
+                         })
+            .second;
+}
+
+bool CdevWriter::requestState(std::string_view cdev_name, int state) {
+    auto it = cdev_node_map_.find(std::string(cdev_name));
+    if (it == cdev_node_map_.end()) {
+        LOG(ERROR) << "Failed to find cdev " << cdev_name << "'s write path";
+        return false;
+    }
+
+    auto &node = it->second;
+    if (node.pending) {
+        pending_coalesced_++;
+    } else {
+        node.pending = true;
+        pending_nodes_.push_back(&node);
+    }
+    node.pending_state = state;
+    return true;
+}
+
+bool CdevWriter::writeState(CdevNode *node, int state) {
+    if (node->fd.get() < 0) {
+        node->fd.reset(TEMP_FAILURE_RETRY(open(node->write_path.c_str(), O_WRONLY | O_CLOEXEC)));
+        if (node->fd.get() < 0) {
+            PLOG(ERROR) << "Failed to open cdev " << node->name << " at " << node->write_path;
+            return false;
+        }
+    }
+
+    char buf[16];
+    const size_t len = std::to_chars(buf, buf + sizeof(buf), state).ptr - buf;
+    // sysfs takes the whole value from a single write at offset 0
+    if (TEMP_FAILURE_RETRY(pwrite(node->fd.get(), buf, len, 0)) != static_cast<ssize_t>(len)) {
+        PLOG(ERROR) << "Failed to update cdev " << node->name << " sysfs to " << state;
+        // Reopen on the next attempt in case the node went away
+        node->fd.reset();
+        return false;
+    }
+    return true;
+}
+
+size_t CdevWriter::flush() {
+    size_t written = 0, skipped = 0, failed = 0;
+
+    for (auto *node : pending_nodes_) {
+        node->pending = false;
+        if (node->pending_state == node->last_state) {
+            skipped++;
+            continue;
+        }
+
+        if (writeState(node, node->pending_state)) {
+            node->last_state = node->pending_state;
+            ATRACE_INT(node->name.c_str(), node->last_state);
+            LOG(VERBOSE) << "Successfully update cdev " << node->name << " sysfs to "
+                         << node->last_state;
+            written++;
+        } else {
+            // Forget the state so the next request is written even if it matches
+            node->last_state = kUnknownState;
+            failed++;
+        }
+    }
+
+    if (!pending_nodes_.empty()) {
+        ATRACE_NAME(::android::base::StringPrintf("CdevWriter::flush - written=%zu skipped=%zu "
+                                                  "coalesced=%zu failed=%zu",
+                                                  written, skipped, pending_coalesced_, failed)
+                            .c_str());
+    }
+    pending_nodes_.clear();
+    stats_.coalesced += pending_coalesced_;
+    pending_coalesced_ = 0;
+    stats_.written += written;
+    stats_.skipped += skipped;
+    stats_.failed += failed;
+    return failed;
+}
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
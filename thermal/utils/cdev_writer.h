@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/unique_fd.h>
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+using ::android::base::unique_fd;
+
+struct CdevWriteStats {
+    // Requests merged into a later request for the same cooling device in a pass
+    uint64_t coalesced;
+    // Requests dropped because the state was already written
+    uint64_t skipped;
+    uint64_t written;
+    uint64_t failed;
+};
+
+// Writes cooling device states in passes. Requests are queued with requestState() and written
+// by flush(): only the last request for a cooling device in a pass is kept, and it is skipped
+// when it matches the state last written. The write nodes are kept open between passes.
+// Not thread-safe; requests and flushes must come from one thread.
+class CdevWriter {
+  public:
+    CdevWriter() = default;
+    ~CdevWriter() = default;
+    CdevWriter(const CdevWriter &) = delete;
+    void operator=(const CdevWriter &) = delete;
+
+    // Returns true if add was successful, false otherwise.
+    bool addCdev(std::string_view cdev_name, std::string_view write_path);
+    // Queue a state for the next flush(). Returns false for an unknown cooling device.
+    bool requestState(std::string_view cdev_name, int state);
+    // Write the queued states which differ from the last written ones. Returns the number of
+    // cooling devices that failed to update.
+    size_t flush();
+    CdevWriteStats getCdevWriteStats() const { return stats_; }
+
+  private:
+    struct CdevNode {
+        std::string name;
+        std::string write_path;
+        // Opened on first write
+        unique_fd fd;
+        // Unknown until the first successful write
+        int last_state;
+        int pending_state;
+        bool pending;
+    };
+
+    bool writeState(CdevNode *node, int state);
+
+    std::unordered_map<std::string, CdevNode> cdev_node_map_;
+    // Cooling devices with a queued state, in request order
+    std::vector<CdevNode *> pending_nodes_;
+    // Requests merged since the last flush
+    size_t pending_coalesced_ = 0;
+    CdevWriteStats stats_{};
+};
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "polling_scheduler.h"
+
+#include <android-base/logging.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+namespace {
+
+// Add a delay to a time point, saturating at time_point::max() for "never".
+boot_clock::time_point AddDelay(boot_clock::time_point now, std::chrono::milliseconds delay) {
+    if (delay == std::chrono::milliseconds::max() ||
+        delay >= std::chrono::duration_cast<std::chrono::milliseconds>(
+                         boot_clock::time_point::max() - now)) {
+        return boot_clock::time_point::max();
+    }
+    return now + delay;
+}
+
+float FirstHotThreshold(const ThrottlingArray &hot_thresholds) {
+    for (size_t i = static_cast<size_t>(ThrottlingSeverity::LIGHT); i < kThrottlingSeverityCount;
+         ++i) {
+        if (!std::isnan(hot_thresholds[i])) {
+            return hot_thresholds[i];
+        }
+    }
+    return NAN;
+}
+
+}  // namespace
+
+std::chrono::milliseconds ComputeAdaptivePollingDelay(const AdaptivePollingInfo &info,
+                                                      std::chrono::milliseconds polling_delay,
+                                                      float hot_threshold, float value,
+                                                      float trend_per_ms) {
+    // Without a hot threshold the sensor can never escalate
+    if (std::isnan(hot_threshold)) {
+        return info.max_polling_delay;
+    }
+
+    const float headroom = hot_threshold - value;
+    if (std::isnan(headroom) || headroom <= 0) {
+        return polling_delay;
+    }
+
+    const float ratio = std::min(headroom / info.headroom, 1.0f);
+    float delay_ms = polling_delay.count() +
+                     (info.max_polling_delay - polling_delay).count() * ratio;
+    // Poll at least twice before a rising trend could cross the threshold
+    if (trend_per_ms > 0) {
+        delay_ms = std::min(delay_ms, headroom / trend_per_ms / 2);
+    }
+
+    return std::clamp(std::chrono::milliseconds(static_cast<int64_t>(delay_ms)), polling_delay,
+                      info.max_polling_delay);
+}
+
+void PollingScheduler::registerSensor(std::string_view sensor_name) {
+    std::lock_guard<std::mutex> _lock(mutex_);
+    if (sensor_index_map_.count(std::string(sensor_name))) {
+        return;
+    }
+
+    const size_t index = sensors_.size();
+    sensors_.push_back({
+            .name = std::string(sensor_name),
+            .deadline = boot_clock::time_point::max(),
+            .generation = 0,
+            .last_value = NAN,
+            .last_poll_time = boot_clock::time_point::min(),
+    });
+    sensor_index_map_[sensors_.back().name] = index;
+    pushLocked(index, boot_clock::time_point::min());
+}
+
+void PollingScheduler::pushLocked(size_t index, boot_clock::time_point deadline) {
+    auto &sensor = sensors_[index];
+    sensor.deadline = deadline;
+    sensor.generation++;
+    if (deadline != boot_clock::time_point::max()) {
+        heap_.push({deadline, sensor.generation, index});
+    }
+}
+
+void PollingScheduler::dropStaleLocked() {
+    while (!heap_.empty() && heap_.top().generation != sensors_[heap_.top().index].generation) {
+        heap_.pop();
+    }
+}
+
+void PollingScheduler::scheduleNoLaterThan(std::string_view sensor_name,
+                                           boot_clock::time_point deadline) {
+    std::lock_guard<std::mutex> _lock(mutex_);
+    auto it = sensor_index_map_.find(std::string(sensor_name));
+    if (it == sensor_index_map_.end()) {
+        return;
+    }
+    if (deadline < sensors_[it->second].deadline) {
+        pushLocked(it->second, deadline);
+    }
+}
+
+void PollingScheduler::scheduleAfter(std::string_view sensor_name, boot_clock::time_point now,
+                                     std::chrono::milliseconds delay) {
+    scheduleNoLaterThan(sensor_name, AddDelay(now, delay));
+}
+
+void PollingScheduler::collectDueSensors(boot_clock::time_point now,
+                                         std::vector<std::string> *due_sensors) {
+    std::lock_guard<std::mutex> _lock(mutex_);
+    due_sensors->clear();
+    for (dropStaleLocked(); !heap_.empty() && heap_.top().deadline <= now; dropStaleLocked()) {
+        auto &sensor = sensors_[heap_.top().index];
+        heap_.pop();
+        // Not due again until the caller reports the poll
+        sensor.deadline = boot_clock::time_point::max();
+        sensor.generation++;
+        due_sensors->push_back(sensor.name);
+    }
+
+    stats_.wakeups++;
+    stats_.sensors_deferred += sensors_.size() - due_sensors->size();
+}
+
+std::chrono::milliseconds PollingScheduler::schedulePolled(
+        std::string_view sensor_name, boot_clock::time_point now, float value,
+        const ThrottlingArray &hot_thresholds, std::chrono::milliseconds base_delay,
+        const AdaptivePollingInfo *adaptive_polling_info) {
+    std::lock_guard<std::mutex> _lock(mutex_);
+    auto it = sensor_index_map_.find(std::string(sensor_name));
+    if (it == sensor_index_map_.end()) {
+        return base_delay;
+    }
+
+    auto &sensor = sensors_[it->second];
+    auto delay = base_delay;
+    if (adaptive_polling_info != nullptr && base_delay != std::chrono::milliseconds::max()) {
+        float trend_per_ms = 0;
+        const auto elapsed_ms =
+                std::chrono::duration_cast<std::chrono::milliseconds>(now - sensor.last_poll_time);
+        if (sensor.last_poll_time != boot_clock::time_point::min() && elapsed_ms.count() > 0 &&
+            !std::isnan(sensor.last_value)) {
+            trend_per_ms = (value - sensor.last_value) / elapsed_ms.count();
+        }
+        delay = ComputeAdaptivePollingDelay(*adaptive_polling_info, base_delay,
+                                            FirstHotThreshold(hot_thresholds), value,
+                                            trend_per_ms);
+        if (delay > base_delay && base_delay.count() > 0) {
+            stats_.adaptive_polls_saved += delay / base_delay - 1;
+        }
+        LOG(VERBOSE) << "Sensor " << sensor_name << ": adaptive polling delay "
+                     << delay.count() << " trend " << trend_per_ms;
+    }
+
+    sensor.last_value = value;
+    sensor.last_poll_time = now;
+    stats_.sensors_polled++;
+    // A reschedule requested while the sensor was being polled still wins
+    const auto deadline = AddDelay(now, delay);
+    if (deadline < sensor.deadline) {
+        pushLocked(it->second, deadline);
+    }
+    return delay;
+}
+
+std::chrono::milliseconds PollingScheduler::timeUntilNextDeadline(boot_clock::time_point now) {
+    std::lock_guard<std::mutex> _lock(mutex_);
+    dropStaleLocked();
+    if (heap_.empty()) {
+        return std::chrono::milliseconds::max();
+    }
+    const auto deadline = heap_.top().deadline;
+    if (deadline <= now) {
+        return std::chrono::milliseconds::zero();
+    }
+    return std::chrono::ceil<std::chrono::milliseconds>(deadline - now);
+}
+
+PollingStats PollingScheduler::GetPollingStats() const {
+    std::lock_guard<std::mutex> _lock(mutex_);
+    return stats_;
+}
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
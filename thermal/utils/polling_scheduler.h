@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/chrono_utils.h>
+
+#include <chrono>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "thermal_info.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+using ::android::base::boot_clock;
+
+struct PollingStats {
+    // Number of watcher callback passes
+    uint64_t wakeups;
+    // Number of sensors updated across all passes
+    uint64_t sensors_polled;
+    // Sensors a full scan would have visited on a pass but that were not due
+    uint64_t sensors_deferred;
+    // Polls at the base PollingDelay avoided by adaptive polling
+    uint64_t adaptive_polls_saved;
+};
+
+// Tracks the next poll deadline of each watched sensor in a min-heap so a watcher pass only
+// handles the sensors that are due. Thread-safe: deadlines can be pulled in from binder threads
+// while the watcher thread collects due sensors.
+class PollingScheduler {
+  public:
+    PollingScheduler() = default;
+    ~PollingScheduler() = default;
+    PollingScheduler(const PollingScheduler &) = delete;
+    void operator=(const PollingScheduler &) = delete;
+
+    // Add a sensor to the schedule; it is due immediately.
+    void registerSensor(std::string_view sensor_name);
+    // Make the sensor due no later than the given deadline.
+    void scheduleNoLaterThan(std::string_view sensor_name, boot_clock::time_point deadline);
+    // Make the sensor due on the next pass.
+    void scheduleNow(std::string_view sensor_name) {
+        scheduleNoLaterThan(sensor_name, boot_clock::time_point::min());
+    }
+    // Make the sensor due no later than delay after now.
+    void scheduleAfter(std::string_view sensor_name, boot_clock::time_point now,
+                       std::chrono::milliseconds delay);
+    // Pop every sensor whose deadline is at or before now, in deadline order. Counts as one
+    // watcher pass in the stats. Each popped sensor stays unscheduled until schedulePolled() or
+    // scheduleAfter() is called for it.
+    void collectDueSensors(boot_clock::time_point now, std::vector<std::string> *due_sensors);
+    // Record a completed poll and schedule the next one. adaptive_polling_info may be nullptr,
+    // in which case the sensor is polled again after base_delay. Returns the delay used.
+    std::chrono::milliseconds schedulePolled(std::string_view sensor_name,
+                                             boot_clock::time_point now, float value,
+                                             const ThrottlingArray &hot_thresholds,
+                                             std::chrono::milliseconds base_delay,
+                                             const AdaptivePollingInfo *adaptive_polling_info);
+    // Time until the earliest deadline, or milliseconds::max() if nothing is scheduled.
+    std::chrono::milliseconds timeUntilNextDeadline(boot_clock::time_point now);
+    PollingStats GetPollingStats() const;
+
+  private:
+    struct SensorSchedule {
+        std::string name;
+        boot_clock::time_point deadline;
+        // Bumped on every reschedule so superseded heap entries can be dropped lazily
+        uint64_t generation;
+        float last_value;
+        boot_clock::time_point last_poll_time;
+    };
+    struct HeapEntry {
+        boot_clock::time_point deadline;
+        uint64_t generation;
+        size_t index;
+        bool operator>(const HeapEntry &other) const { return deadline > other.deadline; }
+    };
+
+    void pushLocked(size_t index, boot_clock::time_point deadline);
+    void dropStaleLocked();
+
+    mutable std::mutex mutex_;
+    std::vector<SensorSchedule> sensors_;
+    std::unordered_map<std::string, size_t> sensor_index_map_;
+    std::priority_queue<HeapEntry, std::vector<HeapEntry>, std::greater<HeapEntry>> heap_;
+    PollingStats stats_{};
+};
+
+// Compute the polling delay of a sensor at NONE severity. The delay stretches linearly from
+// polling_delay to max_polling_delay as the headroom to the first hot threshold grows, and is
+// capped at half the time the current rising trend needs to reach that threshold.
+std::chrono::milliseconds ComputeAdaptivePollingDelay(const AdaptivePollingInfo &info,
+                                                      std::chrono::milliseconds polling_delay,
+                                                      float hot_threshold, float value,
+                                                      float trend_per_ms);
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -23,7 +23,6 @@
 #include <android-base/logging.h>
 #include <android-base/stringprintf.h>
 #include <android-base/strings.h>
-#include <dirent.h>
 #include <utils/Trace.h>
 
 namespace aidl {
@@ -32,11 +31,6 @@ namespace hardware {
 namespace thermal {
 namespace implementation {
 
-constexpr std::string_view kDeviceType("iio:device");
-constexpr std::string_view kIioRootDir("/sys/bus/iio/devices");
-constexpr std::string_view kEnergyValueNode("energy_value");
-
-using ::android::base::ReadFileToString;
 using ::android::base::StringPrintf;
 
 namespace {
@@ -81,53 +75,47 @@ bool PowerFiles::registerPowerRailsToWatch(const Json::Value &config) {
         return false;
     }
 
-    if (!energy_info_map_.size() && !updateEnergyValues()) {
+    // findEnergySourceToWatch() only sizes energy_samples_, read the counters so that the power
+    // history starts from the current energy rather than from zero
+    if (!updateEnergyValues()) {
         LOG(ERROR) << "Faield to update energy info";
         return false;
     }
 
     for (const auto &power_rail_info_pair : power_rail_info_map_) {
-        std::vector<std::queue<PowerSample>> power_history;
+        std::vector<PowerHistory> power_history;
+        std::vector<size_t> energy_rail_index;
         if (!power_rail_info_pair.second.power_sample_count ||
             power_rail_info_pair.second.power_sample_delay == std::chrono::milliseconds::max()) {
             continue;
         }
 
+        std::vector<std::string> linked_power_rails;
         if (power_rail_info_pair.second.virtual_power_rail_info != nullptr &&
             power_rail_info_pair.second.virtual_power_rail_info->linked_power_rails.size()) {
-            for (size_t i = 0;
-                 i < power_rail_info_pair.second.virtual_power_rail_info->linked_power_rails.size();
-                 ++i) {
-                std::string power_rail =
-                        power_rail_info_pair.second.virtual_power_rail_info->linked_power_rails[i];
-                if (!energy_info_map_.count(power_rail)) {
-                    LOG(ERROR) << " Could not find energy source " << power_rail;
-                    return false;
-                }
-
-                const auto curr_sample = energy_info_map_.at(power_rail);
-                power_history.emplace_back(std::queue<PowerSample>());
-                for (int j = 0; j < power_rail_info_pair.second.power_sample_count; j++) {
-                    power_history[i].emplace(curr_sample);
-                }
-            }
+            linked_power_rails =
+                    power_rail_info_pair.second.virtual_power_rail_info->linked_power_rails;
         } else {
-            if (energy_info_map_.count(power_rail_info_pair.first)) {
-                const auto curr_sample = energy_info_map_.at(power_rail_info_pair.first);
-                power_history.emplace_back(std::queue<PowerSample>());
-                for (int j = 0; j < power_rail_info_pair.second.power_sample_count; j++) {
-                    power_history[0].emplace(curr_sample);
-                }
-            } else {
-                LOG(ERROR) << "Could not find energy source " << power_rail_info_pair.first;
+            linked_power_rails.emplace_back(power_rail_info_pair.first);
+        }
+
+        for (const auto &power_rail : linked_power_rails) {
+            const auto rail_id = OdpmSampler::getInstance().getRailId(power_rail);
+            if (rail_id < 0) {
+                LOG(ERROR) << "Could not find energy source " << power_rail;
                 return false;
             }
+            const auto index = static_cast<size_t>(rail_id);
+            energy_rail_index.emplace_back(index);
+            power_history.emplace_back(power_rail_info_pair.second.power_sample_count,
+                                       energy_samples_[index]);
         }
 
         if (power_history.size()) {
             power_status_map_[power_rail_info_pair.first] = {
                     .last_update_time = boot_clock::time_point::min(),
-                    .power_history = power_history,
+                    .power_history = std::move(power_history),
+                    .energy_rail_index = std::move(energy_rail_index),
                     .last_updated_avg_power = NAN,
             };
         } else {
@@ -138,158 +126,98 @@ bool PowerFiles::registerPowerRailsToWatch(const Json::Value &config) {
     }
 
     power_status_log_ = {.prev_log_time = boot_clock::now(),
-                         .prev_energy_info_map = energy_info_map_};
+                         .prev_energy_samples = energy_samples_};
     return true;
 }
 
 bool PowerFiles::findEnergySourceToWatch(void) {
-    std::string devicePath;
-
-    if (energy_path_set_.size()) {
+    if (energy_rail_names_.size()) {
         return true;
     }
 
-    std::unique_ptr<DIR, decltype(&closedir)> dir(opendir(kIioRootDir.data()), closedir);
-    if (!dir) {
-        PLOG(ERROR) << "Error opening directory" << kIioRootDir;
-        return false;
-    }
-
     // Find any iio:devices that support energy_value
-    while (struct dirent *ent = readdir(dir.get())) {
-        std::string devTypeDir = ent->d_name;
-        if (devTypeDir.find(kDeviceType) != std::string::npos) {
-            devicePath = StringPrintf("%s/%s", kIioRootDir.data(), devTypeDir.data());
-            std::string deviceEnergyContent;
-
-            if (!ReadFileToString(StringPrintf("%s/%s", devicePath.data(), kEnergyValueNode.data()),
-                                  &deviceEnergyContent)) {
-            } else if (deviceEnergyContent.size()) {
-                energy_path_set_.emplace(
-                        StringPrintf("%s/%s", devicePath.data(), kEnergyValueNode.data()));
-            }
-        }
-    }
-
-    if (!energy_path_set_.size()) {
+    auto &odpm_sampler = OdpmSampler::getInstance();
+    if (!odpm_sampler.registerDevices({})) {
         return false;
     }
 
-    return true;
+    for (const auto &rail : odpm_sampler.getRails({})) {
+        energy_rail_names_.emplace_back(rail.name);
+    }
+    energy_samples_.assign(energy_rail_names_.size(), {.energy_counter = 0, .duration = 0});
+    return !energy_rail_names_.empty();
 }
 
 bool PowerFiles::updateEnergyValues(void) {
-    std::string deviceEnergyContent;
-    std::string deviceEnergyContents;
-    std::string line;
-
     ATRACE_CALL();
-    for (const auto &path : energy_path_set_) {
-        if (!::android::base::ReadFileToString(path, &deviceEnergyContent)) {
-            LOG(ERROR) << "Failed to read energy content from " << path;
-            return false;
-        } else {
-            deviceEnergyContents.append(deviceEnergyContent);
-        }
+    if (!OdpmSampler::getInstance().sample(&odpm_samples_)) {
+        LOG(ERROR) << "Failed to sample ODPM energy values";
+        return false;
     }
 
-    std::istringstream energyData(deviceEnergyContents);
-
-    while (std::getline(energyData, line)) {
-        /* Read rail energy */
-        uint64_t energy_counter = 0;
-        uint64_t duration = 0;
-
-        /* Format example: CH3(T=358356)[S2M_VDD_CPUCL2], 761330 */
-        auto start_pos = line.find("T=");
-        auto end_pos = line.find(')');
-        if (start_pos != std::string::npos) {
-            duration =
-                    strtoul(line.substr(start_pos + 2, end_pos - start_pos - 2).c_str(), NULL, 10);
-        } else {
+    for (const auto &odpm_sample : odpm_samples_) {
+        if (odpm_sample.rail_id < 0 ||
+            static_cast<size_t>(odpm_sample.rail_id) >= energy_samples_.size()) {
             continue;
         }
-
-        start_pos = line.find(")[");
-        end_pos = line.find(']');
-        std::string railName;
-        if (start_pos != std::string::npos) {
-            railName = line.substr(start_pos + 2, end_pos - start_pos - 2);
-        } else {
-            continue;
-        }
-
-        start_pos = line.find("],");
-        if (start_pos != std::string::npos) {
-            energy_counter = strtoul(line.substr(start_pos + 2).c_str(), NULL, 10);
-        } else {
-            continue;
-        }
-
-        energy_info_map_[railName] = {
-                .energy_counter = energy_counter,
-                .duration = duration,
+        energy_samples_[odpm_sample.rail_id] = {
+                .energy_counter = odpm_sample.energy_uws,
+                .duration = odpm_sample.duration_ms,
         };
     }
 
     return true;
 }
 
-float PowerFiles::updateAveragePower(std::string_view power_rail,
-                                     std::queue<PowerSample> *power_history) {
+float PowerFiles::updateAveragePower(size_t energy_rail_index, PowerHistory *power_history) {
     float avg_power = NAN;
-    if (!energy_info_map_.count(power_rail.data())) {
-        LOG(ERROR) << " Could not find power rail " << power_rail.data();
+    if (energy_rail_index >= energy_samples_.size()) {
+        LOG(ERROR) << " Could not find energy rail index " << energy_rail_index;
         return avg_power;
     }
-    const auto last_sample = power_history->front();
-    const auto curr_sample = energy_info_map_.at(power_rail.data());
-    if (calculateAvgPower(power_rail, last_sample, curr_sample, &avg_power)) {
-        power_history->pop();
+    const auto &last_sample = power_history->front();
+    const auto &curr_sample = energy_samples_[energy_rail_index];
+    if (calculateAvgPower(energy_rail_names_[energy_rail_index], last_sample, curr_sample,
+                          &avg_power)) {
         power_history->push(curr_sample);
     }
     return avg_power;
 }
 
-float PowerFiles::updatePowerRail(std::string_view power_rail) {
+float PowerFiles::updatePowerRail(std::string_view power_rail, PowerStatus *power_status) {
     float avg_power = NAN;
 
     if (!power_rail_info_map_.count(power_rail.data())) {
         return avg_power;
     }
 
-    if (!power_status_map_.count(power_rail.data())) {
-        return avg_power;
-    }
-
     const auto &power_rail_info = power_rail_info_map_.at(power_rail.data());
-    auto &power_status = power_status_map_.at(power_rail.data());
 
     boot_clock::time_point now = boot_clock::now();
     auto time_elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-            now - power_status.last_update_time);
+            now - power_status->last_update_time);
 
-    if (power_status.last_update_time != boot_clock::time_point::min() &&
+    if (power_status->last_update_time != boot_clock::time_point::min() &&
         time_elapsed_ms < power_rail_info.power_sample_delay) {
-        return power_status.last_updated_avg_power;
+        return power_status->last_updated_avg_power;
     }
 
-    if (!energy_info_map_.size() && !updateEnergyValues()) {
+    if (!energy_samples_.size() && !updateEnergyValues()) {
         LOG(ERROR) << "Failed to update energy values";
         return avg_power;
     }
 
     if (power_rail_info.virtual_power_rail_info == nullptr) {
-        avg_power = updateAveragePower(power_rail, &power_status.power_history[0]);
+        avg_power = updateAveragePower(power_status->energy_rail_index[0],
+                                       &power_status->power_history[0]);
     } else {
         const auto offset = power_rail_info.virtual_power_rail_info->offset;
         float avg_power_val = 0.0;
         for (size_t i = 0; i < power_rail_info.virtual_power_rail_info->linked_power_rails.size();
              i++) {
             float coefficient = power_rail_info.virtual_power_rail_info->coefficients[i];
-            float avg_power_number = updateAveragePower(
-                    power_rail_info.virtual_power_rail_info->linked_power_rails[i],
-                    &power_status.power_history[i]);
+            float avg_power_number = updateAveragePower(power_status->energy_rail_index[i],
+                                                        &power_status->power_history[i]);
 
             switch (power_rail_info.virtual_power_rail_info->formula) {
                 case FormulaOption::COUNT_THRESHOLD:
@@ -327,8 +255,8 @@ float PowerFiles::updatePowerRail(std::string_view power_rail) {
         avg_power = NAN;
     }
 
-    power_status.last_updated_avg_power = avg_power;
-    power_status.last_update_time = now;
+    power_status->last_updated_avg_power = avg_power;
+    power_status->last_update_time = now;
     return avg_power;
 }
 
@@ -338,8 +266,8 @@ bool PowerFiles::refreshPowerStatus(void) {
         return false;
     }
 
-    for (const auto &power_status_pair : power_status_map_) {
-        updatePowerRail(power_status_pair.first);
+    for (auto &power_status_pair : power_status_map_) {
+        updatePowerRail(power_status_pair.first, &power_status_pair.second);
     }
     return true;
 }
@@ -350,13 +278,13 @@ void PowerFiles::logPowerStatus(const boot_clock::time_point &now) {
     uint64_t max_duration = 0;
     float tot_power = 0.0;
     std::string out;
-    for (const auto &energy_info_pair : energy_info_map_) {
-        const auto &rail = energy_info_pair.first;
-        if (!power_status_log_.prev_energy_info_map.count(rail)) {
+    for (size_t i = 0; i < energy_samples_.size(); ++i) {
+        const auto &rail = energy_rail_names_[i];
+        if (i >= power_status_log_.prev_energy_samples.size()) {
             continue;
         }
-        const auto &last_sample = power_status_log_.prev_energy_info_map.at(rail);
-        const auto &curr_sample = energy_info_pair.second;
+        const auto &last_sample = power_status_log_.prev_energy_samples[i];
+        const auto &curr_sample = energy_samples_[i];
         float avg_power = NAN;
         if (calculateAvgPower(rail, last_sample, curr_sample, &avg_power) &&
             !std::isnan(avg_power)) {
@@ -379,7 +307,8 @@ void PowerFiles::logPowerStatus(const boot_clock::time_point &now) {
                                   max_duration);
         LOG(INFO) << out;
     }
-    power_status_log_ = {.prev_log_time = now, .prev_energy_info_map = energy_info_map_};
+    power_status_log_.prev_log_time = now;
+    power_status_log_.prev_energy_samples = energy_samples_;
 }
 
 }  // namespace implementation
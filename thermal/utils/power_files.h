@@ -17,13 +17,14 @@
 #pragma once
 
 #include <android-base/chrono_utils.h>
+#include <odpm/OdpmSampler.h>
 
 #include <chrono>
-#include <queue>
 #include <shared_mutex>
 #include <string>
+#include <string_view>
 #include <unordered_map>
-#include <unordered_set>
+#include <vector>
 
 #include "thermal_info.h"
 
@@ -34,23 +35,52 @@ namespace thermal {
 namespace implementation {
 
 using ::android::base::boot_clock;
+using ::android::hardware::google::pixel::OdpmSample;
+using ::android::hardware::google::pixel::OdpmSampler;
 
 struct PowerSample {
     uint64_t energy_counter;
     uint64_t duration;
 };
 
+// A fixed-capacity ring buffer of power samples. The storage is allocated once at
+// registration and every update overwrites the oldest sample in place.
+class PowerHistory {
+  public:
+    PowerHistory() = default;
+    PowerHistory(size_t capacity, const PowerSample &init_sample)
+        : samples_(capacity, init_sample), head_(0) {}
+    size_t size() const { return samples_.size(); }
+    // Get the oldest sample
+    const PowerSample &front() const { return samples_[head_]; }
+    // Replace the oldest sample with the newest one
+    void push(const PowerSample &sample) {
+        samples_[head_] = sample;
+        head_ = (head_ + 1) % samples_.size();
+    }
+    // Get the i-th sample counted from the oldest one
+    const PowerSample &operator[](size_t i) const {
+        return samples_[(head_ + i) % samples_.size()];
+    }
+
+  private:
+    std::vector<PowerSample> samples_;
+    size_t head_ = 0;
+};
+
 struct PowerStatus {
     boot_clock::time_point last_update_time;
-    // A vector to record the queues of power sample history.
-    std::vector<std::queue<PowerSample>> power_history;
+    // A vector to record the ring buffers of power sample history.
+    std::vector<PowerHistory> power_history;
+    // The energy rail index of each power history, resolved at registration.
+    std::vector<size_t> energy_rail_index;
     float last_updated_avg_power;
 };
 
 struct PowerStatusLog {
     boot_clock::time_point prev_log_time;
-    // energy sample at last logging
-    std::unordered_map<std::string, PowerSample> prev_energy_info_map;
+    // energy sample at last logging, indexed by energy rail index
+    std::vector<PowerSample> prev_energy_samples;
 };
 
 // A helper class for monitoring power rails.
@@ -81,23 +111,25 @@ class PowerFiles {
     }
 
   private:
-    // Update energy value to energy_info_map_, return false if the value is failed to update.
+    // Update energy value to energy_samples_, return false if the value is failed to update.
     bool updateEnergyValues(void);
     // Compute the average power for physical power rail.
-    float updateAveragePower(std::string_view power_rail, std::queue<PowerSample> *power_history);
+    float updateAveragePower(size_t energy_rail_index, PowerHistory *power_history);
     // Update the power data for the target power rail.
-    float updatePowerRail(std::string_view power_rail);
+    float updatePowerRail(std::string_view power_rail, PowerStatus *power_status);
     // Find the energy source path, return false if no energy source found.
     bool findEnergySourceToWatch(void);
-    // The map to record the energy counter for each power rail.
-    std::unordered_map<std::string, PowerSample> energy_info_map_;
+    // The energy counter for each energy rail, indexed by energy rail index.
+    std::vector<PowerSample> energy_samples_;
+    // The energy rail name for each energy rail index, i.e. the ODPM rail id.
+    std::vector<std::string> energy_rail_names_;
     // The map to record the power data for each thermal sensor.
     std::unordered_map<std::string, PowerStatus> power_status_map_;
     mutable std::shared_mutex power_status_map_mutex_;
     // The map to record the power rail information from thermal config
     std::unordered_map<std::string, PowerRailInfo> power_rail_info_map_;
-    // The set to store the energy source paths
-    std::unordered_set<std::string> energy_path_set_;
+    // The ODPM samples shared with other energy consumers, indexed by energy rail index.
+    std::vector<OdpmSample> odpm_samples_;
     PowerStatusLog power_status_log_;
 };
 
@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "stats_atom_reporter.h"
+
+#include <android-base/logging.h>
+
+#include <algorithm>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+StatsAtomReporter::StatsAtomReporter(StatsClientGetter stats_client_getter,
+                                     StatsReportingPolicy policy)
+    : stats_client_getter_(std::move(stats_client_getter)),
+      policy_(policy),
+      backoff_(policy.initial_backoff) {}
+
+StatsAtomReporter::~StatsAtomReporter() {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        aborted_ = true;
+    }
+    cv_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void StatsAtomReporter::start(PeriodicCollector periodic_collector) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (thread_.joinable()) {
+        LOG(ERROR) << "Stats atom reporter already started";
+        return;
+    }
+    periodic_collector_ = std::move(periodic_collector);
+    next_report_time_ = boot_clock::now() + policy_.report_interval;
+    thread_ = std::thread([this] { loop(); });
+}
+
+bool StatsAtomReporter::enqueue(PendingAtom &&pending_atom) {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (queue_.size() >= policy_.max_queued_atoms) {
+            return false;
+        }
+        queue_.push_back(std::move(pending_atom));
+    }
+    cv_.notify_one();
+    return true;
+}
+
+void StatsAtomReporter::requestReport() {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        report_requested_ = true;
+    }
+    cv_.notify_one();
+}
+
+void StatsAtomReporter::loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!aborted_) {
+        const auto wake_time = retry_queue_.empty() ? next_report_time_
+                                                    : std::min(next_report_time_, retry_time_);
+        // New atoms wait for the batch being retried instead of cutting its backoff short
+        cv_.wait_until(lock, wake_time, [&] {
+            return aborted_ || report_requested_ ||
+                   (retry_queue_.empty() ? !queue_.empty()
+                                         : boot_clock::now() >= retry_time_);
+        });
+        if (aborted_) {
+            break;
+        }
+
+        const auto now = boot_clock::now();
+        const bool report_due = report_requested_ || now >= next_report_time_;
+        if (!report_due && !retry_queue_.empty() && now < retry_time_) {
+            continue;
+        }
+        if (report_due) {
+            report_requested_ = false;
+            next_report_time_ = now + policy_.report_interval;
+        }
+        std::deque<PendingAtom> batch;
+        batch.swap(retry_queue_);
+        std::move(queue_.begin(), queue_.end(), std::back_inserter(batch));
+        queue_.clear();
+        lock.unlock();
+
+        if (report_due && periodic_collector_) {
+            auto periodic_atoms = periodic_collector_();
+            std::move(periodic_atoms.begin(), periodic_atoms.end(), std::back_inserter(batch));
+        }
+        auto retry_atoms = sendBatch(std::move(batch));
+
+        lock.lock();
+        retry_queue_ = std::move(retry_atoms);
+        if (retry_queue_.empty()) {
+            backoff_ = policy_.initial_backoff;
+        } else {
+            retry_time_ = boot_clock::now() + backoff_;
+            LOG(ERROR) << "Failed to report " << retry_queue_.size()
+                       << " thermal stats atoms, retry in " << backoff_.count() << "ms";
+            backoff_ = std::min(backoff_ * 2, policy_.max_backoff);
+        }
+    }
+}
+
+std::deque<PendingAtom> StatsAtomReporter::sendBatch(std::deque<PendingAtom> batch) {
+    if (batch.empty()) {
+        return {};
+    }
+    const std::shared_ptr<IStats> stats_client = stats_client_getter_();
+    if (!stats_client) {
+        LOG(ERROR) << "Unable to get AIDL Stats service";
+    }
+    while (!batch.empty()) {
+        auto &pending_atom = batch.front();
+        LOG(VERBOSE) << "Reporting thermal stats for atom_id " << pending_atom.atom.atomId;
+        if (!stats_client || !stats_client->reportVendorAtom(pending_atom.atom).isOk()) {
+            // The service is likely unavailable, keep the rest of the batch for the retry
+            if (++pending_atom.attempts < policy_.max_attempts) {
+                break;
+            }
+            LOG(ERROR) << "Dropping thermal stats atom " << pending_atom.atom.atomId << " after "
+                       << pending_atom.attempts << " attempts";
+            if (pending_atom.on_done) {
+                pending_atom.on_done(false);
+            }
+        } else if (pending_atom.on_done) {
+            pending_atom.on_done(true);
+        }
+        batch.pop_front();
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (aborted_) {
+                return {};
+            }
+        }
+    }
+    return batch;
+}
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
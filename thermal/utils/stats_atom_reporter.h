@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <aidl/android/frameworks/stats/IStats.h>
+#include <android-base/chrono_utils.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+using aidl::android::frameworks::stats::IStats;
+using aidl::android::frameworks::stats::VendorAtom;
+using ::android::base::boot_clock;
+using namespace std::chrono_literals;
+
+using StatsClientGetter = std::function<std::shared_ptr<IStats>()>;
+
+struct StatsReportingPolicy {
+    // How often the periodic atoms are collected
+    std::chrono::milliseconds report_interval = 24h;
+    // Delay before the first retry of a failed batch, doubled on every failure
+    std::chrono::milliseconds initial_backoff = 1s;
+    std::chrono::milliseconds max_backoff = 5min;
+    // Attempts for an atom before it is given up
+    int max_attempts = 5;
+    // Bound on the atoms queued through enqueue(), periodic atoms are always taken
+    size_t max_queued_atoms = 64;
+};
+
+struct PendingAtom {
+    VendorAtom atom;
+    // Runs on the reporter thread once the atom was delivered or given up
+    std::function<void(bool delivered)> on_done;
+    int attempts = 0;
+};
+
+// Sends vendor atoms to IStats from its own thread. Producers only take the queue mutex to
+// append, it is never held across a binder call, so a slow or dead stats service cannot stall
+// them. Atoms are sent in batches with one client lookup; when a call fails the rest of the
+// batch is kept and retried after an exponential backoff.
+class StatsAtomReporter {
+  public:
+    // Collects the atoms due at the end of a report interval, called on the reporter thread
+    using PeriodicCollector = std::function<std::vector<PendingAtom>()>;
+
+    StatsAtomReporter(StatsClientGetter stats_client_getter, StatsReportingPolicy policy);
+    ~StatsAtomReporter();
+    // Disallow copy and assign
+    StatsAtomReporter(const StatsAtomReporter &) = delete;
+    void operator=(const StatsAtomReporter &) = delete;
+
+    // Start the reporter thread, the first periodic collection is one interval later
+    void start(PeriodicCollector periodic_collector);
+    // Queue an atom without waiting for it to be sent. Returns false if the queue is full.
+    bool enqueue(PendingAtom &&pending_atom);
+    // Run the periodic collection now instead of at the end of the interval
+    void requestReport();
+
+  private:
+    void loop();
+    // Send the batch, returns the atoms to retry
+    std::deque<PendingAtom> sendBatch(std::deque<PendingAtom> batch);
+
+    const StatsClientGetter stats_client_getter_;
+    const StatsReportingPolicy policy_;
+    PeriodicCollector periodic_collector_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<PendingAtom> queue_;
+    // Atoms being retried, reporter thread only
+    std::deque<PendingAtom> retry_queue_;
+    std::chrono::milliseconds backoff_;
+    boot_clock::time_point retry_time_;
+    boot_clock::time_point next_report_time_;
+    bool report_requested_ = false;
+    bool aborted_ = false;
+    std::thread thread_;
+};
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
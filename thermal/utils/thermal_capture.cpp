@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "thermal_capture.h"
+
+#include <android-base/logging.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+namespace {
+
+constexpr size_t kRecordHeaderSize = sizeof(ThermalCaptureRecordHeader);
+
+// Read a trivially copyable value at offset, which the caller has bounds checked
+template <typename T>
+T ReadAt(std::string_view data, size_t offset) {
+    T value;
+    std::memcpy(&value, data.data() + offset, sizeof(T));
+    return value;
+}
+
+}  // namespace
+
+bool DecodeThermalCapture(std::string_view data, ThermalCaptureSchema *schema,
+                          std::vector<ThermalCaptureRecord> *records) {
+    if (data.size() < sizeof(ThermalCaptureHeader)) {
+        LOG(ERROR) << "Thermal capture is truncated: " << data.size() << " bytes";
+        return false;
+    }
+    const auto header = ReadAt<ThermalCaptureHeader>(data, 0);
+    if (std::memcmp(header.magic, kThermalCaptureMagic, sizeof(header.magic)) != 0) {
+        LOG(ERROR) << "Not a thermal capture";
+        return false;
+    }
+    if (header.version != kThermalCaptureVersion) {
+        LOG(ERROR) << "Unsupported thermal capture version " << header.version;
+        return false;
+    }
+
+    const size_t schema_size = sizeof(ThermalCaptureHeader) +
+                               header.binding_count * sizeof(ThermalCaptureBindingId) +
+                               static_cast<size_t>(header.names_size);
+    const size_t min_record_size =
+            ThermalCaptureRecordSize(header.sensor_count, header.binding_count, header.cdev_count);
+    if (header.header_size < schema_size || header.record_size < min_record_size ||
+        header.record_count == 0 ||
+        data.size() < header.header_size +
+                              static_cast<size_t>(header.record_size) * header.record_count) {
+        LOG(ERROR) << "Thermal capture has an inconsistent layout: header_size="
+                   << header.header_size << " record_size=" << header.record_size
+                   << " record_count=" << header.record_count << " file size=" << data.size();
+        return false;
+    }
+
+    schema->bindings.resize(header.binding_count);
+    size_t offset = sizeof(ThermalCaptureHeader);
+    for (auto &binding : schema->bindings) {
+        binding = ReadAt<ThermalCaptureBindingId>(data, offset);
+        offset += sizeof(ThermalCaptureBindingId);
+        if (binding.sensor_id >= header.sensor_count || binding.cdev_id >= header.cdev_count) {
+            LOG(ERROR) << "Thermal capture binding refers to an unknown sensor or cdev";
+            return false;
+        }
+    }
+    std::string_view names = data.substr(offset, header.names_size);
+    schema->sensors.clear();
+    schema->cdevs.clear();
+    for (auto *list : {&schema->sensors, &schema->cdevs}) {
+        const size_t count = (list == &schema->sensors) ? header.sensor_count : header.cdev_count;
+        for (size_t i = 0; i < count; ++i) {
+            const size_t end = names.find('\0');
+            if (end == std::string_view::npos) {
+                LOG(ERROR) << "Thermal capture name table is truncated";
+                return false;
+            }
+            list->emplace_back(names.substr(0, end));
+            names.remove_prefix(end + 1);
+        }
+    }
+    schema->record_count = header.record_count;
+
+    // Only the last record_count sequence numbers can be live
+    const uint64_t last_seq = header.last_seq;
+    const uint64_t first_seq = last_seq > header.record_count ? last_seq - header.record_count : 0;
+    records->clear();
+    for (size_t slot = 0; slot < header.record_count; ++slot) {
+        const size_t record_offset =
+                header.header_size + slot * static_cast<size_t>(header.record_size);
+        const auto record_header = ReadAt<ThermalCaptureRecordHeader>(data, record_offset);
+        if (record_header.seq <= first_seq || record_header.seq > last_seq ||
+            (record_header.seq - 1) % header.record_count != slot) {
+            continue;
+        }
+
+        ThermalCaptureRecord record = {
+                .seq = record_header.seq,
+                .timestamp_ms = record_header.timestamp_ms,
+                .sensors = std::vector<ThermalCaptureSensor>(header.sensor_count),
+                .bindings = std::vector<ThermalCaptureBinding>(header.binding_count),
+                .cdev_states = std::vector<int32_t>(header.cdev_count),
+        };
+        size_t field_offset = record_offset + kRecordHeaderSize;
+        std::memcpy(record.sensors.data(), data.data() + field_offset,
+                    header.sensor_count * sizeof(ThermalCaptureSensor));
+        field_offset += header.sensor_count * sizeof(ThermalCaptureSensor);
+        std::memcpy(record.bindings.data(), data.data() + field_offset,
+                    header.binding_count * sizeof(ThermalCaptureBinding));
+        field_offset += header.binding_count * sizeof(ThermalCaptureBinding);
+        std::memcpy(record.cdev_states.data(), data.data() + field_offset,
+                    header.cdev_count * sizeof(int32_t));
+        records->push_back(std::move(record));
+    }
+    std::sort(records->begin(), records->end(),
+              [](const ThermalCaptureRecord &a, const ThermalCaptureRecord &b) {
+                  return a.seq < b.seq;
+              });
+    return true;
+}
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+// Capture file layout, in host byte order:
+//   ThermalCaptureHeader
+//   ThermalCaptureBindingId[binding_count]
+//   sensor names then cooling device names, each NUL terminated, padded to 8 bytes
+//   record_count records of record_size bytes, used as a ring
+// A record is a ThermalCaptureRecordHeader followed by ThermalCaptureSensor[sensor_count],
+// ThermalCaptureBinding[binding_count] and the int32_t state of each cooling device, padded to
+// 8 bytes. Sensors, bindings and cooling devices are referred to by their index in the schema.
+constexpr char kThermalCaptureMagic[8] = {'T', 'H', 'M', 'C', 'A', 'P', 'T', '\0'};
+constexpr uint32_t kThermalCaptureVersion = 1;
+// Upper bound of the ring, so that a mistyped record count cannot size a huge file on /data and
+// map it into the HAL. With a few hundred bytes per record, this is at most a few MiB.
+constexpr size_t kThermalCaptureMaxRecords = 8192;
+
+struct ThermalCaptureHeader {
+    char magic[8];
+    uint32_t version;
+    // Offset of the first record
+    uint32_t header_size;
+    uint32_t record_size;
+    uint32_t record_count;
+    uint32_t sensor_count;
+    uint32_t binding_count;
+    uint32_t cdev_count;
+    uint32_t names_size;
+    // Sequence number of the last complete record, 0 if none; record seq is in slot
+    // (seq - 1) % record_count
+    uint64_t last_seq;
+};
+
+// A cooling device binded to a throttling sensor
+struct ThermalCaptureBindingId {
+    uint32_t sensor_id;
+    uint32_t cdev_id;
+};
+
+struct ThermalCaptureRecordHeader {
+    // 0 while the slot is being written
+    uint64_t seq;
+    int64_t timestamp_ms;
+};
+
+struct ThermalCaptureSensor {
+    float temp;
+    // PID terms, NAN when the sensor is not under PID throttling
+    float power_budget;
+    float err;
+    float p;
+    float i;
+    float d;
+    uint8_t severity;
+    // Whether the sensor was polled in this pass; the other values carry over otherwise
+    uint8_t updated;
+    uint16_t reserved;
+};
+
+struct ThermalCaptureBinding {
+    // std::numeric_limits<int>::max() when unlimited
+    int32_t power_budget;
+    int32_t pid_request;
+    int32_t hardlimit_request;
+};
+
+// ThrottlingSeverity names by value, so that reading a capture does not need the HAL AIDL types
+constexpr std::array<std::string_view, 7> kThermalCaptureSeverityNames = {
+        "NONE", "LIGHT", "MODERATE", "SEVERE", "CRITICAL", "EMERGENCY", "SHUTDOWN"};
+
+constexpr size_t ThermalCaptureAlignTo8(size_t size) {
+    return (size + 7) & ~static_cast<size_t>(7);
+}
+
+constexpr size_t ThermalCaptureRecordSize(size_t sensor_count, size_t binding_count,
+                                          size_t cdev_count) {
+    return ThermalCaptureAlignTo8(sizeof(ThermalCaptureRecordHeader) +
+                                  sensor_count * sizeof(ThermalCaptureSensor) +
+                                  binding_count * sizeof(ThermalCaptureBinding) +
+                                  cdev_count * sizeof(int32_t));
+}
+
+struct ThermalCaptureSchema {
+    std::vector<std::string> sensors;
+    std::vector<std::string> cdevs;
+    std::vector<ThermalCaptureBindingId> bindings;
+    size_t record_count;
+};
+
+struct ThermalCaptureRecord {
+    uint64_t seq;
+    int64_t timestamp_ms;
+    std::vector<ThermalCaptureSensor> sensors;
+    std::vector<ThermalCaptureBinding> bindings;
+    std::vector<int32_t> cdev_states;
+};
+
+// Decode a capture file's schema and its complete records, oldest first
+bool DecodeThermalCapture(std::string_view data, ThermalCaptureSchema *schema,
+                          std::vector<ThermalCaptureRecord> *records);
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
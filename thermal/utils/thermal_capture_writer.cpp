@@ -0,0 +1,298 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define ATRACE_TAG (ATRACE_TAG_THERMAL | ATRACE_TAG_HAL)
+
+#include "thermal_capture_writer.h"
+
+#include <android-base/logging.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <utils/Trace.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <set>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+namespace {
+
+constexpr size_t kRecordHeaderSize = sizeof(ThermalCaptureRecordHeader);
+
+static_assert(static_cast<size_t>(ThrottlingSeverity::SHUTDOWN) + 1 ==
+                      kThermalCaptureSeverityNames.size(),
+              "kThermalCaptureSeverityNames is out of sync with ThrottlingSeverity");
+
+}  // namespace
+
+ThermalCapture::~ThermalCapture() {
+    if (map_ != nullptr) {
+        munmap(map_, map_size_);
+    }
+}
+
+bool ThermalCapture::init(
+        std::string_view path, size_t record_count,
+        const std::unordered_map<std::string, SensorInfo> &sensor_info_map,
+        const std::unordered_map<std::string, CdevInfo> &cooling_device_info_map,
+        const std::unordered_map<std::string, ThermalThrottlingStatus>
+                &thermal_throttling_status_map) {
+    if (map_ != nullptr) {
+        LOG(ERROR) << "Thermal capture has been initialized";
+        return false;
+    }
+    if (record_count == 0) {
+        LOG(ERROR) << "Invalid thermal capture record count " << record_count;
+        return false;
+    }
+    if (record_count > kThermalCaptureMaxRecords) {
+        LOG(WARNING) << "Thermal capture record count " << record_count << " clamped to "
+                     << kThermalCaptureMaxRecords;
+        record_count = kThermalCaptureMaxRecords;
+    }
+
+    // Ids follow the name order so that captures of one config share a schema
+    std::vector<std::string> sensors, cdevs;
+    for (const auto &sensor_info_pair : sensor_info_map) {
+        sensors.emplace_back(sensor_info_pair.first);
+    }
+    for (const auto &cdev_info_pair : cooling_device_info_map) {
+        cdevs.emplace_back(cdev_info_pair.first);
+    }
+    std::sort(sensors.begin(), sensors.end());
+    std::sort(cdevs.begin(), cdevs.end());
+    for (size_t i = 0; i < cdevs.size(); ++i) {
+        cdev_id_map_[cdevs[i]] = i;
+    }
+
+    std::vector<ThermalCaptureBindingId> bindings;
+    size_t names_size = 0;
+    for (size_t i = 0; i < sensors.size(); ++i) {
+        auto &sensor_slot = sensor_slot_map_[sensors[i]];
+        sensor_slot.id = i;
+        names_size += sensors[i].size() + 1;
+
+        const auto status_it = thermal_throttling_status_map.find(sensors[i]);
+        if (status_it == thermal_throttling_status_map.end()) {
+            continue;
+        }
+        std::set<std::string> binded_cdevs;
+        for (const auto &pid_power_budget_pair : status_it->second.pid_power_budget_map) {
+            binded_cdevs.insert(pid_power_budget_pair.first);
+        }
+        for (const auto &hardlimit_cdev_request_pair :
+             status_it->second.hardlimit_cdev_request_map) {
+            binded_cdevs.insert(hardlimit_cdev_request_pair.first);
+        }
+        for (const auto &cdev : binded_cdevs) {
+            const auto cdev_it = cdev_id_map_.find(cdev);
+            if (cdev_it == cdev_id_map_.end()) {
+                LOG(ERROR) << "Could not find " << sensors[i] << "'s binded CDEV " << cdev;
+                return false;
+            }
+            sensor_slot.bindings.emplace_back(cdev, bindings.size());
+            bindings.push_back({static_cast<uint32_t>(i), static_cast<uint32_t>(cdev_it->second)});
+        }
+    }
+    for (const auto &cdev : cdevs) {
+        names_size += cdev.size() + 1;
+    }
+
+    const size_t header_size = ThermalCaptureAlignTo8(
+            sizeof(ThermalCaptureHeader) + bindings.size() * sizeof(ThermalCaptureBindingId) +
+            names_size);
+    const size_t record_size =
+            ThermalCaptureRecordSize(sensors.size(), bindings.size(), cdevs.size());
+    map_size_ = header_size + record_size * record_count;
+
+    const std::string capture_path(path);
+    if (rename(capture_path.c_str(), (capture_path + ".prev").c_str()) != 0 && errno != ENOENT) {
+        PLOG(WARNING) << "Failed to keep the previous thermal capture " << capture_path;
+    }
+    fd_.reset(TEMP_FAILURE_RETRY(
+            open(capture_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0640)));
+    if (fd_.get() < 0) {
+        PLOG(ERROR) << "Failed to create thermal capture " << capture_path;
+        return false;
+    }
+    if (TEMP_FAILURE_RETRY(ftruncate(fd_.get(), map_size_)) != 0) {
+        PLOG(ERROR) << "Failed to size thermal capture " << capture_path << " to " << map_size_;
+        return false;
+    }
+    void *map = mmap(nullptr, map_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_.get(), 0);
+    if (map == MAP_FAILED) {
+        PLOG(ERROR) << "Failed to map thermal capture " << capture_path;
+        return false;
+    }
+    map_ = static_cast<uint8_t *>(map);
+
+    // Schema, in the zero-filled file
+    header_ = reinterpret_cast<ThermalCaptureHeader *>(map_);
+    std::memcpy(header_->magic, kThermalCaptureMagic, sizeof(header_->magic));
+    header_->version = kThermalCaptureVersion;
+    header_->header_size = header_size;
+    header_->record_size = record_size;
+    header_->record_count = record_count;
+    header_->sensor_count = sensors.size();
+    header_->binding_count = bindings.size();
+    header_->cdev_count = cdevs.size();
+    header_->names_size = names_size;
+    header_->last_seq = 0;
+    uint8_t *pos = map_ + sizeof(ThermalCaptureHeader);
+    std::memcpy(pos, bindings.data(), bindings.size() * sizeof(ThermalCaptureBindingId));
+    pos += bindings.size() * sizeof(ThermalCaptureBindingId);
+    for (const auto *names : {&sensors, &cdevs}) {
+        for (const auto &name : *names) {
+            std::memcpy(pos, name.c_str(), name.size() + 1);
+            pos += name.size() + 1;
+        }
+    }
+
+    staging_.assign(record_size / sizeof(uint64_t), 0);
+    auto *staged_sensors = stagedSensors();
+    for (size_t i = 0; i < sensors.size(); ++i) {
+        staged_sensors[i] = {
+                .temp = NAN,
+                .power_budget = NAN,
+                .err = NAN,
+                .p = NAN,
+                .i = NAN,
+                .d = NAN,
+                .severity = static_cast<uint8_t>(ThrottlingSeverity::NONE),
+                .updated = 0,
+                .reserved = 0,
+        };
+    }
+    auto *staged_bindings = stagedBindings();
+    for (size_t i = 0; i < bindings.size(); ++i) {
+        staged_bindings[i] = {
+                .power_budget = std::numeric_limits<int>::max(),
+                .pid_request = 0,
+                .hardlimit_request = 0,
+        };
+    }
+
+    LOG(INFO) << "Thermal capture " << capture_path << ": " << record_count << " records of "
+              << record_size << " bytes, " << sensors.size() << " sensors, " << bindings.size()
+              << " bindings, " << cdevs.size() << " cooling devices";
+    return true;
+}
+
+ThermalCaptureSensor *ThermalCapture::stagedSensors() {
+    return reinterpret_cast<ThermalCaptureSensor *>(
+            reinterpret_cast<uint8_t *>(staging_.data()) + kRecordHeaderSize);
+}
+
+ThermalCaptureBinding *ThermalCapture::stagedBindings() {
+    return reinterpret_cast<ThermalCaptureBinding *>(stagedSensors() + header_->sensor_count);
+}
+
+int32_t *ThermalCapture::stagedCdevStates() {
+    return reinterpret_cast<int32_t *>(stagedBindings() + header_->binding_count);
+}
+
+void ThermalCapture::updateSensor(const std::string &sensor_name, float temp,
+                                  ThrottlingSeverity severity,
+                                  const ThermalThrottlingStatus *throttling_status) {
+    if (map_ == nullptr) {
+        return;
+    }
+    const auto slot_it = sensor_slot_map_.find(sensor_name);
+    if (slot_it == sensor_slot_map_.end()) {
+        return;
+    }
+
+    auto &sensor = stagedSensors()[slot_it->second.id];
+    sensor.temp = temp;
+    sensor.severity = static_cast<uint8_t>(severity);
+    sensor.updated = 1;
+    if (throttling_status == nullptr) {
+        return;
+    }
+    sensor.power_budget = throttling_status->prev_power_budget;
+    sensor.err = throttling_status->prev_err;
+    sensor.p = throttling_status->p_budget;
+    sensor.i = throttling_status->i_budget;
+    sensor.d = throttling_status->d_budget;
+
+    auto *bindings = stagedBindings();
+    for (const auto &[cdev, binding_id] : slot_it->second.bindings) {
+        auto &binding = bindings[binding_id];
+        const auto budget_it = throttling_status->pid_power_budget_map.find(cdev);
+        if (budget_it != throttling_status->pid_power_budget_map.end()) {
+            binding.power_budget = budget_it->second;
+        }
+        const auto pid_request_it = throttling_status->pid_cdev_request_map.find(cdev);
+        if (pid_request_it != throttling_status->pid_cdev_request_map.end()) {
+            binding.pid_request = pid_request_it->second;
+        }
+        const auto hardlimit_request_it = throttling_status->hardlimit_cdev_request_map.find(cdev);
+        if (hardlimit_request_it != throttling_status->hardlimit_cdev_request_map.end()) {
+            binding.hardlimit_request = hardlimit_request_it->second;
+        }
+    }
+}
+
+void ThermalCapture::updateCdev(const std::string &cdev_name, int state) {
+    if (map_ == nullptr) {
+        return;
+    }
+    const auto cdev_it = cdev_id_map_.find(cdev_name);
+    if (cdev_it != cdev_id_map_.end()) {
+        stagedCdevStates()[cdev_it->second] = state;
+    }
+}
+
+void ThermalCapture::commit(boot_clock::time_point now) {
+    if (map_ == nullptr) {
+        return;
+    }
+    ATRACE_CALL();
+    const uint64_t seq = header_->last_seq + 1;
+    uint8_t *slot = map_ + header_->header_size +
+                    ((seq - 1) % header_->record_count) * header_->record_size;
+    auto *record_header = reinterpret_cast<ThermalCaptureRecordHeader *>(slot);
+
+    // Invalidate the slot while it is rewritten, so a reader never takes a torn record
+    __atomic_store_n(&record_header->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    record_header->timestamp_ms =
+            std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+    std::memcpy(slot + kRecordHeaderSize,
+                reinterpret_cast<const uint8_t *>(staging_.data()) + kRecordHeaderSize,
+                header_->record_size - kRecordHeaderSize);
+    __atomic_store_n(&record_header->seq, seq, __ATOMIC_RELEASE);
+    __atomic_store_n(&header_->last_seq, seq, __ATOMIC_RELEASE);
+
+    auto *sensors = stagedSensors();
+    for (size_t i = 0; i < header_->sensor_count; ++i) {
+        sensors[i].updated = 0;
+    }
+}
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/chrono_utils.h>
+#include <android-base/unique_fd.h>
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "thermal_capture.h"
+#include "thermal_info.h"
+#include "thermal_throttling.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+using ::android::base::boot_clock;
+using ::android::base::unique_fd;
+
+// Appends one fixed-layout record per watcher pass to an mmap'ed ring file. The values of a pass
+// are staged with updateSensor()/updateCdev() and the record is published by commit(). A record
+// costs a copy into the page cache and no syscall, so the capture outlives a crash of the HAL
+// but not of the kernel. Not thread-safe; meant to be driven from the watcher thread.
+class ThermalCapture {
+  public:
+    ThermalCapture() = default;
+    ~ThermalCapture();
+    ThermalCapture(const ThermalCapture &) = delete;
+    void operator=(const ThermalCapture &) = delete;
+
+    // Create the ring file at path with the schema of the given sensors and cooling devices.
+    // record_count is clamped to kThermalCaptureMaxRecords. A capture left by a previous run is
+    // kept with a ".prev" suffix.
+    bool init(std::string_view path, size_t record_count,
+              const std::unordered_map<std::string, SensorInfo> &sensor_info_map,
+              const std::unordered_map<std::string, CdevInfo> &cooling_device_info_map,
+              const std::unordered_map<std::string, ThermalThrottlingStatus>
+                      &thermal_throttling_status_map);
+    bool isEnabled() const { return map_ != nullptr; }
+    // Stage the values of a sensor polled in this pass; throttling_status may be null
+    void updateSensor(const std::string &sensor_name, float temp, ThrottlingSeverity severity,
+                      const ThermalThrottlingStatus *throttling_status);
+    // Stage the state requested for a cooling device
+    void updateCdev(const std::string &cdev_name, int state);
+    // Append the staged record to the ring
+    void commit(boot_clock::time_point now);
+
+  private:
+    struct SensorSlot {
+        size_t id;
+        // Binded cooling device name and binding id
+        std::vector<std::pair<std::string, size_t>> bindings;
+    };
+
+    ThermalCaptureSensor *stagedSensors();
+    ThermalCaptureBinding *stagedBindings();
+    int32_t *stagedCdevStates();
+
+    unique_fd fd_;
+    uint8_t *map_ = nullptr;
+    size_t map_size_ = 0;
+    ThermalCaptureHeader *header_ = nullptr;
+    std::unordered_map<std::string, SensorSlot> sensor_slot_map_;
+    std::unordered_map<std::string, size_t> cdev_id_map_;
+    // The next record, laid out as in the file
+    std::vector<uint64_t> staging_;
+};
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
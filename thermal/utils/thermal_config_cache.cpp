@@ -0,0 +1,319 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "thermal_config_cache.h"
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+namespace {
+
+enum class CacheTag : uint8_t {
+    NULL_VALUE = 0,
+    FALSE_VALUE,
+    TRUE_VALUE,
+    INT_VALUE,
+    UINT_VALUE,
+    REAL_VALUE,
+    STRING_VALUE,
+    ARRAY_VALUE,
+    OBJECT_VALUE,
+};
+
+// Far deeper than any config, only there to bound the recursion on a corrupted cache
+constexpr size_t kMaxDepth = 64;
+
+uint64_t HashConfig(std::string_view content) {
+    return std::hash<std::string_view>{}(content);
+}
+
+template <typename T>
+void Append(std::string *out, T value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    out->append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+void AppendString(std::string *out, std::string_view str) {
+    Append(out, static_cast<uint32_t>(str.size()));
+    out->append(str);
+}
+
+void EncodeValue(const Json::Value &value, std::string *out) {
+    switch (value.type()) {
+        case Json::nullValue:
+            Append(out, CacheTag::NULL_VALUE);
+            break;
+        case Json::booleanValue:
+            Append(out, value.asBool() ? CacheTag::TRUE_VALUE : CacheTag::FALSE_VALUE);
+            break;
+        case Json::intValue:
+            Append(out, CacheTag::INT_VALUE);
+            Append(out, static_cast<int64_t>(value.asLargestInt()));
+            break;
+        case Json::uintValue:
+            Append(out, CacheTag::UINT_VALUE);
+            Append(out, static_cast<uint64_t>(value.asLargestUInt()));
+            break;
+        case Json::realValue:
+            Append(out, CacheTag::REAL_VALUE);
+            Append(out, value.asDouble());
+            break;
+        case Json::stringValue: {
+            Append(out, CacheTag::STRING_VALUE);
+            const char *begin = nullptr;
+            const char *end = nullptr;
+            value.getString(&begin, &end);
+            AppendString(out, std::string_view(begin, end - begin));
+            break;
+        }
+        case Json::arrayValue:
+            Append(out, CacheTag::ARRAY_VALUE);
+            Append(out, static_cast<uint32_t>(value.size()));
+            for (const auto &element : value) {
+                EncodeValue(element, out);
+            }
+            break;
+        case Json::objectValue:
+            Append(out, CacheTag::OBJECT_VALUE);
+            Append(out, static_cast<uint32_t>(value.size()));
+            for (auto it = value.begin(); it != value.end(); ++it) {
+                AppendString(out, it.name());
+                EncodeValue(*it, out);
+            }
+            break;
+    }
+}
+
+// Bounds checked reads from the cache content
+class CacheReader {
+  public:
+    explicit CacheReader(std::string_view data) : data_(data) {}
+
+    template <typename T>
+    bool read(T *value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (data_.size() - pos_ < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(value, data_.data() + pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return true;
+    }
+
+    bool readString(std::string_view *str) {
+        uint32_t size;
+        if (!read(&size) || data_.size() - pos_ < size) {
+            return false;
+        }
+        *str = data_.substr(pos_, size);
+        pos_ += size;
+        return true;
+    }
+
+    bool done() const { return pos_ == data_.size(); }
+
+  private:
+    std::string_view data_;
+    size_t pos_ = 0;
+};
+
+bool DecodeValue(CacheReader *reader, size_t depth, Json::Value *value) {
+    CacheTag tag;
+    if (depth > kMaxDepth || !reader->read(&tag)) {
+        return false;
+    }
+    switch (tag) {
+        case CacheTag::NULL_VALUE:
+            *value = Json::Value();
+            return true;
+        case CacheTag::FALSE_VALUE:
+        case CacheTag::TRUE_VALUE:
+            *value = Json::Value(tag == CacheTag::TRUE_VALUE);
+            return true;
+        case CacheTag::INT_VALUE: {
+            int64_t int_value;
+            if (!reader->read(&int_value)) {
+                return false;
+            }
+            *value = Json::Value(static_cast<Json::Value::LargestInt>(int_value));
+            return true;
+        }
+        case CacheTag::UINT_VALUE: {
+            uint64_t uint_value;
+            if (!reader->read(&uint_value)) {
+                return false;
+            }
+            *value = Json::Value(static_cast<Json::Value::LargestUInt>(uint_value));
+            return true;
+        }
+        case CacheTag::REAL_VALUE: {
+            double real_value;
+            if (!reader->read(&real_value)) {
+                return false;
+            }
+            *value = Json::Value(real_value);
+            return true;
+        }
+        case CacheTag::STRING_VALUE: {
+            std::string_view str;
+            if (!reader->readString(&str)) {
+                return false;
+            }
+            *value = Json::Value(str.data(), str.data() + str.size());
+            return true;
+        }
+        case CacheTag::ARRAY_VALUE: {
+            uint32_t size;
+            if (!reader->read(&size)) {
+                return false;
+            }
+            *value = Json::Value(Json::arrayValue);
+            for (uint32_t i = 0; i < size; ++i) {
+                if (!DecodeValue(reader, depth + 1, &value->append(Json::Value()))) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        case CacheTag::OBJECT_VALUE: {
+            uint32_t size;
+            if (!reader->read(&size)) {
+                return false;
+            }
+            *value = Json::Value(Json::objectValue);
+            for (uint32_t i = 0; i < size; ++i) {
+                std::string_view name;
+                if (!reader->readString(&name) ||
+                    !DecodeValue(reader, depth + 1,
+                                 &(*value)[std::string(name.data(), name.size())])) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+bool LoadThermalConfigCache(std::string_view cache_path, std::string_view config_path,
+                            Json::Value *config) {
+    std::string cache;
+    if (!::android::base::ReadFileToString(cache_path.data(), &cache)) {
+        LOG(INFO) << "No thermal config cache at " << cache_path;
+        return false;
+    }
+
+    CacheReader reader(cache);
+    char magic[sizeof(kThermalConfigCacheMagic)];
+    uint32_t version;
+    uint32_t file_count;
+    if (!reader.read(&magic) ||
+        std::memcmp(magic, kThermalConfigCacheMagic, sizeof(magic)) != 0 ||
+        !reader.read(&version) || version != kThermalConfigCacheVersion ||
+        !reader.read(&file_count) || file_count == 0) {
+        LOG(WARNING) << "Invalid thermal config cache header in " << cache_path;
+        return false;
+    }
+
+    for (uint32_t i = 0; i < file_count; ++i) {
+        std::string_view path;
+        uint64_t size;
+        uint64_t hash;
+        if (!reader.readString(&path) || !reader.read(&size) || !reader.read(&hash)) {
+            LOG(WARNING) << "Truncated thermal config cache " << cache_path;
+            return false;
+        }
+        if (i == 0 && path != config_path) {
+            LOG(INFO) << "Thermal config cache was built from " << path << ", not "
+                      << config_path;
+            return false;
+        }
+        std::string content;
+        if (!::android::base::ReadFileToString(std::string(path), &content) ||
+            content.size() != size || HashConfig(content) != hash) {
+            LOG(INFO) << "Thermal config cache is stale, " << path << " changed";
+            return false;
+        }
+    }
+
+    Json::Value cached_config;
+    if (!DecodeValue(&reader, 0, &cached_config) || !reader.done()) {
+        LOG(WARNING) << "Corrupted thermal config cache " << cache_path;
+        return false;
+    }
+    *config = std::move(cached_config);
+    return true;
+}
+
+bool SaveThermalConfigCache(std::string_view cache_path, std::string_view config_path,
+                            const Json::Value &config,
+                            const std::unordered_set<std::string> &loaded_config_paths) {
+    std::vector<std::string> paths(loaded_config_paths.begin(), loaded_config_paths.end());
+    std::sort(paths.begin(), paths.end());
+    auto main_config = std::find(paths.begin(), paths.end(), config_path);
+    if (main_config == paths.end()) {
+        LOG(ERROR) << "Thermal config " << config_path << " is not among the loaded configs";
+        return false;
+    }
+    std::rotate(paths.begin(), main_config, main_config + 1);
+
+    std::string cache(kThermalConfigCacheMagic, sizeof(kThermalConfigCacheMagic));
+    Append(&cache, kThermalConfigCacheVersion);
+    Append(&cache, static_cast<uint32_t>(paths.size()));
+    for (const auto &path : paths) {
+        std::string content;
+        if (!::android::base::ReadFileToString(path, &content)) {
+            LOG(ERROR) << "Failed to read " << path << " for the thermal config cache";
+            return false;
+        }
+        AppendString(&cache, path);
+        Append(&cache, static_cast<uint64_t>(content.size()));
+        Append(&cache, HashConfig(content));
+    }
+    EncodeValue(config, &cache);
+
+    // Written aside and renamed, so that a crash never leaves a partial cache behind
+    const std::string tmp_path = std::string(cache_path) + ".tmp";
+    if (!::android::base::WriteStringToFile(cache, tmp_path) ||
+        rename(tmp_path.c_str(), cache_path.data()) != 0) {
+        PLOG(ERROR) << "Failed to write the thermal config cache " << cache_path;
+        unlink(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <json/value.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+// Cache file layout, in host byte order:
+//   kThermalConfigCacheMagic, uint32_t version, uint32_t file count
+//   per config file: uint32_t path length, path, uint64_t size, uint64_t content hash; the main
+//   config comes first, then its includes
+//   the merged config, as a tagged encoding of the Json::Value tree
+constexpr char kThermalConfigCacheMagic[8] = {'T', 'H', 'M', 'C', 'F', 'G', 'C', '\0'};
+constexpr uint32_t kThermalConfigCacheVersion = 1;
+
+// Load the config merged by ParseThermalConfig() from config_path, as saved at cache_path.
+// Every config file the cache was built from is read back and hashed, so an edited or pushed
+// config is never shadowed by the cache. Returns false, leaving config untouched, if the cache is
+// missing, stale or corrupted.
+bool LoadThermalConfigCache(std::string_view cache_path, std::string_view config_path,
+                            Json::Value *config);
+
+// Save the config merged by ParseThermalConfig() from config_path and the files it loaded
+bool SaveThermalConfigCache(std::string_view cache_path, std::string_view config_path,
+                            const Json::Value &config,
+                            const std::unordered_set<std::string> &loaded_config_paths);
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -22,6 +22,8 @@
 #include <json/reader.h>
 
 #include <cmath>
+#include <functional>
+#include <future>
 #include <unordered_set>
 
 namespace aidl {
@@ -183,8 +185,94 @@ bool getTempStuckInfoFromJsonValue(const Json::Value &values, TempStuckInfo *tem
               << " stuck_duration=" << temp_stuck_info->min_stuck_duration.count();
     return true;
 }
+
+// Fill a boundary list with the valid levels in ascending order. Each level takes the tightest
+// boundary of itself and the levels above it: this makes the list monotonic while keeping the
+// highest level a reading reaches unchanged.
+template <typename Tighter>
+void CompileBoundaries(const ThrottlingArray &boundaries, Tighter tighter,
+                       SeverityTable::BoundaryArray *boundaries_out,
+                       SeverityTable::SeverityArray *severities_out) {
+    std::array<size_t, SeverityTable::kLaneCount> levels;
+    size_t count = 0;
+    for (size_t i = static_cast<size_t>(ThrottlingSeverity::LIGHT); i < kThrottlingSeverityCount;
+         ++i) {
+        if (!std::isnan(boundaries[i])) {
+            levels[count++] = i;
+        }
+    }
+
+    boundaries_out->fill(NAN);
+    severities_out->fill(ThrottlingSeverity::NONE);
+    float bound = NAN;
+    for (size_t k = count; k-- > 0;) {
+        const float boundary = boundaries[levels[k]];
+        if (std::isnan(bound) || tighter(boundary, bound)) {
+            bound = boundary;
+        }
+        (*boundaries_out)[k] = bound;
+        (*severities_out)[k + 1] = static_cast<ThrottlingSeverity>(levels[k]);
+    }
+}
+
+// An ML vt estimator created while parsing, whose model is loaded once all sensors are parsed
+struct PendingVtEstimatorInit {
+    std::string sensor_name;
+    ::thermal::vtestimator::VirtualTempEstimator *vt_estimator;
+    ::thermal::vtestimator::VtEstimationInitData init_data;
+};
+
+// Loading the TFLite models dominates the HAL startup, so the models are loaded concurrently
+bool InitializeVtEstimators(std::vector<PendingVtEstimatorInit> *pending_inits) {
+    std::vector<std::future<bool>> results;
+    results.reserve(pending_inits->size());
+    for (auto &pending_init : *pending_inits) {
+        results.emplace_back(std::async(std::launch::async, [&pending_init] {
+            ::thermal::vtestimator::VtEstimatorStatus ret =
+                    pending_init.vt_estimator->Initialize(pending_init.init_data);
+            if (ret != ::thermal::vtestimator::kVtEstimatorOk) {
+                LOG(ERROR) << "Failed to initialize vt estimator for Sensor["
+                           << pending_init.sensor_name << "] with ModelPath: "
+                           << pending_init.init_data.ml_model_init_data.model_path
+                           << " with ret code : " << ret;
+                return false;
+            }
+            LOG(INFO) << "Successfully created vt_estimator for Sensor["
+                      << pending_init.sensor_name << "]";
+            return true;
+        }));
+    }
+
+    // Wait for every load, the estimators must not be destroyed under a running one
+    bool ret = true;
+    for (auto &result : results) {
+        ret &= result.get();
+    }
+    return ret;
+}
 }  // namespace
 
+SeverityTable BuildSeverityTable(const ThrottlingArray &hot_thresholds,
+                                 const ThrottlingArray &cold_thresholds,
+                                 const ThrottlingArray &hot_hysteresis,
+                                 const ThrottlingArray &cold_hysteresis) {
+    ThrottlingArray hot_release;
+    ThrottlingArray cold_release;
+    for (size_t i = 0; i < kThrottlingSeverityCount; ++i) {
+        hot_release[i] = hot_thresholds[i] - hot_hysteresis[i];
+        cold_release[i] = cold_thresholds[i] + cold_hysteresis[i];
+    }
+
+    SeverityTable table;
+    CompileBoundaries(hot_thresholds, std::less<float>(), &table.hot, &table.hot_severity);
+    CompileBoundaries(hot_release, std::less<float>(), &table.hot_hysteresis,
+                      &table.hot_hysteresis_severity);
+    CompileBoundaries(cold_thresholds, std::greater<float>(), &table.cold, &table.cold_severity);
+    CompileBoundaries(cold_release, std::greater<float>(), &table.cold_hysteresis,
+                      &table.cold_hysteresis_severity);
+    return table;
+}
+
 std::ostream &operator<<(std::ostream &stream, const SensorFusionType &sensor_fusion_type) {
     switch (sensor_fusion_type) {
         case SensorFusionType::SENSOR:
@@ -313,7 +401,8 @@ bool ParseOffsetThresholds(const std::string_view name, const Json::Value &senso
 }
 
 bool ParseVirtualSensorInfo(const std::string_view name, const Json::Value &sensor,
-                            std::unique_ptr<VirtualSensorInfo> *virtual_sensor_info) {
+                            std::unique_ptr<VirtualSensorInfo> *virtual_sensor_info,
+                            std::vector<PendingVtEstimatorInit> *pending_vt_estimator_inits) {
     if (sensor["VirtualSensor"].empty() || !sensor["VirtualSensor"].isBool()) {
         LOG(INFO) << "Failed to read Sensor[" << name << "]'s VirtualSensor";
         return true;
@@ -530,15 +619,9 @@ bool ParseVirtualSensorInfo(const std::string_view name, const Json::Value &sens
             LOG(INFO) << "Sensor[" << name << "] supports under sampling estimation.";
         }
 
-        ::thermal::vtestimator::VtEstimatorStatus ret = vt_estimator->Initialize(init_data);
-        if (ret != ::thermal::vtestimator::kVtEstimatorOk) {
-            LOG(ERROR) << "Failed to initialize vt estimator for Sensor[" << name
-                       << "] with ModelPath: " << vt_estimator_model_file
-                       << " with ret code : " << ret;
-            return false;
-        }
-
-        LOG(INFO) << "Successfully created vt_estimator for Sensor[" << name
+        // The model is loaded by ParseSensorInfo, together with the other sensors' models
+        pending_vt_estimator_inits->push_back({std::string(name), vt_estimator.get(), init_data});
+        LOG(INFO) << "Created vt_estimator for Sensor[" << name
                   << "] with input samples: " << linked_sensors.size();
 
     } else if (formula == FormulaOption::USE_LINEAR_MODEL) {
@@ -642,13 +725,75 @@ bool ParsePredictorInfo(const std::string_view name, const Json::Value &sensor,
         }
     }
 
+    // parse model predictive throttling configuration
+    bool support_mpc_throttling = false;
+    std::chrono::milliseconds prediction_interval = std::chrono::milliseconds::zero();
+    float thermal_resistance = NAN;
+    std::chrono::milliseconds thermal_time_constant = std::chrono::milliseconds::zero();
+    const Json::Value model_predictive = predictor["ModelPredictive"];
+    if (!model_predictive.empty()) {
+        support_mpc_throttling = true;
+        prediction_interval = std::chrono::milliseconds(
+                getIntFromValue(model_predictive["PredictionIntervalMs"]));
+        thermal_resistance = getFloatFromValue(model_predictive["ThermalResistance"]);
+        thermal_time_constant =
+                std::chrono::milliseconds(getIntFromValue(model_predictive["TimeConstantMs"]));
+        if (prediction_interval <= std::chrono::milliseconds::zero() ||
+            !(thermal_resistance > 0) ||
+            thermal_time_constant <= std::chrono::milliseconds::zero()) {
+            LOG(ERROR) << "Sensor[" << name << "]'s ModelPredictive needs positive "
+                       << "PredictionIntervalMs, ThermalResistance and TimeConstantMs";
+            return false;
+        }
+        LOG(INFO) << "Sensor[" << name << "]'s model predictive throttling: prediction interval "
+                  << prediction_interval.count() << "ms, thermal resistance "
+                  << thermal_resistance << ", time constant " << thermal_time_constant.count()
+                  << "ms";
+    }
+
     LOG(INFO) << "Successfully created PredictorInfo for Sensor[" << name << "]";
     predictor_info->reset(new PredictorInfo{predict_sensor, support_pid_compensation,
-                                            prediction_weights, k_p_compensate});
+                                            prediction_weights, k_p_compensate,
+                                            support_mpc_throttling, prediction_interval,
+                                            thermal_resistance, thermal_time_constant});
 
     return true;
 }
 
+bool ParseAdaptivePollingInfo(const std::string_view name, const Json::Value &sensor,
+                              const std::chrono::milliseconds polling_delay,
+                              std::unique_ptr<AdaptivePollingInfo> *adaptive_polling_info) {
+    Json::Value adaptive_polling = sensor["AdaptivePolling"];
+    if (adaptive_polling.empty()) {
+        return true;
+    }
+
+    LOG(INFO) << "Start to parse Sensor[" << name << "]'s AdaptivePolling";
+    if (adaptive_polling["MaxPollingDelay"].empty() || adaptive_polling["Headroom"].empty()) {
+        LOG(ERROR) << "Sensor[" << name << "]'s AdaptivePolling needs MaxPollingDelay and Headroom";
+        return false;
+    }
+
+    const auto max_polling_delay =
+            std::chrono::milliseconds(getIntFromValue(adaptive_polling["MaxPollingDelay"]));
+    if (polling_delay == std::chrono::milliseconds::max() || max_polling_delay <= polling_delay) {
+        LOG(ERROR) << "Sensor[" << name << "]'s MaxPollingDelay " << max_polling_delay.count()
+                   << " should be larger than PollingDelay " << polling_delay.count();
+        return false;
+    }
+
+    const float headroom = getFloatFromValue(adaptive_polling["Headroom"]);
+    if (std::isnan(headroom) || headroom <= 0) {
+        LOG(ERROR) << "Sensor[" << name << "]'s AdaptivePolling Headroom should be positive";
+        return false;
+    }
+
+    LOG(INFO) << "Sensor[" << name << "]'s MaxPollingDelay: " << max_polling_delay.count()
+              << " Headroom: " << headroom;
+    adaptive_polling_info->reset(new AdaptivePollingInfo{max_polling_delay, headroom});
+    return true;
+}
+
 bool ParseBindedCdevInfo(
         const Json::Value &values,
         std::unordered_map<std::string, BindedCdevInfo> *binded_cdev_info_map,
@@ -912,6 +1057,7 @@ bool ParseSensorThrottlingInfo(
     float i_default = 0.0;
     float i_default_pct = NAN;
     int tran_cycle = 0;
+    float budget_tolerance = NAN;
     bool support_pid = false;
     bool support_hard_limit = false;
 
@@ -1016,6 +1162,15 @@ bool ParseSensorThrottlingInfo(
         }
         tran_cycle = getFloatFromValue(sensor["PIDInfo"]["TranCycle"]);
         LOG(INFO) << "Sensor[" << name << "]'s TranCycle: " << tran_cycle;
+        if (!sensor["PIDInfo"]["BudgetTolerance"].empty()) {
+            budget_tolerance = getFloatFromValue(sensor["PIDInfo"]["BudgetTolerance"]);
+            if (budget_tolerance < 0) {
+                LOG(ERROR) << "Sensor[" << name << "]: Invalid BudgetTolerance "
+                           << budget_tolerance;
+                return false;
+            }
+            LOG(INFO) << "Sensor[" << name << "]'s BudgetTolerance: " << budget_tolerance;
+        }
 
         // Confirm we have at least one valid PID combination
         bool valid_pid_combination = false;
@@ -1110,8 +1265,9 @@ bool ParseSensorThrottlingInfo(
     }
     throttling_info->reset(new ThrottlingInfo{k_po, k_pu, k_io, k_iu, k_d, i_max, max_alloc_power,
                                               min_alloc_power, s_power, i_cutoff, i_default,
-                                              i_default_pct, tran_cycle, excluded_power_info_map,
-                                              binded_cdev_info_map, profile_map});
+                                              i_default_pct, tran_cycle, budget_tolerance,
+                                              excluded_power_info_map, binded_cdev_info_map,
+                                              profile_map});
     *support_throttling = support_pid | support_hard_limit;
     return true;
 }
@@ -1165,6 +1321,7 @@ bool ParseSensorInfo(const Json::Value &config,
 
     std::size_t total_parsed = 0;
     std::unordered_set<std::string> sensors_name_parsed;
+    std::vector<PendingVtEstimatorInit> pending_vt_estimator_inits;
 
     for (Json::Value::ArrayIndex i = 0; i < sensors.size(); ++i) {
         const std::string &name = sensors[i]["Name"].asString();
@@ -1446,7 +1603,8 @@ bool ParseSensorInfo(const Json::Value &config,
         }
 
         std::unique_ptr<VirtualSensorInfo> virtual_sensor_info;
-        if (!ParseVirtualSensorInfo(name, sensors[i], &virtual_sensor_info)) {
+        if (!ParseVirtualSensorInfo(name, sensors[i], &virtual_sensor_info,
+                                    &pending_vt_estimator_inits)) {
             LOG(ERROR) << "Sensor[" << name << "]: failed to parse virtual sensor info";
             sensors_parsed->clear();
             return false;
@@ -1459,6 +1617,13 @@ bool ParseSensorInfo(const Json::Value &config,
             return false;
         }
 
+        std::unique_ptr<AdaptivePollingInfo> adaptive_polling_info;
+        if (!ParseAdaptivePollingInfo(name, sensors[i], polling_delay, &adaptive_polling_info)) {
+            LOG(ERROR) << "Sensor[" << name << "]: failed to parse adaptive polling info";
+            sensors_parsed->clear();
+            return false;
+        }
+
         bool support_throttling = false;  // support pid or hard limit
         std::shared_ptr<ThrottlingInfo> throttling_info;
         if (!ParseSensorThrottlingInfo(name, sensors[i], &support_throttling, &throttling_info,
@@ -1477,6 +1642,8 @@ bool ParseSensorInfo(const Json::Value &config,
                 .cold_thresholds = cold_thresholds,
                 .hot_hysteresis = hot_hysteresis,
                 .cold_hysteresis = cold_hysteresis,
+                .severity_table = BuildSeverityTable(hot_thresholds, cold_thresholds,
+                                                     hot_hysteresis, cold_hysteresis),
                 .temp_path = temp_path,
                 .severity_reference = severity_reference,
                 .vr_threshold = vr_threshold,
@@ -1493,10 +1660,17 @@ bool ParseSensorInfo(const Json::Value &config,
                 .virtual_sensor_info = std::move(virtual_sensor_info),
                 .throttling_info = std::move(throttling_info),
                 .predictor_info = std::move(predictor_info),
+                .adaptive_polling_info = std::move(adaptive_polling_info),
         };
 
         ++total_parsed;
     }
+
+    if (!InitializeVtEstimators(&pending_vt_estimator_inits)) {
+        LOG(ERROR) << "Failed to load the vt estimator models";
+        sensors_parsed->clear();
+        return false;
+    }
     LOG(INFO) << total_parsed << " Sensors parsed successfully";
     return true;
 }
@@ -21,10 +21,12 @@
 #include <aidl/android/hardware/thermal/ThrottlingSeverity.h>
 #include <json/value.h>
 
+#include <array>
 #include <chrono>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <variant>
 
 #include "virtualtemp_estimator/virtualtemp_estimator.h"
@@ -151,6 +153,22 @@ struct PredictorInfo {
     bool support_pid_compensation;
     std::vector<float> prediction_weights;
     ThrottlingArray k_p_compensate;
+    // Plan the PID cdev requests from the predicted temperatures instead of the PID power budget
+    bool support_mpc_throttling;
+    // Time between two consecutive predictions of the model
+    std::chrono::milliseconds prediction_interval;
+    // Steady state temperature drop per mW cut from the binded cdevs
+    float thermal_resistance;
+    // Time constant of the first order temperature response to a power change
+    std::chrono::milliseconds thermal_time_constant;
+};
+
+// Lets a sensor at NONE severity poll slower than PollingDelay while it is far from its first
+// hot threshold. The delay scales with the remaining headroom up to max_polling_delay.
+struct AdaptivePollingInfo {
+    std::chrono::milliseconds max_polling_delay;
+    // Headroom to the first hot threshold at which max_polling_delay is reached
+    float headroom;
 };
 
 struct VirtualPowerRailInfo {
@@ -203,17 +221,65 @@ struct ThrottlingInfo {
     float i_default;
     float i_default_pct;
     int tran_cycle;
+    // Budget and rail power change (mW) below which a settled power split is kept, NAN to
+    // recompute the split on every update
+    float budget_tolerance;
     std::unordered_map<std::string, ThrottlingArray> excluded_power_info_map;
     std::unordered_map<std::string, BindedCdevInfo> binded_cdev_info_map;
     ProfileMap profile_map;
 };
 
+// A sensor's hot and cold thresholds compiled into sorted, NaN-free boundary lists, so that a
+// reading is classified by counting the boundaries it crosses instead of walking the severities.
+struct SeverityTable {
+    // Room for every severity above NONE, rounded up so the compare loops vectorize
+    static constexpr size_t kLaneCount = 8;
+    static_assert(kThrottlingSeverityCount - 1 <= kLaneCount);
+    using BoundaryArray = std::array<float, kLaneCount>;
+    using SeverityArray = std::array<ThrottlingSeverity, kLaneCount + 1>;
+
+    // Non-decreasing for hot and non-increasing for cold, padded with NaN which never matches
+    BoundaryArray hot;
+    BoundaryArray hot_hysteresis;
+    BoundaryArray cold;
+    BoundaryArray cold_hysteresis;
+    // Severity reached once the first k boundaries of the matching list are crossed
+    SeverityArray hot_severity;
+    SeverityArray hot_hysteresis_severity;
+    SeverityArray cold_severity;
+    SeverityArray cold_hysteresis_severity;
+
+    // Return hot and cold severity, with hysteresis applied when the severity would drop
+    std::pair<ThrottlingSeverity, ThrottlingSeverity> classify(
+            float value, ThrottlingSeverity prev_hot_severity,
+            ThrottlingSeverity prev_cold_severity) const {
+        int hot_count = 0, hot_hysteresis_count = 0, cold_count = 0, cold_hysteresis_count = 0;
+        for (size_t i = 0; i < kLaneCount; ++i) {
+            hot_count += hot[i] <= value;
+            hot_hysteresis_count += hot_hysteresis[i] < value;
+            cold_count += cold[i] >= value;
+            cold_hysteresis_count += cold_hysteresis[i] > value;
+        }
+
+        const ThrottlingSeverity ret_hot = hot_severity[hot_count];
+        const ThrottlingSeverity ret_cold = cold_severity[cold_count];
+        return std::make_pair(
+                static_cast<size_t>(ret_hot) < static_cast<size_t>(prev_hot_severity)
+                        ? hot_hysteresis_severity[hot_hysteresis_count]
+                        : ret_hot,
+                static_cast<size_t>(ret_cold) < static_cast<size_t>(prev_cold_severity)
+                        ? cold_hysteresis_severity[cold_hysteresis_count]
+                        : ret_cold);
+    }
+};
+
 struct SensorInfo {
     TemperatureType type;
     ThrottlingArray hot_thresholds;
     ThrottlingArray cold_thresholds;
     ThrottlingArray hot_hysteresis;
     ThrottlingArray cold_hysteresis;
+    SeverityTable severity_table;
     std::string temp_path;
     std::string severity_reference;
     float vr_threshold;
@@ -232,6 +298,7 @@ struct SensorInfo {
     std::unique_ptr<VirtualSensorInfo> virtual_sensor_info;
     std::shared_ptr<ThrottlingInfo> throttling_info;
     std::unique_ptr<PredictorInfo> predictor_info;
+    std::unique_ptr<AdaptivePollingInfo> adaptive_polling_info;
 };
 
 struct CdevInfo {
@@ -240,6 +307,8 @@ struct CdevInfo {
     std::string write_path;
     std::vector<float> state2power;
     int max_state;
+    // Whether state2power never increases with the state, so it can be binary searched
+    bool state2power_descending;
 };
 
 struct PowerRailInfo {
@@ -252,6 +321,10 @@ bool LoadThermalConfig(std::string_view config_path, Json::Value *config);
 bool ParseThermalConfig(std::string_view config_path, Json::Value *config,
                         std::unordered_set<std::string> *loaded_config_paths);
 void MergeConfigEntries(Json::Value *config, Json::Value *sub_config, std::string_view member_name);
+SeverityTable BuildSeverityTable(const ThrottlingArray &hot_thresholds,
+                                 const ThrottlingArray &cold_thresholds,
+                                 const ThrottlingArray &hot_hysteresis,
+                                 const ThrottlingArray &cold_hysteresis);
 bool ParseSensorInfo(const Json::Value &config,
                      std::unordered_map<std::string, SensorInfo> *sensors_parsed);
 bool ParseCoolingDevice(const Json::Value &config,
@@ -76,14 +76,143 @@ int calculateThresholdBucket(const std::vector<T> &thresholds, T value) {
     return bucket;
 }
 
-void resetCurrentTempStatus(CurrTempStatus *curr_temp_status, float new_temp) {
+void resetCurrentTempStatus(CurrTempStatus *curr_temp_status, float new_temp,
+                            boot_clock::time_point now) {
     curr_temp_status->temp = new_temp;
-    curr_temp_status->start_time = boot_clock::now();
+    curr_temp_status->start_time = now;
     curr_temp_status->repeat_count = 1;
 }
 
+int64_t toNs(boot_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+boot_clock::time_point fromNs(int64_t ns) {
+    return boot_clock::time_point(
+            std::chrono::duration_cast<boot_clock::duration>(std::chrono::nanoseconds(ns)));
+}
+
+SystemTimePoint toSystemTime(int64_t ticks) {
+    return SystemTimePoint(SystemTimePoint::duration(ticks));
+}
+
+std::chrono::milliseconds nsToMs(int64_t ns) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::nanoseconds(ns));
+}
+
+// Residency not reported yet, as of the given read of the counter
+StatsRecord makeStatsRecord(const ResidencyCounter &counter,
+                            const std::vector<int64_t> &time_in_state_ns, int64_t now_ns) {
+    StatsRecord stats_record;
+    stats_record.cur_state = counter.curState();
+    stats_record.cur_state_start_time = fromNs(now_ns);
+    stats_record.last_stats_report_time =
+            fromNs(counter.last_report_ns.load(std::memory_order_relaxed));
+    stats_record.report_fail_count = counter.report_fail_count.load(std::memory_order_relaxed);
+    stats_record.time_in_state_ms.resize(counter.size());
+    for (size_t i = 0; i < counter.size(); ++i) {
+        stats_record.time_in_state_ms[i] = nsToMs(
+                time_in_state_ns[i] - counter.reported_ns[i].load(std::memory_order_relaxed));
+    }
+    return stats_record;
+}
+
+// Read the residency stats in one consistent section
+template <typename ValueType>
+void readResidencyStats(const ResidencyStats<ValueType> &residency_stats, int64_t now_ns,
+                        std::vector<std::vector<int64_t>> *custom_threshold_ns,
+                        std::vector<int64_t> *default_threshold_ns) {
+    custom_threshold_ns->resize(residency_stats.by_custom_threshold.size());
+    uint32_t seq;
+    do {
+        seq = residency_stats.seq_lock.readBegin();
+        for (size_t i = 0; i < residency_stats.by_custom_threshold.size(); ++i) {
+            residency_stats.by_custom_threshold[i].counter.read(now_ns,
+                                                                &(*custom_threshold_ns)[i]);
+        }
+        if (residency_stats.by_default_threshold) {
+            residency_stats.by_default_threshold->read(now_ns, default_threshold_ns);
+        }
+    } while (residency_stats.seq_lock.readRetry(seq));
+}
+
+template <typename ValueType>
+ThermalStats<ValueType> makeThermalStats(const ResidencyStats<ValueType> &residency_stats,
+                                         int64_t now_ns) {
+    std::vector<std::vector<int64_t>> custom_threshold_ns;
+    std::vector<int64_t> default_threshold_ns;
+    readResidencyStats(residency_stats, now_ns, &custom_threshold_ns, &default_threshold_ns);
+
+    ThermalStats<ValueType> thermal_stats;
+    for (size_t i = 0; i < residency_stats.by_custom_threshold.size(); ++i) {
+        const auto &by_threshold = residency_stats.by_custom_threshold[i];
+        StatsByThreshold<ValueType> stats_by_threshold;
+        stats_by_threshold.thresholds = by_threshold.thresholds;
+        stats_by_threshold.logging_name = by_threshold.logging_name;
+        stats_by_threshold.stats_record =
+                makeStatsRecord(by_threshold.counter, custom_threshold_ns[i], now_ns);
+        thermal_stats.stats_by_custom_threshold.push_back(std::move(stats_by_threshold));
+    }
+    if (residency_stats.by_default_threshold) {
+        thermal_stats.stats_by_default_threshold = makeStatsRecord(
+                *residency_stats.by_default_threshold, default_threshold_ns, now_ns);
+    }
+    return thermal_stats;
+}
+
 }  // namespace
 
+ResidencyCounter::ResidencyCounter(size_t state_count, int64_t now_ns)
+    : reported_ns(new std::atomic<int64_t>[state_count]),
+      last_report_ns(now_ns),
+      state_count_(state_count),
+      cur_state_start_ns_(now_ns),
+      time_in_state_ns_(new std::atomic<int64_t>[state_count]) {
+    for (size_t i = 0; i < state_count_; ++i) {
+        reported_ns[i].store(0, std::memory_order_relaxed);
+        time_in_state_ns_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void ResidencyCounter::update(int new_state, int64_t now_ns) {
+    const int cur_state = cur_state_.load(std::memory_order_relaxed);
+    if (new_state == cur_state) {
+        return;
+    }
+    if (new_state < 0 || static_cast<size_t>(new_state) >= state_count_) {
+        LOG(ERROR) << "Stats state " << new_state << " out of range " << state_count_;
+        return;
+    }
+    const int64_t cur_state_start_ns = cur_state_start_ns_.load(std::memory_order_relaxed);
+    LOG(VERBOSE) << "Adding duration " << nsToMs(now_ns - cur_state_start_ns).count()
+                 << " for cur_state: " << cur_state;
+    // Update last record end time, the only writer holds the owner's write lock
+    time_in_state_ns_[cur_state].store(
+            time_in_state_ns_[cur_state].load(std::memory_order_relaxed) + now_ns -
+                    cur_state_start_ns,
+            std::memory_order_relaxed);
+    cur_state_start_ns_.store(now_ns, std::memory_order_relaxed);
+    cur_state_.store(new_state, std::memory_order_relaxed);
+}
+
+void ResidencyCounter::read(int64_t now_ns, std::vector<int64_t> *time_in_state_ns) const {
+    time_in_state_ns->resize(state_count_);
+    for (size_t i = 0; i < state_count_; ++i) {
+        (*time_in_state_ns)[i] = time_in_state_ns_[i].load(std::memory_order_relaxed);
+    }
+    // Close the unclosed entry as of now
+    const int cur_state = cur_state_.load(std::memory_order_relaxed);
+    (*time_in_state_ns)[cur_state] +=
+            now_ns - cur_state_start_ns_.load(std::memory_order_relaxed);
+}
+
+ThermalStatsHelper::ThermalStatsHelper()
+    : ThermalStatsHelper(getStatsService, StatsReportingPolicy()) {}
+
+ThermalStatsHelper::ThermalStatsHelper(StatsClientGetter stats_client_getter,
+                                       StatsReportingPolicy policy)
+    : stats_atom_reporter_(std::move(stats_client_getter), policy) {}
+
 bool ThermalStatsHelper::initializeStats(
         const Json::Value &config,
         const std::unordered_map<std::string, SensorInfo> &sensor_info_map_,
@@ -117,8 +246,8 @@ bool ThermalStatsHelper::initializeStats(
     }
 
     thermal_helper_handle_ = thermal_helper_handle;
-    last_total_stats_report_time = boot_clock::now();
     abnormal_stats_reported_per_update_interval = 0;
+    stats_atom_reporter_.start([this] { return collectStatsAtoms(); });
     LOG(INFO) << "Thermal Stats Initialized Successfully";
     return true;
 }
@@ -127,13 +256,20 @@ bool ThermalStatsHelper::initializeSensorCdevRequestStats(
         const StatsInfo<int> &request_stats_info,
         const std::unordered_map<std::string, SensorInfo> &sensor_info_map_,
         const std::unordered_map<std::string, CdevInfo> &cooling_device_info_map_) {
-    std::unique_lock<std::shared_mutex> _lock(sensor_cdev_request_stats_map_mutex_);
+    const int64_t now_ns = toNs(boot_clock::now());
     for (const auto &[sensor, sensor_info] : sensor_info_map_) {
         for (const auto &binded_cdev_info_pair :
              sensor_info.throttling_info->binded_cdev_info_map) {
             const auto &cdev = binded_cdev_info_pair.first;
             const auto &max_state =
                     cooling_device_info_map_.at(binded_cdev_info_pair.first).max_state;
+            const auto get_request_stats = [&]() -> ResidencyStats<int> & {
+                auto &request_stats = sensor_cdev_request_stats_map_[sensor][cdev];
+                if (!request_stats) {
+                    request_stats = std::make_unique<ResidencyStats<int>>();
+                }
+                return *request_stats;
+            };
             // Record by all state
             if (isRecordByDefaultThreshold(
                         request_stats_info.record_by_default_threshold_all_or_name_set_, cdev)) {
@@ -148,13 +284,12 @@ bool ThermalStatsHelper::initializeSensorCdevRequestStats(
                     std::iota(thresholds.begin(), thresholds.end(), starting_state);
                     const auto logging_name = cdev + kCompressedThresholdSuffix.data();
                     ThresholdList<int> threshold_list(logging_name, thresholds);
-                    sensor_cdev_request_stats_map_[sensor][cdev]
-                            .stats_by_custom_threshold.emplace_back(threshold_list);
+                    get_request_stats().by_custom_threshold.emplace_back(threshold_list, now_ns);
                 } else {
                     // buckets = [0, 1, 2, 3, ...max_state]
                     const auto default_threshold_time_in_state_size = max_state + 1;
-                    sensor_cdev_request_stats_map_[sensor][cdev].stats_by_default_threshold =
-                            StatsRecord(default_threshold_time_in_state_size);
+                    get_request_stats().by_default_threshold = std::make_unique<ResidencyCounter>(
+                            default_threshold_time_in_state_size, now_ns);
                 }
                 LOG(INFO) << "Sensor Cdev user vote stats on basis of all state initialized for ["
                           << sensor << "-" << cdev << "]";
@@ -172,8 +307,7 @@ bool ThermalStatsHelper::initializeSensorCdevRequestStats(
                         sensor_cdev_request_stats_map_.clear();
                         return false;
                     }
-                    sensor_cdev_request_stats_map_[sensor][cdev]
-                            .stats_by_custom_threshold.emplace_back(threshold_list);
+                    get_request_stats().by_custom_threshold.emplace_back(threshold_list, now_ns);
                     LOG(INFO)
                             << "Sensor Cdev user vote stats on basis of threshold initialized for ["
                             << sensor << "-" << cdev << "]";
@@ -187,17 +321,19 @@ bool ThermalStatsHelper::initializeSensorCdevRequestStats(
 bool ThermalStatsHelper::initializeSensorTempStats(
         const StatsInfo<float> &sensor_stats_info,
         const std::unordered_map<std::string, SensorInfo> &sensor_info_map_) {
-    std::unique_lock<std::shared_mutex> _lock(sensor_stats_mutex_);
-    auto &temp_stats_map_ = sensor_stats.temp_stats_map_;
-    const int severity_time_in_state_size = kThrottlingSeverityCount;
+    const int64_t now_ns = toNs(boot_clock::now());
     for (const auto &[sensor, sensor_info] : sensor_info_map_) {
+        // Every sensor gets an entry so the abnormality checks can be set up later
+        auto &sensor_stats = sensor_stats_map_[sensor];
+        sensor_stats = std::make_unique<SensorStatsEntry>();
         // Record by severity
         if (sensor_info.is_watch &&
             isRecordByDefaultThreshold(
                     sensor_stats_info.record_by_default_threshold_all_or_name_set_, sensor)) {
             // number of buckets = number of severity
-            temp_stats_map_[sensor].stats_by_default_threshold =
-                    StatsRecord(severity_time_in_state_size);
+            sensor_stats->by_default_threshold =
+                    std::make_unique<ResidencyCounter>(kThrottlingSeverityCount, now_ns);
+            sensor_stats->record_temp = true;
             LOG(INFO) << "Sensor temp stats on basis of severity initialized for [" << sensor
                       << "]";
         }
@@ -205,7 +341,8 @@ bool ThermalStatsHelper::initializeSensorTempStats(
         // Record by custom threshold
         if (sensor_stats_info.record_by_threshold.count(sensor)) {
             for (const auto &threshold_list : sensor_stats_info.record_by_threshold.at(sensor)) {
-                temp_stats_map_[sensor].stats_by_custom_threshold.emplace_back(threshold_list);
+                sensor_stats->by_custom_threshold.emplace_back(threshold_list, now_ns);
+                sensor_stats->record_temp = true;
                 LOG(INFO) << "Sensor temp stats on basis of threshold initialized for [" << sensor
                           << "]";
             }
@@ -217,21 +354,18 @@ bool ThermalStatsHelper::initializeSensorTempStats(
 bool ThermalStatsHelper::initializeSensorAbnormalityStats(
         const AbnormalStatsInfo &abnormal_stats_info,
         const std::unordered_map<std::string, SensorInfo> &sensor_info_map_) {
-    std::unique_lock<std::shared_mutex> _lock(sensor_stats_mutex_);
-    auto &temp_range_info_map_ = sensor_stats.temp_range_info_map_;
     for (const auto &sensors_temp_range_info : abnormal_stats_info.sensors_temp_range_infos) {
         const auto &temp_range_info_ptr =
                 std::make_shared<TempRangeInfo>(sensors_temp_range_info.temp_range_info);
         for (const auto &sensor : sensors_temp_range_info.sensors) {
-            temp_range_info_map_[sensor] = temp_range_info_ptr;
+            sensor_stats_map_.at(sensor)->temp_range_info = temp_range_info_ptr;
         }
     }
-    auto &temp_stuck_info_map_ = sensor_stats.temp_stuck_info_map_;
     for (const auto &sensors_temp_stuck_info : abnormal_stats_info.sensors_temp_stuck_infos) {
         const auto &temp_stuck_info_ptr =
                 std::make_shared<TempStuckInfo>(sensors_temp_stuck_info.temp_stuck_info);
         for (const auto &sensor : sensors_temp_stuck_info.sensors) {
-            temp_stuck_info_map_[sensor] = temp_stuck_info_ptr;
+            sensor_stats_map_.at(sensor)->temp_stuck_info = temp_stuck_info_ptr;
         }
     }
     const auto &default_temp_range_info_ptr =
@@ -245,126 +379,114 @@ bool ThermalStatsHelper::initializeSensorAbnormalityStats(
                               abnormal_stats_info.default_temp_stuck_info.value())
                     : nullptr;
     for (const auto &sensor_info : sensor_info_map_) {
-        const auto &sensor = sensor_info.first;
-        if (default_temp_range_info_ptr && !temp_range_info_map_.count(sensor))
-            temp_range_info_map_[sensor] = default_temp_range_info_ptr;
-        if (default_temp_stuck_info_ptr && !temp_stuck_info_map_.count(sensor))
-            temp_stuck_info_map_[sensor] = default_temp_stuck_info_ptr;
-    }
-
-    for (const auto &sensor_temp_stuck_info : temp_stuck_info_map_) {
-        sensor_stats.curr_temp_status_map_[sensor_temp_stuck_info.first] = {
-                .temp = std::numeric_limits<float>::min(),
-                .start_time = boot_clock::time_point::min(),
-                .repeat_count = 0,
-        };
+        auto &sensor_stats = *sensor_stats_map_.at(sensor_info.first);
+        if (default_temp_range_info_ptr && !sensor_stats.temp_range_info)
+            sensor_stats.temp_range_info = default_temp_range_info_ptr;
+        if (default_temp_stuck_info_ptr && !sensor_stats.temp_stuck_info)
+            sensor_stats.temp_stuck_info = default_temp_stuck_info_ptr;
+        if (sensor_stats.temp_stuck_info) {
+            sensor_stats.curr_temp_status = {
+                    .temp = std::numeric_limits<float>::min(),
+                    .start_time = boot_clock::time_point::min(),
+                    .repeat_count = 0,
+            };
+        }
     }
     return true;
 }
 
-void ThermalStatsHelper::updateStatsRecord(StatsRecord *stats_record, int new_state) {
-    const auto now = boot_clock::now();
-    const auto cur_state_duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-            now - stats_record->cur_state_start_time);
-    LOG(VERBOSE) << "Adding duration " << cur_state_duration.count()
-                 << " for cur_state: " << stats_record->cur_state << " with value: "
-                 << stats_record->time_in_state_ms[stats_record->cur_state].count();
-    // Update last record end time
-    stats_record->time_in_state_ms[stats_record->cur_state] += cur_state_duration;
-    stats_record->cur_state_start_time = now;
-    stats_record->cur_state = new_state;
-}
-
 void ThermalStatsHelper::updateSensorCdevRequestStats(std::string_view sensor,
                                                       std::string_view cdev, int new_value) {
-    std::unique_lock<std::shared_mutex> _lock(sensor_cdev_request_stats_map_mutex_);
-    if (!sensor_cdev_request_stats_map_.count(sensor.data()) ||
-        !sensor_cdev_request_stats_map_[sensor.data()].count(cdev.data())) {
+    const auto sensor_it = sensor_cdev_request_stats_map_.find(std::string(sensor));
+    if (sensor_it == sensor_cdev_request_stats_map_.end()) {
         return;
     }
-    auto &request_stats = sensor_cdev_request_stats_map_[sensor.data()][cdev.data()];
-    for (auto &stats_by_threshold : request_stats.stats_by_custom_threshold) {
-        int value = calculateThresholdBucket(stats_by_threshold.thresholds, new_value);
-        if (value != stats_by_threshold.stats_record.cur_state) {
-            LOG(VERBOSE) << "Updating bindedCdev stats for sensor: " << sensor.data()
-                         << " , cooling_device: " << cdev.data() << " with new value: " << value;
-            updateStatsRecord(&stats_by_threshold.stats_record, value);
-        }
+    const auto cdev_it = sensor_it->second.find(std::string(cdev));
+    if (cdev_it == sensor_it->second.end()) {
+        return;
     }
-
-    if (request_stats.stats_by_default_threshold.has_value()) {
-        auto &stats_record = request_stats.stats_by_default_threshold.value();
-        if (new_value != stats_record.cur_state) {
-            LOG(VERBOSE) << "Updating bindedCdev stats for sensor: " << sensor.data()
-                         << " , cooling_device: " << cdev.data()
-                         << " with new value: " << new_value;
-            updateStatsRecord(&stats_record, new_value);
-        }
+    auto &request_stats = *cdev_it->second;
+    const int64_t now_ns = toNs(boot_clock::now());
+    request_stats.seq_lock.writeLock();
+    for (auto &by_threshold : request_stats.by_custom_threshold) {
+        by_threshold.counter.update(calculateThresholdBucket(by_threshold.thresholds, new_value),
+                                    now_ns);
     }
+    if (request_stats.by_default_threshold) {
+        request_stats.by_default_threshold->update(new_value, now_ns);
+    }
+    request_stats.seq_lock.writeUnlock();
 }
 
 void ThermalStatsHelper::updateSensorTempStatsByThreshold(std::string_view sensor,
                                                           float temperature) {
-    std::unique_lock<std::shared_mutex> _lock(sensor_stats_mutex_);
-    verifySensorAbnormality(sensor, temperature);
-    auto &temp_stats_map_ = sensor_stats.temp_stats_map_;
-    if (!temp_stats_map_.count(sensor.data())) {
+    const auto sensor_it = sensor_stats_map_.find(std::string(sensor));
+    if (sensor_it == sensor_stats_map_.end()) {
         return;
     }
-    auto &sensor_temp_stats = temp_stats_map_[sensor.data()];
-    for (auto &stats_by_threshold : sensor_temp_stats.stats_by_custom_threshold) {
-        int value = calculateThresholdBucket(stats_by_threshold.thresholds, temperature);
-        if (value != stats_by_threshold.stats_record.cur_state) {
-            LOG(VERBOSE) << "Updating sensor stats for sensor: " << sensor.data()
-                         << " with value: " << value;
-            updateStatsRecord(&stats_by_threshold.stats_record, value);
+    auto &sensor_stats = *sensor_it->second;
+    const int64_t now_ns = toNs(boot_clock::now());
+    sensor_stats.seq_lock.writeLock();
+    verifySensorAbnormality(sensor, &sensor_stats, temperature);
+    if (sensor_stats.record_temp) {
+        for (auto &by_threshold : sensor_stats.by_custom_threshold) {
+            by_threshold.counter.update(
+                    calculateThresholdBucket(by_threshold.thresholds, temperature), now_ns);
+        }
+        if (sensor_stats.reset_temp_range.exchange(false, std::memory_order_relaxed)) {
+            sensor_stats.max_temp.store(std::numeric_limits<float>::min(),
+                                        std::memory_order_relaxed);
+            sensor_stats.min_temp.store(std::numeric_limits<float>::max(),
+                                        std::memory_order_relaxed);
+        }
+        if (temperature > sensor_stats.max_temp.load(std::memory_order_relaxed)) {
+            sensor_stats.max_temp.store(temperature, std::memory_order_relaxed);
+            sensor_stats.max_temp_timestamp.store(
+                    system_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+        }
+        if (temperature < sensor_stats.min_temp.load(std::memory_order_relaxed)) {
+            sensor_stats.min_temp.store(temperature, std::memory_order_relaxed);
+            sensor_stats.min_temp_timestamp.store(
+                    system_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
         }
     }
-    if (temperature > sensor_temp_stats.max_temp) {
-        sensor_temp_stats.max_temp = temperature;
-        sensor_temp_stats.max_temp_timestamp = system_clock::now();
-    }
-    if (temperature < sensor_temp_stats.min_temp) {
-        sensor_temp_stats.min_temp = temperature;
-        sensor_temp_stats.min_temp_timestamp = system_clock::now();
-    }
+    sensor_stats.seq_lock.writeUnlock();
 }
 
 void ThermalStatsHelper::updateSensorTempStatsBySeverity(std::string_view sensor,
                                                          const ThrottlingSeverity &severity) {
-    std::unique_lock<std::shared_mutex> _lock(sensor_stats_mutex_);
-    auto &temp_stats_map_ = sensor_stats.temp_stats_map_;
-    if (temp_stats_map_.count(sensor.data()) &&
-        temp_stats_map_[sensor.data()].stats_by_default_threshold.has_value()) {
-        auto &stats_record = temp_stats_map_[sensor.data()].stats_by_default_threshold.value();
-        int value = static_cast<int>(severity);
-        if (value != stats_record.cur_state) {
-            LOG(VERBOSE) << "Updating sensor stats for sensor: " << sensor.data()
-                         << " with value: " << value;
-            updateStatsRecord(&stats_record, value);
-        }
+    const auto sensor_it = sensor_stats_map_.find(std::string(sensor));
+    if (sensor_it == sensor_stats_map_.end() || !sensor_it->second->by_default_threshold) {
+        return;
     }
+    auto &sensor_stats = *sensor_it->second;
+    const int64_t now_ns = toNs(boot_clock::now());
+    sensor_stats.seq_lock.writeLock();
+    sensor_stats.by_default_threshold->update(static_cast<int>(severity), now_ns);
+    sensor_stats.seq_lock.writeUnlock();
 }
 
-void ThermalStatsHelper::verifySensorAbnormality(std::string_view sensor, float temp) {
+void ThermalStatsHelper::verifySensorAbnormality(std::string_view sensor,
+                                                 SensorStatsEntry *sensor_stats, float temp) {
     LOG(VERBOSE) << "Verify sensor abnormality for " << sensor << " with temp " << temp;
-    if (sensor_stats.temp_range_info_map_.count(sensor.data())) {
-        const auto &temp_range_info = sensor_stats.temp_range_info_map_[sensor.data()];
+    if (sensor_stats->temp_range_info) {
+        const auto &temp_range_info = sensor_stats->temp_range_info;
         if (temp < temp_range_info->min_temp_threshold) {
-            LOG(ERROR) << "Outlier Temperature Detected, sensor: " << sensor.data()
+            LOG(ERROR) << "Outlier Temperature Detected, sensor: " << sensor
                        << " temp: " << temp << " < " << temp_range_info->min_temp_threshold;
             reportThermalAbnormality(ThermalSensorAbnormalityDetected::EXTREME_LOW_TEMP, sensor,
                                      std::round(temp));
         } else if (temp > temp_range_info->max_temp_threshold) {
-            LOG(ERROR) << "Outlier Temperature Detected, sensor: " << sensor.data()
+            LOG(ERROR) << "Outlier Temperature Detected, sensor: " << sensor
                        << " temp: " << temp << " > " << temp_range_info->max_temp_threshold;
             reportThermalAbnormality(ThermalSensorAbnormalityDetected::EXTREME_HIGH_TEMP, sensor,
                                      std::round(temp));
         }
     }
-    if (sensor_stats.temp_stuck_info_map_.count(sensor.data())) {
-        const auto &temp_stuck_info = sensor_stats.temp_stuck_info_map_[sensor.data()];
-        auto &curr_temp_status = sensor_stats.curr_temp_status_map_[sensor.data()];
+    if (sensor_stats->temp_stuck_info) {
+        const auto &temp_stuck_info = sensor_stats->temp_stuck_info;
+        auto &curr_temp_status = sensor_stats->curr_temp_status;
+        const auto now = boot_clock::now();
         LOG(VERBOSE) << "Current Temp Status: temp=" << curr_temp_status.temp
                      << " repeat_count=" << curr_temp_status.repeat_count
                      << " start_time=" << curr_temp_status.start_time.time_since_epoch().count();
@@ -372,9 +494,9 @@ void ThermalStatsHelper::verifySensorAbnormality(std::string_view sensor, float
             curr_temp_status.repeat_count++;
             if (temp_stuck_info->min_polling_count <= curr_temp_status.repeat_count) {
                 auto time_elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                        boot_clock::now() - curr_temp_status.start_time);
+                        now - curr_temp_status.start_time);
                 if (temp_stuck_info->min_stuck_duration <= time_elapsed_ms) {
-                    LOG(ERROR) << "Stuck Temperature Detected, sensor: " << sensor.data()
+                    LOG(ERROR) << "Stuck Temperature Detected, sensor: " << sensor
                                << " temp: " << temp << " repeated "
                                << temp_stuck_info->min_polling_count << " times for "
                                << time_elapsed_ms.count() << "ms";
@@ -382,206 +504,176 @@ void ThermalStatsHelper::verifySensorAbnormality(std::string_view sensor, float
                                                  sensor, std::round(temp))) {
                         // reset current status to verify for sensor stuck with start time as
                         // current polling
-                        resetCurrentTempStatus(&curr_temp_status, temp);
+                        resetCurrentTempStatus(&curr_temp_status, temp, now);
                     }
                 }
             }
         } else {
-            resetCurrentTempStatus(&curr_temp_status, temp);
+            resetCurrentTempStatus(&curr_temp_status, temp, now);
         }
     }
 }
 
-int ThermalStatsHelper::reportStats() {
-    const auto curTime = boot_clock::now();
-    const auto since_last_total_stats_update_ms =
-            std::chrono::duration_cast<std::chrono::milliseconds>(curTime -
-                                                                  last_total_stats_report_time);
-    LOG(VERBOSE) << "Duration from last total stats update is: "
-                 << since_last_total_stats_update_ms.count();
-    if (since_last_total_stats_update_ms < kUpdateIntervalMs) {
-        LOG(VERBOSE) << "Time elapsed since last update less than " << kUpdateIntervalMs.count();
-        return 0;
-    }
-
-    const std::shared_ptr<IStats> stats_client = getStatsService();
-    if (!stats_client) {
-        LOG(ERROR) << "Unable to get AIDL Stats service";
-        return -1;
-    }
-    int count_failed_reporting =
-            reportAllSensorTempStats(stats_client) + reportAllSensorCdevRequestStats(stats_client);
-    last_total_stats_report_time = curTime;
-    abnormal_stats_reported_per_update_interval = 0;
-    return count_failed_reporting;
+void ThermalStatsHelper::requestReport() {
+    stats_atom_reporter_.requestReport();
 }
 
-int ThermalStatsHelper::reportAllSensorTempStats(const std::shared_ptr<IStats> &stats_client) {
-    int count_failed_reporting = 0;
-    std::unique_lock<std::shared_mutex> _lock(sensor_stats_mutex_);
-    for (auto &[sensor, temp_stats] : sensor_stats.temp_stats_map_) {
-        for (size_t threshold_set_idx = 0;
-             threshold_set_idx < temp_stats.stats_by_custom_threshold.size(); threshold_set_idx++) {
-            auto &stats_by_threshold = temp_stats.stats_by_custom_threshold[threshold_set_idx];
-            std::string sensor_name = stats_by_threshold.logging_name.value_or(
-                    sensor + kCustomThresholdSetSuffix.data() + std::to_string(threshold_set_idx));
-            if (!reportSensorTempStats(stats_client, sensor_name, temp_stats,
-                                       &stats_by_threshold.stats_record)) {
-                count_failed_reporting++;
-            }
+std::vector<PendingAtom> ThermalStatsHelper::collectStatsAtoms() {
+    std::vector<PendingAtom> atoms;
+    for (auto &[sensor, sensor_stats] : sensor_stats_map_) {
+        if (sensor_stats->record_temp) {
+            collectSensorTempStatsAtoms(sensor, sensor_stats.get(), &atoms);
         }
-        if (temp_stats.stats_by_default_threshold.has_value()) {
-            if (!reportSensorTempStats(stats_client, sensor, temp_stats,
-                                       &temp_stats.stats_by_default_threshold.value())) {
-                count_failed_reporting++;
-            }
+    }
+    for (auto &[sensor, cdev_request_stats_map] : sensor_cdev_request_stats_map_) {
+        for (auto &[cdev, request_stats] : cdev_request_stats_map) {
+            collectSensorCdevRequestStatsAtoms(sensor, cdev, request_stats.get(), &atoms);
         }
-        // Reset temp stats after reporting
-        temp_stats.max_temp = std::numeric_limits<float>::min();
-        temp_stats.min_temp = std::numeric_limits<float>::max();
     }
-    return count_failed_reporting;
+    abnormal_stats_reported_per_update_interval = 0;
+    LOG(VERBOSE) << "Collected " << atoms.size() << " thermal stats atoms";
+    return atoms;
 }
 
-bool ThermalStatsHelper::reportSensorTempStats(const std::shared_ptr<IStats> &stats_client,
-                                               std::string_view sensor,
-                                               const SensorTempStats &sensor_temp_stats,
-                                               StatsRecord *stats_record) {
+void ThermalStatsHelper::collectSensorTempStatsAtoms(std::string_view sensor,
+                                                     SensorStatsEntry *sensor_stats,
+                                                     std::vector<PendingAtom> *atoms) {
     LOG(VERBOSE) << "Reporting sensor stats for " << sensor;
-    // maintain a copy in case reporting fails
-    StatsRecord thermal_stats_before_reporting = *stats_record;
-    std::vector<VendorAtomValue> values(2);
-    values[0].set<VendorAtomValue::stringValue>(sensor);
-    std::vector<int64_t> time_in_state_ms = processStatsRecordForReporting(stats_record);
-    const auto since_last_update_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-            stats_record->cur_state_start_time - stats_record->last_stats_report_time);
-    values[1].set<VendorAtomValue::longValue>(since_last_update_ms.count());
-    VendorAtomValue tmp;
-    for (auto &time_in_state : time_in_state_ms) {
-        tmp.set<VendorAtomValue::longValue>(time_in_state);
-        values.push_back(tmp);
-    }
-    auto remaining_residency_buckets_count = kMaxStatsResidencyCount - time_in_state_ms.size();
-    if (remaining_residency_buckets_count > 0) {
-        tmp.set<VendorAtomValue::longValue>(0);
-        values.insert(values.end(), remaining_residency_buckets_count, tmp);
-    }
-    tmp.set<VendorAtomValue::floatValue>(sensor_temp_stats.max_temp);
-    values.push_back(tmp);
-    tmp.set<VendorAtomValue::longValue>(
-            system_clock::to_time_t(sensor_temp_stats.max_temp_timestamp));
-    values.push_back(tmp);
-    tmp.set<VendorAtomValue::floatValue>(sensor_temp_stats.min_temp);
-    values.push_back(tmp);
-    tmp.set<VendorAtomValue::longValue>(
-            system_clock::to_time_t(sensor_temp_stats.min_temp_timestamp));
-    values.push_back(tmp);
-
-    if (!reportAtom(stats_client, PixelAtoms::Atom::kVendorTempResidencyStats, std::move(values))) {
-        LOG(ERROR) << "Unable to report VendorTempResidencyStats to Stats service for "
-                      "sensor: "
-                   << sensor;
-        *stats_record = restoreStatsRecordOnFailure(std::move(thermal_stats_before_reporting));
-        return false;
-    }
-    // Update last time of stats reporting
-    stats_record->last_stats_report_time = boot_clock::now();
-    return true;
-}
-
-int ThermalStatsHelper::reportAllSensorCdevRequestStats(
-        const std::shared_ptr<IStats> &stats_client) {
-    int count_failed_reporting = 0;
-    std::unique_lock<std::shared_mutex> _lock(sensor_cdev_request_stats_map_mutex_);
-    for (auto &[sensor, cdev_request_stats_map] : sensor_cdev_request_stats_map_) {
-        for (auto &[cdev, request_stats] : cdev_request_stats_map) {
-            for (size_t threshold_set_idx = 0;
-                 threshold_set_idx < request_stats.stats_by_custom_threshold.size();
-                 threshold_set_idx++) {
-                auto &stats_by_threshold =
-                        request_stats.stats_by_custom_threshold[threshold_set_idx];
-                std::string cdev_name = stats_by_threshold.logging_name.value_or(
-                        cdev + kCustomThresholdSetSuffix.data() +
-                        std::to_string(threshold_set_idx));
-                if (!reportSensorCdevRequestStats(stats_client, sensor, cdev_name,
-                                                  &stats_by_threshold.stats_record)) {
-                    count_failed_reporting++;
-                }
-            }
-
-            if (request_stats.stats_by_default_threshold.has_value()) {
-                if (!reportSensorCdevRequestStats(
-                            stats_client, sensor, cdev,
-                            &request_stats.stats_by_default_threshold.value())) {
-                    count_failed_reporting++;
-                }
-            }
+    const int64_t now_ns = toNs(boot_clock::now());
+    std::vector<std::vector<int64_t>> custom_threshold_ns;
+    std::vector<int64_t> default_threshold_ns;
+    float max_temp, min_temp;
+    int64_t max_temp_timestamp, min_temp_timestamp;
+    uint32_t seq;
+    do {
+        seq = sensor_stats->seq_lock.readBegin();
+        max_temp = sensor_stats->max_temp.load(std::memory_order_relaxed);
+        max_temp_timestamp = sensor_stats->max_temp_timestamp.load(std::memory_order_relaxed);
+        min_temp = sensor_stats->min_temp.load(std::memory_order_relaxed);
+        min_temp_timestamp = sensor_stats->min_temp_timestamp.load(std::memory_order_relaxed);
+    } while (sensor_stats->seq_lock.readRetry(seq));
+    readResidencyStats<float>(*sensor_stats, now_ns, &custom_threshold_ns, &default_threshold_ns);
+    // Reset temp stats after reporting
+    sensor_stats->reset_temp_range.store(true, std::memory_order_relaxed);
+
+    const auto append_temp_range = [&](PendingAtom *pending_atom) {
+        auto &values = pending_atom->atom.values;
+        // Name and time since the last report precede the residency buckets
+        const size_t residency_count = values.size() - 2;
+        if (residency_count < kMaxStatsResidencyCount) {
+            values.insert(values.end(), kMaxStatsResidencyCount - residency_count,
+                          VendorAtomValue::make<VendorAtomValue::longValue>(0));
         }
+        values.push_back(VendorAtomValue::make<VendorAtomValue::floatValue>(max_temp));
+        values.push_back(VendorAtomValue::make<VendorAtomValue::longValue>(
+                system_clock::to_time_t(toSystemTime(max_temp_timestamp))));
+        values.push_back(VendorAtomValue::make<VendorAtomValue::floatValue>(min_temp));
+        values.push_back(VendorAtomValue::make<VendorAtomValue::longValue>(
+                system_clock::to_time_t(toSystemTime(min_temp_timestamp))));
+    };
+    for (size_t threshold_set_idx = 0; threshold_set_idx < sensor_stats->by_custom_threshold.size();
+         threshold_set_idx++) {
+        auto &by_threshold = sensor_stats->by_custom_threshold[threshold_set_idx];
+        std::string sensor_name = by_threshold.logging_name.value_or(
+                std::string(sensor) + kCustomThresholdSetSuffix.data() +
+                std::to_string(threshold_set_idx));
+        std::vector<VendorAtomValue> values(1);
+        values[0].set<VendorAtomValue::stringValue>(sensor_name);
+        atoms->push_back(makeResidencyAtom(PixelAtoms::Atom::kVendorTempResidencyStats,
+                                           std::move(values), &by_threshold.counter,
+                                           custom_threshold_ns[threshold_set_idx], now_ns));
+        append_temp_range(&atoms->back());
+    }
+    if (sensor_stats->by_default_threshold) {
+        std::vector<VendorAtomValue> values(1);
+        values[0].set<VendorAtomValue::stringValue>(sensor);
+        atoms->push_back(makeResidencyAtom(PixelAtoms::Atom::kVendorTempResidencyStats,
+                                           std::move(values),
+                                           sensor_stats->by_default_threshold.get(),
+                                           default_threshold_ns, now_ns));
+        append_temp_range(&atoms->back());
     }
-    return count_failed_reporting;
 }
 
-bool ThermalStatsHelper::reportSensorCdevRequestStats(const std::shared_ptr<IStats> &stats_client,
-                                                      std::string_view sensor,
-                                                      std::string_view cdev,
-                                                      StatsRecord *stats_record) {
+void ThermalStatsHelper::collectSensorCdevRequestStatsAtoms(std::string_view sensor,
+                                                            std::string_view cdev,
+                                                            ResidencyStats<int> *request_stats,
+                                                            std::vector<PendingAtom> *atoms) {
     LOG(VERBOSE) << "Reporting bindedCdev stats for sensor: " << sensor
                  << " cooling_device: " << cdev;
-    // maintain a copy in case reporting fails
-    StatsRecord thermal_stats_before_reporting = *stats_record;
-    std::vector<VendorAtomValue> values(3);
-    values[0].set<VendorAtomValue::stringValue>(sensor);
-    values[1].set<VendorAtomValue::stringValue>(cdev);
-    std::vector<int64_t> time_in_state_ms = processStatsRecordForReporting(stats_record);
-    const auto since_last_update_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-            stats_record->cur_state_start_time - stats_record->last_stats_report_time);
-    values[2].set<VendorAtomValue::longValue>(since_last_update_ms.count());
-    VendorAtomValue tmp;
-    for (auto &time_in_state : time_in_state_ms) {
-        tmp.set<VendorAtomValue::longValue>(time_in_state);
-        values.push_back(tmp);
-    }
-
-    if (!reportAtom(stats_client, PixelAtoms::Atom::kVendorSensorCoolingDeviceStats,
-                    std::move(values))) {
-        LOG(ERROR) << "Unable to report VendorSensorCoolingDeviceStats to Stats "
-                      "service for sensor: "
-                   << sensor << " cooling_device: " << cdev;
-        *stats_record = restoreStatsRecordOnFailure(std::move(thermal_stats_before_reporting));
-        return false;
+    const int64_t now_ns = toNs(boot_clock::now());
+    std::vector<std::vector<int64_t>> custom_threshold_ns;
+    std::vector<int64_t> default_threshold_ns;
+    readResidencyStats(*request_stats, now_ns, &custom_threshold_ns, &default_threshold_ns);
+
+    for (size_t threshold_set_idx = 0;
+         threshold_set_idx < request_stats->by_custom_threshold.size(); threshold_set_idx++) {
+        auto &by_threshold = request_stats->by_custom_threshold[threshold_set_idx];
+        std::string cdev_name = by_threshold.logging_name.value_or(
+                std::string(cdev) + kCustomThresholdSetSuffix.data() +
+                std::to_string(threshold_set_idx));
+        std::vector<VendorAtomValue> values(2);
+        values[0].set<VendorAtomValue::stringValue>(sensor);
+        values[1].set<VendorAtomValue::stringValue>(cdev_name);
+        atoms->push_back(makeResidencyAtom(PixelAtoms::Atom::kVendorSensorCoolingDeviceStats,
+                                           std::move(values), &by_threshold.counter,
+                                           custom_threshold_ns[threshold_set_idx], now_ns));
+    }
+    if (request_stats->by_default_threshold) {
+        std::vector<VendorAtomValue> values(2);
+        values[0].set<VendorAtomValue::stringValue>(sensor);
+        values[1].set<VendorAtomValue::stringValue>(cdev);
+        atoms->push_back(makeResidencyAtom(PixelAtoms::Atom::kVendorSensorCoolingDeviceStats,
+                                           std::move(values),
+                                           request_stats->by_default_threshold.get(),
+                                           default_threshold_ns, now_ns));
     }
-    // Update last time of stats reporting
-    stats_record->last_stats_report_time = boot_clock::now();
-    return true;
 }
 
-std::vector<int64_t> ThermalStatsHelper::processStatsRecordForReporting(StatsRecord *stats_record) {
-    // update the last unclosed entry and start new record with same state
-    updateStatsRecord(stats_record, stats_record->cur_state);
-    std::vector<std::chrono::milliseconds> &time_in_state_ms = stats_record->time_in_state_ms;
-    // convert std::chrono::milliseconds time_in_state to int64_t vector for reporting
-    std::vector<int64_t> stats_residency(time_in_state_ms.size());
-    std::transform(time_in_state_ms.begin(), time_in_state_ms.end(), stats_residency.begin(),
-                   [](std::chrono::milliseconds time_ms) { return time_ms.count(); });
-    // clear previous stats
-    std::fill(time_in_state_ms.begin(), time_in_state_ms.end(), std::chrono::milliseconds::zero());
-    return stats_residency;
+PendingAtom ThermalStatsHelper::makeResidencyAtom(int32_t atom_id,
+                                                  std::vector<VendorAtomValue> &&values,
+                                                  ResidencyCounter *counter,
+                                                  const std::vector<int64_t> &time_in_state_ns,
+                                                  int64_t now_ns) {
+    const auto since_last_update_ms =
+            nsToMs(now_ns - counter->last_report_ns.load(std::memory_order_relaxed));
+    values.push_back(
+            VendorAtomValue::make<VendorAtomValue::longValue>(since_last_update_ms.count()));
+    for (size_t i = 0; i < time_in_state_ns.size(); ++i) {
+        const int64_t reported_ns = counter->reported_ns[i].load(std::memory_order_relaxed);
+        values.push_back(VendorAtomValue::make<VendorAtomValue::longValue>(
+                nsToMs(time_in_state_ns[i] - reported_ns).count()));
+    }
+    return PendingAtom{
+            .atom = {.reverseDomainName = "", .atomId = atom_id, .values = std::move(values)},
+            // The residency read above is what this atom carries, move the baseline up to it
+            // once delivered. A record failing too often is dropped to avoid overflow.
+            .on_done =
+                    [counter, time_in_state_ns, now_ns](bool delivered) {
+                        if (!delivered && counter->report_fail_count.fetch_add(1) + 1 <
+                                                  kMaxStatsReportingFailCount) {
+                            return;
+                        }
+                        for (size_t i = 0; i < time_in_state_ns.size(); ++i) {
+                            counter->reported_ns[i].store(time_in_state_ns[i],
+                                                          std::memory_order_relaxed);
+                        }
+                        counter->last_report_ns.store(now_ns, std::memory_order_relaxed);
+                        counter->report_fail_count = 0;
+                    },
+    };
 }
 
 bool ThermalStatsHelper::reportThermalAbnormality(
         const ThermalSensorAbnormalityDetected::AbnormalityType &type, std::string_view name,
         std::optional<int> reading) {
     const auto value_str = reading.has_value() ? std::to_string(reading.value()) : "undefined";
-    if (abnormal_stats_reported_per_update_interval >= kMaxAbnormalLoggingPerUpdateInterval) {
-        LOG(ERROR) << "Thermal abnormal atom logging rate limited for " << name.data()
+    if (abnormal_stats_reported_per_update_interval.fetch_add(1) >=
+        kMaxAbnormalLoggingPerUpdateInterval) {
+        LOG(ERROR) << "Thermal abnormal atom logging rate limited for " << name
                    << " with value " << value_str;
         return true;
     }
-    const std::shared_ptr<IStats> stats_client = getStatsService();
-    if (!stats_client) {
-        LOG(ERROR) << "Unable to get AIDL Stats service";
-        return false;
-    }
     std::vector<VendorAtomValue> values(3);
     values[ThermalSensorAbnormalityDetected::kTypeFieldNumber - kVendorAtomOffset] =
             VendorAtomValue::make<VendorAtomValue::intValue>(type);
@@ -597,72 +689,59 @@ bool ThermalStatsHelper::reportThermalAbnormality(
         thermal_helper_handle_->dumpTraces(name);
     }
 
-    if (!reportAtom(stats_client, PixelAtoms::Atom::kThermalSensorAbnormalityDetected,
-                    std::move(values))) {
-        LOG(ERROR) << "Failed to log thermal abnormal atom for " << name.data() << " with value "
+    PendingAtom pending_atom{
+            .atom = {.reverseDomainName = "",
+                     .atomId = PixelAtoms::Atom::kThermalSensorAbnormalityDetected,
+                     .values = std::move(values)},
+            .on_done =
+                    [name = std::string(name), value_str](bool delivered) {
+                        if (delivered) {
+                            LOG(INFO) << "Thermal abnormality reported for " << name
+                                      << " with value " << value_str;
+                        } else {
+                            LOG(ERROR) << "Failed to log thermal abnormal atom for " << name
+                                       << " with value " << value_str;
+                        }
+                    },
+    };
+    if (!stats_atom_reporter_.enqueue(std::move(pending_atom))) {
+        LOG(ERROR) << "Thermal abnormal atom queue full, dropped " << name << " with value "
                    << value_str;
+        abnormal_stats_reported_per_update_interval--;
         return false;
     }
-    LOG(INFO) << "Thermal abnormality reported for " << name.data() << " with value " << value_str;
-    abnormal_stats_reported_per_update_interval++;
     return true;
 }
 
-bool ThermalStatsHelper::reportAtom(const std::shared_ptr<IStats> &stats_client,
-                                    const int32_t &atom_id, std::vector<VendorAtomValue> &&values) {
-    LOG(VERBOSE) << "Reporting thermal stats for atom_id " << atom_id;
-    // Send vendor atom to IStats HAL
-    VendorAtom event = {.reverseDomainName = "", .atomId = atom_id, .values = std::move(values)};
-    const ndk::ScopedAStatus ret = stats_client->reportVendorAtom(event);
-    return ret.isOk();
-}
-
-StatsRecord ThermalStatsHelper::restoreStatsRecordOnFailure(
-        StatsRecord &&stats_record_before_failure) {
-    stats_record_before_failure.report_fail_count += 1;
-    // If consecutive count of failure is high, reset stat to avoid overflow
-    if (stats_record_before_failure.report_fail_count >= kMaxStatsReportingFailCount) {
-        return StatsRecord(stats_record_before_failure.time_in_state_ms.size(),
-                           stats_record_before_failure.cur_state);
-    } else {
-        return stats_record_before_failure;
-    }
-}
-
 std::unordered_map<std::string, SensorTempStats> ThermalStatsHelper::GetSensorTempStatsSnapshot() {
-    auto sensor_temp_stats_snapshot = sensor_stats.temp_stats_map_;
-    for (auto &sensor_temp_stats_pair : sensor_temp_stats_snapshot) {
-        for (auto &temp_stats : sensor_temp_stats_pair.second.stats_by_custom_threshold) {
-            // update the last unclosed entry and start new record with same state
-            updateStatsRecord(&temp_stats.stats_record, temp_stats.stats_record.cur_state);
-        }
-        if (sensor_temp_stats_pair.second.stats_by_default_threshold.has_value()) {
-            auto &stats_by_default_threshold =
-                    sensor_temp_stats_pair.second.stats_by_default_threshold.value();
-            // update the last unclosed entry and start new record with same state
-            updateStatsRecord(&stats_by_default_threshold, stats_by_default_threshold.cur_state);
+    const int64_t now_ns = toNs(boot_clock::now());
+    std::unordered_map<std::string, SensorTempStats> sensor_temp_stats_snapshot;
+    for (const auto &[sensor, sensor_stats] : sensor_stats_map_) {
+        if (!sensor_stats->record_temp) {
+            continue;
         }
+        auto &sensor_temp_stats = sensor_temp_stats_snapshot[sensor];
+        static_cast<ThermalStats<float> &>(sensor_temp_stats) =
+                makeThermalStats<float>(*sensor_stats, now_ns);
+        sensor_temp_stats.max_temp = sensor_stats->max_temp.load(std::memory_order_relaxed);
+        sensor_temp_stats.max_temp_timestamp =
+                toSystemTime(sensor_stats->max_temp_timestamp.load(std::memory_order_relaxed));
+        sensor_temp_stats.min_temp = sensor_stats->min_temp.load(std::memory_order_relaxed);
+        sensor_temp_stats.min_temp_timestamp =
+                toSystemTime(sensor_stats->min_temp_timestamp.load(std::memory_order_relaxed));
     }
     return sensor_temp_stats_snapshot;
 }
 
 std::unordered_map<std::string, std::unordered_map<std::string, ThermalStats<int>>>
 ThermalStatsHelper::GetSensorCoolingDeviceRequestStatsSnapshot() {
-    auto sensor_cdev_request_stats_snapshot = sensor_cdev_request_stats_map_;
-    for (auto &sensor_cdev_request_stats_pair : sensor_cdev_request_stats_snapshot) {
-        for (auto &cdev_request_stats_pair : sensor_cdev_request_stats_pair.second) {
-            for (auto &request_stats : cdev_request_stats_pair.second.stats_by_custom_threshold) {
-                // update the last unclosed entry and start new record with same state
-                updateStatsRecord(&request_stats.stats_record,
-                                  request_stats.stats_record.cur_state);
-            }
-            if (cdev_request_stats_pair.second.stats_by_default_threshold.has_value()) {
-                auto &stats_by_default_threshold =
-                        cdev_request_stats_pair.second.stats_by_default_threshold.value();
-                // update the last unclosed entry and start new record with same state
-                updateStatsRecord(&stats_by_default_threshold,
-                                  stats_by_default_threshold.cur_state);
-            }
+    const int64_t now_ns = toNs(boot_clock::now());
+    std::unordered_map<std::string, std::unordered_map<std::string, ThermalStats<int>>>
+            sensor_cdev_request_stats_snapshot;
+    for (const auto &[sensor, cdev_request_stats_map] : sensor_cdev_request_stats_map_) {
+        for (const auto &[cdev, request_stats] : cdev_request_stats_map) {
+            sensor_cdev_request_stats_snapshot[sensor][cdev] =
+                    makeThermalStats(*request_stats, now_ns);
         }
     }
     return sensor_cdev_request_stats_snapshot;
@@ -21,12 +21,15 @@
 #include <android-base/chrono_utils.h>
 #include <hardware/google/pixel/pixelstats/pixelatoms.pb.h>
 
+#include <atomic>
 #include <chrono>
-#include <shared_mutex>
+#include <deque>
 #include <string_view>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
+#include "stats_atom_reporter.h"
 #include "thermal_info.h"
 
 namespace aidl {
@@ -44,8 +47,9 @@ using ::android::hardware::google::pixel::PixelAtoms::ThermalSensorAbnormalityDe
 using std::chrono::system_clock;
 using SystemTimePoint = std::chrono::time_point<std::chrono::system_clock>;
 
-// Number of abnormal atoms to be logged per kUpdateIntervalMs
+// Number of abnormal atoms to be logged per report interval
 constexpr int kMaxAbnormalLoggingPerUpdateInterval = 20;
+// Undelivered reports of a stats record before its residency is dropped
 constexpr int kMaxStatsReportingFailCount = 3;
 // Proto messages are 1-indexed and VendorAtom field numbers start at 2, so
 // store everything in the values array at the index of the field number
@@ -115,25 +119,107 @@ struct CurrTempStatus {
     int repeat_count;
 };
 
-struct SensorStats {
-    // Temperature residency stats for each sensor being watched
-    std::unordered_map<std::string, SensorTempStats> temp_stats_map_;
-    // Min, Max Temp threshold info for each sensor being monitored
-    std::unordered_map<std::string, std::shared_ptr<TempRangeInfo>> temp_range_info_map_;
-    // Temperature Stuck info for each sensor being monitored
-    std::unordered_map<std::string, std::shared_ptr<TempStuckInfo>> temp_stuck_info_map_;
-    // Current temperature status for each sensor being monitored for stuck
-    std::unordered_map<std::string, CurrTempStatus> curr_temp_status_map_;
+// Sequence word for a group of relaxed atomics. Writers serialize on an odd sequence, which only
+// spins against another writer of the same group, readers retry and never hold up a writer.
+class StatsSeqLock {
+  public:
+    void writeLock() {
+        uint32_t seq = seq_.load(std::memory_order_relaxed);
+        while ((seq & 1) || !seq_.compare_exchange_weak(seq, seq + 1, std::memory_order_relaxed)) {
+            if (seq & 1) {
+                std::this_thread::yield();
+                seq = seq_.load(std::memory_order_relaxed);
+            }
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+    void writeUnlock() { seq_.fetch_add(1, std::memory_order_release); }
+    uint32_t readBegin() const {
+        uint32_t seq;
+        while ((seq = seq_.load(std::memory_order_acquire)) & 1) {
+            std::this_thread::yield();
+        }
+        return seq;
+    }
+    bool readRetry(uint32_t seq) const {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return seq_.load(std::memory_order_relaxed) != seq;
+    }
+
+  private:
+    std::atomic<uint32_t> seq_ = 0;
+};
+
+// Residency of one stats record. The counters only grow: the reporter keeps the residency it
+// last delivered and reports the difference, so it never writes what the update path writes.
+class ResidencyCounter {
+  public:
+    ResidencyCounter(size_t state_count, int64_t now_ns);
+    // Called with the owner's write lock held
+    void update(int new_state, int64_t now_ns);
+    // Called in the owner's read section, the open entry is counted up to now_ns
+    void read(int64_t now_ns, std::vector<int64_t> *time_in_state_ns) const;
+    size_t size() const { return state_count_; }
+    int curState() const { return cur_state_.load(std::memory_order_relaxed); }
+
+    // Reporter side, written only by the reporter thread
+    std::unique_ptr<std::atomic<int64_t>[]> reported_ns;
+    std::atomic<int64_t> last_report_ns;
+    std::atomic<int> report_fail_count = 0;
+
+  private:
+    const size_t state_count_;
+    std::atomic<int> cur_state_ = 0;
+    std::atomic<int64_t> cur_state_start_ns_;
+    std::unique_ptr<std::atomic<int64_t>[]> time_in_state_ns_;
 };
 
+template <typename ValueType>
+struct ResidencyByThreshold {
+    std::vector<ValueType> thresholds;
+    std::optional<std::string> logging_name;
+    ResidencyCounter counter;
+    ResidencyByThreshold(const ThresholdList<ValueType> &threshold_list, int64_t now_ns)
+        : thresholds(threshold_list.thresholds),
+          logging_name(threshold_list.logging_name),
+          // number of states = number of thresholds + 1
+          counter(threshold_list.thresholds.size() + 1, now_ns) {}
+};
+
+template <typename ValueType>
+struct ResidencyStats {
+    StatsSeqLock seq_lock;
+    std::deque<ResidencyByThreshold<ValueType>> by_custom_threshold;
+    std::unique_ptr<ResidencyCounter> by_default_threshold;
+};
+
+struct SensorStatsEntry : ResidencyStats<float> {
+    // Whether the sensor has temperature residency stats, or only abnormality checks
+    bool record_temp = false;
+    std::atomic<float> max_temp = std::numeric_limits<float>::min();
+    std::atomic<int64_t> max_temp_timestamp = SystemTimePoint::min().time_since_epoch().count();
+    std::atomic<float> min_temp = std::numeric_limits<float>::max();
+    std::atomic<int64_t> min_temp_timestamp = SystemTimePoint::min().time_since_epoch().count();
+    // Set by the reporter, the next update starts a new min/max interval
+    std::atomic<bool> reset_temp_range = false;
+    std::shared_ptr<TempRangeInfo> temp_range_info;
+    std::shared_ptr<TempStuckInfo> temp_stuck_info;
+    // Written with the write lock held
+    CurrTempStatus curr_temp_status;
+};
+
+// Stats are updated from the watcher and binder threads without locks, see StatsSeqLock. The
+// atoms are sent by a StatsAtomReporter so throttling never waits on the stats service.
 class ThermalStatsHelper {
   public:
-    ThermalStatsHelper() = default;
+    ThermalStatsHelper();
+    ThermalStatsHelper(StatsClientGetter stats_client_getter, StatsReportingPolicy policy);
     ~ThermalStatsHelper() = default;
     // Disallow copy and assign
     ThermalStatsHelper(const ThermalStatsHelper &) = delete;
     void operator=(const ThermalStatsHelper &) = delete;
 
+    // Also starts the atom reporter
     bool initializeStats(const Json::Value &config,
                          const std::unordered_map<std::string, SensorInfo> &sensor_info_map_,
                          const std::unordered_map<std::string, CdevInfo> &cooling_device_info_map_,
@@ -143,14 +229,9 @@ class ThermalStatsHelper {
     void updateSensorTempStatsBySeverity(std::string_view sensor,
                                          const ThrottlingSeverity &severity);
     void updateSensorTempStatsByThreshold(std::string_view sensor, float temperature);
-    /*
-     * Function to report all the stats by calling all specific stats reporting function.
-     * Returns:
-     *   0, if time_elapsed < kUpdateIntervalMs or if no failure in reporting
-     *  -1, if failed to get AIDL stats services
-     *  >0, count represents the number of stats failed to report.
-     */
-    int reportStats();
+    // Report the residency stats now instead of at the end of the report interval
+    void requestReport();
+    // Queue the abnormality atom. Returns false if it could not be queued.
     bool reportThermalAbnormality(const ThermalSensorAbnormalityDetected::AbnormalityType &type,
                                   std::string_view name, std::optional<int> reading);
     // Get a snapshot of Thermal Stats Sensor Map till that point in time
@@ -160,18 +241,17 @@ class ThermalStatsHelper {
     GetSensorCoolingDeviceRequestStatsSnapshot();
 
   private:
-    static constexpr std::chrono::milliseconds kUpdateIntervalMs =
-            std::chrono::duration_cast<std::chrono::milliseconds>(24h);
-    boot_clock::time_point last_total_stats_report_time = boot_clock::time_point::min();
-    int abnormal_stats_reported_per_update_interval = 0;
-    mutable std::shared_mutex sensor_stats_mutex_;
-    SensorStats sensor_stats;
-    mutable std::shared_mutex sensor_cdev_request_stats_map_mutex_;
-    ThermalHelper *thermal_helper_handle_;
+    std::atomic<int> abnormal_stats_reported_per_update_interval = 0;
+    ThermalHelper *thermal_helper_handle_ = nullptr;
+    // Built by initializeStats() and not modified afterwards, so lookups need no lock
+    std::unordered_map<std::string, std::unique_ptr<SensorStatsEntry>> sensor_stats_map_;
     // userVote request stat for the sensor to the corresponding cdev (sensor -> cdev ->
-    // StatsRecord)
-    std::unordered_map<std::string, std::unordered_map<std::string, ThermalStats<int>>>
+    // ResidencyStats)
+    std::unordered_map<std::string,
+                       std::unordered_map<std::string, std::unique_ptr<ResidencyStats<int>>>>
             sensor_cdev_request_stats_map_;
+    // Declared last so the reporter thread stops before the stats it reads are destroyed
+    StatsAtomReporter stats_atom_reporter_;
 
     bool initializeSensorTempStats(
             const StatsInfo<float> &sensor_stats_info,
@@ -183,19 +263,19 @@ class ThermalStatsHelper {
     bool initializeSensorAbnormalityStats(
             const AbnormalStatsInfo &abnormal_stats_info,
             const std::unordered_map<std::string, SensorInfo> &sensor_info_map_);
-    void updateStatsRecord(StatsRecord *stats_record, int new_state);
-    void verifySensorAbnormality(std::string_view sensor, float temperature);
-    int reportAllSensorTempStats(const std::shared_ptr<IStats> &stats_client);
-    bool reportSensorTempStats(const std::shared_ptr<IStats> &stats_client, std::string_view sensor,
-                               const SensorTempStats &sensor_temp_stats, StatsRecord *stats_record);
-    int reportAllSensorCdevRequestStats(const std::shared_ptr<IStats> &stats_client);
-    bool reportSensorCdevRequestStats(const std::shared_ptr<IStats> &stats_client,
-                                      std::string_view sensor, std::string_view cdev,
-                                      StatsRecord *stats_record);
-    bool reportAtom(const std::shared_ptr<IStats> &stats_client, const int32_t &atom_id,
-                    std::vector<VendorAtomValue> &&values);
-    std::vector<int64_t> processStatsRecordForReporting(StatsRecord *stats_record);
-    StatsRecord restoreStatsRecordOnFailure(StatsRecord &&stats_record_before_failure);
+    void verifySensorAbnormality(std::string_view sensor, SensorStatsEntry *sensor_stats,
+                                 float temperature);
+    // Runs on the reporter thread at the end of every report interval
+    std::vector<PendingAtom> collectStatsAtoms();
+    void collectSensorTempStatsAtoms(std::string_view sensor, SensorStatsEntry *sensor_stats,
+                                     std::vector<PendingAtom> *atoms);
+    void collectSensorCdevRequestStatsAtoms(std::string_view sensor, std::string_view cdev,
+                                            ResidencyStats<int> *request_stats,
+                                            std::vector<PendingAtom> *atoms);
+    // Appends the time since the last report and the residency to values
+    PendingAtom makeResidencyAtom(int32_t atom_id, std::vector<VendorAtomValue> &&values,
+                                  ResidencyCounter *counter,
+                                  const std::vector<int64_t> &time_in_state_ns, int64_t now_ns);
 };
 
 }  // namespace implementation
@@ -24,7 +24,10 @@
 #include <android-base/strings.h>
 #include <utils/Trace.h>
 
+#include <algorithm>
+#include <cmath>
 #include <iterator>
+#include <limits>
 #include <set>
 #include <sstream>
 #include <thread>
@@ -58,6 +61,34 @@ size_t getTargetStateOfPID(const SensorInfo &sensor_info, const ThrottlingSeveri
     return target_state;
 }
 
+// To find the first state whose power is within the budget, or the max state if none is
+size_t getCdevStateOfPower(const CdevInfo &cdev_info, int power_budget) {
+    const auto &state2power = cdev_info.state2power;
+    if (state2power.size() < 2) {
+        return 0;
+    }
+    const auto over_budget = [power_budget](float power) { return !(power_budget >= power); };
+
+    if (!cdev_info.state2power_descending) {
+        return std::find_if_not(state2power.begin(), state2power.end() - 1, over_budget) -
+               state2power.begin();
+    }
+    // Branchless binary search over all but the max state, which is the fallback
+    const float *base = state2power.data();
+    size_t len = state2power.size() - 1;
+    while (len > 1) {
+        const size_t half = len / 2;
+        base = over_budget(base[half]) ? base + half : base;
+        len -= half;
+    }
+    return (base - state2power.data()) + over_budget(*base);
+}
+
+bool isModelPredictiveThrottling(const SensorInfo &sensor_info) {
+    return sensor_info.throttling_info != nullptr && sensor_info.predictor_info != nullptr &&
+           sensor_info.predictor_info->support_mpc_throttling;
+}
+
 void ThermalThrottling::parseProfileProperty(std::string_view sensor_name,
                                              const SensorInfo &sensor_info) {
     if (sensor_info.throttling_info == nullptr) {
@@ -72,11 +103,13 @@ void ThermalThrottling::parseProfileProperty(std::string_view sensor_name,
             LOG(INFO) << sensor_name.data() << ": throttling profile change to "
                       << ((profile.empty()) ? "default" : profile);
             thermal_throttling_status_map_[sensor_name.data()].profile = profile;
+            thermal_throttling_status_map_[sensor_name.data()].allocated_power_budget = NAN;
         }
     } else {
         LOG(ERROR) << sensor_name.data() << ": set profile to default because " << profile
                    << " is invalid";
         thermal_throttling_status_map_[sensor_name.data()].profile = "";
+        thermal_throttling_status_map_[sensor_name.data()].allocated_power_budget = NAN;
     }
 }
 
@@ -107,11 +140,15 @@ void ThermalThrottling::clearThrottlingData(std::string_view sensor_name) {
     }
 
     thermal_throttling_status_map_[sensor_name.data()].prev_err = NAN;
+    thermal_throttling_status_map_[sensor_name.data()].p_budget = NAN;
     thermal_throttling_status_map_[sensor_name.data()].i_budget = NAN;
+    thermal_throttling_status_map_[sensor_name.data()].d_budget = NAN;
     thermal_throttling_status_map_[sensor_name.data()].prev_target =
             static_cast<size_t>(ThrottlingSeverity::NONE);
     thermal_throttling_status_map_[sensor_name.data()].prev_power_budget = NAN;
     thermal_throttling_status_map_[sensor_name.data()].tran_cycle = 0;
+    thermal_throttling_status_map_[sensor_name.data()].allocated_power_budget = NAN;
+    thermal_throttling_status_map_[sensor_name.data()].predicted_peak = NAN;
 
     return;
 }
@@ -130,12 +167,18 @@ bool ThermalThrottling::registerThermalThrottling(
     }
 
     thermal_throttling_status_map_[sensor_name.data()].prev_err = NAN;
+    thermal_throttling_status_map_[sensor_name.data()].p_budget = NAN;
     thermal_throttling_status_map_[sensor_name.data()].i_budget = NAN;
+    thermal_throttling_status_map_[sensor_name.data()].d_budget = NAN;
     thermal_throttling_status_map_[sensor_name.data()].prev_target =
             static_cast<size_t>(ThrottlingSeverity::NONE);
     thermal_throttling_status_map_[sensor_name.data()].prev_power_budget = NAN;
     thermal_throttling_status_map_[sensor_name.data()].tran_cycle = 0;
     thermal_throttling_status_map_[sensor_name.data()].profile = "";
+    thermal_throttling_status_map_[sensor_name.data()].allocated_power_budget = NAN;
+    thermal_throttling_status_map_[sensor_name.data()].allocated_severity =
+            ThrottlingSeverity::NONE;
+    thermal_throttling_status_map_[sensor_name.data()].predicted_peak = NAN;
 
     for (auto &binded_cdev_pair : throttling_info->binded_cdev_info_map) {
         if (!cooling_device_info_map.count(binded_cdev_pair.first)) {
@@ -275,6 +318,8 @@ float ThermalThrottling::updatePowerBudget(
     }
 
     throttling_status.prev_err = err;
+    throttling_status.p_budget = p;
+    throttling_status.d_budget = d;
     // Calculate power budget
     power_budget = sensor_info.throttling_info->s_power[target_state] + p +
                    throttling_status.i_budget + d + compensation;
@@ -359,6 +404,41 @@ float ThermalThrottling::computeExcludedPower(
     return excluded_power;
 }
 
+bool ThermalThrottling::isPowerAllocationSettled(
+        const ThermalThrottlingStatus &throttling_status, const SensorInfo &sensor_info,
+        const std::unordered_map<std::string, BindedCdevInfo> &binded_cdev_info_map,
+        const std::unordered_map<std::string, PowerStatus> &power_status_map,
+        float total_power_budget, ThrottlingSeverity curr_severity) {
+    const float tolerance = sensor_info.throttling_info->budget_tolerance;
+
+    if (std::isnan(tolerance) || std::isnan(throttling_status.allocated_power_budget) ||
+        throttling_status.allocated_severity != curr_severity ||
+        !(std::fabs(total_power_budget - throttling_status.allocated_power_budget) <= tolerance) ||
+        throttling_status.allocated_rail_power.size() != binded_cdev_info_map.size()) {
+        return false;
+    }
+
+    size_t i = 0;
+    for (const auto &binded_cdev_info_pair : binded_cdev_info_map) {
+        const float allocated_rail_power = throttling_status.allocated_rail_power[i++];
+        if (binded_cdev_info_pair.second.power_rail.empty()) {
+            continue;
+        }
+        const auto power_status_it = power_status_map.find(binded_cdev_info_pair.second.power_rail);
+        if (power_status_it == power_status_map.end()) {
+            return false;
+        }
+        const float last_updated_avg_power = power_status_it->second.last_updated_avg_power;
+        if (std::isnan(last_updated_avg_power) && std::isnan(allocated_rail_power)) {
+            continue;
+        }
+        if (!(std::fabs(last_updated_avg_power - allocated_rail_power) <= tolerance)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 // Allocate power budget to binded cooling devices base on the real ODPM power data
 bool ThermalThrottling::allocatePowerToCdev(
         const Temperature &temp, const SensorInfo &sensor_info,
@@ -373,14 +453,18 @@ bool ThermalThrottling::allocatePowerToCdev(
     bool low_power_device_check = true;
     bool is_budget_allocated = false;
     bool power_data_invalid = false;
-    std::set<std::string> allocated_cdev;
     std::string log_buf;
 
     std::unique_lock<std::shared_mutex> _lock(thermal_throttling_status_map_mutex_);
     auto total_power_budget =
             updatePowerBudget(temp, sensor_info, cooling_device_info_map, time_elapsed_ms,
                               curr_severity, max_throttling, sensor_predictions);
-    const auto &profile = thermal_throttling_status_map_[temp.name].profile;
+    auto &throttling_status = thermal_throttling_status_map_.at(temp.name);
+    throttling_status.predicted_peak = NAN;
+    const auto &profile = throttling_status.profile;
+    const auto &binded_cdev_info_map = sensor_info.throttling_info->profile_map.count(profile)
+                                               ? sensor_info.throttling_info->profile_map.at(profile)
+                                               : sensor_info.throttling_info->binded_cdev_info_map;
 
     if (sensor_info.throttling_info->excluded_power_info_map.size()) {
         total_power_budget -= computeExcludedPower(sensor_info, curr_severity, power_status_map,
@@ -392,102 +476,110 @@ bool ThermalThrottling::allocatePowerToCdev(
         }
     }
 
+    // Keep the settled split while its inputs stay within the tolerance
+    if (!max_throttling &&
+        isPowerAllocationSettled(throttling_status, sensor_info, binded_cdev_info_map,
+                                 power_status_map, total_power_budget, curr_severity)) {
+        LOG(VERBOSE) << temp.name << " power budget=" << total_power_budget
+                     << " keeps the settled split of " << throttling_status.allocated_power_budget;
+        return true;
+    }
+    throttling_status.allocated_power_budget = NAN;
+    const float split_power_budget = total_power_budget;
+
+    // Binded cdevs are visited in the same order on every pass, so they are tracked by index
+    std::vector<bool> allocated_cdev(binded_cdev_info_map.size(), false);
+
     // Compute total cdev weight
-    for (const auto &binded_cdev_info_pair :
-         (sensor_info.throttling_info->profile_map.count(profile)
-                  ? sensor_info.throttling_info->profile_map.at(profile)
-                  : sensor_info.throttling_info->binded_cdev_info_map)) {
+    size_t cdev_index = 0;
+    for (const auto &binded_cdev_info_pair : binded_cdev_info_map) {
         const auto cdev_weight = binded_cdev_info_pair.second
                                          .cdev_weight_for_pid[static_cast<size_t>(curr_severity)];
+        const size_t i = cdev_index++;
         if (!binded_cdev_info_pair.second.enabled) {
             continue;
         } else if (std::isnan(cdev_weight) || cdev_weight == 0) {
-            allocated_cdev.insert(binded_cdev_info_pair.first);
+            allocated_cdev[i] = true;
             continue;
         }
         total_weight += cdev_weight;
     }
 
     while (!is_budget_allocated) {
-        for (const auto &binded_cdev_info_pair :
-             (sensor_info.throttling_info->profile_map.count(profile)
-                      ? sensor_info.throttling_info->profile_map.at(profile)
-                      : sensor_info.throttling_info->binded_cdev_info_map)) {
+        cdev_index = 0;
+        for (const auto &binded_cdev_info_pair : binded_cdev_info_map) {
+            const auto &cdev_name = binded_cdev_info_pair.first;
+            const auto &binded_cdev_info = binded_cdev_info_pair.second;
             float cdev_power_adjustment = 0;
             const auto cdev_weight =
-                    binded_cdev_info_pair.second
-                            .cdev_weight_for_pid[static_cast<size_t>(curr_severity)];
+                    binded_cdev_info.cdev_weight_for_pid[static_cast<size_t>(curr_severity)];
+            const size_t i = cdev_index++;
 
-            if (allocated_cdev.count(binded_cdev_info_pair.first)) {
+            if (allocated_cdev[i]) {
                 continue;
             }
 
             // Get the power data
             if (!power_data_invalid) {
-                if (!binded_cdev_info_pair.second.power_rail.empty()) {
+                if (!binded_cdev_info.power_rail.empty()) {
                     last_updated_avg_power =
-                            power_status_map.at(binded_cdev_info_pair.second.power_rail)
-                                    .last_updated_avg_power;
+                            power_status_map.at(binded_cdev_info.power_rail).last_updated_avg_power;
                     if (std::isnan(last_updated_avg_power)) {
                         LOG(VERBOSE) << "power data is under collecting";
                         power_data_invalid = true;
                         break;
                     }
 
-                    ATRACE_INT((temp.name + std::string("-") +
-                                binded_cdev_info_pair.second.power_rail + std::string("-avg_power"))
+                    ATRACE_INT((temp.name + std::string("-") + binded_cdev_info.power_rail +
+                                std::string("-avg_power"))
                                        .c_str(),
                                static_cast<int>(last_updated_avg_power));
                 } else {
                     power_data_invalid = true;
                     break;
                 }
-                if (binded_cdev_info_pair.second.throttling_with_power_link) {
+                if (binded_cdev_info.throttling_with_power_link) {
                     return false;
                 }
             }
 
             auto cdev_power_budget = total_power_budget * (cdev_weight / total_weight);
             cdev_power_adjustment = cdev_power_budget - last_updated_avg_power;
+            const auto curr_cdev_vote = throttling_status.pid_cdev_request_map.at(cdev_name);
 
             if (low_power_device_check) {
                 // Share the budget for the CDEV which power is lower than target
-                if (cdev_power_adjustment > 0 &&
-                    thermal_throttling_status_map_[temp.name].pid_cdev_request_map.at(
-                            binded_cdev_info_pair.first) == 0) {
+                if (cdev_power_adjustment > 0 && curr_cdev_vote == 0) {
                     allocated_power += last_updated_avg_power;
                     allocated_weight += cdev_weight;
-                    allocated_cdev.insert(binded_cdev_info_pair.first);
-                    if (!binded_cdev_info_pair.second.power_rail.empty()) {
+                    allocated_cdev[i] = true;
+                    if (!binded_cdev_info.power_rail.empty()) {
                         log_buf.append(StringPrintf("(%s: %0.2f mW)",
-                                                    binded_cdev_info_pair.second.power_rail.c_str(),
+                                                    binded_cdev_info.power_rail.c_str(),
                                                     last_updated_avg_power));
                     }
-                    LOG(VERBOSE) << temp.name << " binded " << binded_cdev_info_pair.first
+                    LOG(VERBOSE) << temp.name << " binded " << cdev_name
                                  << " has been already at min state 0";
                 }
             } else {
-                const CdevInfo &cdev_info = cooling_device_info_map.at(binded_cdev_info_pair.first);
-                if (!binded_cdev_info_pair.second.power_rail.empty()) {
+                const CdevInfo &cdev_info = cooling_device_info_map.at(cdev_name);
+                if (!binded_cdev_info.power_rail.empty()) {
                     log_buf.append(StringPrintf("(%s: %0.2f mW)",
-                                                binded_cdev_info_pair.second.power_rail.c_str(),
+                                                binded_cdev_info.power_rail.c_str(),
                                                 last_updated_avg_power));
                 }
                 // Ignore the power distribution if the CDEV has no space to reduce power
-                if ((cdev_power_adjustment < 0 &&
-                     thermal_throttling_status_map_[temp.name].pid_cdev_request_map.at(
-                             binded_cdev_info_pair.first) == cdev_info.max_state)) {
-                    LOG(VERBOSE) << temp.name << " binded " << binded_cdev_info_pair.first
+                if ((cdev_power_adjustment < 0 && curr_cdev_vote == cdev_info.max_state)) {
+                    LOG(VERBOSE) << temp.name << " binded " << cdev_name
                                  << " has been already at max state " << cdev_info.max_state;
                     continue;
                 }
 
-                if (!binded_cdev_info_pair.second.enabled) {
+                auto &pid_power_budget = throttling_status.pid_power_budget_map.at(cdev_name);
+                if (!binded_cdev_info.enabled) {
                     cdev_power_budget = cdev_info.state2power[0];
-                } else if (!power_data_invalid && binded_cdev_info_pair.second.power_rail != "") {
-                    auto cdev_curr_power_budget =
-                            thermal_throttling_status_map_[temp.name].pid_power_budget_map.at(
-                                    binded_cdev_info_pair.first);
+                } else if (!power_data_invalid && binded_cdev_info.power_rail != "") {
+                    auto cdev_curr_power_budget = pid_power_budget;
 
                     if (last_updated_avg_power > cdev_curr_power_budget) {
                         cdev_power_budget = cdev_curr_power_budget +=
@@ -508,29 +600,23 @@ bool ThermalThrottling::allocatePowerToCdev(
                 }
 
                 int max_cdev_vote;
-                if (!getCdevMaxRequest(binded_cdev_info_pair.first, &max_cdev_vote)) {
+                if (!getCdevMaxRequest(cdev_name, &max_cdev_vote)) {
                     return false;
                 }
 
-                const auto curr_cdev_vote =
-                        thermal_throttling_status_map_[temp.name].pid_cdev_request_map.at(
-                                binded_cdev_info_pair.first);
-
                 if (!max_throttling) {
-                    if (binded_cdev_info_pair.second.max_release_step !=
-                                std::numeric_limits<int>::max() &&
+                    if (binded_cdev_info.max_release_step != std::numeric_limits<int>::max() &&
                         (power_data_invalid || cdev_power_adjustment > 0)) {
                         if (!power_data_invalid && curr_cdev_vote < max_cdev_vote) {
                             cdev_power_budget = cdev_info.state2power[curr_cdev_vote];
-                            LOG(VERBOSE) << temp.name << "'s " << binded_cdev_info_pair.first
+                            LOG(VERBOSE) << temp.name << "'s " << cdev_name
                                          << " vote: " << curr_cdev_vote
                                          << " is lower than max cdev vote: " << max_cdev_vote;
                         } else {
-                            int target_release_step = binded_cdev_info_pair.second.max_release_step;
+                            int target_release_step = binded_cdev_info.max_release_step;
                             while ((curr_cdev_vote - target_release_step) >
-                                           binded_cdev_info_pair.second
-                                                   .limit_info[static_cast<size_t>(
-                                                           curr_severity)] &&
+                                           binded_cdev_info
+                                                   .limit_info[static_cast<size_t>(curr_severity)] &&
                                    cdev_info.state2power[curr_cdev_vote - target_release_step] ==
                                            cdev_info.state2power[curr_cdev_vote]) {
                                 target_release_step += 1;
@@ -543,33 +629,27 @@ bool ThermalThrottling::allocatePowerToCdev(
                         }
                     }
 
-                    if (binded_cdev_info_pair.second.max_throttle_step !=
-                                std::numeric_limits<int>::max() &&
+                    if (binded_cdev_info.max_throttle_step != std::numeric_limits<int>::max() &&
                         (power_data_invalid || cdev_power_adjustment < 0)) {
-                        int target_throttle_step = binded_cdev_info_pair.second.max_throttle_step;
+                        int target_throttle_step = binded_cdev_info.max_throttle_step;
                         while ((curr_cdev_vote + target_throttle_step) <
-                                       binded_cdev_info_pair.second
+                                       binded_cdev_info
                                                .cdev_ceiling[static_cast<size_t>(curr_severity)] &&
                                cdev_info.state2power[curr_cdev_vote + target_throttle_step] ==
                                        cdev_info.state2power[curr_cdev_vote]) {
                             target_throttle_step += 1;
                         }
-                        const auto target_state =
-                                std::min(curr_cdev_vote + target_throttle_step,
-                                         binded_cdev_info_pair.second
-                                                 .cdev_ceiling[static_cast<size_t>(curr_severity)]);
+                        const auto target_state = std::min(
+                                curr_cdev_vote + target_throttle_step,
+                                binded_cdev_info.cdev_ceiling[static_cast<size_t>(curr_severity)]);
                         cdev_power_budget =
                                 std::max(cdev_power_budget, cdev_info.state2power[target_state]);
                     }
                 }
 
-                thermal_throttling_status_map_[temp.name].pid_power_budget_map.at(
-                        binded_cdev_info_pair.first) = cdev_power_budget;
-                LOG(VERBOSE) << temp.name << " allocate "
-                             << thermal_throttling_status_map_[temp.name].pid_power_budget_map.at(
-                                        binded_cdev_info_pair.first)
-                             << "mW to " << binded_cdev_info_pair.first
-                             << "(cdev_weight=" << cdev_weight << ")";
+                pid_power_budget = cdev_power_budget;
+                LOG(VERBOSE) << temp.name << " allocate " << pid_power_budget << "mW to "
+                             << cdev_name << "(cdev_weight=" << cdev_weight << ")";
             }
         }
 
@@ -589,28 +669,208 @@ bool ThermalThrottling::allocatePowerToCdev(
     if (log_buf.size()) {
         LOG(INFO) << temp.name << " binded power rails: " << log_buf;
     }
+
+    // Remember what the split was computed from, updateCdevRequestByPower() drops it again
+    // unless the split left every PID request where it was
+    if (!power_data_invalid && !max_throttling) {
+        throttling_status.allocated_power_budget = split_power_budget;
+        throttling_status.allocated_severity = curr_severity;
+        throttling_status.allocated_rail_power.clear();
+        for (const auto &binded_cdev_info_pair : binded_cdev_info_map) {
+            const auto power_status_it =
+                    power_status_map.find(binded_cdev_info_pair.second.power_rail);
+            throttling_status.allocated_rail_power.push_back(
+                    power_status_it == power_status_map.end()
+                            ? NAN
+                            : power_status_it->second.last_updated_avg_power);
+        }
+    }
     return true;
 }
 
-void ThermalThrottling::updateCdevRequestByPower(
-        std::string sensor_name,
-        const std::unordered_map<std::string, CdevInfo> &cooling_device_info_map) {
-    size_t i;
+// The trajectory is predicted with the current requests in place. Cutting P mW from the binded
+// cdevs is taken to lower the temperature t ms later by
+// P * thermal_resistance * (1 - exp(-t / thermal_time_constant)). The plan holds one state per
+// cdev over the whole prediction window and is made again on every update.
+bool ThermalThrottling::updateCdevRequestByPrediction(
+        const Temperature &temp, const SensorInfo &sensor_info,
+        const ThrottlingSeverity curr_severity,
+        const std::unordered_map<std::string, CdevInfo> &cooling_device_info_map,
+        const std::vector<float> &sensor_predictions) {
+    const auto &predictor_info = *sensor_info.predictor_info;
+    const auto target_state = getTargetStateOfPID(sensor_info, curr_severity);
+    const float target = sensor_info.hot_thresholds[target_state];
+    if (sensor_predictions.empty() || std::isnan(target)) {
+        return false;
+    }
+
+    // The power cut which keeps every predicted temperature under the target, a negative cut
+    // leaves room to release
+    float required_cut = -std::numeric_limits<float>::infinity();
+    float predicted_peak = -std::numeric_limits<float>::infinity();
+    for (size_t i = 0; i < sensor_predictions.size(); ++i) {
+        const float predicted_temp = sensor_predictions[i] * sensor_info.multiplier;
+        if (std::isnan(predicted_temp)) {
+            return false;
+        }
+        const float time_ms =
+                static_cast<float>((i + 1) * predictor_info.prediction_interval.count());
+        const float temp_per_mw =
+                predictor_info.thermal_resistance *
+                (1 - std::exp(-time_ms / predictor_info.thermal_time_constant.count()));
+        predicted_peak = std::max(predicted_peak, predicted_temp);
+        required_cut = std::max(required_cut, (predicted_temp - target) / temp_per_mw);
+    }
 
     std::unique_lock<std::shared_mutex> _lock(thermal_throttling_status_map_mutex_);
-    for (auto &pid_power_budget_pair :
-         thermal_throttling_status_map_[sensor_name.data()].pid_power_budget_map) {
+    auto &throttling_status = thermal_throttling_status_map_.at(temp.name);
+    const auto &profile = throttling_status.profile;
+    const auto &binded_cdev_info_map = sensor_info.throttling_info->profile_map.count(profile)
+                                               ? sensor_info.throttling_info->profile_map.at(profile)
+                                               : sensor_info.throttling_info->binded_cdev_info_map;
+
+    struct PlannedCdev {
+        const std::string *cdev_name;
+        const CdevInfo *cdev_info;
+        const BindedCdevInfo *binded_cdev_info;
+        int curr_request;
+        float weight;
+        // NAN until the cdev's share of the budget is settled
+        float power_budget;
+    };
+    std::vector<PlannedCdev> planned_cdevs;
+    float current_power = 0;
+    float total_weight = 0;
+    for (const auto &pid_power_budget_pair : throttling_status.pid_power_budget_map) {
+        const auto binded_cdev_info_it = binded_cdev_info_map.find(pid_power_budget_pair.first);
+        if (binded_cdev_info_it == binded_cdev_info_map.end()) {
+            continue;
+        }
         const CdevInfo &cdev_info = cooling_device_info_map.at(pid_power_budget_pair.first);
+        const int curr_request =
+                throttling_status.pid_cdev_request_map.at(pid_power_budget_pair.first);
+        if (static_cast<size_t>(curr_request) >= cdev_info.state2power.size()) {
+            return false;
+        }
+        current_power += cdev_info.state2power[curr_request];
+
+        const auto &binded_cdev_info = binded_cdev_info_it->second;
+        const float weight = binded_cdev_info.cdev_weight_for_pid[target_state];
+        PlannedCdev planned_cdev = {&pid_power_budget_pair.first, &cdev_info, &binded_cdev_info,
+                                    curr_request, weight, NAN};
+        if (!binded_cdev_info.enabled || !(weight > 0)) {
+            // Not throttled by PID, the cdev is left unthrottled
+            planned_cdev.power_budget = cdev_info.state2power[0];
+        } else {
+            total_weight += weight;
+        }
+        planned_cdevs.push_back(planned_cdev);
+    }
+    if (!(total_weight > 0) || std::isnan(current_power)) {
+        return false;
+    }
 
-        for (i = 0; i < cdev_info.state2power.size() - 1; ++i) {
-            if (pid_power_budget_pair.second >= cdev_info.state2power[i]) {
-                break;
+    const float power_budget =
+            std::clamp(current_power - required_cut,
+                       sensor_info.throttling_info->min_alloc_power[target_state],
+                       sensor_info.throttling_info->max_alloc_power[target_state]);
+    float remaining_budget = power_budget;
+    for (const auto &planned_cdev : planned_cdevs) {
+        if (!std::isnan(planned_cdev.power_budget)) {
+            remaining_budget -= planned_cdev.power_budget;
+        }
+    }
+    if (std::isnan(remaining_budget)) {
+        return false;
+    }
+    // Split the budget by weight, a cdev whose unthrottled power fits in its share hands the
+    // rest of the share to the others
+    bool share_changed = true;
+    while (share_changed) {
+        share_changed = false;
+        for (auto &planned_cdev : planned_cdevs) {
+            if (!std::isnan(planned_cdev.power_budget)) {
+                continue;
+            }
+            const float max_power = planned_cdev.cdev_info->state2power[0];
+            if (remaining_budget * planned_cdev.weight / total_weight >= max_power) {
+                planned_cdev.power_budget = max_power;
+                remaining_budget -= max_power;
+                total_weight -= planned_cdev.weight;
+                share_changed = true;
             }
         }
-        thermal_throttling_status_map_[sensor_name.data()].pid_cdev_request_map.at(
-                pid_power_budget_pair.first) = static_cast<int>(i);
     }
 
+    bool request_changed = false;
+    for (auto &planned_cdev : planned_cdevs) {
+        if (std::isnan(planned_cdev.power_budget)) {
+            planned_cdev.power_budget =
+                    std::max(remaining_budget * planned_cdev.weight / total_weight, 0.0f);
+        }
+        int state = static_cast<int>(getCdevStateOfPower(
+                *planned_cdev.cdev_info, static_cast<int>(planned_cdev.power_budget)));
+        // Move at most the configured steps per update, as PID does
+        const auto &binded_cdev_info = *planned_cdev.binded_cdev_info;
+        if (state - planned_cdev.curr_request > binded_cdev_info.max_throttle_step) {
+            state = planned_cdev.curr_request + binded_cdev_info.max_throttle_step;
+        } else if (planned_cdev.curr_request - state > binded_cdev_info.max_release_step) {
+            state = planned_cdev.curr_request - binded_cdev_info.max_release_step;
+        }
+        throttling_status.pid_power_budget_map.at(*planned_cdev.cdev_name) =
+                static_cast<int>(planned_cdev.power_budget);
+        request_changed |= state != planned_cdev.curr_request;
+        throttling_status.pid_cdev_request_map.at(*planned_cdev.cdev_name) = state;
+        LOG(VERBOSE) << temp.name << " plan " << *planned_cdev.cdev_name << " to state " << state
+                     << " with " << planned_cdev.power_budget << "mW";
+    }
+
+    // PID starts over if the predictions stop
+    throttling_status.prev_err = NAN;
+    throttling_status.p_budget = NAN;
+    throttling_status.i_budget = NAN;
+    throttling_status.d_budget = NAN;
+    throttling_status.prev_target = static_cast<size_t>(ThrottlingSeverity::NONE);
+    throttling_status.tran_cycle = 0;
+    throttling_status.allocated_power_budget = NAN;
+    throttling_status.prev_power_budget = power_budget;
+    throttling_status.predicted_peak = predicted_peak;
+
+    // The plan runs on every poll, only a cut or a new cdev request is worth an INFO log
+    if (required_cut > 0 || request_changed) {
+        LOG(INFO) << temp.name << " predicted peak=" << predicted_peak << " target=" << target
+                  << " required cut=" << required_cut << " power_budget=" << power_budget
+                  << " current power=" << current_power << " control target=" << target_state;
+    }
+    ATRACE_INT((temp.name + std::string("-predicted_peak")).c_str(),
+               static_cast<int>(predicted_peak));
+    ATRACE_INT((temp.name + std::string("-power_budget")).c_str(),
+               static_cast<int>(power_budget));
+    return true;
+}
+
+void ThermalThrottling::updateCdevRequestByPower(
+        std::string sensor_name,
+        const std::unordered_map<std::string, CdevInfo> &cooling_device_info_map) {
+    std::unique_lock<std::shared_mutex> _lock(thermal_throttling_status_map_mutex_);
+    auto &throttling_status = thermal_throttling_status_map_.at(sensor_name);
+    bool request_changed = false;
+
+    for (const auto &pid_power_budget_pair : throttling_status.pid_power_budget_map) {
+        const CdevInfo &cdev_info = cooling_device_info_map.at(pid_power_budget_pair.first);
+        const int state =
+                static_cast<int>(getCdevStateOfPower(cdev_info, pid_power_budget_pair.second));
+        auto &pid_cdev_request = throttling_status.pid_cdev_request_map.at(pid_power_budget_pair.first);
+        if (pid_cdev_request != state) {
+            pid_cdev_request = state;
+            request_changed = true;
+        }
+    }
+
+    // The split has not settled while it still moves the requests
+    if (request_changed) {
+        throttling_status.allocated_power_budget = NAN;
+    }
     return;
 }
 
@@ -618,26 +878,26 @@ void ThermalThrottling::updateCdevRequestBySeverity(std::string_view sensor_name
                                                     const SensorInfo &sensor_info,
                                                     ThrottlingSeverity curr_severity) {
     std::unique_lock<std::shared_mutex> _lock(thermal_throttling_status_map_mutex_);
-    const auto &profile = thermal_throttling_status_map_[sensor_name.data()].profile;
+    auto &throttling_status = thermal_throttling_status_map_.at(sensor_name.data());
+    const auto &profile = throttling_status.profile;
 
     for (const auto &binded_cdev_info_pair :
          (sensor_info.throttling_info->profile_map.count(profile)
                   ? sensor_info.throttling_info->profile_map.at(profile)
                   : sensor_info.throttling_info->binded_cdev_info_map)) {
-        if (!thermal_throttling_status_map_[sensor_name.data()].hardlimit_cdev_request_map.count(
-                    binded_cdev_info_pair.first)) {
+        const auto hardlimit_cdev_request_it =
+                throttling_status.hardlimit_cdev_request_map.find(binded_cdev_info_pair.first);
+        if (hardlimit_cdev_request_it == throttling_status.hardlimit_cdev_request_map.end()) {
             continue;
         }
-        thermal_throttling_status_map_[sensor_name.data()].hardlimit_cdev_request_map.at(
-                binded_cdev_info_pair.first) =
+        hardlimit_cdev_request_it->second =
                 (binded_cdev_info_pair.second.enabled)
                         ? binded_cdev_info_pair.second
                                   .limit_info[static_cast<size_t>(curr_severity)]
                         : 0;
         LOG(VERBOSE) << "Hard Limit: Sensor " << sensor_name.data() << " update cdev "
                      << binded_cdev_info_pair.first << " to "
-                     << thermal_throttling_status_map_[sensor_name.data()]
-                                .hardlimit_cdev_request_map.at(binded_cdev_info_pair.first);
+                     << hardlimit_cdev_request_it->second;
     }
 }
 
@@ -752,7 +1012,14 @@ void ThermalThrottling::thermalThrottlingUpdate(
         parseProfileProperty(temp.name.c_str(), sensor_info);
     }
 
-    if (thermal_throttling_status_map_[temp.name].pid_power_budget_map.size()) {
+    // Max throttling is left to PID, which jumps to the min allocated power
+    const bool planned_by_prediction =
+            !max_throttling && isModelPredictiveThrottling(sensor_info) &&
+            thermal_throttling_status_map_[temp.name].pid_power_budget_map.size() &&
+            updateCdevRequestByPrediction(temp, sensor_info, curr_severity,
+                                          cooling_device_info_map, sensor_predictions);
+    if (!planned_by_prediction &&
+        thermal_throttling_status_map_[temp.name].pid_power_budget_map.size()) {
         if (!allocatePowerToCdev(temp, sensor_info, curr_severity, time_elapsed_ms,
                                  power_status_map, cooling_device_info_map, max_throttling,
                                  sensor_predictions)) {
@@ -771,8 +1038,17 @@ void ThermalThrottling::thermalThrottlingUpdate(
     }
 
     if (thermal_throttling_status_map_[temp.name].throttling_release_map.size()) {
-        throttlingReleaseUpdate(temp.name.c_str(), cooling_device_info_map, power_status_map,
-                                curr_severity, sensor_info);
+        if (curr_severity == ThrottlingSeverity::NONE) {
+            // Only a model predictive sensor is updated at NONE, there is nothing to release
+            std::unique_lock<std::shared_mutex> _lock(thermal_throttling_status_map_mutex_);
+            for (auto &throttling_release_pair :
+                 thermal_throttling_status_map_[temp.name].throttling_release_map) {
+                throttling_release_pair.second = 0;
+            }
+        } else {
+            throttlingReleaseUpdate(temp.name.c_str(), cooling_device_info_map,
+                                    power_status_map, curr_severity, sensor_info);
+        }
     }
 }
 
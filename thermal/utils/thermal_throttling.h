@@ -25,6 +25,7 @@
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "power_files.h"
 #include "thermal_info.h"
@@ -43,16 +44,29 @@ struct ThermalThrottlingStatus {
     std::unordered_map<std::string, int> throttling_release_map;
     std::unordered_map<std::string, int> cdev_status_map;
     float prev_err;
+    // Proportional and derivative terms of the last power budget
+    float p_budget;
     float i_budget;
+    float d_budget;
     float prev_target;
     float prev_power_budget;
     float budget_transient;
     int tran_cycle;
     std::string profile;
+    // Inputs of the last settled power split, NAN budget if it has to be recomputed
+    float allocated_power_budget;
+    ThrottlingSeverity allocated_severity;
+    std::vector<float> allocated_rail_power;
+    // Highest predicted temperature of the last model predictive plan, NAN when PID is in charge
+    float predicted_peak;
 };
 
 // Return the control temp target of PID algorithm
 size_t getTargetStateOfPID(const SensorInfo &sensor_info, const ThrottlingSeverity curr_severity);
+// Return the lowest cooling device state whose power fits in the power budget
+size_t getCdevStateOfPower(const CdevInfo &cdev_info, int power_budget);
+// Return true if the PID cdev requests of the sensor are planned from its predictions
+bool isModelPredictiveThrottling(const SensorInfo &sensor_info);
 
 // A helper class for conducting thermal throttling
 class ThermalThrottling {
@@ -75,7 +89,8 @@ class ThermalThrottling {
         std::shared_lock<std::shared_mutex> _lock(thermal_throttling_status_map_mutex_);
         return thermal_throttling_status_map_;
     }
-    // Update thermal throttling request for the specific sensor
+    // Update thermal throttling request for the specific sensor. A model predictive sensor is
+    // also updated at NONE severity, so it can throttle ahead of its thresholds.
     void thermalThrottlingUpdate(
             const Temperature &temp, const SensorInfo &sensor_info,
             const ThrottlingSeverity curr_severity, const std::chrono::milliseconds time_elapsed_ms,
@@ -109,6 +124,13 @@ class ThermalThrottling {
                                const std::unordered_map<std::string, PowerStatus> &power_status_map,
                                std::string *log_buf, std::string_view sensor_name);
 
+    // PID algo - return true if the last power split still holds, i.e. the budget and the
+    // binded rail power moved less than the sensor's budget tolerance since it settled
+    bool isPowerAllocationSettled(
+            const ThermalThrottlingStatus &throttling_status, const SensorInfo &sensor_info,
+            const std::unordered_map<std::string, BindedCdevInfo> &binded_cdev_info_map,
+            const std::unordered_map<std::string, PowerStatus> &power_status_map,
+            float total_power_budget, ThrottlingSeverity curr_severity);
     // PID algo - allocate the power to target CDEV according to the ODPM
     bool allocatePowerToCdev(
             const Temperature &temp, const SensorInfo &sensor_info,
@@ -116,6 +138,13 @@ class ThermalThrottling {
             const std::unordered_map<std::string, PowerStatus> &power_status_map,
             const std::unordered_map<std::string, CdevInfo> &cooling_device_info_map,
             const bool max_throttling, const std::vector<float> &sensor_predictions);
+    // Model predictive algo - plan the lowest PID cdev requests which keep the predicted
+    // temperatures under the PID target, return false if the predictions cannot be used
+    bool updateCdevRequestByPrediction(
+            const Temperature &temp, const SensorInfo &sensor_info,
+            const ThrottlingSeverity curr_severity,
+            const std::unordered_map<std::string, CdevInfo> &cooling_device_info_map,
+            const std::vector<float> &sensor_predictions);
     // PID algo - map the target throttling state according to the power budget
     void updateCdevRequestByPower(
             std::string sensor_name,
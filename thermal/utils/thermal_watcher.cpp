@@ -28,10 +28,12 @@
 #include <linux/thermal.h>
 #include <sys/inotify.h>
 #include <sys/resource.h>
+#include <sys/socket.h>
 #include <sys/types.h>
 #include <utils/Trace.h>
 
 #include <chrono>
+#include <cmath>
 #include <fstream>
 
 #include "../thermal-helper.h"
@@ -46,6 +48,19 @@ namespace {
 
 using ::android::base::StringPrintf;
 
+constexpr size_t kUeventMsgLen = 2048;
+// Uevents received per recvmmsg() call
+constexpr size_t kUeventBatchSize = 8;
+// Upper bound of genl datagrams handled per wakeup, so an event storm cannot starve the callback
+constexpr int kGenlBatchLimit = 64;
+
+// A thermal zone event decoded from a genl message
+struct TzEvent {
+    int cmd;
+    int tz_id;
+    float tz_temp;
+};
+
 constexpr static const char *const kNlAttributeStringMap[THERMAL_GENL_ATTR_MAX + 1] = {
         [THERMAL_GENL_ATTR_TZ_ID] = "tz_id",
         [THERMAL_GENL_ATTR_TZ_TEMP] = "tz_temp",
@@ -250,9 +265,9 @@ static int handleEvent(struct nl_msg *n, void *arg) {
     struct nlmsghdr *nlh = nlmsg_hdr(n);
     struct genlmsghdr *glh = genlmsg_hdr(nlh);
     struct nlattr *attrs[THERMAL_GENL_ATTR_MAX + 1];
-    std::pair<int, float> *tz_info = reinterpret_cast<std::pair<int, float> *>(arg);
-    int &tz_id = tz_info->first;
-    float &tz_temp = tz_info->second;
+    std::vector<TzEvent> *tz_events = reinterpret_cast<std::vector<TzEvent> *>(arg);
+    int tz_id = -1;
+    float tz_temp = NAN;
     std::string out;
 
     genlmsg_parse(nlh, 0, attrs, THERMAL_GENL_ATTR_MAX, NULL);
@@ -339,21 +354,73 @@ static int handleEvent(struct nl_msg *n, void *arg) {
     }
     LOG(INFO) << out;
 
+    if (tz_id >= 0) {
+        tz_events->push_back({glh->cmd, tz_id, tz_temp});
+    }
     return 0;
 }
 
+// Return the zone name of a thermal uevent, or an empty view for any other uevent. The message
+// is a sequence of NUL terminated KEY=VALUE fields; the returned view points into it.
+std::string_view parseThermalUeventName(std::string_view msg) {
+    bool thermal_event = false;
+    std::string_view name;
+
+    while (!msg.empty()) {
+        const size_t field_len = msg.find('\0');
+        const std::string_view field = msg.substr(0, field_len);
+        if (::android::base::StartsWith(field, "SUBSYSTEM=")) {
+            if (field != "SUBSYSTEM=thermal") {
+                return {};
+            }
+            thermal_event = true;
+        } else if (::android::base::StartsWith(field, "NAME=")) {
+            name = field.substr(5);
+        }
+        if (field_len == std::string_view::npos) {
+            break;
+        }
+        msg.remove_prefix(field_len + 1);
+    }
+
+    return thermal_event ? name : std::string_view();
+}
+
+// Only accept uevents sent by the kernel, as uevent_kernel_multicast_recv() does.
+bool isKernelUevent(const struct msghdr &hdr) {
+    const auto *addr = reinterpret_cast<const struct sockaddr_nl *>(hdr.msg_name);
+    if (hdr.msg_namelen >= sizeof(*addr) && addr->nl_family == AF_NETLINK &&
+        (addr->nl_groups == 0 || addr->nl_pid != 0)) {
+        return false;
+    }
+
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&hdr); cmsg != nullptr;
+         cmsg = CMSG_NXTHDR(const_cast<struct msghdr *>(&hdr), cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_CREDENTIALS) {
+            return reinterpret_cast<const struct ucred *>(CMSG_DATA(cmsg))->uid == 0;
+        }
+    }
+    return false;
+}
+
 }  // namespace
 
 void ThermalWatcher::registerFilesToWatch(const std::set<std::string> &sensors_to_watch) {
     LOG(INFO) << "Uevent register file to watch...";
-    monitored_sensors_.insert(sensors_to_watch.begin(), sensors_to_watch.end());
-
-    uevent_fd_.reset((TEMP_FAILURE_RETRY(uevent_open_socket(64 * 1024, true))));
-    if (uevent_fd_.get() < 0) {
+    unique_fd uevent_fd(TEMP_FAILURE_RETRY(uevent_open_socket(64 * 1024, true)));
+    if (uevent_fd.get() < 0) {
         LOG(ERROR) << "failed to open uevent socket";
         return;
     }
 
+    registerUeventFd(std::move(uevent_fd), sensors_to_watch);
+}
+
+void ThermalWatcher::registerUeventFd(unique_fd uevent_fd,
+                                      const std::set<std::string> &sensors_to_watch) {
+    monitored_sensors_.insert(sensors_to_watch.begin(), sensors_to_watch.end());
+    uevent_fd_ = std::move(uevent_fd);
+
     fcntl(uevent_fd_, F_SETFL, O_NONBLOCK);
 
     looper_->addFd(uevent_fd_.get(), 0, ::android::Looper::EVENT_INPUT, nullptr, nullptr);
@@ -363,26 +430,18 @@ void ThermalWatcher::registerFilesToWatch(const std::set<std::string> &sensors_t
 
 void ThermalWatcher::registerFilesToWatchNl(const std::set<std::string> &sensors_to_watch) {
     LOG(INFO) << "Thermal genl register file to watch...";
-    monitored_sensors_.insert(sensors_to_watch.begin(), sensors_to_watch.end());
-
-    sk_thermal = nl_socket_alloc();
-    if (!sk_thermal) {
+    struct nl_sock *sock = nl_socket_alloc();
+    if (!sock) {
         LOG(ERROR) << "nl_socket_alloc failed";
         return;
     }
 
-    if (genl_connect(sk_thermal)) {
+    if (genl_connect(sock)) {
         LOG(ERROR) << "genl_connect failed: sk_thermal";
         return;
     }
 
-    thermal_genl_fd_.reset(nl_socket_get_fd(sk_thermal));
-    if (thermal_genl_fd_.get() < 0) {
-        LOG(ERROR) << "Failed to create thermal netlink socket";
-        return;
-    }
-
-    if (!socketAddMembership(sk_thermal, THERMAL_GENL_EVENT_GROUP_NAME)) {
+    if (!socketAddMembership(sock, THERMAL_GENL_EVENT_GROUP_NAME)) {
         return;
     }
 
@@ -391,11 +450,33 @@ void ThermalWatcher::registerFilesToWatchNl(const std::set<std::string> &sensors
      * from kernel. To avoid thermal-hal busy because samlping events are sent
      * too frequently, ignore thermal genl samlping events until we figure out how to use it.
      *
-    if (!socketAddMembership(sk_thermal, THERMAL_GENL_SAMPLING_GROUP_NAME)) {
+    if (!socketAddMembership(sock, THERMAL_GENL_SAMPLING_GROUP_NAME)) {
         return;
     }
     */
 
+    registerGenlSocket(sock, getThermalZoneTypeMap(), sensors_to_watch);
+}
+
+void ThermalWatcher::registerGenlSocket(struct nl_sock *sock,
+                                        std::unordered_map<int, std::string> tz_types,
+                                        const std::set<std::string> &sensors_to_watch) {
+    monitored_sensors_.insert(sensors_to_watch.begin(), sensors_to_watch.end());
+
+    for (auto &[tz_id, tz_type] : tz_types) {
+        if (monitored_sensors_.find(tz_type) == monitored_sensors_.end()) {
+            tz_type.clear();
+        }
+        tz_id_to_sensor_map_.emplace(tz_id, std::move(tz_type));
+    }
+
+    sk_thermal = sock;
+    thermal_genl_fd_.reset(nl_socket_get_fd(sk_thermal));
+    if (thermal_genl_fd_.get() < 0) {
+        LOG(ERROR) << "Failed to create thermal netlink socket";
+        return;
+    }
+
     fcntl(thermal_genl_fd_, F_SETFL, O_NONBLOCK);
     looper_->addFd(thermal_genl_fd_.get(), 0, ::android::Looper::EVENT_INPUT, nullptr, nullptr);
     sleep_ms_ = std::chrono::milliseconds(0);
@@ -416,62 +497,85 @@ bool ThermalWatcher::startWatchingDeviceFiles() {
     return false;
 }
 void ThermalWatcher::parseUevent(std::unordered_map<std::string, float> *sensor_map) {
-    bool thermal_event = false;
-    constexpr int kUeventMsgLen = 2048;
-    char msg[kUeventMsgLen + 2];
-    char *cp;
+    char msgs[kUeventBatchSize][kUeventMsgLen];
+    struct sockaddr_nl addrs[kUeventBatchSize];
+    union {
+        char buf[CMSG_SPACE(sizeof(struct ucred))];
+        struct cmsghdr align;
+    } controls[kUeventBatchSize];
+    struct iovec iovs[kUeventBatchSize];
+    struct mmsghdr hdrs[kUeventBatchSize];
+
+    for (size_t i = 0; i < kUeventBatchSize; ++i) {
+        iovs[i] = {msgs[i], kUeventMsgLen};
+    }
 
     while (true) {
-        int n = uevent_kernel_multicast_recv(uevent_fd_.get(), msg, kUeventMsgLen);
+        for (size_t i = 0; i < kUeventBatchSize; ++i) {
+            hdrs[i].msg_hdr = {
+                    .msg_name = &addrs[i],
+                    .msg_namelen = sizeof(addrs[i]),
+                    .msg_iov = &iovs[i],
+                    .msg_iovlen = 1,
+                    .msg_control = controls[i].buf,
+                    .msg_controllen = sizeof(controls[i].buf),
+            };
+        }
+
+        const int n = TEMP_FAILURE_RETRY(
+                recvmmsg(uevent_fd_.get(), hdrs, kUeventBatchSize, MSG_DONTWAIT, nullptr));
         if (n <= 0) {
-            if (errno != EAGAIN && errno != EWOULDBLOCK) {
-                LOG(ERROR) << "Error reading from Uevent Fd";
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                PLOG(ERROR) << "Error reading from Uevent Fd";
             }
             break;
         }
 
-        if (n >= kUeventMsgLen) {
-            LOG(ERROR) << "Uevent overflowed buffer, discarding";
-            continue;
-        }
-
-        msg[n] = '\0';
-        msg[n + 1] = '\0';
-
-        cp = msg;
-        while (*cp) {
-            std::string uevent = cp;
-            auto findSubSystemThermal = uevent.find("SUBSYSTEM=thermal");
-            if (!thermal_event) {
-                if (::android::base::StartsWith(uevent, "SUBSYSTEM=")) {
-                    if (findSubSystemThermal != std::string::npos) {
-                        thermal_event = true;
-                    } else {
-                        break;
-                    }
-                }
-            } else {
-                auto start_pos = uevent.find("NAME=");
-                if (start_pos != std::string::npos) {
-                    start_pos += 5;
-                    std::string name = uevent.substr(start_pos);
-                    if (monitored_sensors_.find(name) != monitored_sensors_.end()) {
-                        sensor_map->insert({name, NAN});
-                    }
-                    break;
-                }
+        for (int i = 0; i < n; ++i) {
+            if (!isKernelUevent(hdrs[i].msg_hdr)) {
+                continue;
             }
-            while (*cp++) {
+            if (hdrs[i].msg_len >= kUeventMsgLen) {
+                LOG(ERROR) << "Uevent overflowed buffer, discarding";
+                continue;
             }
+
+            const std::string_view name =
+                    parseThermalUeventName(std::string_view(msgs[i], hdrs[i].msg_len));
+            if (!name.empty() && monitored_sensors_.find(name) != monitored_sensors_.end()) {
+                sensor_map->emplace(name, NAN);
+            }
+        }
+
+        // A short batch means the socket has been drained
+        if (n < static_cast<int>(kUeventBatchSize)) {
+            break;
+        }
+    }
+}
+
+const std::string *ThermalWatcher::findSensorByTzId(int tz_id) {
+    auto it = tz_id_to_sensor_map_.find(tz_id);
+    if (it == tz_id_to_sensor_map_.end()) {
+        // A zone created after registration, resolve it once from sysfs
+        std::string tz_type;
+        if (!getThermalZoneTypeById(tz_id, &tz_type)) {
+            return nullptr;
         }
+        if (monitored_sensors_.find(tz_type) == monitored_sensors_.end()) {
+            tz_type.clear();
+        }
+        it = tz_id_to_sensor_map_.emplace(tz_id, std::move(tz_type)).first;
     }
+
+    return it->second.empty() ? nullptr : &it->second;
 }
 
 // TODO(b/175367921): Consider for potentially adding more type of event in the function
 // instead of just add the sensors to the list.
 void ThermalWatcher::parseGenlink(std::unordered_map<std::string, float> *sensor_map) {
     int err = 0, done = 0;
-    std::pair<int, float> tz_info(-1, NAN);
+    std::vector<TzEvent> tz_events;
 
     std::unique_ptr<nl_cb, decltype(&nl_cb_put)> cb(nl_cb_alloc(NL_CB_DEFAULT), nl_cb_put);
 
@@ -479,19 +583,33 @@ void ThermalWatcher::parseGenlink(std::unordered_map<std::string, float> *sensor
     nl_cb_set(cb.get(), NL_CB_FINISH, NL_CB_CUSTOM, nlFinishHandle, &done);
     nl_cb_set(cb.get(), NL_CB_ACK, NL_CB_CUSTOM, nlAckHandle, &done);
     nl_cb_set(cb.get(), NL_CB_SEQ_CHECK, NL_CB_CUSTOM, nlSeqCheckHandle, &done);
-    nl_cb_set(cb.get(), NL_CB_VALID, NL_CB_CUSTOM, handleEvent, &tz_info);
-
-    while (!done && !err) {
-        nl_recvmsgs(sk_thermal, cb.get());
+    nl_cb_set(cb.get(), NL_CB_VALID, NL_CB_CUSTOM, handleEvent, &tz_events);
 
-        if (tz_info.first < 0) {
+    // Drain all pending datagrams rather than one per looper wakeup
+    for (int i = 0; i < kGenlBatchLimit && !err; ++i) {
+        if (nl_recvmsgs_report(sk_thermal, cb.get()) <= 0) {
             break;
         }
+    }
 
-        std::string name;
-        if (getThermalZoneTypeById(tz_info.first, &name) &&
-            monitored_sensors_.find(name) != monitored_sensors_.end()) {
-            sensor_map->insert({name, tz_info.second});
+    for (const auto &tz_event : tz_events) {
+        if (tz_event.cmd == THERMAL_GENL_EVENT_TZ_CREATE ||
+            tz_event.cmd == THERMAL_GENL_EVENT_TZ_DELETE) {
+            // Zone ids are reused, so resolve the zone again on its next event
+            tz_id_to_sensor_map_.erase(tz_event.tz_id);
+            if (tz_event.cmd == THERMAL_GENL_EVENT_TZ_DELETE) {
+                continue;
+            }
+        }
+
+        const std::string *sensor = findSensorByTzId(tz_event.tz_id);
+        if (sensor == nullptr) {
+            continue;
+        }
+        // Keep the latest temperature reported for the sensor in this batch
+        auto [it, inserted] = sensor_map->try_emplace(*sensor, tz_event.tz_temp);
+        if (!inserted && !std::isnan(tz_event.tz_temp)) {
+            it->second = tz_event.tz_temp;
         }
     }
 }
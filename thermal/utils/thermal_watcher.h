@@ -31,6 +31,7 @@
 #include <mutex>
 #include <set>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <unordered_map>
 #include <vector>
@@ -64,8 +65,14 @@ class ThermalWatcher : public ::android::Thread {
     // This should be called before starting watcher thread.
     // For monitoring uevents.
     void registerFilesToWatch(const std::set<std::string> &sensors_to_watch);
+    // For monitoring uevents from an already opened socket, e.g. synthetic traffic in tests.
+    void registerUeventFd(unique_fd uevent_fd, const std::set<std::string> &sensors_to_watch);
     // For monitoring thermal genl events.
     void registerFilesToWatchNl(const std::set<std::string> &sensors_to_watch);
+    // For monitoring thermal genl events from an already connected socket, with the thermal zone
+    // types by id, e.g. synthetic traffic in tests. The watcher takes the socket fd.
+    void registerGenlSocket(struct nl_sock *sock, std::unordered_map<int, std::string> tz_types,
+                            const std::set<std::string> &sensors_to_watch);
     // Wake up the looper thus the worker thread, immediately. This can be called
     // in any thread.
     void wake();
@@ -83,6 +90,9 @@ class ThermalWatcher : public ::android::Thread {
     // Parse thermal netlink message
     void parseGenlink(std::unordered_map<std::string, float> *sensor_map);
 
+    // Look up the monitored sensor backed by a thermal zone, or nullptr if there is none
+    const std::string *findSensorByTzId(int tz_id);
+
     // Maps watcher filer descriptor to watched file path.
     std::unordered_map<int, std::string> watch_to_file_path_map_;
 
@@ -99,7 +109,10 @@ class ThermalWatcher : public ::android::Thread {
     // For thermal genl socket registration.
     ::android::base::unique_fd thermal_genl_fd_;
     // Sensor list which monitor flag is enabled.
-    std::set<std::string> monitored_sensors_;
+    std::set<std::string, std::less<>> monitored_sensors_;
+    // Maps thermal zone id to the monitored sensor name, or to an empty string for zones
+    // which are not monitored. Built at genl registration so events need no sysfs read.
+    std::unordered_map<int, std::string> tz_id_to_sensor_map_;
     // Sleep interval voting result
     std::chrono::milliseconds sleep_ms_;
     // Timestamp for last thermal update
@@ -23,8 +23,10 @@
 #include <json/reader.h>
 #include <utils/Trace.h>
 
+#include <algorithm>
 #include <cmath>
 #include <sstream>
+#include <unordered_map>
 #include <vector>
 
 namespace thermal {
@@ -75,6 +77,83 @@ float CalculateOffset(const std::vector<float> &offset_thresholds,
 
     return 0;
 }
+
+template <typename T>
+void LoadTFLiteWrapperSymbol(void *lib_handle, const char *symbol, T *method) {
+    *method = reinterpret_cast<T>(dlsym(lib_handle, symbol));
+    if (!*method) {
+        LOG(ERROR) << "Could not link and cast " << symbol << " with error: " << dlerror();
+    }
+}
+
+// The TFLite wrapper library is loaded once and its methods are shared by all the estimators.
+const TFLiteWrapperMethods *GetTFLiteWrapperMethods() {
+    static TFLiteWrapperMethods tflite_methods = {};
+    static std::once_flag load_flag;
+
+    std::call_once(load_flag, []() {
+        void *lib_handle = dlopen("/vendor/lib64/libthermal_tflite_wrapper.so", 0);
+        if (lib_handle == nullptr) {
+            LOG(ERROR) << "Could not load libthermal_tflite_wrapper library with error: "
+                       << dlerror();
+            return;
+        }
+
+        LoadTFLiteWrapperSymbol(lib_handle, "ThermalTfliteCreate", &tflite_methods.create);
+        LoadTFLiteWrapperSymbol(lib_handle, "ThermalTfliteInit", &tflite_methods.init);
+        LoadTFLiteWrapperSymbol(lib_handle, "ThermalTfliteInvoke", &tflite_methods.invoke);
+        LoadTFLiteWrapperSymbol(lib_handle, "ThermalTfliteDestroy", &tflite_methods.destroy);
+        LoadTFLiteWrapperSymbol(lib_handle, "ThermalTfliteGetInputConfigSize",
+                                &tflite_methods.get_input_config_size);
+        LoadTFLiteWrapperSymbol(lib_handle, "ThermalTfliteGetInputConfig",
+                                &tflite_methods.get_input_config);
+    });
+
+    return &tflite_methods;
+}
+
+struct RegisteredTFLiteModel {
+    // Held while the model is loaded, so estimators of other models can load concurrently
+    std::mutex mutex;
+    std::weak_ptr<VtEstimatorTFLiteModel> model;
+};
+
+// Get the model instance of model_path, the model is created and initialized by the first
+// estimator loading it, and released with the last estimator using it.
+std::shared_ptr<VtEstimatorTFLiteModel> AcquireTFLiteModel(std::string_view model_path,
+                                                           const TFLiteWrapperMethods *methods) {
+    static std::mutex registry_mutex;
+    static std::unordered_map<std::string, RegisteredTFLiteModel> registry;
+
+    std::unique_lock<std::mutex> registry_lock(registry_mutex);
+    // References to unordered_map elements stay valid across insertions
+    auto &registered = registry[std::string(model_path)];
+    registry_lock.unlock();
+
+    std::unique_lock<std::mutex> lock(registered.mutex);
+    auto &registered_model = registered.model;
+    if (auto model = registered_model.lock()) {
+        LOG(INFO) << "Sharing tflite model " << model_path;
+        return model;
+    }
+
+    auto model = std::make_shared<VtEstimatorTFLiteModel>(model_path, methods);
+    model->tflite_wrapper = methods->create(kNumInputTensors, kNumOutputTensors);
+    if (!model->tflite_wrapper) {
+        LOG(ERROR) << "Failed to create tflite wrapper for " << model_path;
+        return nullptr;
+    }
+
+    int ret = methods->init(model->tflite_wrapper, model->model_path.c_str());
+    if (ret) {
+        LOG(ERROR) << "Failed to Init tflite_wrapper for " << model_path << " (ret: " << ret
+                   << ")";
+        return nullptr;
+    }
+
+    registered_model = model;
+    return model;
+}
 }  // namespace
 
 VtEstimatorStatus VirtualTempEstimator::DumpTraces() {
@@ -87,7 +166,7 @@ VtEstimatorStatus VirtualTempEstimator::DumpTraces() {
         return kVtEstimatorInitFailed;
     }
 
-    std::unique_lock<std::mutex> lock(tflite_instance_->tflite_methods.mutex);
+    std::unique_lock<std::mutex> lock(tflite_instance_->mutex);
 
     if (!common_instance_->is_initialized) {
         LOG(ERROR) << "tflite_instance_ not initialized for " << common_instance_->sensor_name;
@@ -95,14 +174,21 @@ VtEstimatorStatus VirtualTempEstimator::DumpTraces() {
     }
 
     // get model input/output buffers
-    float *model_input = tflite_instance_->input_buffer;
-    float *model_output = tflite_instance_->output_buffer;
+    const auto &input_buffer = tflite_instance_->input_buffer;
+    const float *model_output = tflite_instance_->output_buffer.data();
     auto input_buffer_size = tflite_instance_->input_buffer_size;
     auto output_buffer_size = tflite_instance_->output_buffer_size;
 
-    // In Case of use_prev_samples, inputs are available in order in scratch buffer
-    if (common_instance_->use_prev_samples) {
-        model_input = tflite_instance_->scratch_buffer;
+    // In Case of use_prev_samples, the oldest input sample follows the latest one
+    std::vector<float> model_input(input_buffer.begin(), input_buffer.end());
+    if (common_instance_->use_prev_samples && common_instance_->cur_sample_count) {
+        size_t cur_sample_index =
+                (common_instance_->cur_sample_count - 1) % common_instance_->prev_samples_order;
+        size_t sample_start_index =
+                ((cur_sample_index + 1) * common_instance_->num_linked_sensors) % input_buffer_size;
+        for (size_t i = 0; i < input_buffer_size; ++i) {
+            model_input[i] = input_buffer[(sample_start_index + i) % input_buffer_size];
+        }
     }
 
     // Add traces for model input/output buffers
@@ -141,53 +227,8 @@ void VirtualTempEstimator::LoadTFLiteWrapper() {
         return;
     }
 
-    std::unique_lock<std::mutex> lock(tflite_instance_->tflite_methods.mutex);
-
-    void *mLibHandle = dlopen("/vendor/lib64/libthermal_tflite_wrapper.so", 0);
-    if (mLibHandle == nullptr) {
-        LOG(ERROR) << "Could not load libthermal_tflite_wrapper library with error: " << dlerror();
-        return;
-    }
-
-    tflite_instance_->tflite_methods.create =
-            reinterpret_cast<tflitewrapper_create>(dlsym(mLibHandle, "ThermalTfliteCreate"));
-    if (!tflite_instance_->tflite_methods.create) {
-        LOG(ERROR) << "Could not link and cast tflitewrapper_create with error: " << dlerror();
-    }
-
-    tflite_instance_->tflite_methods.init =
-            reinterpret_cast<tflitewrapper_init>(dlsym(mLibHandle, "ThermalTfliteInit"));
-    if (!tflite_instance_->tflite_methods.init) {
-        LOG(ERROR) << "Could not link and cast tflitewrapper_init with error: " << dlerror();
-    }
-
-    tflite_instance_->tflite_methods.invoke =
-            reinterpret_cast<tflitewrapper_invoke>(dlsym(mLibHandle, "ThermalTfliteInvoke"));
-    if (!tflite_instance_->tflite_methods.invoke) {
-        LOG(ERROR) << "Could not link and cast tflitewrapper_invoke with error: " << dlerror();
-    }
-
-    tflite_instance_->tflite_methods.destroy =
-            reinterpret_cast<tflitewrapper_destroy>(dlsym(mLibHandle, "ThermalTfliteDestroy"));
-    if (!tflite_instance_->tflite_methods.destroy) {
-        LOG(ERROR) << "Could not link and cast tflitewrapper_destroy with error: " << dlerror();
-    }
-
-    tflite_instance_->tflite_methods.get_input_config_size =
-            reinterpret_cast<tflitewrapper_get_input_config_size>(
-                    dlsym(mLibHandle, "ThermalTfliteGetInputConfigSize"));
-    if (!tflite_instance_->tflite_methods.get_input_config_size) {
-        LOG(ERROR) << "Could not link and cast tflitewrapper_get_input_config_size with error: "
-                   << dlerror();
-    }
-
-    tflite_instance_->tflite_methods.get_input_config =
-            reinterpret_cast<tflitewrapper_get_input_config>(
-                    dlsym(mLibHandle, "ThermalTfliteGetInputConfig"));
-    if (!tflite_instance_->tflite_methods.get_input_config) {
-        LOG(ERROR) << "Could not link and cast tflitewrapper_get_input_config with error: "
-                   << dlerror();
-    }
+    std::unique_lock<std::mutex> lock(tflite_instance_->mutex);
+    tflite_instance_->tflite_methods = GetTFLiteWrapperMethods();
 }
 
 VirtualTempEstimator::VirtualTempEstimator(std::string_view sensor_name,
@@ -237,17 +278,10 @@ VtEstimatorStatus VirtualTempEstimator::LinearModelInitialize(LinearModelInitDat
     common_instance_->use_prev_samples = data.use_prev_samples;
     common_instance_->prev_samples_order = data.prev_samples_order;
 
-    linear_model_instance_->input_samples.reserve(common_instance_->prev_samples_order);
-    linear_model_instance_->coefficients.reserve(common_instance_->prev_samples_order);
-
-    // Store coefficients
-    for (size_t i = 0; i < data.prev_samples_order; ++i) {
-        std::vector<float> single_order_coefficients;
-        for (size_t j = 0; j < num_linked_sensors; ++j) {
-            single_order_coefficients.emplace_back(data.coefficients[i * num_linked_sensors + j]);
-        }
-        linear_model_instance_->coefficients.emplace_back(single_order_coefficients);
-    }
+    linear_model_instance_->input_samples.assign(
+            2 * common_instance_->prev_samples_order * num_linked_sensors, 0.0f);
+    linear_model_instance_->coefficients = data.coefficients;
+    common_instance_->cur_sample_count = 0;
 
     common_instance_->offset_thresholds = data.offset_thresholds;
     common_instance_->offset_values = data.offset_values;
@@ -269,7 +303,7 @@ VtEstimatorStatus VirtualTempEstimator::TFliteInitialize(MLModelInitData data) {
     size_t num_hot_spots = data.num_hot_spots;
     size_t output_label_count = data.output_label_count;
 
-    std::unique_lock<std::mutex> lock(tflite_instance_->tflite_methods.mutex);
+    std::unique_lock<std::mutex> lock(tflite_instance_->mutex);
 
     if (data.model_path.empty()) {
         LOG(ERROR) << "Invalid model_path:" << data.model_path << " for " << sensor_name;
@@ -289,10 +323,7 @@ VtEstimatorStatus VirtualTempEstimator::TFliteInitialize(MLModelInitData data) {
     tflite_instance_->support_under_sampling = data.support_under_sampling;
     tflite_instance_->enable_input_validation = data.enable_input_validation;
     tflite_instance_->input_buffer_size = num_linked_sensors * prev_samples_order;
-    tflite_instance_->input_buffer = new float[tflite_instance_->input_buffer_size];
-    if (common_instance_->use_prev_samples) {
-        tflite_instance_->scratch_buffer = new float[tflite_instance_->input_buffer_size];
-    }
+    tflite_instance_->input_buffer.assign(tflite_instance_->input_buffer_size, 0);
 
     if (output_label_count < 1 || num_hot_spots < 1) {
         LOG(ERROR) << "Invalid tflite_instance_ config:" << "number of hot spots: " << num_hot_spots
@@ -303,29 +334,28 @@ VtEstimatorStatus VirtualTempEstimator::TFliteInitialize(MLModelInitData data) {
     tflite_instance_->output_label_count = output_label_count;
     tflite_instance_->num_hot_spots = num_hot_spots;
     tflite_instance_->output_buffer_size = output_label_count * num_hot_spots;
-    tflite_instance_->output_buffer = new float[tflite_instance_->output_buffer_size];
+    tflite_instance_->output_buffer.assign(tflite_instance_->output_buffer_size, 0);
 
-    if (!tflite_instance_->tflite_methods.create || !tflite_instance_->tflite_methods.init ||
-        !tflite_instance_->tflite_methods.invoke || !tflite_instance_->tflite_methods.destroy ||
-        !tflite_instance_->tflite_methods.get_input_config_size ||
-        !tflite_instance_->tflite_methods.get_input_config) {
+    const auto *tflite_methods = tflite_instance_->tflite_methods;
+    if (!tflite_methods || !tflite_methods->create || !tflite_methods->init ||
+        !tflite_methods->invoke || !tflite_methods->destroy ||
+        !tflite_methods->get_input_config_size || !tflite_methods->get_input_config) {
         LOG(ERROR) << "Invalid tflite methods for " << sensor_name;
         return kVtEstimatorInitFailed;
     }
 
-    tflite_instance_->tflite_wrapper =
-            tflite_instance_->tflite_methods.create(kNumInputTensors, kNumOutputTensors);
-    if (!tflite_instance_->tflite_wrapper) {
-        LOG(ERROR) << "Failed to create tflite wrapper for " << sensor_name;
+    tflite_instance_->model = AcquireTFLiteModel(data.model_path, tflite_methods);
+    if (!tflite_instance_->model) {
+        LOG(ERROR) << "Failed to load tflite model for " << sensor_name;
         return kVtEstimatorInitFailed;
     }
 
-    int ret = tflite_instance_->tflite_methods.init(tflite_instance_->tflite_wrapper,
-                                                    data.model_path.c_str());
-    if (ret) {
-        LOG(ERROR) << "Failed to Init tflite_wrapper for " << sensor_name << " (ret: " << ret
-                   << ")";
-        return kVtEstimatorInitFailed;
+    {
+        std::unique_lock<std::mutex> model_lock(tflite_instance_->model->mutex);
+        auto &scratch_buffer = tflite_instance_->model->scratch_buffer;
+        if (scratch_buffer.size() < tflite_instance_->input_buffer_size) {
+            scratch_buffer.resize(tflite_instance_->input_buffer_size);
+        }
     }
 
     Json::Value input_config;
@@ -379,28 +409,32 @@ VtEstimatorStatus VirtualTempEstimator::LinearModelEstimate(const std::vector<fl
         return kVtEstimatorInitFailed;
     }
 
+    std::vector<float> &input_samples = linear_model_instance_->input_samples;
+    const size_t window_size = prev_samples_order * num_linked_sensors;
+
     // For the first iteration copy current inputs to all previous inputs
     // This would allow the estimator to have previous samples from the first iteration itself
     // and provide a valid predicted value
     if (common_instance_->cur_sample_count == 0) {
-        for (size_t i = 0; i < prev_samples_order; ++i) {
-            linear_model_instance_->input_samples[i] = thermistors;
+        for (size_t i = 0; i < 2 * prev_samples_order; ++i) {
+            std::copy(thermistors.begin(), thermistors.end(),
+                      input_samples.begin() + i * num_linked_sensors);
         }
     }
 
+    // History is kept newest first, so the write row walks backwards through the ring
     size_t cur_sample_index = common_instance_->cur_sample_count % prev_samples_order;
-    linear_model_instance_->input_samples[cur_sample_index] = thermistors;
-
-    // Calculate Weighted Average Value
-    int input_level = cur_sample_index;
+    size_t write_row = (prev_samples_order - cur_sample_index) % prev_samples_order;
+    float *window = input_samples.data() + write_row * num_linked_sensors;
+    std::copy(thermistors.begin(), thermistors.end(), window);
+    std::copy(thermistors.begin(), thermistors.end(), window + window_size);
+
+    // Calculate Weighted Average Value. Accumulation order matches the per-order, per-sensor
+    // walk so results are bit-exact with the nested implementation.
+    const float *coefficients = linear_model_instance_->coefficients.data();
     float estimated_value = 0;
-    for (size_t i = 0; i < prev_samples_order; ++i) {
-        for (size_t j = 0; j < num_linked_sensors; ++j) {
-            estimated_value += linear_model_instance_->coefficients[i][j] *
-                               linear_model_instance_->input_samples[input_level][j];
-        }
-        input_level--;  // go to previous samples
-        input_level = (input_level >= 0) ? input_level : (prev_samples_order - 1);
+    for (size_t i = 0; i < window_size; ++i) {
+        estimated_value += coefficients[i] * window[i];
     }
 
     // Update sample count
@@ -410,8 +444,7 @@ VtEstimatorStatus VirtualTempEstimator::LinearModelEstimate(const std::vector<fl
     estimated_value += CalculateOffset(common_instance_->offset_thresholds,
                                        common_instance_->offset_values, estimated_value);
 
-    std::vector<float> data = {estimated_value};
-    *output = data;
+    output->assign(1, estimated_value);
     return kVtEstimatorOk;
 }
 
@@ -422,7 +455,7 @@ VtEstimatorStatus VirtualTempEstimator::TFliteEstimate(const std::vector<float>
         return kVtEstimatorInitFailed;
     }
 
-    std::unique_lock<std::mutex> lock(tflite_instance_->tflite_methods.mutex);
+    std::unique_lock<std::mutex> lock(tflite_instance_->mutex);
 
     if (!common_instance_->is_initialized) {
         LOG(ERROR) << "tflite_instance_ not initialized for " << tflite_instance_->model_path;
@@ -488,24 +521,27 @@ VtEstimatorStatus VirtualTempEstimator::TFliteEstimate(const std::vector<float>
         return kVtEstimatorUnderSampling;
     }
 
-    // prepare model input
+    // prepare model input, the model and its scratch buffer are shared with other estimators
+    auto &model = *tflite_instance_->model;
+    std::unique_lock<std::mutex> model_lock(model.mutex);
     float *model_input;
     size_t input_buffer_size = tflite_instance_->input_buffer_size;
     size_t output_buffer_size = tflite_instance_->output_buffer_size;
     if (!common_instance_->use_prev_samples) {
-        model_input = tflite_instance_->input_buffer;
+        model_input = tflite_instance_->input_buffer.data();
     } else {
         sample_start_index = ((cur_sample_index + 1) * num_linked_sensors) % input_buffer_size;
         for (size_t i = 0; i < input_buffer_size; ++i) {
             size_t input_index = (sample_start_index + i) % input_buffer_size;
-            tflite_instance_->scratch_buffer[i] = tflite_instance_->input_buffer[input_index];
+            model.scratch_buffer[i] = tflite_instance_->input_buffer[input_index];
         }
-        model_input = tflite_instance_->scratch_buffer;
+        model_input = model.scratch_buffer.data();
     }
 
-    int ret = tflite_instance_->tflite_methods.invoke(
-            tflite_instance_->tflite_wrapper, model_input, input_buffer_size,
-            tflite_instance_->output_buffer, output_buffer_size);
+    int ret = model.tflite_methods->invoke(model.tflite_wrapper, model_input, input_buffer_size,
+                                           tflite_instance_->output_buffer.data(),
+                                           output_buffer_size);
+    model_lock.unlock();
     if (ret) {
         LOG(ERROR) << "Failed to Invoke for " << sensor_name << " (ret: " << ret << ")";
         return kVtEstimatorInvokeFailed;
@@ -584,7 +620,7 @@ VtEstimatorStatus VirtualTempEstimator::TFlitePredictAfterTimeMs(const size_t ti
         return kVtEstimatorInitFailed;
     }
 
-    std::unique_lock<std::mutex> lock(tflite_instance_->tflite_methods.mutex);
+    std::unique_lock<std::mutex> lock(tflite_instance_->mutex);
 
     size_t window = tflite_instance_->predict_window_ms;
     auto sample_interval = tflite_instance_->sample_interval;
@@ -612,7 +648,7 @@ VtEstimatorStatus VirtualTempEstimator::TFlitePredictAfterTimeMs(const size_t ti
 
     size_t request_step = request_time_ms / sample_interval;
     size_t output_label_count = tflite_instance_->output_label_count;
-    float *output_buffer = tflite_instance_->output_buffer;
+    const auto &output_buffer = tflite_instance_->output_buffer;
     float prediction;
     if (request_step == output_label_count - 1) {
         // request prediction is on the right boundary of the window
@@ -646,7 +682,7 @@ VtEstimatorStatus VirtualTempEstimator::TFliteGetAllPredictions(std::vector<floa
         return kVtEstimatorInitFailed;
     }
 
-    std::unique_lock<std::mutex> lock(tflite_instance_->tflite_methods.mutex);
+    std::unique_lock<std::mutex> lock(tflite_instance_->mutex);
 
     if (!common_instance_->is_initialized) {
         LOG(ERROR) << "tflite_instance_ not initialized for " << tflite_instance_->model_path;
@@ -690,7 +726,7 @@ VtEstimatorStatus VirtualTempEstimator::TFLiteDumpStatus(std::string_view sensor
         return kVtEstimatorInitFailed;
     }
 
-    std::unique_lock<std::mutex> lock(tflite_instance_->tflite_methods.mutex);
+    std::unique_lock<std::mutex> lock(tflite_instance_->mutex);
 
     *dump_buf << " Sensor Name: " << sensor_name << std::endl;
     *dump_buf << "  Current Values: ";
@@ -797,9 +833,10 @@ bool VirtualTempEstimator::ParseInputConfig(const Json::Value &input_config) {
 }
 
 bool VirtualTempEstimator::GetInputConfig(Json::Value *config) {
+    const auto &model = *tflite_instance_->model;
+    std::unique_lock<std::mutex> model_lock(model.mutex);
     int config_size = 0;
-    int ret = tflite_instance_->tflite_methods.get_input_config_size(
-            tflite_instance_->tflite_wrapper, &config_size);
+    int ret = model.tflite_methods->get_input_config_size(model.tflite_wrapper, &config_size);
     if (ret || config_size <= 0) {
         LOG(ERROR) << "Failed to get tflite input config size (ret: " << ret
                    << ") with size: " << config_size;
@@ -810,8 +847,7 @@ bool VirtualTempEstimator::GetInputConfig(Json::Value *config) {
               << common_instance_->sensor_name;
 
     char *config_str = new char[config_size];
-    ret = tflite_instance_->tflite_methods.get_input_config(tflite_instance_->tflite_wrapper,
-                                                            config_str, config_size);
+    ret = model.tflite_methods->get_input_config(model.tflite_wrapper, config_str, config_size);
     if (ret) {
         LOG(ERROR) << "Failed to get tflite input config (ret: " << ret << ")";
         delete[] config_str;
@@ -57,7 +57,7 @@ struct LinearModelInitData {
     std::vector<float> offset_values;
 };
 
-union VtEstimationInitData {
+struct VtEstimationInitData {
     VtEstimationInitData(VtEstimationType type) {
         if (type == kUseMLModel) {
             ml_model_init_data.model_path = "";
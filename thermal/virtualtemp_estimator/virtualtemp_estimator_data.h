@@ -16,8 +16,10 @@
 #include <android-base/chrono_utils.h>
 
 #include <cstddef>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 #pragma once
 
@@ -46,7 +48,28 @@ struct TFLiteWrapperMethods {
     tflitewrapper_destroy destroy;
     tflitewrapper_get_input_config_size get_input_config_size;
     tflitewrapper_get_input_config get_input_config;
+};
+
+// A model instance shared by all the estimators which load the same model file. The model
+// invocations are serialized by the mutex, so one scratch buffer serves all the estimators.
+struct VtEstimatorTFLiteModel {
+    VtEstimatorTFLiteModel(std::string_view path, const TFLiteWrapperMethods *methods) {
+        model_path = path;
+        tflite_methods = methods;
+        tflite_wrapper = nullptr;
+    }
+
+    void *tflite_wrapper;
+    const TFLiteWrapperMethods *tflite_methods;
+    std::string model_path;
+    std::vector<float> scratch_buffer;
     mutable std::mutex mutex;
+
+    ~VtEstimatorTFLiteModel() {
+        if (tflite_wrapper && tflite_methods && tflite_methods->destroy) {
+            tflite_methods->destroy(tflite_wrapper);
+        }
+    }
 };
 
 struct InputRangeInfo {
@@ -77,12 +100,9 @@ struct VtEstimatorCommonData {
 
 struct VtEstimatorTFLiteData {
     VtEstimatorTFLiteData() {
-        scratch_buffer = nullptr;
-        input_buffer = nullptr;
         input_buffer_size = 0;
         output_label_count = 1;
         num_hot_spots = 1;
-        output_buffer = nullptr;
         output_buffer_size = 1;
         support_under_sampling = false;
         sample_interval = std::chrono::milliseconds{0};
@@ -91,26 +111,19 @@ struct VtEstimatorTFLiteData {
         last_update_time = boot_clock::time_point::min();
         prev_sample_time = boot_clock::time_point::min();
         enable_input_validation = false;
-
-        tflite_wrapper = nullptr;
-        tflite_methods.create = nullptr;
-        tflite_methods.init = nullptr;
-        tflite_methods.get_input_config_size = nullptr;
-        tflite_methods.get_input_config = nullptr;
-        tflite_methods.invoke = nullptr;
-        tflite_methods.destroy = nullptr;
+        tflite_methods = nullptr;
     }
 
-    void *tflite_wrapper;
-    float *scratch_buffer;
-    float *input_buffer;
+    // The history of input samples and the latest model output of this estimator
+    std::vector<float> input_buffer;
     size_t input_buffer_size;
     size_t num_hot_spots;
     size_t output_label_count;
-    float *output_buffer;
+    std::vector<float> output_buffer;
     size_t output_buffer_size;
     std::string model_path;
-    TFLiteWrapperMethods tflite_methods;
+    const TFLiteWrapperMethods *tflite_methods;
+    std::shared_ptr<VtEstimatorTFLiteModel> model;
     std::vector<InputRangeInfo> input_range;
     bool support_under_sampling;
     std::chrono::milliseconds sample_interval{};
@@ -119,24 +132,7 @@ struct VtEstimatorTFLiteData {
     boot_clock::time_point last_update_time;
     boot_clock::time_point prev_sample_time;
     bool enable_input_validation;
-
-    ~VtEstimatorTFLiteData() {
-        if (tflite_wrapper && tflite_methods.destroy) {
-            tflite_methods.destroy(tflite_wrapper);
-        }
-
-        if (scratch_buffer) {
-            delete scratch_buffer;
-        }
-
-        if (input_buffer) {
-            delete input_buffer;
-        }
-
-        if (output_buffer) {
-            delete output_buffer;
-        }
-    }
+    mutable std::mutex mutex;
 };
 
 struct VtEstimatorLinearModelData {
@@ -144,8 +140,13 @@ struct VtEstimatorLinearModelData {
 
     ~VtEstimatorLinearModelData() {}
 
-    std::vector<std::vector<float>> input_samples;
-    std::vector<std::vector<float>> coefficients;
+    // Sample history of 2 * prev_samples_order rows of num_linked_sensors, newest first. Each
+    // sample is written to row r and to its mirror r + prev_samples_order, so the latest
+    // prev_samples_order samples are always one contiguous window starting at row r.
+    std::vector<float> input_samples;
+    // Coefficients flattened as [prev_samples_order][num_linked_sensors], which matches the
+    // window order so the estimate is a single pass over both buffers.
+    std::vector<float> coefficients;
     mutable std::mutex mutex;
 };
 
@@ -405,18 +405,104 @@ static int run_batch_process(std::string_view model_path, std::string_view therm
     return 0;
 }
 
+// Reference linear model: weighted sum over a ring of per-order sample vectors, walking from the
+// newest sample backwards. The estimator must match it bit for bit.
+static float linear_model_reference(const std::vector<std::vector<float>> &coefficients,
+                                    std::vector<std::vector<float>> *samples, size_t sample_count,
+                                    const std::vector<float> &thermistors) {
+    size_t prev_samples_order = coefficients.size();
+    if (sample_count == 0) {
+        for (size_t i = 0; i < prev_samples_order; ++i) {
+            (*samples)[i] = thermistors;
+        }
+    }
+
+    int input_level = sample_count % prev_samples_order;
+    (*samples)[input_level] = thermistors;
+
+    float estimated_value = 0;
+    for (size_t i = 0; i < prev_samples_order; ++i) {
+        for (size_t j = 0; j < thermistors.size(); ++j) {
+            estimated_value += coefficients[i][j] * (*samples)[input_level][j];
+        }
+        input_level--;
+        input_level = (input_level >= 0) ? input_level : (prev_samples_order - 1);
+    }
+    return estimated_value;
+}
+
+static int run_linear_model_bit_exactness(int inference_count, int prev_samples_order) {
+    constexpr size_t kNumLinkedSensors = 12;
+
+    if (inference_count <= 0) {
+        inference_count = 1000;
+    }
+    if (prev_samples_order <= 0) {
+        std::cout << "Invalid prev_samples_order: " << prev_samples_order << "\n";
+        return -1;
+    }
+
+    std::srand(time(NULL));
+    std::vector<std::vector<float>> coefficients(prev_samples_order);
+    ::thermal::vtestimator::VtEstimationInitData init_data(thermal::vtestimator::kUseLinearModel);
+    init_data.linear_model_init_data.prev_samples_order = prev_samples_order;
+    init_data.linear_model_init_data.use_prev_samples = (prev_samples_order > 1) ? true : false;
+    for (int i = 0; i < prev_samples_order; ++i) {
+        for (size_t j = 0; j < kNumLinkedSensors; ++j) {
+            float coefficient = static_cast<float>(std::rand()) / RAND_MAX - 0.5f;
+            coefficients[i].push_back(coefficient);
+            init_data.linear_model_init_data.coefficients.push_back(coefficient);
+        }
+    }
+
+    thermal::vtestimator::VirtualTempEstimator vt_estimator_(
+            kTestSensorName, thermal::vtestimator::kUseLinearModel, kNumLinkedSensors);
+    thermal::vtestimator::VtEstimatorStatus ret = vt_estimator_.Initialize(init_data);
+    if (ret != thermal::vtestimator::kVtEstimatorOk) {
+        std::cout << "Failed to Initialize estimator (ret: " << ret << ")\n";
+        return -1;
+    }
+
+    std::vector<std::vector<float>> reference_samples(prev_samples_order);
+    std::vector<float> output;
+    for (int count = 0; count < inference_count; ++count) {
+        std::vector<float> thermistors;
+        for (size_t j = 0; j < kNumLinkedSensors; ++j) {
+            thermistors.push_back(static_cast<float>(std::rand() % 60000) / 1.7f);
+        }
+
+        ret = vt_estimator_.Estimate(thermistors, &output);
+        if (ret != thermal::vtestimator::kVtEstimatorOk || output.size() != 1) {
+            std::cout << "Failed to run estimator (ret: " << ret << ")\n";
+            return -1;
+        }
+
+        float expected =
+                linear_model_reference(coefficients, &reference_samples, count, thermistors);
+        if (memcmp(&expected, &output[0], sizeof(float)) != 0) {
+            std::cout << "Mismatch at inference " << count << ": expected " << expected
+                      << " got " << output[0] << "\n";
+            return -1;
+        }
+    }
+
+    std::cout << "linear model bit-exact over " << inference_count << " inferences\n";
+    return 0;
+}
+
 void print_usage() {
     std::string message = "usage: \n";
     message += "-m : input mode (";
     message += "0: single inference ";
     message += "1: json input file ";
-    message += "2: generate random inputs) \n";
+    message += "2: generate random inputs ";
+    message += "3: linear model bit-exactness check) \n";
     message += "-p : path to model file \n";
     message += "-t : path to thermal config file \n";
     message += "-i : input samples (mode 0), path to input file (mode 1) \n";
     message += "-o : output file (mode 1) \n";
     message += "-d : delay between inferences in seconds (mode 2) \n";
-    message += "-c : inference count (mode 2)";
+    message += "-c : inference count (mode 2, 3)";
     message += "-s : prev_samples_order";
 
     std::cout << message << std::endl;
@@ -496,6 +582,9 @@ int main(int argc, char *argv[]) {
             ret = run_random_input_inference(model_path, thermal_config_path, min_inference_count,
                                              inference_delay_sec, prev_samples_order);
             break;
+        case 3:
+            ret = run_linear_model_bit_exactness(min_inference_count, prev_samples_order);
+            break;
         default:
             std::cout << "unsupported mode" << std::endl;
             print_usage();